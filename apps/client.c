@@ -8,15 +8,227 @@
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 #include <termios.h>
+#include <time.h>
+#include "wire.h"
 
 #define PORT 8080
 #define CLIENT_CERT "certs/client.crt"
 #define CLIENT_KEY  "certs/client.key"
 #define CA_CERT     "certs/ca.crt"
 #define EOM_MARKER  '\x03'
+#define MAX_UNIT_NAME 256
 
 struct termios orig_termios;
 
+// ============================================================
+// BINARY MODE (-b): frames of common/wire.h
+// ============================================================
+
+static unsigned char frame_buf[WIRE_MAX_FRAME + 4];
+static size_t frame_len;
+static char (*unit_names)[MAX_UNIT_NAME];   // from UNITS frames, by index
+static int unit_names_count;
+
+typedef struct {
+    uint64_t seq;                           // 0 = no snapshot yet
+    WireSnapshot values;
+} UnitBase;
+
+static UnitBase *unit_bases;                // last snapshot per unit, the DELTA base
+static int unit_bases_count;
+
+static const char *status_names[] = {"OK", "WARNING", "CRITICAL", "FAULT"};
+static const char *channel_names[] = {"vibration", "sound", "temperature", "current"};
+
+static const char *status_name(unsigned s) {
+    return s < sizeof(status_names) / sizeof(status_names[0]) ? status_names[s] : "UNKNOWN";
+}
+
+static void format_time(char *out, size_t size, uint64_t t_ms) {
+    time_t t = (time_t)(t_ms / 1000);
+    struct tm tm;
+    localtime_r(&t, &tm);
+    strftime(out, size, "%Y-%m-%d %H:%M:%S", &tm);
+}
+
+static void print_unit(uint16_t unit) {
+    if (unit < unit_names_count && unit_names[unit][0])
+        printf("%s ", unit_names[unit]);
+    else if (unit != WIRE_NO_UNIT)
+        printf("#%u ", unit);
+}
+
+static UnitBase *unit_base(uint16_t unit) {
+    if (unit == WIRE_NO_UNIT)
+        return NULL;
+    if (unit >= unit_bases_count) {
+        UnitBase *grown = realloc(unit_bases, (unit + 1u) * sizeof(UnitBase));
+        if (!grown)
+            return NULL;
+        memset(grown + unit_bases_count, 0, (unit + 1u - unit_bases_count) * sizeof(UnitBase));
+        unit_bases = grown;
+        unit_bases_count = unit + 1;
+    }
+    return &unit_bases[unit];
+}
+
+static void print_snapshot(const WireHeader *h, const WireSnapshot *w) {
+    const float *v = w->values;
+    printf("[%s] ", status_name(w->status));
+    print_unit(h->unit);
+    printf("Vib: %.0f | Snd: %.0f%% | Temp: %.1fC | Cur: %.2fA\n"
+           "    Vib RMS: %.3f | Peak: %.3f | Crest: %.2f | Kurt: %.2f | Skew: %.2f\n",
+           v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8]);
+}
+
+static void handle_units(const unsigned char *p, uint32_t len) {
+    if (len < 4)
+        return;
+    uint16_t first = wire_get_u16(p), count = wire_get_u16(p + 2);
+    uint32_t off = 4;
+
+    if (first + count > unit_names_count) {
+        char (*grown)[MAX_UNIT_NAME] = realloc(unit_names, (size_t)(first + count) * MAX_UNIT_NAME);
+        if (!grown)
+            return;
+        memset(grown + unit_names_count, 0, (size_t)(first + count - unit_names_count) * MAX_UNIT_NAME);
+        unit_names = grown;
+        unit_names_count = first + count;
+    }
+    if (first == 0)
+        printf("=== Registered Units ===\n");
+    for (int i = first; i < first + count && off < len; i++) {
+        uint32_t n = p[off++];
+        if (off + n > len || n >= MAX_UNIT_NAME)
+            return;
+        memcpy(unit_names[i], p + off, n);
+        unit_names[i][n] = '\0';
+        off += n;
+        printf("  %s\n", unit_names[i]);
+    }
+}
+
+static void handle_history(const WireHeader *h, const unsigned char *p, uint32_t len) {
+    if (len < WIRE_HISTORY_HEAD)
+        return;
+    uint32_t width = wire_get_u32(p + 4), count = wire_get_u32(p + 8);
+    if ((uint64_t)count * WIRE_HISTORY_POINT > len - WIRE_HISTORY_HEAD)
+        return;
+
+    printf("=== History ");
+    print_unit(h->unit);
+    printf("%s (%u x %u s points) ===\n",
+           p[0] < 4 ? channel_names[p[0]] : "?", count, width);
+    if (count == 0)
+        printf("[INFO] No history for that range yet.\n");
+    for (uint32_t i = 0; i < count; i++) {
+        const unsigned char *pt = p + WIRE_HISTORY_HEAD + i * WIRE_HISTORY_POINT;
+        char stamp[32];
+        format_time(stamp, sizeof(stamp), wire_get_u32(pt) * 1000ull);
+        printf("%s  min %.3f  max %.3f  avg %.3f  (%u windows)\n", stamp,
+               wire_get_f32(pt + 8), wire_get_f32(pt + 12), wire_get_f32(pt + 16),
+               wire_get_u32(pt + 4));
+    }
+}
+
+static void handle_alert(const WireHeader *h, const unsigned char *p, uint32_t len) {
+    char stamp[32];
+    if (len < 14 || 14u + wire_get_u16(p + 12) > len)
+        return;
+    format_time(stamp, sizeof(stamp), h->t_ms);
+    printf("[ALERT #%llu] %s | ", (unsigned long long)h->seq, stamp);
+    print_unit(h->unit);
+    printf("| %s -> %s | %.*s", status_name(p[0]), status_name(p[1]),
+           (int)wire_get_u16(p + 12), (const char *)p + 14);
+    if (wire_get_u32(p + 4))
+        printf(" (%u held back)", wire_get_u32(p + 4));
+    printf("\n");
+}
+
+/* Prints one frame; returns 1 at the end of a reply */
+static int handle_frame(const WireHeader *h, const unsigned char *p) {
+    WireSnapshot w;
+    UnitBase *base;
+
+    switch (h->type) {
+    case WIRE_HELLO:
+        if (h->len >= 4)
+            printf("[INFO] Binary protocol v%u%s, %u units\n", p[0],
+                   (p[1] & WIRE_FLAG_DELTA) ? " with deltas" : "", wire_get_u16(p + 2));
+        break;
+    case WIRE_TEXT:
+        fwrite(p, 1, h->len, stdout);
+        break;
+    case WIRE_END:
+        return 1;
+    case WIRE_UNITS:
+        handle_units(p, h->len);
+        break;
+    case WIRE_SNAPSHOT:
+        if (wire_parse_snapshot(p, h->len, &w) != 0)
+            break;
+        if ((base = unit_base(h->unit))) {
+            base->seq = h->seq;
+            base->values = w;
+        }
+        print_snapshot(h, &w);
+        break;
+    case WIRE_DELTA:
+        // Applies to the last frame of the unit; the next SNAPSHOT resyncs
+        base = unit_base(h->unit);
+        if (!base || !base->seq || wire_apply_delta(p, h->len, &base->values) != 0) {
+            if (base)
+                base->seq = 0;
+            break;
+        }
+        base->seq = h->seq;
+        print_snapshot(h, &base->values);
+        break;
+    case WIRE_HISTORY:
+        handle_history(h, p, h->len);
+        break;
+    case WIRE_ALERT:
+        handle_alert(h, p, h->len);
+        break;
+    default:
+        break;  // newer frame type: skip
+    }
+    return 0;
+}
+
+/*
+ * Feeds received bytes to the frame decoder. Returns the number of
+ * replies that ended, or -1 on a malformed stream.
+ */
+static int feed_frames(const char *data, int len) {
+    int ends = 0;
+
+    while (len > 0) {
+        size_t n = sizeof(frame_buf) - frame_len;
+        if (n > (size_t)len)
+            n = (size_t)len;
+        memcpy(frame_buf + frame_len, data, n);
+        frame_len += n;
+        data += n;
+        len -= (int)n;
+
+        size_t off = 0;
+        for (;;) {
+            WireHeader h;
+            long size = wire_parse_header(frame_buf + off, frame_len - off, &h);
+            if (size < 0)
+                return -1;
+            if (size == 0)
+                break;
+            ends += handle_frame(&h, frame_buf + off + WIRE_HEADER_SIZE);
+            off += (size_t)size;
+        }
+        memmove(frame_buf, frame_buf + off, frame_len - off);
+        frame_len -= off;
+    }
+    return ends;
+}
+
 void reset_terminal_mode() {
     tcsetattr(0, TCSANOW, &orig_termios);
 }
@@ -68,12 +280,14 @@ void configure_context(SSL_CTX *ctx) {
 }
 
 int main(int argc, char **argv) {
-    if (argc != 2) {
-        printf("Usage: %s <server_ip>\n", argv[0]);
+    int binary = argc == 3 && !strcmp(argv[1], "-b");
+    if (argc != 2 && !binary) {
+        printf("Usage: %s [-b] <server_ip>\n", argv[0]);
+        printf("  -b  binary framed replies (common/wire.h) instead of text\n");
         exit(EXIT_FAILURE);
     }
 
-    const char *server_ip = argv[1];
+    const char *server_ip = argv[argc - 1];
     int sock;
     struct sockaddr_in addr;
     SSL_CTX *ctx;
@@ -115,6 +329,13 @@ int main(int argc, char **argv) {
         fd_set readfds;
         int max_fd = (sock > STDIN_FILENO) ? sock : STDIN_FILENO;
         int in_monitor_mode = 0;
+        int framed = 0;     // -b: frames follow the text banner
+
+        // Asked for now, answered after the banner (commands run in order)
+        if (binary) {
+            const char *cmd = "protocol binary 1 delta";
+            SSL_write(ssl, cmd, (int)strlen(cmd));
+        }
 
         printf("IMS> ");
         fflush(stdout);
@@ -137,8 +358,21 @@ int main(int argc, char **argv) {
                     break;
                 }
                 for (int i = 0; i < bytes; i++) {
+                    if (framed) {
+                        int ends = feed_frames(rx_buf + i, bytes - i);
+                        if (ends < 0) {
+                            printf("\n[ERROR] Malformed frame from server.\n");
+                            goto done;
+                        }
+                        if (ends > 0) {
+                            in_monitor_mode = 0;
+                            printf("\nIMS> ");
+                        }
+                        break;
+                    }
                     if (rx_buf[i] == EOM_MARKER) {
                         in_monitor_mode = 0;
+                        framed = binary;
                         printf("\nIMS> ");
                     } else {
                         putchar(rx_buf[i]);
@@ -153,8 +387,14 @@ int main(int argc, char **argv) {
                 if (read(STDIN_FILENO, &c, 1) > 0) {
                     if (c == '\n' || c == '\r') {
                         tx_buf[tx_ptr] = '\0';
-                        if (tx_ptr > 0) {
-                            if (strncmp(tx_buf, "monitor", 7) == 0) in_monitor_mode = 1;
+                        if (tx_ptr > 0 && strncmp(tx_buf, "protocol", 8) == 0) {
+                            // The decoder must know where the format changes
+                            printf("\n[INFO] Reply format is chosen at start: %s [-b] <server_ip>",
+                                   argv[0]);
+                        } else if (tx_ptr > 0) {
+                            if (strncmp(tx_buf, "monitor", 7) == 0 ||
+                                strncmp(tx_buf, "follow_log", 10) == 0 ||
+                                strncmp(tx_buf, "subscribe_alerts", 16) == 0) in_monitor_mode = 1;
                             SSL_write(ssl, tx_buf, (int)strlen(tx_buf));
                         } else if (in_monitor_mode) {
                             // Instant interrupt for monitor mode
@@ -184,6 +424,7 @@ int main(int argc, char **argv) {
                 }
             }        }
     }
+done:
     printf("\n");
     reset_terminal_mode();
     SSL_shutdown(ssl);
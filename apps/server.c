@@ -8,13 +8,28 @@
 #include <openssl/err.h>
 #include <signal.h> // Required for handling SIGPIPE
 #include <pthread.h>
+#include <errno.h>
 
 #include "authorization.h"
 #include "sensor_manager.h"
 #include "protocol.h"
+#include "rt_log.h"
+#include "rt_profile.h"
+#include "blackbox.h"
+#include "tls_session.h"
+#ifdef __linux__
+#include "reactor.h"
+#endif
 
 #define PORT 8080
+
+// Linux serves sessions from a few epoll reactors (reactor.h), so the cap
+// is memory, not threads; elsewhere each session has a thread of its own
+#ifdef __linux__
+#define MAX_CONCURRENT_SESSIONS 512
+#else
 #define MAX_CONCURRENT_SESSIONS 32
+#endif
 
 // Paths to certificates generated by quick_start.sh
 #define SERVER_CERT "certs/server.crt"
@@ -47,7 +62,7 @@ int try_reserve_session_slot() {
         accepted = 1;
     }
 
-    printf("[SESSIONS] Current: %d | Max Observed: %d | Limit: %d\n",
+    log_info("[SESSIONS] Current: %d | Max Observed: %d | Limit: %d\n",
            current_sessions, max_observed_sessions, MAX_CONCURRENT_SESSIONS);
     pthread_mutex_unlock(&session_mutex);
 
@@ -59,7 +74,7 @@ void release_session_slot() {
     if (current_sessions > 0)
         current_sessions--;
 
-    printf("[SESSIONS] Current: %d | Max Observed: %d | Limit: %d\n",
+    log_info("[SESSIONS] Current: %d | Max Observed: %d | Limit: %d\n",
            current_sessions, max_observed_sessions, MAX_CONCURRENT_SESSIONS);
     pthread_mutex_unlock(&session_mutex);
 }
@@ -71,8 +86,8 @@ SSL_CTX* create_context() {
     const SSL_METHOD *method = TLS_server_method();
     SSL_CTX *ctx = SSL_CTX_new(method);
     if (!ctx) {
-        perror("[ERROR] Unable to create SSL context");
-        ERR_print_errors_fp(stderr);
+        log_error("[ERROR] Unable to create SSL context\n");
+        ERR_print_errors_cb(rt_log_ssl_error, NULL);
         exit(EXIT_FAILURE);
     }
     return ctx;
@@ -83,28 +98,34 @@ SSL_CTX* create_context() {
 // ============================================================
 void configure_context(SSL_CTX *ctx) {
     if (SSL_CTX_use_certificate_file(ctx, SERVER_CERT, SSL_FILETYPE_PEM) <= 0) {
-        ERR_print_errors_fp(stderr);
+        ERR_print_errors_cb(rt_log_ssl_error, NULL);
         exit(EXIT_FAILURE);
     }
 
     if (SSL_CTX_use_PrivateKey_file(ctx, SERVER_KEY, SSL_FILETYPE_PEM) <= 0) {
-        ERR_print_errors_fp(stderr);
+        ERR_print_errors_cb(rt_log_ssl_error, NULL);
         exit(EXIT_FAILURE);
     }
 
     if (!SSL_CTX_load_verify_locations(ctx, CA_CERT, NULL)) {
-        ERR_print_errors_fp(stderr);
+        ERR_print_errors_cb(rt_log_ssl_error, NULL);
         exit(EXIT_FAILURE);
     }
 
     // Force Client Authentication (mTLS)
     SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, NULL);
+
+    // Reconnecting clients resume instead of redoing the full handshake
+    if (tls_session_setup(ctx) != 0)
+        log_error("[WARN] No session ticket key, reconnects will do full handshakes\n");
 }
 
 // ============================================================
 // Helper: Create Listening Socket
 // ============================================================
-int create_socket(int port) {
+// reuseport lets several reactors bind the same port; the kernel then
+// spreads incoming connections across their sockets.
+int create_socket(int port, int reuseport) {
     int s;
     struct sockaddr_in addr;
 
@@ -114,21 +135,31 @@ int create_socket(int port) {
 
     s = socket(AF_INET, SOCK_STREAM, 0);
     if (s < 0) {
-        perror("[ERROR] Unable to create socket");
+        log_error("[ERROR] Unable to create socket: %s\n", strerror(errno));
         exit(EXIT_FAILURE);
     }
 
     // Allow immediate port reuse on restart
     int opt = 1;
     setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+#ifdef SO_REUSEPORT
+    if (reuseport && setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        log_error("[ERROR] Unable to set SO_REUSEPORT: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+#else
+    (void)reuseport;
+#endif
 
     if (bind(s, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        perror("[ERROR] Unable to bind");
+        log_error("[ERROR] Unable to bind: %s\n", strerror(errno));
         exit(EXIT_FAILURE);
     }
 
-    if (listen(s, 5) < 0) {
-        perror("[ERROR] Unable to listen");
+    // Reconnect storms (every dashboard after a network blip) must not
+    // overflow the accept queue
+    if (listen(s, SOMAXCONN) < 0) {
+        log_error("[ERROR] Unable to listen: %s\n", strerror(errno));
         exit(EXIT_FAILURE);
     }
 
@@ -141,11 +172,11 @@ void *client_session_thread(void *arg) {
     char ip_buf[INET_ADDRSTRLEN] = {0};
 
     inet_ntop(AF_INET, &session->client_addr.sin_addr, ip_buf, sizeof(ip_buf));
-    printf("[CONN] Worker thread started for client %s\n", ip_buf);
+    log_info("[CONN] Worker thread started for client %s\n", ip_buf);
 
     SSL *ssl = SSL_new(session->ssl_ctx);
     if (!ssl) {
-        fprintf(stderr, "[ERROR] Failed to allocate SSL object for %s\n", ip_buf);
+        log_error("[ERROR] Failed to allocate SSL object for %s\n", ip_buf);
         close(session->client_fd);
         free(session);
         return NULL;
@@ -154,33 +185,35 @@ void *client_session_thread(void *arg) {
     SSL_set_fd(ssl, session->client_fd);
 
     if (SSL_accept(ssl) <= 0) {
-        printf("[AUTH] TLS Handshake failed. Rejecting connection from %s.\n", ip_buf);
-        ERR_print_errors_fp(stderr);
+        log_info("[AUTH] TLS Handshake failed. Rejecting connection from %s.\n", ip_buf);
+        ERR_print_errors_cb(rt_log_ssl_error, NULL);
     } else {
         if (authorize_client(ssl, &id) == 0) {
             if (id.role != ROLE_UNAUTHORIZED) {
-                printf("[AUTH] Access GRANTED to User: '%s' | Assigned Role: '%s'\n", id.common_name, role_to_string(id.role));
+                log_info("[AUTH] Access GRANTED to User: '%s' | Assigned Role: '%s'%s\n", id.common_name,
+                         role_to_string(id.role), SSL_session_reused(ssl) ? " (resumed)" : "");
 
                 ProtocolContext protocol_ctx;
                 protocol_init(&protocol_ctx, ssl, id, session->sensor_mgr);
                 protocol_run(&protocol_ctx);
+                protocol_cleanup(&protocol_ctx);
 
-                printf("[CONN] Session ended for %s\n", id.common_name);
+                log_info("[CONN] Session ended for %s\n", id.common_name);
             } else {
-                printf("[AUTH] Access DENIED: Client '%s' has an unauthorized role.\n", id.common_name);
+                log_info("[AUTH] Access DENIED: Client '%s' has an unauthorized role.\n", id.common_name);
             }
         } else {
-            printf("[AUTH] Access DENIED: Missing or invalid client certificate from %s.\n", ip_buf);
+            log_info("[AUTH] Access DENIED: Missing or invalid client certificate from %s.\n", ip_buf);
         }
     }
 
-    printf("[CONN] Cleaning up session and closing socket for %s...\n", ip_buf);
+    log_info("[CONN] Cleaning up session and closing socket for %s...\n", ip_buf);
     SSL_shutdown(ssl);
     SSL_free(ssl);
     close(session->client_fd);
     free(session);
     release_session_slot();
-    printf("[CONN] Session fully closed for %s.\n", ip_buf);
+    log_info("[CONN] Session fully closed for %s.\n", ip_buf);
 
     return NULL;
 }
@@ -196,30 +229,61 @@ int main() {
     // IMPORTANT: Ignore SIGPIPE to prevent server crashes on client disconnects
     signal(SIGPIPE, SIG_IGN);
 
-    printf("====================================================\n");
-    printf("   Starting Sentinel-RT Monitoring System (Server)  \n");
-    printf("====================================================\n");
+    // Console/blackbox output goes through the async log from here on;
+    // atexit drains it on the exit(EXIT_FAILURE) paths too.
+    if (rt_log_init() != 0)
+        log_error("[WARN] Log writer unavailable, logging synchronously\n");
+    atexit(rt_log_shutdown);
+
+    // Alerts are group-committed by the blackbox thread; atexit commits
+    // what is staged before the log writer goes away
+    BlackboxConfig bb_cfg;
+    blackbox_load_config(BLACKBOX_CONFIG, &bb_cfg);
+    if (blackbox_start(&bb_cfg) != 0)
+        log_error("[WARN] Blackbox unavailable (%s), alerts will not be recorded\n", BLACKBOX_PATH);
+    atexit(blackbox_stop);
+    blackbox_log(BLACKBOX_EVENT, NULL, 0, "Server started");
+
+    log_info("====================================================\n");
+    log_info("   Starting Sentinel-RT Monitoring System (Server)  \n");
+    log_info("====================================================\n");
     
     // 1. Initialize Hardware & Background Polling Threads
     if (manager_init(&sensor_mgr) != 0) {
-        fprintf(stderr, "[FATAL] Failed to initialize hardware/sensor manager\n");
+        log_error("[FATAL] Failed to initialize hardware/sensor manager\n");
         return 1;
     }
-    printf("[SYSTEM] Hardware threads actively polling (Vib:17, Snd:27, Temp:4, Cur:I2C)\n");
+    log_info("[SYSTEM] Hardware threads actively polling (Vib:17, Snd:27, Temp:4, Cur:I2C)\n");
 
     // 2. Initialize Security
     init_openssl(); 
     ctx = create_context();
     configure_context(ctx);
 
+#ifdef __linux__
+    // 3. Prepare Network: one listening socket per reactor
+    ReactorConfig reactor_cfg;
+    memset(&reactor_cfg, 0, sizeof(reactor_cfg));
+    reactor_cfg.ssl_ctx = ctx;
+    reactor_cfg.sensor_mgr = &sensor_mgr;
+    reactor_cfg.threads = reactor_default_threads();
+    reactor_cfg.reserve_slot = try_reserve_session_slot;
+    reactor_cfg.release_slot = release_session_slot;
+    for (int i = 0; i < reactor_cfg.threads; i++)
+        reactor_cfg.listen_fd[i] = create_socket(PORT, reactor_cfg.threads > 1);
+
+    // 4. Event loops (returns only if they cannot start)
+    log_info("\n[NETWORK] Listening on port %d (up to %d sessions)\n", PORT, MAX_CONCURRENT_SESSIONS);
+    reactor_run(&reactor_cfg);
+    log_error("[FATAL] Session reactor failed to start\n");
+    sock = reactor_cfg.listen_fd[0];
+#else
     // 3. Prepare Network
-    sock = create_socket(PORT);
-
-    
+    sock = create_socket(PORT, 0);
 
     // 4. Infinite Listener Loop
     while (1) {
-        printf("\n[NETWORK] Ready and waiting for a new client connection on port %d...\n", PORT);
+        log_info("\n[NETWORK] Ready and waiting for a new client connection on port %d...\n", PORT);
         
         struct sockaddr_in addr;
         unsigned int len = sizeof(addr);
@@ -228,16 +292,16 @@ int main() {
         int client_fd = accept(sock, (struct sockaddr*)&addr, &len);
 
         if (client_fd < 0) {
-            perror("[ERROR] Accept failed");
+            log_error("[ERROR] Accept failed: %s\n", strerror(errno));
             continue; // Do not exit, go back to waiting
         }
 
         char ip_buf[INET_ADDRSTRLEN] = {0};
         inet_ntop(AF_INET, &addr.sin_addr, ip_buf, sizeof(ip_buf));
-        printf("[CONN] TCP Connection established from IP: %s\n", ip_buf);
+        log_info("[CONN] TCP Connection established from IP: %s\n", ip_buf);
 
         if (!try_reserve_session_slot()) {
-            printf("[SESSIONS] Connection rejected for %s: session limit reached (%d).\n",
+            log_info("[SESSIONS] Connection rejected for %s: session limit reached (%d).\n",
                    ip_buf, MAX_CONCURRENT_SESSIONS);
             close(client_fd);
             continue;
@@ -245,7 +309,7 @@ int main() {
 
         ClientSession *session = (ClientSession *)malloc(sizeof(ClientSession));
         if (!session) {
-            fprintf(stderr, "[ERROR] Failed to allocate client session state\n");
+            log_error("[ERROR] Failed to allocate client session state\n");
             close(client_fd);
             release_session_slot();
             continue;
@@ -257,8 +321,13 @@ int main() {
         session->client_addr = addr;
 
         pthread_t thread_id;
-        if (pthread_create(&thread_id, NULL, client_session_thread, session) != 0) {
-            perror("[ERROR] Failed to create client worker thread");
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        rt_profile_worker_attr(&attr);
+        int rc = pthread_create(&thread_id, &attr, client_session_thread, session);
+        pthread_attr_destroy(&attr);
+        if (rc != 0) {
+            log_error("[ERROR] Failed to create client worker thread: %s\n", strerror(rc));
             close(client_fd);
             free(session);
             release_session_slot();
@@ -268,12 +337,15 @@ int main() {
         // Detached workers self-clean when a client disconnects.
         pthread_detach(thread_id);
     }
+#endif
 
     // 8. Server Cleanup (Unreachable in standard operation due to while(1))
     close(sock);
     SSL_CTX_free(ctx);
     cleanup_openssl(); 
     manager_cleanup(&sensor_mgr);
+    blackbox_stop();
+    rt_log_shutdown();
     return 0;
 }
 
@@ -1,6 +1,6 @@
 import socket
 import ssl
-import re
+import struct
 import os
 import sys
 import matplotlib.pyplot as plt
@@ -103,44 +103,153 @@ def secure_connect():
         print("Tip: Ensure './ims_server' is running on the QNX Pi.")
         return None
 
+def read_reply(conn):
+    """Reads one text-mode server reply, up to the end-of-message marker."""
+    buf = b''
+    while not buf.endswith(b'\x03'):
+        chunk = conn.read(4096)
+        if not chunk: break
+        buf += chunk
+    return buf.decode('utf-8', errors='ignore')
+
+# ============================================================
+# BINARY PROTOCOL (layouts in common/wire.h)
+# ============================================================
+WIRE_VERSION = 1
+WIRE_HEADER = struct.Struct('<IBBHQQ')     # rest length, version, type, unit, seq, ms
+WIRE_MAX_FRAME = 128 * 1024
+(WIRE_HELLO, WIRE_TEXT, WIRE_END, WIRE_UNITS, WIRE_SNAPSHOT,
+ WIRE_DELTA, WIRE_HISTORY, WIRE_ALERT) = range(1, 9)
+SNAPSHOT = struct.Struct('<B3x9f')          # status, then the 9 values
+HISTORY_HEAD = struct.Struct('<BBxxII')     # channel, tier, width s, count
+HISTORY_POINT = struct.Struct('<IIfff')     # start s, windows, min, max, avg
+
+class FrameReader:
+    """Splits the byte stream into frames, whatever the read boundaries."""
+    def __init__(self, conn):
+        self.conn = conn
+        self.buf = b''
+
+    def frames(self):
+        """Yields (type, unit, seq, ms, payload) for every complete frame buffered."""
+        while len(self.buf) >= WIRE_HEADER.size:
+            rest, _, ftype, unit, seq, ms = WIRE_HEADER.unpack_from(self.buf)
+            if rest < WIRE_HEADER.size - 4 or rest > WIRE_MAX_FRAME:
+                raise ValueError("malformed frame")
+            if len(self.buf) < rest + 4:
+                break
+            payload = self.buf[WIRE_HEADER.size:rest + 4]
+            self.buf = self.buf[rest + 4:]
+            yield ftype, unit, seq, ms, payload
+
+    def fill(self):
+        """Reads what is available; False once the server has closed."""
+        chunk = self.conn.recv(16384)
+        self.buf += chunk
+        return bool(chunk)
+
+    def reply(self):
+        """Blocks for one complete reply; returns its frames, END excluded."""
+        out = []
+        while True:
+            for f in self.frames():
+                if f[0] == WIRE_END:
+                    return out
+                out.append(f)
+            if not self.fill():
+                return out
+
+def apply_delta(payload, base):
+    """Returns (status, values): base (status, values) updated by a DELTA payload."""
+    status, mask = payload[0], struct.unpack_from('<H', payload, 2)[0]
+    values = list(base[1])
+    n = 4
+    for i in range(len(values)):
+        if not mask & (1 << i):
+            continue
+        x, shift = 0, 0
+        while True:
+            b = payload[n]; n += 1
+            x |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                break
+        bits = struct.unpack('<I', struct.pack('<f', values[i]))[0] ^ x
+        values[i] = struct.unpack('<f', struct.pack('<I', bits))[0]
+    return status, values
+
+def backfill_history(reader):
+    """Seeds the plots with the last HISTORY_LEN seconds kept by the server."""
+    for key, channel in [('vib', 'vibration'), ('snd', 'sound'), ('tmp', 'temperature'), ('cur', 'current')]:
+        reader.conn.write(f"get_history {channel} {HISTORY_LEN}s".encode())
+        for ftype, _, _, _, payload in reader.reply():
+            if ftype != WIRE_HISTORY:
+                continue
+            count = HISTORY_HEAD.unpack_from(payload)[3]
+            data_streams[key].extend(HISTORY_POINT.unpack_from(payload, HISTORY_HEAD.size + i * HISTORY_POINT.size)[4]
+                                     for i in range(count))
+
+    line_vib.set_ydata(data_streams['vib'])
+    line_snd.set_ydata(data_streams['snd'])
+    line_tmp.set_ydata(data_streams['tmp'])
+    line_cur.set_ydata(data_streams['cur'])
+
 conn = secure_connect()
+reader = None
 if conn:
-    conn.read(1024) 
-    conn.write(b"monitor")
+    read_reply(conn)
+    conn.write(f"protocol binary {WIRE_VERSION} delta".encode())
+    reader = FrameReader(conn)
+    hello = [f for f in reader.reply() if f[0] == WIRE_HELLO]
+    if not hello or hello[0][4][0] != WIRE_VERSION:
+        print("[ERROR] Server does not speak binary protocol v1.")
+        conn = None
+    else:
+        backfill_history(reader)
+        conn.write(b"monitor")
+
+STATUS_BANNERS = {
+    0: ("STATUS: OPERATIONAL", '#66ff66'),
+    1: ("STATUS: SYSTEM WARNING", '#ffcc00'),
+    2: ("STATUS: CRITICAL FAULT", '#ff4d4d'),
+    3: ("STATUS: SENSOR FAULT", '#ff4d4d'),
+}
+last = {'snap': None}   # the base the next DELTA applies to
+
+def on_snapshot(status, values):
+    data_streams['vib'].append(values[0]); data_streams['snd'].append(values[1])
+    data_streams['tmp'].append(values[2]); data_streams['cur'].append(values[3])
+
+    line_vib.set_ydata(data_streams['vib'])
+    line_snd.set_ydata(data_streams['snd'])
+    line_tmp.set_ydata(data_streams['tmp'])
+    line_cur.set_ydata(data_streams['cur'])
+
+    if status in STATUS_BANNERS:
+        text, color = STATUS_BANNERS[status]
+        status_text.set_text(text)
+        status_text.set_backgroundcolor(color)
 
 def update(frame):
     if not conn: return
     try:
         conn.setblocking(False)
-        raw_data = conn.recv(1024).decode('utf-8', errors='ignore')
-        
-        match = re.search(r"Vib:\s+(\d+)\s+\|\s+Snd:\s+(\d+)%\s+\|\s+Temp:\s+([\d\.]+)C\s+\|\s+Cur:\s+([\d\.]+)A", raw_data)
-        
-        if match:
-            v, s, t, c = map(float, match.groups())
-            data_streams['vib'].append(v); data_streams['snd'].append(s)
-            data_streams['tmp'].append(t); data_streams['cur'].append(c)
-            
-            line_vib.set_ydata(data_streams['vib'])
-            line_snd.set_ydata(data_streams['snd'])
-            line_tmp.set_ydata(data_streams['tmp'])
-            line_cur.set_ydata(data_streams['cur'])
-
-        if "[CRITICAL]" in raw_data:
-            status_text.set_text("STATUS: CRITICAL FAULT")
-            status_text.set_backgroundcolor('#ff4d4d')
-        elif "[WARNING]" in raw_data:
-            status_text.set_text("STATUS: SYSTEM WARNING")
-            status_text.set_backgroundcolor('#ffcc00')
-        elif "[OK]" in raw_data:
-            status_text.set_text("STATUS: OPERATIONAL")
-            status_text.set_backgroundcolor('#66ff66')
-
+        reader.fill()
     except (BlockingIOError, ssl.SSLWantReadError):
         pass
     except Exception as e:
         pass
 
+    for ftype, _, _, _, payload in reader.frames():
+        if ftype == WIRE_SNAPSHOT:
+            status, *values = SNAPSHOT.unpack_from(payload)
+            last['snap'] = (status, values)
+        elif ftype == WIRE_DELTA and last['snap']:
+            last['snap'] = apply_delta(payload, last['snap'])
+        else:
+            continue    # text, or a delta without its base: wait for a snapshot
+        on_snapshot(*last['snap'])
+
 if conn:
     ani = FuncAnimation(fig, update, interval=1000, cache_frame_data=False)
     plt.show()
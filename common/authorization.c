@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <pthread.h>
 #include <openssl/ssl.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
@@ -26,15 +27,33 @@ const char* role_to_string(UserRole role) {
 }
 
 // ============================================================
-// CERTIFICATE PARSING LOGIC
+// IDENTITY CACHE
 // ============================================================
-int authorize_client(SSL *ssl, ClientIdentity *out_id) {
-    X509 *cert = SSL_get_peer_certificate(ssl);
-    if (!cert) {
-        return -1; // No certificate provided
-    }
+// Name and role depend only on the certificate, so each certificate is
+// resolved once and every reconnect reuses the result. Entries are keyed
+// by the CA's signature over the certificate: it is as unique as a
+// fingerprint (two certificates sharing one would need a SHA-256
+// collision) and already in memory, whereas hashing the DER costs more
+// than parsing the names. Direct-mapped: a certificate landing on a
+// taken slot replaces the entry.
+#define AUTH_CACHE_SLOTS 64    // power of two
+#define AUTH_SIG_MAX     512   // RSA-4096; longer signatures are not cached
 
+typedef struct {
+    unsigned char sig[AUTH_SIG_MAX];
+    int sig_len;
+    ClientIdentity id;
+} AuthCacheEntry;
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static AuthCacheEntry cache[AUTH_CACHE_SLOTS];
+
+// ============================================================
+// CERTIFICATE PARSING LOGIC
+// ============================================================
+static void resolve_identity(X509 *cert, ClientIdentity *out_id) {
     // 1. Extract Common Name (CN)
+    out_id->common_name[0] = '\0';
     X509_NAME_get_text_by_NID(X509_get_subject_name(cert), 
                               NID_commonName, 
                               out_id->common_name, 
@@ -60,6 +79,41 @@ int authorize_client(SSL *ssl, ClientIdentity *out_id) {
     } else {
         out_id->role = ROLE_ADMIN;
     }
+}
+
+int authorize_client(SSL *ssl, ClientIdentity *out_id) {
+    const ASN1_BIT_STRING *sig = NULL;
+    X509 *cert = SSL_get_peer_certificate(ssl);
+    if (!cert) {
+        return -1; // No certificate provided
+    }
+
+    X509_get0_signature(&sig, NULL, cert);
+    int sig_len = sig ? ASN1_STRING_length(sig) : 0;
+    if (sig_len <= 0 || sig_len > AUTH_SIG_MAX) {
+        resolve_identity(cert, out_id);
+        X509_free(cert);
+        return 0;
+    }
+
+    const unsigned char *sig_data = ASN1_STRING_get0_data(sig);
+    AuthCacheEntry *e = &cache[sig_data[sig_len - 1] & (AUTH_CACHE_SLOTS - 1)];
+    pthread_mutex_lock(&cache_lock);
+    if (e->sig_len == sig_len && memcmp(e->sig, sig_data, sig_len) == 0) {
+        *out_id = e->id;
+        pthread_mutex_unlock(&cache_lock);
+        X509_free(cert);
+        return 0;
+    }
+    pthread_mutex_unlock(&cache_lock);
+
+    resolve_identity(cert, out_id);
+
+    pthread_mutex_lock(&cache_lock);
+    memcpy(e->sig, sig_data, sig_len);
+    e->sig_len = sig_len;
+    e->id = *out_id;
+    pthread_mutex_unlock(&cache_lock);
 
     X509_free(cert);
     return 0; // Success
@@ -18,6 +18,8 @@ typedef struct {
 
 /**
  * authorize_client: Extracts identity info from the mTLS certificate.
+ * Resolved identities are cached per certificate (keyed by its
+ * signature), so a reconnecting client is not parsed again. Thread-safe.
  * Returns 0 on success, -1 on failure.
  */
 int authorize_client(SSL *ssl, ClientIdentity *out_id);
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include "config_file.h"
+#include "rt_log.h"
+
+static int parse_int(const char *s, long min, long max, long *out)
+{
+    char *end;
+    errno = 0;
+    long v = strtol(s, &end, 10);
+    while (isspace((unsigned char)*end)) end++;
+    if (errno || end == s || *end != '\0' || v < min || v > max)
+        return -1;
+    *out = v;
+    return 0;
+}
+
+static const ConfigKey *find_key(const ConfigKey *keys, size_t nkeys, const char *name)
+{
+    for (size_t i = 0; i < nkeys; i++)
+        if (!strcmp(keys[i].name, name))
+            return &keys[i];
+    return NULL;
+}
+
+int config_file_load(const char *path, const char *tag,
+                     const ConfigKey *keys, size_t nkeys)
+{
+    char line[128];
+    int lineno = 0, rc = 0;
+    FILE *f;
+
+    f = fopen(path, "r");
+    if (!f)
+        return 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        char *key = line, *val, *eq;
+        const ConfigKey *k;
+        long v;
+
+        lineno++;
+        while (isspace((unsigned char)*key)) key++;
+        if (*key == '#' || *key == '\0')
+            continue;
+
+        line[strcspn(line, "\r\n")] = '\0';
+        eq = strchr(key, '=');
+        if (!eq) {
+            log_error("[%s] %s:%d: expected key=value\n", tag, path, lineno);
+            rc = -1;
+            continue;
+        }
+        *eq = '\0';
+        val = eq + 1;
+        for (char *e = eq; e > key && isspace((unsigned char)e[-1]); ) *--e = '\0';
+
+        k = find_key(keys, nkeys, key);
+        if (!k || parse_int(val, k->min, k->max, &v) != 0) {
+            log_error("[%s] %s:%d: bad setting '%s'\n", tag, path, lineno, key);
+            rc = -1;
+            continue;
+        }
+        if (k->as_int)
+            *k->as_int = (int)v;
+        else
+            *k->as_u32 = (uint32_t)v;
+    }
+
+    fclose(f);
+    return rc;
+}
@@ -0,0 +1,37 @@
+#ifndef CONFIG_FILE_H
+#define CONFIG_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================
+// KEY=VALUE CONFIG FILES
+// ============================================================
+//
+// Reader for the small integer settings files under config/ (rt.conf,
+// blackbox.conf): one key=value per line, '#' comments and blank lines
+// ignored, whitespace around the key and value allowed.
+
+/**
+ * ConfigKey: One accepted setting. Exactly one of as_int / as_u32 is
+ * set; the value is stored there only if it parses and lies in
+ * [min, max], otherwise the target keeps its default.
+ */
+typedef struct {
+    const char *name;
+    long min;
+    long max;
+    int *as_int;
+    uint32_t *as_u32;
+} ConfigKey;
+
+/**
+ * config_file_load: Applies path to the targets in keys. A missing file
+ * is not an error (the defaults stay). Malformed lines, unknown keys
+ * and out-of-range values are logged with tag (e.g. "RT") and skipped.
+ * Returns 0, or -1 if any line was rejected.
+ */
+int config_file_load(const char *path, const char *tag,
+                     const ConfigKey *keys, size_t nkeys);
+
+#endif // CONFIG_FILE_H
@@ -0,0 +1,72 @@
+#include <string.h>
+#include "latency_hist.h"
+
+// Highest value that still maps to the given bucket
+static uint64_t bucket_upper_bound(unsigned idx)
+{
+    if (idx < LAT_SUB_COUNT)
+        return idx;
+
+    unsigned shift = (idx - LAT_SUB_COUNT) / LAT_SUB_COUNT;
+    unsigned sub = (idx - LAT_SUB_COUNT) % LAT_SUB_COUNT;
+    return (((uint64_t)(LAT_SUB_COUNT + sub + 1)) << shift) - 1;
+}
+
+void lat_hist_init(LatencyHist *h)
+{
+    for (unsigned i = 0; i < LAT_BUCKETS; i++)
+        atomic_init(&h->counts[i], 0);
+    atomic_init(&h->total, 0);
+    atomic_init(&h->sum_ns, 0);
+}
+
+void lat_hist_snapshot(const LatencyHist *h, LatencySnapshot *out)
+{
+    // total first (acquire): buckets may only be ahead of it, never behind
+    out->total = atomic_load_explicit((atomic_uint_least64_t *)&h->total, memory_order_acquire);
+    out->sum_ns = atomic_load_explicit((atomic_uint_least64_t *)&h->sum_ns, memory_order_relaxed);
+    for (unsigned i = 0; i < LAT_BUCKETS; i++)
+        out->counts[i] = atomic_load_explicit((atomic_uint_least64_t *)&h->counts[i],
+                                              memory_order_relaxed);
+}
+
+void lat_snapshot_diff(const LatencySnapshot *now, const LatencySnapshot *before,
+                       LatencySnapshot *out)
+{
+    out->total = now->total - before->total;
+    out->sum_ns = now->sum_ns - before->sum_ns;
+    for (unsigned i = 0; i < LAT_BUCKETS; i++)
+        out->counts[i] = now->counts[i] - before->counts[i];
+}
+
+uint64_t lat_snapshot_percentile(const LatencySnapshot *s, double percentile)
+{
+    uint64_t seen = 0;
+    uint64_t total = 0;
+
+    // Use the bucket sum, not s->total, so a racing record cannot skew ranks
+    for (unsigned i = 0; i < LAT_BUCKETS; i++)
+        total += s->counts[i];
+    if (total == 0)
+        return 0;
+
+    uint64_t rank = (uint64_t)((percentile / 100.0) * (double)total + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+
+    for (unsigned i = 0; i < LAT_BUCKETS; i++) {
+        seen += s->counts[i];
+        if (seen >= rank)
+            return bucket_upper_bound(i);
+    }
+    return bucket_upper_bound(LAT_BUCKETS - 1);
+}
+
+uint64_t lat_snapshot_max(const LatencySnapshot *s)
+{
+    for (unsigned i = LAT_BUCKETS; i-- > 0;) {
+        if (s->counts[i])
+            return bucket_upper_bound(i);
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+// ============================================================
+// LOG-LINEAR LATENCY HISTOGRAM (HDR style)
+// ============================================================
+//
+// Values below 2^LAT_SUB_BITS ns are counted exactly; above that each
+// power of two is split into 2^LAT_SUB_BITS linear sub-buckets, giving
+// ~3% relative precision from 1 ns to ~18 minutes in fixed memory.
+// Recording is a handful of relaxed atomic ops from a single writer;
+// any thread may take a snapshot at any time.
+
+#define LAT_SUB_BITS   5
+#define LAT_SUB_COUNT  (1u << LAT_SUB_BITS)
+#define LAT_MAX_MSB    40                     // 2^40 ns ~ 18 min
+#define LAT_BUCKETS    (LAT_SUB_COUNT + (LAT_MAX_MSB - LAT_SUB_BITS + 1) * LAT_SUB_COUNT)
+
+/**
+ * LatencyHist: Live histogram written by exactly one thread.
+ */
+typedef struct {
+    atomic_uint_least64_t counts[LAT_BUCKETS];
+    atomic_uint_least64_t total;
+    atomic_uint_least64_t sum_ns;
+} LatencyHist;
+
+/**
+ * LatencySnapshot: Plain copy of a histogram, safe to diff and query.
+ */
+typedef struct {
+    uint64_t counts[LAT_BUCKETS];
+    uint64_t total;
+    uint64_t sum_ns;
+} LatencySnapshot;
+
+static inline unsigned lat_bucket_index(uint64_t v)
+{
+    if (v < LAT_SUB_COUNT)
+        return (unsigned)v;
+
+    unsigned msb = 63u - (unsigned)__builtin_clzll(v);
+    if (msb > LAT_MAX_MSB)
+        return LAT_BUCKETS - 1;
+
+    unsigned shift = msb - LAT_SUB_BITS;
+    unsigned sub = (unsigned)(v >> shift) - LAT_SUB_COUNT;
+    return LAT_SUB_COUNT + shift * LAT_SUB_COUNT + sub;
+}
+
+/**
+ * lat_hist_record: Adds one value. Single-writer, wait-free, RT-safe:
+ * plain load/store pairs, no read-modify-write bus locks.
+ */
+static inline void lat_hist_record(LatencyHist *h, uint64_t value_ns)
+{
+    atomic_uint_least64_t *c = &h->counts[lat_bucket_index(value_ns)];
+
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_store_explicit(&h->sum_ns,
+                          atomic_load_explicit(&h->sum_ns, memory_order_relaxed) + value_ns,
+                          memory_order_relaxed);
+    atomic_store_explicit(&h->total,
+                          atomic_load_explicit(&h->total, memory_order_relaxed) + 1,
+                          memory_order_release);
+}
+
+void lat_hist_init(LatencyHist *h);
+
+/**
+ * lat_hist_snapshot: Copies the live histogram. Buckets are read one by
+ * one, so a snapshot taken during a record may be off by one sample.
+ */
+void lat_hist_snapshot(const LatencyHist *h, LatencySnapshot *out);
+
+/**
+ * lat_snapshot_diff: out = now - before (activity in between).
+ */
+void lat_snapshot_diff(const LatencySnapshot *now, const LatencySnapshot *before,
+                       LatencySnapshot *out);
+
+/**
+ * lat_snapshot_percentile: Upper bound of the bucket holding the given
+ * percentile (0..100). Returns 0 for an empty snapshot.
+ */
+uint64_t lat_snapshot_percentile(const LatencySnapshot *s, double percentile);
+
+/**
+ * lat_snapshot_max: Upper bound of the highest non-empty bucket.
+ */
+uint64_t lat_snapshot_max(const LatencySnapshot *s);
+
+#endif // LATENCY_HIST_H
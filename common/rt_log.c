@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "rt_log.h"
+#include "rt_profile.h"
+
+#define WRITER_IDLE_NS   10000000L    // poll interval when the ring is empty
+#define FLUSH_POLL_NS    1000000L
+#define FLUSH_MAX_POLLS  500          // give up after ~0.5 s
+
+/**
+ * LogSlot: One record. seq follows Vyukov's bounded queue protocol:
+ * seq == pos means free for the producer claiming pos, seq == pos + 1
+ * means published and ready for the writer.
+ */
+typedef struct {
+    atomic_uint_least64_t seq;
+    uint8_t sink;
+    const char *fmt;                  // non-NULL: deferred, format args[]
+    uint64_t args[RT_LOG_MAX_ARGS];
+    char text[RT_LOG_TEXT_MAX];
+} __attribute__((aligned(64))) LogSlot;
+
+static LogSlot slots[RT_LOG_CAPACITY];
+static _Alignas(64) atomic_uint_least64_t enqueue_pos;
+static _Alignas(64) atomic_uint_least64_t dequeue_pos;
+static _Alignas(64) atomic_uint_least64_t dropped;
+static atomic_int writer_active;
+static atomic_int writer_running;
+static pthread_t writer_thread;
+
+// Writer-private state
+static uint64_t reported_drops = 0;
+
+static void sleep_ns(long ns)
+{
+    struct timespec ts = { 0, ns };
+    nanosleep(&ts, NULL);
+}
+
+// Keeps truncated text line-terminated
+static void terminate_line(char *text, int written)
+{
+    if (written >= RT_LOG_TEXT_MAX) {
+        text[RT_LOG_TEXT_MAX - 2] = '\n';
+        text[RT_LOG_TEXT_MAX - 1] = '\0';
+    }
+}
+
+static void emit(const LogSlot *s)
+{
+    char deferred[RT_LOG_TEXT_MAX];
+    const char *text = s->text;
+
+    if (s->fmt) {
+        int n = snprintf(deferred, sizeof(deferred), s->fmt,
+                         (unsigned long long)s->args[0], (unsigned long long)s->args[1],
+                         (unsigned long long)s->args[2], (unsigned long long)s->args[3]);
+        terminate_line(deferred, n);
+        text = deferred;
+    }
+
+    if (s->sink == RT_LOG_STDERR)
+        fputs(text, stderr);
+    else
+        fputs(text, stdout);
+}
+
+/**
+ * claim_slot: Reserves the next slot, or returns NULL (and counts a
+ * drop) if the writer is a full ring behind. Never waits.
+ */
+static LogSlot *claim_slot(uint64_t *pos_out)
+{
+    uint64_t pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+
+    for (;;) {
+        LogSlot *s = &slots[pos & RT_LOG_MASK];
+        uint64_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        int64_t dif = (int64_t)(seq - pos);
+
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                *pos_out = pos;
+                return s;
+            }
+        } else if (dif < 0) {
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            return NULL;
+        } else {
+            pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+static void publish_slot(LogSlot *s, uint64_t pos)
+{
+    atomic_store_explicit(&s->seq, pos + 1, memory_order_release);
+}
+
+// Single consumer: the writer thread, or the caller once it is joined
+static int drain(void)
+{
+    int n = 0;
+    uint64_t pos = atomic_load_explicit(&dequeue_pos, memory_order_relaxed);
+
+    for (;;) {
+        LogSlot *s = &slots[pos & RT_LOG_MASK];
+        if (atomic_load_explicit(&s->seq, memory_order_acquire) != pos + 1)
+            break;   // empty, or the next producer has not finished yet
+
+        emit(s);
+        atomic_store_explicit(&s->seq, pos + RT_LOG_CAPACITY, memory_order_release);
+        pos++;
+        n++;
+        atomic_store_explicit(&dequeue_pos, pos, memory_order_release);
+    }
+
+    uint64_t lost = atomic_load_explicit(&dropped, memory_order_relaxed);
+    if (lost != reported_drops) {
+        fprintf(stderr, "[LOG] %llu records dropped (ring full)\n",
+                (unsigned long long)(lost - reported_drops));
+        reported_drops = lost;
+    }
+
+    if (n)
+        fflush(stdout);
+    return n;
+}
+
+static void *writer_main(void *arg)
+{
+    (void)arg;
+    while (atomic_load_explicit(&writer_running, memory_order_acquire)) {
+        if (drain() == 0)
+            sleep_ns(WRITER_IDLE_NS);
+    }
+    drain();
+    return NULL;
+}
+
+// Used while no writer exists: format and write on the calling thread
+static void write_now(LogSlot *s)
+{
+    emit(s);
+    if (s->sink == RT_LOG_STDOUT)
+        fflush(stdout);
+}
+
+int rt_log_init(void)
+{
+    pthread_attr_t attr;
+
+    if (atomic_load(&writer_active))
+        return 0;
+
+    for (uint32_t i = 0; i < RT_LOG_CAPACITY; i++)
+        atomic_init(&slots[i].seq, i);
+    atomic_init(&enqueue_pos, 0);
+    atomic_init(&dequeue_pos, 0);
+    atomic_init(&dropped, 0);
+    reported_drops = 0;
+
+    if (pthread_attr_init(&attr) != 0)
+        return -1;
+    rt_profile_worker_attr(&attr);
+
+#ifdef __QNX__
+    {
+        // Below every RT thread: output only happens when the CPU is idle
+        struct sched_param sp;
+        memset(&sp, 0, sizeof(sp));
+        sp.sched_priority = 5;
+
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+        pthread_attr_setschedparam(&attr, &sp);
+    }
+#endif
+
+    atomic_store(&writer_running, 1);
+    if (pthread_create(&writer_thread, &attr, writer_main, NULL) != 0) {
+        atomic_store(&writer_running, 0);
+        pthread_attr_destroy(&attr);
+        return -1;
+    }
+    pthread_attr_destroy(&attr);
+
+    atomic_store_explicit(&writer_active, 1, memory_order_release);
+    return 0;
+}
+
+void rt_log_shutdown(void)
+{
+    if (!atomic_exchange(&writer_active, 0))
+        return;
+
+    atomic_store_explicit(&writer_running, 0, memory_order_release);
+    pthread_join(writer_thread, NULL);
+    drain();   // records that raced with the writer's final pass
+}
+
+void rt_log_printf(RtLogSink sink, const char *fmt, ...)
+{
+    va_list ap;
+    uint64_t pos;
+    LogSlot local;
+    int active = atomic_load_explicit(&writer_active, memory_order_acquire);
+    LogSlot *s = active ? claim_slot(&pos) : &local;
+
+    if (!s)
+        return;
+
+    s->sink = (uint8_t)sink;
+    s->fmt = NULL;
+
+    va_start(ap, fmt);
+    int n = vsnprintf(s->text, RT_LOG_TEXT_MAX, fmt, ap);
+    va_end(ap);
+    terminate_line(s->text, n);
+
+    if (active)
+        publish_slot(s, pos);
+    else
+        write_now(s);
+}
+
+void rt_log_u64(RtLogSink sink, const char *fmt,
+                uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3)
+{
+    uint64_t pos;
+    LogSlot local;
+    int active = atomic_load_explicit(&writer_active, memory_order_acquire);
+    LogSlot *s = active ? claim_slot(&pos) : &local;
+
+    if (!s)
+        return;
+
+    s->sink = (uint8_t)sink;
+    s->fmt = fmt;
+    s->args[0] = a0;
+    s->args[1] = a1;
+    s->args[2] = a2;
+    s->args[3] = a3;
+
+    if (active)
+        publish_slot(s, pos);
+    else
+        write_now(s);
+}
+
+void rt_log_flush(void)
+{
+    uint64_t target = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+
+    for (int i = 0; i < FLUSH_MAX_POLLS && atomic_load(&writer_active); i++) {
+        if (atomic_load_explicit(&dequeue_pos, memory_order_acquire) >= target)
+            return;
+        sleep_ns(FLUSH_POLL_NS);
+    }
+}
+
+uint64_t rt_log_dropped(void)
+{
+    return atomic_load_explicit(&dropped, memory_order_relaxed);
+}
+
+int rt_log_ssl_error(const char *str, size_t len, void *u)
+{
+    (void)u;
+    log_error("%.*s", (int)len, str);
+    return 1;
+}
@@ -0,0 +1,80 @@
+#ifndef RT_LOG_H
+#define RT_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================
+// RT-SAFE ASYNCHRONOUS LOG
+// ============================================================
+//
+// Producers (any thread, including polling_thread) claim a slot in a
+// bounded lock-free MPSC ring and return immediately; a low-priority
+// writer thread drains the ring to stdout or stderr. The event audit
+// trail is the blackbox (storage/blackbox.h), not this log.
+// When the ring is full the record is dropped and counted, so a stalled
+// terminal or disk can never back-pressure the RT loop.
+//
+// Before rt_log_init and after rt_log_shutdown records are written
+// synchronously, so early startup errors are never lost.
+
+#define RT_LOG_ORDER     10
+#define RT_LOG_CAPACITY  (1u << RT_LOG_ORDER)     // 1024 records
+#define RT_LOG_MASK      (RT_LOG_CAPACITY - 1u)
+#define RT_LOG_TEXT_MAX  192
+#define RT_LOG_MAX_ARGS  4
+
+typedef enum {
+    RT_LOG_STDOUT = 0,
+    RT_LOG_STDERR
+} RtLogSink;
+
+/**
+ * rt_log_init: Starts the writer thread. Returns 0 on success.
+ */
+int rt_log_init(void);
+
+/**
+ * rt_log_shutdown: Drains pending records and joins the writer.
+ * Safe to call more than once (e.g. from atexit).
+ */
+void rt_log_shutdown(void);
+
+/**
+ * rt_log_printf: Formats on the caller's stack and enqueues the text.
+ * Lock-free, but vsnprintf makes it unsuitable for the RT loop itself.
+ * Lines longer than RT_LOG_TEXT_MAX are truncated.
+ */
+void rt_log_printf(RtLogSink sink, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * rt_log_u64: RT-safe variant. Stores fmt and up to RT_LOG_MAX_ARGS raw
+ * values; formatting happens on the writer thread. fmt must be a string
+ * literal whose conversions all take unsigned long long (%llu, %llx);
+ * unused trailing arguments are ignored.
+ */
+void rt_log_u64(RtLogSink sink, const char *fmt,
+                uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3);
+
+/**
+ * rt_log_flush: Waits (bounded) until every record enqueued before the
+ * call has been written. Never from the RT loop.
+ */
+void rt_log_flush(void);
+
+/**
+ * rt_log_dropped: Records lost to a full ring since startup.
+ */
+uint64_t rt_log_dropped(void);
+
+/**
+ * rt_log_ssl_error: ERR_print_errors_cb callback; logs each queued
+ * OpenSSL error line with log_error. Always returns 1 (keep going).
+ */
+int rt_log_ssl_error(const char *str, size_t len, void *u);
+
+#define log_info(...)  rt_log_printf(RT_LOG_STDOUT, __VA_ARGS__)
+#define log_error(...) rt_log_printf(RT_LOG_STDERR, __VA_ARGS__)
+
+#endif // RT_LOG_H
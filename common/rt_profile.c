@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <alloca.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#ifdef __QNX__
+#include <sys/neutrino.h>
+#else
+#include <dirent.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "rt_profile.h"
+#include "config_file.h"
+#include "rt_log.h"
+
+#define DEFAULT_PRIORITY          60
+#define DEFAULT_PREFAULT_STACK_KB 256
+#define DEFAULT_PREFAULT_HEAP_KB  4096
+#define STACK_HEADROOM            (64 * 1024)   // above the prefaulted part
+#define MAX_PREFAULT_KB           (256 * 1024)
+#ifdef CPU_SETSIZE
+#define MAX_CPU                   (CPU_SETSIZE - 1)
+#else
+#define MAX_CPU                   31              // QNX runmask width
+#endif
+
+static long page_size(void)
+{
+    long ps = sysconf(_SC_PAGESIZE);
+    return ps > 0 ? ps : 4096;
+}
+
+// ============================================================
+// CONFIGURATION
+// ============================================================
+
+int rt_profile_load(const char *path, RtProfile *p)
+{
+    const ConfigKey keys[] = {
+        { "priority",          0,  255,             &p->priority,    NULL },
+        { "cpu",               -1, MAX_CPU,         &p->cpu,         NULL },
+        { "isolate",           0,  1,               &p->isolate,     NULL },
+        { "lock_memory",       0,  1,               &p->lock_memory, NULL },
+        { "prefault_stack_kb", 0,  MAX_PREFAULT_KB, NULL, &p->prefault_stack_kb },
+        { "prefault_heap_kb",  0,  MAX_PREFAULT_KB, NULL, &p->prefault_heap_kb },
+    };
+
+    p->priority = DEFAULT_PRIORITY;
+    p->cpu = -1;
+    p->isolate = 0;
+    p->lock_memory = 1;
+    p->prefault_stack_kb = DEFAULT_PREFAULT_STACK_KB;
+    p->prefault_heap_kb = DEFAULT_PREFAULT_HEAP_KB;
+
+    return config_file_load(path, "RT", keys, sizeof(keys) / sizeof(keys[0]));
+}
+
+// ============================================================
+// PROCESS SETUP
+// ============================================================
+
+void rt_profile_prefault(void *buf, size_t len)
+{
+    volatile char *c = buf;
+    long ps = page_size();
+
+    for (size_t off = 0; off < len; off += (size_t)ps)
+        c[off] = c[off];
+    if (len)
+        c[len - 1] = c[len - 1];
+}
+
+#ifndef __QNX__
+// Is cpu listed in the kernel's isolcpus set ("1,3-5")?
+static int kernel_isolated(int cpu)
+{
+    char buf[256];
+    FILE *f = fopen("/sys/devices/system/cpu/isolated", "r");
+    int found = 0;
+
+    if (!f)
+        return 0;
+    if (fgets(buf, sizeof(buf), f)) {
+        for (char *tok = strtok(buf, ",\n"); tok && !found; tok = strtok(NULL, ",\n")) {
+            int lo, hi;
+            int n = sscanf(tok, "%d-%d", &lo, &hi);
+            if (n == 1) hi = lo;
+            found = n >= 1 && cpu >= lo && cpu <= hi;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+// Moves every thread the process has so far off cpu; threads created
+// later inherit the reduced mask from their creator.
+static void isolate_cpu(int cpu)
+{
+    cpu_set_t mask;
+    DIR *dir;
+    struct dirent *de;
+    int moved = 0;
+
+    if (sched_getaffinity(0, sizeof(mask), &mask) != 0)
+        return;
+    CPU_CLR(cpu, &mask);
+    if (CPU_COUNT(&mask) == 0) {
+        log_error("[RT] CPU %d is the only CPU; not isolating\n", cpu);
+        return;
+    }
+
+    dir = opendir("/proc/self/task");
+    if (dir) {
+        while ((de = readdir(dir)) != NULL) {
+            pid_t tid = (pid_t)atoi(de->d_name);
+            if (tid > 0 && sched_setaffinity(tid, sizeof(mask), &mask) == 0)
+                moved++;
+        }
+        closedir(dir);
+    }
+    if (moved == 0 && sched_setaffinity(0, sizeof(mask), &mask) == 0)
+        moved = 1;
+
+    log_info("[RT] Isolated CPU %d for the poll loop (%d thread%s moved)%s\n", cpu, moved,
+             moved == 1 ? "" : "s",
+             kernel_isolated(cpu) ? "" : "; add it to isolcpus= to keep the kernel off it too");
+}
+#endif
+
+void rt_profile_apply_process(RtProfile *p)
+{
+#ifndef __QNX__
+    cpu_set_t allowed;
+    if (p->cpu >= 0 && sched_getaffinity(0, sizeof(allowed), &allowed) == 0 &&
+        !CPU_ISSET(p->cpu, &allowed)) {
+        log_error("[RT] CPU %d is not available to this process; not pinning\n", p->cpu);
+        p->cpu = -1;
+    }
+#endif
+
+#ifdef __GLIBC__
+    // Keep freed memory in the heap and serve large blocks from it too,
+    // so prefaulted pages are reused instead of being unmapped
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+#endif
+
+    if (p->lock_memory) {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+            log_error("[RT] mlockall failed: %s (memory stays pageable)\n", strerror(errno));
+        else
+            log_info("[RT] Process memory locked\n");
+    }
+
+    if (p->prefault_heap_kb) {
+        size_t len = (size_t)p->prefault_heap_kb * 1024u;
+        void *heap = malloc(len);
+        if (heap) {
+            rt_profile_prefault(heap, len);
+            free(heap);
+        }
+    }
+
+    if (p->isolate && p->cpu >= 0) {
+#ifdef __QNX__
+        log_error("[RT] isolate=1 is not supported on QNX; use adaptive partitioning\n");
+#else
+        isolate_cpu(p->cpu);
+#endif
+    }
+}
+
+// ============================================================
+// RT THREAD
+// ============================================================
+
+void rt_profile_thread_attr(const RtProfile *p, pthread_attr_t *attr)
+{
+    // Prefaulted part plus headroom, not the default: memory is locked
+    size_t want = (size_t)p->prefault_stack_kb * 1024u + STACK_HEADROOM;
+    if (want < (size_t)RT_WORKER_STACK_KB * 1024u)
+        want = (size_t)RT_WORKER_STACK_KB * 1024u;
+    pthread_attr_setstacksize(attr, want);
+
+    if (p->priority > 0) {
+        struct sched_param sp;
+        int lo = sched_get_priority_min(SCHED_FIFO);
+        int hi = sched_get_priority_max(SCHED_FIFO);
+
+        memset(&sp, 0, sizeof(sp));
+        sp.sched_priority = p->priority < lo ? lo : p->priority > hi ? hi : p->priority;
+        if (sp.sched_priority != p->priority)
+            log_error("[RT] priority %d out of range, using %d\n", p->priority, sp.sched_priority);
+
+        pthread_attr_setinheritsched(attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(attr, SCHED_FIFO);
+        pthread_attr_setschedparam(attr, &sp);
+    }
+
+#if !defined(__QNX__) && defined(__GLIBC__)
+    if (p->cpu >= 0) {
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        CPU_SET(p->cpu, &mask);
+        pthread_attr_setaffinity_np(attr, sizeof(mask), &mask);
+    }
+#endif
+}
+
+void rt_profile_worker_attr(pthread_attr_t *attr)
+{
+    pthread_attr_setstacksize(attr, (size_t)RT_WORKER_STACK_KB * 1024u);
+}
+
+// Touches the next 'len' bytes of stack below the caller; noinline so the
+// frame, and with it the alloca, is gone when it returns
+static __attribute__((noinline)) void prefault_stack(size_t len)
+{
+    char *buf = alloca(len);
+    rt_profile_prefault(buf, len);
+    __asm__ __volatile__("" : : "r"(buf) : "memory");
+}
+
+void rt_profile_enter_thread(const RtProfile *p)
+{
+#ifdef __QNX__
+    if (p->cpu >= 0 && p->cpu < 32 &&
+        ThreadCtl(_NTO_TCTL_RUNMASK, (void *)(uintptr_t)(1u << p->cpu)) == -1)
+        log_error("[RT] Pinning to CPU %d failed: %s\n", p->cpu, strerror(errno));
+#endif
+
+    if (p->prefault_stack_kb)
+        prefault_stack((size_t)p->prefault_stack_kb * 1024u);
+
+    // Report what the OS actually granted
+    {
+        struct sched_param sp;
+        int policy = SCHED_OTHER;
+        int cpu = -1;
+
+        memset(&sp, 0, sizeof(sp));
+        pthread_getschedparam(pthread_self(), &policy, &sp);
+#if !defined(__QNX__) && defined(__GLIBC__)
+        cpu_set_t mask;
+        if (pthread_getaffinity_np(pthread_self(), sizeof(mask), &mask) == 0 && CPU_COUNT(&mask) == 1)
+            for (int c = 0; c < CPU_SETSIZE && cpu < 0; c++)
+                if (CPU_ISSET(c, &mask))
+                    cpu = c;
+#else
+        cpu = p->cpu;
+#endif
+        char where[16] = "any CPU";
+        if (cpu >= 0)
+            snprintf(where, sizeof(where), "CPU %d", cpu);
+        log_info("[RT] Poll thread: %s priority %d, %s, stack prefault %u KB\n",
+                 policy == SCHED_FIFO ? "SCHED_FIFO" : policy == SCHED_RR ? "SCHED_RR" : "SCHED_OTHER",
+                 sp.sched_priority, where, p->prefault_stack_kb);
+    }
+}
+
+void rt_profile_faults(RtFaults *out)
+{
+#ifdef RUSAGE_THREAD
+    struct rusage ru;
+    if (getrusage(RUSAGE_THREAD, &ru) == 0) {
+        out->major = (uint64_t)ru.ru_majflt;
+        out->minor = (uint64_t)ru.ru_minflt;
+        return;
+    }
+#endif
+    out->major = 0;
+    out->minor = 0;
+}
@@ -0,0 +1,88 @@
+#ifndef RT_PROFILE_H
+#define RT_PROFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// ============================================================
+// REAL-TIME EXECUTION PROFILE
+// ============================================================
+//
+// Scheduling, CPU placement and memory settings for the acquisition
+// thread, read from config/rt.conf (key=value). The same profile is
+// applied on QNX and Linux (stock or PREEMPT_RT). Each setting that the
+// OS refuses, e.g. SCHED_FIFO or mlockall without privileges, is logged
+// and skipped; the server always starts.
+
+#define RT_PROFILE_CONFIG "config/rt.conf"
+#define RT_WORKER_STACK_KB 256   // every thread but the poll loop (deepest frame ~10 KB plus TLS)
+
+/**
+ * RtProfile: Parsed config/rt.conf.
+ */
+typedef struct {
+    int priority;               // SCHED_FIFO priority, 0 = inherit default scheduling
+    int cpu;                    // core the RT thread is pinned to, -1 = any
+    int isolate;                // move every other thread of the process off 'cpu'
+    int lock_memory;            // mlockall(MCL_CURRENT | MCL_FUTURE)
+    uint32_t prefault_stack_kb; // RT stack touched before the loop starts
+    uint32_t prefault_heap_kb;  // heap touched and kept (malloc trimming disabled)
+} RtProfile;
+
+/**
+ * RtFaults: Page faults taken by the calling thread.
+ */
+typedef struct {
+    uint64_t major;
+    uint64_t minor;
+} RtFaults;
+
+/**
+ * rt_profile_load: Fills p with defaults (priority 60, no affinity,
+ * memory locked, 256 KB stack, 4 MB heap), then applies path. A missing
+ * file keeps the defaults. Returns 0, or -1 after logging a bad line
+ * (the remaining lines are still applied).
+ */
+int rt_profile_load(const char *path, RtProfile *p);
+
+/**
+ * rt_profile_apply_process: Process-wide part of the profile: memory
+ * locking, malloc tuning, heap prefault and core isolation of the
+ * threads that already exist. Call before the RT thread and before
+ * allocating its buffers. A cpu the process may not use is reset to -1.
+ */
+void rt_profile_apply_process(RtProfile *p);
+
+/**
+ * rt_profile_thread_attr: Sets policy, priority, affinity and a stack
+ * of the prefaulted size plus headroom on attr.
+ */
+void rt_profile_thread_attr(const RtProfile *p, pthread_attr_t *attr);
+
+/**
+ * rt_profile_worker_attr: Gives a non-RT thread a RT_WORKER_STACK_KB
+ * stack instead of the 8 MB default, which mlockall(MCL_FUTURE) would
+ * otherwise lock and fault in whole for every thread.
+ */
+void rt_profile_worker_attr(pthread_attr_t *attr);
+
+/**
+ * rt_profile_enter_thread: First call inside the RT thread: pins it
+ * where the attribute could not and prefaults its stack.
+ */
+void rt_profile_enter_thread(const RtProfile *p);
+
+/**
+ * rt_profile_prefault: Touches every page of [buf, buf + len) so the
+ * RT loop does not take the first-use faults.
+ */
+void rt_profile_prefault(void *buf, size_t len);
+
+/**
+ * rt_profile_faults: Major/minor page faults of the calling thread
+ * (zeros where the OS does not report per-thread usage).
+ */
+void rt_profile_faults(RtFaults *out);
+
+#endif // RT_PROFILE_H
@@ -0,0 +1,161 @@
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <openssl/ssl.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#else
+#include <openssl/hmac.h>
+#endif
+#include "tls_session.h"
+
+// Ties cached sessions to this server (required with client certificates)
+#define SESSION_ID_CONTEXT "sentinel-rt"
+
+typedef struct {
+    unsigned char name[16];     // sent in the clear in each ticket
+    unsigned char aes_key[32];  // AES-256-CBC
+    unsigned char hmac_key[32]; // HMAC-SHA256
+    time_t created;
+    int valid;
+} TicketKey;
+
+// keys[current] seals new tickets; the other one only opens old ones
+static pthread_mutex_t key_lock = PTHREAD_MUTEX_INITIALIZER;
+static TicketKey keys[2];
+static int current = 0;
+
+static int new_key(TicketKey *k, time_t now)
+{
+    if (RAND_bytes(k->name, sizeof(k->name)) != 1 ||
+        RAND_bytes(k->aes_key, sizeof(k->aes_key)) != 1 ||
+        RAND_bytes(k->hmac_key, sizeof(k->hmac_key)) != 1) {
+        k->valid = 0;
+        return -1;
+    }
+    k->created = now;
+    k->valid = 1;
+    return 0;
+}
+
+/*
+ * Key to seal a ticket with (enc) or the one named by a ticket (!enc).
+ * Returns 1 for the current key, 2 for the previous one (the ticket
+ * should be renewed), 0 if there is none.
+ */
+static int pick_key(int enc, const unsigned char *name, TicketKey *out)
+{
+    time_t now = time(NULL);
+    int rc = 0;
+
+    pthread_mutex_lock(&key_lock);
+    if (now - keys[current].created >= TLS_TICKET_ROTATE_S) {
+        TicketKey fresh;
+        if (new_key(&fresh, now) == 0) {
+            current ^= 1;
+            keys[current] = fresh;
+        }
+    }
+
+    if (enc) {
+        if (keys[current].valid) {
+            *out = keys[current];
+            rc = 1;
+        }
+    } else {
+        for (int i = 0; i < 2; i++) {
+            const TicketKey *k = &keys[current ^ i];
+            if (k->valid && memcmp(k->name, name, sizeof(k->name)) == 0) {
+                *out = *k;
+                rc = i == 0 ? 1 : 2;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&key_lock);
+    return rc;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+static int ticket_key_cb(SSL *ssl, unsigned char key_name[16], unsigned char iv[EVP_MAX_IV_LENGTH],
+                         EVP_CIPHER_CTX *cctx, EVP_MAC_CTX *hctx, int enc)
+{
+    OSSL_PARAM params[2];
+    TicketKey k;
+    int rc;
+
+    params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, "SHA256", 0);
+    params[1] = OSSL_PARAM_construct_end();
+
+    rc = pick_key(enc, key_name, &k);
+    if (rc == 0)
+        return 0;   // no key: no ticket / full handshake
+
+    if (enc) {
+        memcpy(key_name, k.name, sizeof(k.name));
+        if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1 ||
+            !EVP_EncryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, k.aes_key, iv))
+            rc = -1;
+    } else if (!EVP_DecryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, k.aes_key, iv)) {
+        rc = -1;
+    } else if (SSL_version(ssl) >= TLS1_3_VERSION) {
+        rc = 2;     // TLS 1.3 tickets are single-use: always hand out the next one
+    }
+    if (rc > 0 && !EVP_MAC_init(hctx, k.hmac_key, sizeof(k.hmac_key), params))
+        rc = -1;
+
+    OPENSSL_cleanse(&k, sizeof(k));
+    return rc;
+}
+#else
+static int ticket_key_cb(SSL *ssl, unsigned char key_name[16], unsigned char *iv,
+                         EVP_CIPHER_CTX *cctx, HMAC_CTX *hctx, int enc)
+{
+    TicketKey k;
+    int rc;
+
+    rc = pick_key(enc, key_name, &k);
+    if (rc == 0)
+        return 0;
+
+    if (enc) {
+        memcpy(key_name, k.name, sizeof(k.name));
+        if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1 ||
+            !EVP_EncryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, k.aes_key, iv))
+            rc = -1;
+    } else if (!EVP_DecryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, k.aes_key, iv)) {
+        rc = -1;
+    } else if (SSL_version(ssl) >= TLS1_3_VERSION) {
+        rc = 2;     // TLS 1.3 tickets are single-use: always hand out the next one
+    }
+    if (rc > 0 && !HMAC_Init_ex(hctx, k.hmac_key, sizeof(k.hmac_key), EVP_sha256(), NULL))
+        rc = -1;
+
+    OPENSSL_cleanse(&k, sizeof(k));
+    return rc;
+}
+#endif
+
+int tls_session_setup(SSL_CTX *ctx)
+{
+    int rc;
+
+    SSL_CTX_set_session_id_context(ctx, (const unsigned char *)SESSION_ID_CONTEXT,
+                                   sizeof(SESSION_ID_CONTEXT) - 1);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx, TLS_SESSION_CACHE_SIZE);
+    SSL_CTX_set_timeout(ctx, TLS_SESSION_LIFETIME_S);
+
+    pthread_mutex_lock(&key_lock);
+    rc = new_key(&keys[current], time(NULL));
+    pthread_mutex_unlock(&key_lock);
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, ticket_key_cb);
+#else
+    SSL_CTX_set_tlsext_ticket_key_cb(ctx, ticket_key_cb);
+#endif
+    return rc;
+}
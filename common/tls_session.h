@@ -0,0 +1,38 @@
+#ifndef TLS_SESSION_H
+#define TLS_SESSION_H
+
+#include <openssl/ssl.h>
+
+// ============================================================
+// TLS SESSION RESUMPTION
+// ============================================================
+//
+// A full mTLS handshake (key exchange plus signing and verifying two
+// certificates) is the most expensive thing the server does. A client
+// that reconnects can skip most of it, in either of two ways:
+//
+// - Stateless tickets (TLS 1.3, and TLS 1.2 clients that ask for them):
+//   the server encrypts the session into a ticket the client keeps. The
+//   ticket key lives only in memory. It is replaced every
+//   TLS_TICKET_ROTATE_S; tickets sealed with the previous key are still
+//   accepted and re-issued under the new one, so a ticket lives at most
+//   two rotations and a server restart invalidates them all.
+// - Session-ID cache (TLS 1.2 clients without tickets): up to
+//   TLS_SESSION_CACHE_SIZE sessions are kept in the SSL_CTX.
+//
+// Either way resumption is allowed for TLS_SESSION_LIFETIME_S after the
+// full handshake, and the session keeps the client certificate, so
+// authorize_client sees the same identity.
+
+#define TLS_SESSION_CACHE_SIZE  1024
+#define TLS_SESSION_LIFETIME_S  7200
+#define TLS_TICKET_ROTATE_S     3600
+
+/**
+ * tls_session_setup: Enables the session cache and rotating ticket keys
+ * on a server context. Returns 0, or -1 if no ticket key could be made
+ * (full handshakes still work).
+ */
+int tls_session_setup(SSL_CTX *ctx);
+
+#endif // TLS_SESSION_H
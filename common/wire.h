@@ -0,0 +1,288 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ============================================================
+// BINARY WIRE FORMAT (version 1)
+// ============================================================
+//
+// A session starts in text mode, where replies are free text and each
+// one ends with EOM (0x03). The command "protocol binary [version]
+// [delta]" switches the server's replies to length-prefixed frames, and
+// "protocol text" switches back. Commands are text lines in both modes.
+// Shared by the server (protocol.c, telemetry.c), ims_client and, in
+// Python, clients/dashboard.py.
+//
+// Frame (all integers little-endian, floats IEEE-754 binary32):
+//   0   u32  length of the rest of the frame (WIRE_HEADER_SIZE - 4 + payload)
+//   4   u8   version (WIRE_VERSION)
+//   5   u8   type (WireType)
+//   6   u16  unit: index in list_units order, WIRE_NO_UNIT if none
+//   8   u64  seq: per-unit window number (SNAPSHOT/DELTA), alert number
+//             (ALERT), else 0
+//   16  u64  time: Unix ms of the window, alert or first history point,
+//             else 0
+//   24  payload
+//
+// Payloads:
+//   HELLO     u8 version, u8 flags (WIRE_FLAG_*), u16 unit count
+//   TEXT      UTF-8 text, a piece of a reply
+//   END       empty: the reply is complete (text mode's EOM)
+//   UNITS     u16 first unit index, u16 count, then per unit u8 length
+//             and the id bytes (list_units)
+//   SNAPSHOT  u8 status, u8[3] zero, then WIRE_SNAPSHOT_VALUES f32:
+//             vibration, sound (%), temperature (C), current (A) levels,
+//             vibration RMS, peak (max |x|), crest factor, kurtosis,
+//             skewness
+//   DELTA     a SNAPSHOT given as changes to the previous SNAPSHOT or
+//             DELTA of the same unit on this stream (seq may skip):
+//             u8 status, u8 zero, u16 mask (bit i = value i changed),
+//             then per set bit the varint of (bits XOR previous bits).
+//             Only sent if "delta" was negotiated; a stream starts with
+//             a SNAPSHOT and at least one frame in WIRE_DELTA_KEYFRAME is
+//             a full SNAPSHOT
+//   HISTORY   u8 channel (SensorChannel), u8 tier, u16 zero, u32 point
+//             width in s, u32 count, then count points of u32 start
+//             (Unix s), u32 windows, f32 min, f32 max, f32 avg.
+//             A long history comes as several frames
+//   ALERT     u8 from, u8 to (HealthStatus), u16 zero, u32 changes held
+//             back, u32 message id, u16 message length, message bytes
+//
+// Varints are unsigned LEB128: 7 bits per byte, low group first, high
+// bit set on all but the last byte. Receivers skip frame types they do
+// not know and may drop the connection on a frame over WIRE_MAX_FRAME.
+
+#define WIRE_VERSION          1
+#define WIRE_HEADER_SIZE      24
+#define WIRE_MAX_FRAME        (128 * 1024)
+#define WIRE_NO_UNIT          0xFFFFu
+#define WIRE_FLAG_DELTA       0x01
+#define WIRE_DELTA_KEYFRAME   60
+
+#define WIRE_SNAPSHOT_VALUES  9
+#define WIRE_SNAPSHOT_SIZE    (4 + 4 * WIRE_SNAPSHOT_VALUES)
+#define WIRE_DELTA_MAX        (4 + 5 * WIRE_SNAPSHOT_VALUES)
+#define WIRE_HISTORY_HEAD     12
+#define WIRE_HISTORY_POINT    20
+#define WIRE_UNITS_PER_FRAME  256
+
+typedef enum {
+    WIRE_HELLO = 1,
+    WIRE_TEXT,
+    WIRE_END,
+    WIRE_UNITS,
+    WIRE_SNAPSHOT,
+    WIRE_DELTA,
+    WIRE_HISTORY,
+    WIRE_ALERT
+} WireType;
+
+/**
+ * WireSnapshot: A decoded SNAPSHOT (the base a DELTA applies to).
+ */
+typedef struct {
+    uint8_t status;
+    float values[WIRE_SNAPSHOT_VALUES];
+} WireSnapshot;
+
+/**
+ * WireHeader: A decoded frame header. len is the payload length.
+ */
+typedef struct {
+    uint32_t len;
+    uint8_t version;
+    uint8_t type;
+    uint16_t unit;
+    uint64_t seq;
+    uint64_t t_ms;
+} WireHeader;
+
+// ============================================================
+// ENCODING
+// ============================================================
+
+static inline void wire_put_u16(unsigned char *p, uint16_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static inline void wire_put_u32(unsigned char *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static inline void wire_put_u64(unsigned char *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+        p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static inline uint32_t wire_f32_bits(float v)
+{
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+static inline void wire_put_f32(unsigned char *p, float v)
+{
+    wire_put_u32(p, wire_f32_bits(v));
+}
+
+static inline size_t wire_put_varint(unsigned char *p, uint32_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (unsigned char)v;
+    return n;
+}
+
+/**
+ * wire_header: Writes the header of a frame with payload_len bytes of
+ * payload to p (WIRE_HEADER_SIZE bytes).
+ */
+static inline void wire_header(unsigned char *p, WireType type, uint16_t unit,
+                               uint64_t seq, uint64_t t_ms, size_t payload_len)
+{
+    wire_put_u32(p, (uint32_t)(WIRE_HEADER_SIZE - 4 + payload_len));
+    p[4] = WIRE_VERSION;
+    p[5] = (unsigned char)type;
+    wire_put_u16(p + 6, unit);
+    wire_put_u64(p + 8, seq);
+    wire_put_u64(p + 16, t_ms);
+}
+
+/**
+ * wire_snapshot: Writes a SNAPSHOT payload (WIRE_SNAPSHOT_SIZE bytes).
+ */
+static inline void wire_snapshot(unsigned char *p, const WireSnapshot *s)
+{
+    memset(p, 0, 4);
+    p[0] = s->status;
+    for (int i = 0; i < WIRE_SNAPSHOT_VALUES; i++)
+        wire_put_f32(p + 4 + 4 * i, s->values[i]);
+}
+
+/**
+ * wire_delta: Writes the DELTA payload taking prev to cur.
+ * Returns its length (at most WIRE_DELTA_MAX).
+ */
+static inline size_t wire_delta(unsigned char *p, const WireSnapshot *prev, const WireSnapshot *cur)
+{
+    size_t n = 4;
+    uint16_t mask = 0;
+
+    for (int i = 0; i < WIRE_SNAPSHOT_VALUES; i++) {
+        uint32_t x = wire_f32_bits(cur->values[i]) ^ wire_f32_bits(prev->values[i]);
+        if (x) {
+            mask |= (uint16_t)(1u << i);
+            n += wire_put_varint(p + n, x);
+        }
+    }
+    p[0] = cur->status;
+    p[1] = 0;
+    wire_put_u16(p + 2, mask);
+    return n;
+}
+
+// ============================================================
+// DECODING
+// ============================================================
+
+static inline uint16_t wire_get_u16(const unsigned char *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t wire_get_u32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t wire_get_u64(const unsigned char *p)
+{
+    return (uint64_t)wire_get_u32(p) | ((uint64_t)wire_get_u32(p + 4) << 32);
+}
+
+static inline float wire_get_f32(const unsigned char *p)
+{
+    uint32_t bits = wire_get_u32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+/**
+ * wire_parse_header: Decodes the header at the start of buf (avail
+ * bytes). Returns the whole frame's size once it is all in buf, 0 if
+ * more bytes are needed, -1 if the length is invalid.
+ */
+static inline long wire_parse_header(const unsigned char *buf, size_t avail, WireHeader *h)
+{
+    if (avail < WIRE_HEADER_SIZE)
+        return 0;
+    uint32_t rest = wire_get_u32(buf);
+    if (rest < WIRE_HEADER_SIZE - 4 || rest > WIRE_MAX_FRAME)
+        return -1;
+    h->len = rest - (WIRE_HEADER_SIZE - 4);
+    h->version = buf[4];
+    h->type = buf[5];
+    h->unit = wire_get_u16(buf + 6);
+    h->seq = wire_get_u64(buf + 8);
+    h->t_ms = wire_get_u64(buf + 16);
+    return avail >= (size_t)rest + 4 ? (long)rest + 4 : 0;
+}
+
+/**
+ * wire_parse_snapshot: Decodes a SNAPSHOT payload. Returns 0, or -1 if
+ * it is too short.
+ */
+static inline int wire_parse_snapshot(const unsigned char *p, size_t len, WireSnapshot *out)
+{
+    if (len < WIRE_SNAPSHOT_SIZE)
+        return -1;
+    out->status = p[0];
+    for (int i = 0; i < WIRE_SNAPSHOT_VALUES; i++)
+        out->values[i] = wire_get_f32(p + 4 + 4 * i);
+    return 0;
+}
+
+/**
+ * wire_apply_delta: Updates base (the previous snapshot) with a DELTA
+ * payload. Returns 0, or -1 if the payload is malformed.
+ */
+static inline int wire_apply_delta(const unsigned char *p, size_t len, WireSnapshot *base)
+{
+    size_t n = 4;
+
+    if (len < 4)
+        return -1;
+    uint16_t mask = wire_get_u16(p + 2);
+    for (int i = 0; i < WIRE_SNAPSHOT_VALUES; i++) {
+        if (!(mask & (1u << i)))
+            continue;
+        uint32_t x = 0;
+        for (int shift = 0;; shift += 7) {
+            if (n >= len || shift > 28)
+                return -1;
+            uint8_t b = p[n++];
+            x |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                break;
+        }
+        uint32_t bits = wire_f32_bits(base->values[i]) ^ x;
+        memcpy(&base->values[i], &bits, sizeof(bits));
+    }
+    base->status = p[0];
+    return 0;
+}
+
+#endif // WIRE_H
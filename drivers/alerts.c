@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include "alerts.h"
+#include "rules.h"
+#include "blackbox.h"
+
+_Static_assert((ALERT_RING_SIZE & (ALERT_RING_SIZE - 1)) == 0, "ring size must be a power of two");
+
+#define ALERT_REFILL_MS ((uint64_t)ALERT_RATE_REFILL_S * 1000u)
+
+// Published alerts: one producer (store thread), any number of session
+// readers. Both sides are ordinary threads, so a mutex and a condition
+// variable are enough.
+static pthread_mutex_t ring_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ring_cond;
+static pthread_once_t ring_once = PTHREAD_ONCE_INIT;
+static AlertEvent ring[ALERT_RING_SIZE];
+static uint64_t last_seq = 0;
+static int watch_fd[ALERT_WATCH_MAX];   // written on every publish
+static int watch_count = 0;
+
+static void ring_init(void)
+{
+    pthread_condattr_t ca;
+
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&ring_cond, &ca);
+    pthread_condattr_destroy(&ca);
+}
+
+// ============================================================
+// ENGINE
+// ============================================================
+
+void alert_unit_init(AlertUnitState *s, HealthStatus current)
+{
+    s->level = current;
+    s->announced = current;
+    s->tokens = ALERT_RATE_BURST;
+    s->suppressed = 0;
+    s->refill_ms = 0;
+}
+
+int alert_evaluate(AlertUnitState *s, const EquipmentHealth *h, AlertEvent *out)
+{
+    if (s->refill_ms == 0 || h->window_end_ms < s->refill_ms) {
+        s->refill_ms = h->window_end_ms;
+    } else if (s->tokens < ALERT_RATE_BURST) {
+        uint64_t earned = (h->window_end_ms - s->refill_ms) / ALERT_REFILL_MS;
+        if (earned > 0) {
+            s->tokens = earned >= ALERT_RATE_BURST - s->tokens ? ALERT_RATE_BURST
+                                                                : s->tokens + (uint32_t)earned;
+            s->refill_ms += earned * ALERT_REFILL_MS;
+        }
+    } else {
+        s->refill_ms = h->window_end_ms;
+    }
+
+    if (h->status != s->level) {
+        s->level = h->status;
+        if (s->tokens == 0)
+            s->suppressed++;
+    }
+    if (s->level == s->announced || s->tokens == 0)
+        return 0;
+
+    memset(out, 0, sizeof(*out));
+    out->t_ms = h->window_end_ms;
+    memcpy(out->unit_id, h->unit_id, MAX_ID_LENGTH);
+    out->from = s->announced;
+    out->to = s->level;
+    out->message_id = s->level == HEALTH_HEALTHY ? RULE_MESSAGE_NOMINAL : h->message_id;
+    out->suppressed = s->suppressed;
+
+    s->announced = s->level;
+    s->suppressed = 0;
+    s->tokens--;
+    return 1;
+}
+
+// ============================================================
+// PUBLISHING
+// ============================================================
+
+static void log_alert(const AlertEvent *e)
+{
+    char held[48] = "";
+
+    if (e->suppressed)
+        snprintf(held, sizeof(held), " (%u change%s held back)", e->suppressed,
+                 e->suppressed == 1 ? "" : "s");
+
+    if (e->to == HEALTH_CRITICAL)
+        blackbox_log(BLACKBOX_ALERT, e->unit_id, (int64_t)e->t_ms, "%s%s",
+                     rules_message(e->message_id), held);
+    else if (e->to == HEALTH_WARNING)
+        blackbox_log(BLACKBOX_EVENT, e->unit_id, (int64_t)e->t_ms, "%s %s: %s%s",
+                     e->from == HEALTH_CRITICAL ? "Critical condition eased to" : "Entered",
+                     health_to_string(e->to), rules_message(e->message_id), held);
+    else
+        blackbox_log(BLACKBOX_EVENT, e->unit_id, (int64_t)e->t_ms,
+                     "%s condition cleared (now %s)%s",
+                     e->from == HEALTH_CRITICAL ? "Critical" : "Warning",
+                     health_to_string(e->to), held);
+}
+
+void alerts_publish(AlertEvent *e)
+{
+    pthread_once(&ring_once, ring_init);
+
+    pthread_mutex_lock(&ring_lock);
+    e->seq = ++last_seq;
+    ring[e->seq & (ALERT_RING_SIZE - 1)] = *e;
+    pthread_cond_broadcast(&ring_cond);
+    for (int i = 0; i < watch_count; i++) {
+        uint64_t one = 1;
+        ssize_t n = write(watch_fd[i], &one, sizeof(one));
+        (void)n;   // a full pipe already has a wakeup pending
+    }
+    pthread_mutex_unlock(&ring_lock);
+
+    log_alert(e);
+}
+
+int alerts_wait(uint64_t after_seq, int timeout_ms, uint64_t *latest)
+{
+    struct timespec deadline;
+    int rc;
+
+    pthread_once(&ring_once, ring_init);
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_nsec -= 1000000000L;
+        deadline.tv_sec++;
+    }
+
+    pthread_mutex_lock(&ring_lock);
+    while (last_seq <= after_seq) {
+        if (pthread_cond_timedwait(&ring_cond, &ring_lock, &deadline) == ETIMEDOUT)
+            break;
+    }
+    rc = last_seq > after_seq;
+    if (latest)
+        *latest = last_seq;
+    pthread_mutex_unlock(&ring_lock);
+    return rc;
+}
+
+int alerts_watch(int fd)
+{
+    int rc = -1;
+
+    pthread_mutex_lock(&ring_lock);
+    if (watch_count < ALERT_WATCH_MAX) {
+        watch_fd[watch_count++] = fd;
+        rc = 0;
+    }
+    pthread_mutex_unlock(&ring_lock);
+    return rc;
+}
+
+int alerts_read(uint64_t *cursor, AlertEvent *out, int max, uint64_t *missed)
+{
+    int n = 0;
+
+    pthread_mutex_lock(&ring_lock);
+    if (last_seq > ALERT_RING_SIZE && *cursor < last_seq - ALERT_RING_SIZE) {
+        if (missed)
+            *missed += last_seq - ALERT_RING_SIZE - *cursor;
+        *cursor = last_seq - ALERT_RING_SIZE;
+    }
+    while (n < max && *cursor < last_seq) {
+        (*cursor)++;
+        out[n++] = ring[*cursor & (ALERT_RING_SIZE - 1)];
+    }
+    pthread_mutex_unlock(&ring_lock);
+    return n;
+}
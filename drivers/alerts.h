@@ -0,0 +1,98 @@
+#ifndef ALERTS_H
+#define ALERTS_H
+
+#include <stdint.h>
+#include "sensors.h"
+
+// ============================================================
+// ALERT ENGINE (state transitions, rate-limited, pushed)
+// ============================================================
+//
+// An alert is a change of a unit's health level, not a window at that
+// level: entering WARNING or CRITICAL raises one alert, leaving it one
+// clear, however long the condition lasts and however many sessions are
+// watching. The manager's store thread feeds every published window to
+// alert_evaluate and hands what fires to alerts_publish, which records
+// it in the blackbox and in an in-memory ring that subscribers
+// (subscribe_alerts) wait on or are woken for through a watch fd, so a
+// push goes out as soon as the window is published instead of on a
+// session's next poll.
+//
+// Each unit has a token bucket of ALERT_RATE_BURST alerts, refilled by
+// one every ALERT_RATE_REFILL_S. A flapping unit that runs out keeps its
+// level tracked but announces nothing; once a token is back the next
+// window announces the level it has settled on, with the count of
+// changes that were held back.
+
+#define ALERT_RATE_BURST    5
+#define ALERT_RATE_REFILL_S 30
+#define ALERT_RING_SIZE     256    // alerts kept for subscribers (power of two)
+#define ALERT_WATCH_MAX     8
+
+/**
+ * AlertEvent: One announced level change of a unit.
+ */
+typedef struct {
+    uint64_t seq;             // 1, 2, ... since server start
+    uint64_t t_ms;            // window close, Unix ms
+    char unit_id[MAX_ID_LENGTH];
+    HealthStatus from;        // level last announced
+    HealthStatus to;          // level now
+    uint32_t message_id;      // rules_message() of the window (nominal on a clear)
+    uint32_t suppressed;      // changes held back by the rate limit before this one
+} AlertEvent;
+
+/**
+ * AlertUnitState: Engine state of one unit. Owned by the thread that
+ * calls alert_evaluate.
+ */
+typedef struct {
+    HealthStatus level;       // level of the last window
+    HealthStatus announced;   // level of the last alert
+    uint32_t tokens;
+    uint32_t suppressed;
+    uint64_t refill_ms;       // window time the bucket was last topped up
+} AlertUnitState;
+
+/**
+ * alert_unit_init: Starts a unit at 'current' (e.g. a level restored
+ * from a checkpoint) with a full bucket. Nothing fires for it.
+ */
+void alert_unit_init(AlertUnitState *s, HealthStatus current);
+
+/**
+ * alert_evaluate: Feeds one published window. Returns 1 and fills out
+ * (all but seq) when an alert fires, else 0.
+ */
+int alert_evaluate(AlertUnitState *s, const EquipmentHealth *h, AlertEvent *out);
+
+/**
+ * alerts_publish: Numbers e, logs it to the blackbox and wakes every
+ * subscriber. Not for the RT loop (formats and takes a lock).
+ */
+void alerts_publish(AlertEvent *e);
+
+/**
+ * alerts_wait: Sleeps until an alert after after_seq is published or
+ * timeout_ms passes. latest, if not NULL, gets the newest seq.
+ * Returns 1 if there are new alerts, 0 on timeout.
+ */
+int alerts_wait(uint64_t after_seq, int timeout_ms, uint64_t *latest);
+
+/**
+ * alerts_watch: Registers fd (a non-blocking eventfd or pipe) to be
+ * written 8 bytes on every publish, for event loops that cannot sleep in
+ * alerts_wait. At most ALERT_WATCH_MAX, kept for the life of the process.
+ * Returns 0, or -1 if the table is full.
+ */
+int alerts_watch(int fd);
+
+/**
+ * alerts_read: Copies up to max alerts after *cursor, oldest first, and
+ * advances the cursor. Alerts already overwritten in the ring are
+ * skipped and counted in *missed.
+ * Returns the number copied.
+ */
+int alerts_read(uint64_t *cursor, AlertEvent *out, int max, uint64_t *missed);
+
+#endif // ALERTS_H
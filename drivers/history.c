@@ -0,0 +1,256 @@
+#include <stdlib.h>
+#include <string.h>
+#include "history.h"
+#include "seqlock.h"
+
+/**
+ * HistoryAccum: Running aggregate of the open bucket of one tier.
+ * Private to the writer.
+ */
+typedef struct {
+    uint64_t bucket;           // bucket number + 1 (0 = nothing yet)
+    uint32_t windows;
+    double sum[CH_COUNT];
+    float min[CH_COUNT];
+    float max[CH_COUNT];
+} HistoryAccum;
+
+// Ring slots: id = bucket number + 1, so a zeroed slot is empty and a
+// slot left over from an earlier lap never matches the bucket asked for
+typedef struct {
+    uint64_t id;
+    uint32_t windows;
+    float avg[CH_COUNT];
+} SecondSlot;
+
+typedef struct {
+    uint64_t id;
+    uint32_t windows;
+    float min[CH_COUNT];
+    float max[CH_COUNT];
+    float avg[CH_COUNT];
+} RollupSlot;
+
+struct HistoryStore {
+    SeqLock seq;
+    HistoryAccum open[HISTORY_TIER_COUNT];
+    SecondSlot seconds[HISTORY_SECONDS];
+    RollupSlot minutes[HISTORY_MINUTES];
+    RollupSlot hours[HISTORY_HOURS];
+};
+
+static const struct {
+    uint32_t width_s;
+    uint32_t slots;
+} tiers[HISTORY_TIER_COUNT] = {
+    { 1,    HISTORY_SECONDS },
+    { 60,   HISTORY_MINUTES },
+    { 3600, HISTORY_HOURS },
+};
+
+// ============================================================
+// ALLOCATION
+// ============================================================
+
+HistoryStore* history_create(void)
+{
+    // Zeroing also pre-faults the pages before the RT loop touches them
+    HistoryStore *hs = calloc(1, sizeof(HistoryStore));
+    if (hs)
+        seqlock_init(&hs->seq);
+    return hs;
+}
+
+void history_destroy(HistoryStore *hs)
+{
+    free(hs);
+}
+
+uint32_t history_tier_seconds(HistoryTier tier)
+{
+    return tiers[tier].width_s;
+}
+
+uint32_t history_tier_span(HistoryTier tier)
+{
+    return tiers[tier].width_s * tiers[tier].slots;
+}
+
+// ============================================================
+// WRITER SIDE (polling_thread)
+// ============================================================
+
+static void accum_add(HistoryAccum *a, uint64_t bucket, const float level[CH_COUNT])
+{
+    if (a->bucket != bucket + 1) {
+        a->bucket = bucket + 1;
+        a->windows = 0;
+        for (int c = 0; c < CH_COUNT; c++) {
+            a->sum[c] = 0.0;
+            a->min[c] = level[c];
+            a->max[c] = level[c];
+        }
+    }
+
+    a->windows++;
+    for (int c = 0; c < CH_COUNT; c++) {
+        a->sum[c] += level[c];
+        if (level[c] < a->min[c]) a->min[c] = level[c];
+        if (level[c] > a->max[c]) a->max[c] = level[c];
+    }
+}
+
+static void rollup_store(RollupSlot *slot, const HistoryAccum *a)
+{
+    slot->id = a->bucket;
+    slot->windows = a->windows;
+    for (int c = 0; c < CH_COUNT; c++) {
+        slot->min[c] = a->min[c];
+        slot->max[c] = a->max[c];
+        slot->avg[c] = (float)(a->sum[c] / a->windows);
+    }
+}
+
+void history_add(HistoryStore *hs, uint64_t t_s, const float level[CH_COUNT])
+{
+    uint64_t sec = t_s;
+    uint64_t min = t_s / tiers[HISTORY_TIER_MINUTE].width_s;
+    uint64_t hour = t_s / tiers[HISTORY_TIER_HOUR].width_s;
+
+    accum_add(&hs->open[HISTORY_TIER_SECOND], sec, level);
+    accum_add(&hs->open[HISTORY_TIER_MINUTE], min, level);
+    accum_add(&hs->open[HISTORY_TIER_HOUR], hour, level);
+
+    // Write the open buckets through so readers see them while they fill
+    seqlock_write_begin(&hs->seq);
+    {
+        const HistoryAccum *a = &hs->open[HISTORY_TIER_SECOND];
+        SecondSlot *slot = &hs->seconds[sec % HISTORY_SECONDS];
+        slot->id = a->bucket;
+        slot->windows = a->windows;
+        for (int c = 0; c < CH_COUNT; c++)
+            slot->avg[c] = (float)(a->sum[c] / a->windows);
+    }
+    rollup_store(&hs->minutes[min % HISTORY_MINUTES], &hs->open[HISTORY_TIER_MINUTE]);
+    rollup_store(&hs->hours[hour % HISTORY_HOURS], &hs->open[HISTORY_TIER_HOUR]);
+    seqlock_write_end(&hs->seq);
+}
+
+// ============================================================
+// READER SIDE
+// ============================================================
+
+int history_read(HistoryStore *hs, HistoryTier tier, SensorChannel channel,
+                 uint64_t from_s, uint64_t to_s, HistoryPoint *out, int max)
+{
+    uint64_t width = tiers[tier].width_s;
+    uint64_t slots = tiers[tier].slots;
+    uint64_t first = (from_s + width - 1) / width;
+    uint64_t last = to_s / width;
+    unsigned s;
+    int n;
+
+    if (from_s > to_s || max <= 0 || (unsigned)channel >= CH_COUNT)
+        return 0;
+    if (last >= slots && first < last - slots + 1)
+        first = last - slots + 1;
+
+    do {
+        s = seqlock_read_begin(&hs->seq);
+        n = 0;
+        for (uint64_t b = first; b <= last && n < max; b++) {
+            HistoryPoint *p = &out[n];
+
+            if (tier == HISTORY_TIER_SECOND) {
+                const SecondSlot *slot = &hs->seconds[b % slots];
+                if (slot->id != b + 1)
+                    continue;
+                p->min = p->max = p->avg = slot->avg[channel];
+                p->windows = slot->windows;
+            } else {
+                const RollupSlot *slot = tier == HISTORY_TIER_MINUTE ? &hs->minutes[b % slots]
+                                                                     : &hs->hours[b % slots];
+                if (slot->id != b + 1)
+                    continue;
+                p->min = slot->min[channel];
+                p->max = slot->max[channel];
+                p->avg = slot->avg[channel];
+                p->windows = slot->windows;
+            }
+            p->t_s = b * width;
+            n++;
+        }
+    } while (seqlock_read_retry(&hs->seq, s));
+
+    return n;
+}
+
+// ============================================================
+// CHECKPOINT IMAGE
+// ============================================================
+
+size_t history_image_size(void)
+{
+    return sizeof(((HistoryStore *)0)->seconds) + sizeof(((HistoryStore *)0)->minutes) +
+           sizeof(((HistoryStore *)0)->hours);
+}
+
+void history_save(HistoryStore *hs, void *image)
+{
+    uint8_t *p = image;
+    unsigned s;
+
+    do {
+        s = seqlock_read_begin(&hs->seq);
+        memcpy(p, hs->seconds, sizeof(hs->seconds));
+        memcpy(p + sizeof(hs->seconds), hs->minutes, sizeof(hs->minutes));
+        memcpy(p + sizeof(hs->seconds) + sizeof(hs->minutes), hs->hours, sizeof(hs->hours));
+    } while (seqlock_read_retry(&hs->seq, s));
+}
+
+// Reopens the accumulator of a tier's newest bucket from its slot
+static void accum_reopen(HistoryAccum *a, uint64_t id, uint32_t windows, const float *min,
+                         const float *max, const float *avg)
+{
+    a->bucket = id;
+    a->windows = windows;
+    for (int c = 0; c < CH_COUNT; c++) {
+        a->sum[c] = (double)avg[c] * windows;
+        a->min[c] = min[c];
+        a->max[c] = max[c];
+    }
+}
+
+int history_restore(HistoryStore *hs, const void *image, size_t len)
+{
+    const uint8_t *p = image;
+    const SecondSlot *sec = NULL;
+    const RollupSlot *newest;
+
+    if (len != history_image_size())
+        return -1;
+
+    memcpy(hs->seconds, p, sizeof(hs->seconds));
+    memcpy(hs->minutes, p + sizeof(hs->seconds), sizeof(hs->minutes));
+    memcpy(hs->hours, p + sizeof(hs->seconds) + sizeof(hs->minutes), sizeof(hs->hours));
+    memset(hs->open, 0, sizeof(hs->open));
+
+    for (int i = 0; i < HISTORY_SECONDS; i++)
+        if (hs->seconds[i].id && (!sec || hs->seconds[i].id > sec->id))
+            sec = &hs->seconds[i];
+    if (sec && sec->windows)
+        accum_reopen(&hs->open[HISTORY_TIER_SECOND], sec->id, sec->windows,
+                     sec->avg, sec->avg, sec->avg);
+
+    for (int t = HISTORY_TIER_MINUTE; t < HISTORY_TIER_COUNT; t++) {
+        const RollupSlot *ring = t == HISTORY_TIER_MINUTE ? hs->minutes : hs->hours;
+        newest = NULL;
+        for (uint32_t i = 0; i < tiers[t].slots; i++)
+            if (ring[i].id && (!newest || ring[i].id > newest->id))
+                newest = &ring[i];
+        if (newest && newest->windows)
+            accum_reopen(&hs->open[t], newest->id, newest->windows,
+                         newest->min, newest->max, newest->avg);
+    }
+    return 0;
+}
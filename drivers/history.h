@@ -0,0 +1,94 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sensors.h"
+
+// ============================================================
+// TIERED TIME-SERIES HISTORY (single writer, lock-free readers)
+// ============================================================
+//
+// Fixed-memory history of the four channel levels of one unit, kept in
+// three preallocated rings:
+//
+//   second tier   1 s averages        3600 slots  (last hour)
+//   minute tier   1 min min/max/avg   1440 slots  (last day)
+//   hour tier     1 h min/max/avg      720 slots  (last 30 days)
+//
+// polling_thread folds every closed window into all three tiers at once
+// (O(1), no allocation); the bucket being filled is written through, so
+// readers also see the current second, minute and hour. Slots are keyed
+// by bucket number and a stale slot is simply skipped, so gaps (server
+// restart, windows longer than a bucket) need no bookkeeping. Readers
+// copy under a SeqLock and never delay the writer.
+
+#define HISTORY_SECONDS 3600
+#define HISTORY_MINUTES 1440
+#define HISTORY_HOURS    720
+
+typedef enum {
+    HISTORY_TIER_SECOND = 0,
+    HISTORY_TIER_MINUTE,
+    HISTORY_TIER_HOUR,
+    HISTORY_TIER_COUNT
+} HistoryTier;
+
+/**
+ * HistoryPoint: One bucket of one channel. For the second tier min, max
+ * and avg are the same value.
+ */
+typedef struct {
+    uint64_t t_s;        // bucket start, seconds on the writer's time base
+    float min;
+    float max;
+    float avg;
+    uint32_t windows;    // windows folded into the bucket
+} HistoryPoint;
+
+typedef struct HistoryStore HistoryStore;
+
+/**
+ * history_create: Allocates an empty store (~190 KB).
+ * Returns NULL on allocation failure.
+ */
+HistoryStore* history_create(void);
+void history_destroy(HistoryStore *hs);
+
+/**
+ * history_tier_seconds / history_tier_span: Bucket width and the time
+ * a tier covers, in seconds.
+ */
+uint32_t history_tier_seconds(HistoryTier tier);
+uint32_t history_tier_span(HistoryTier tier);
+
+/**
+ * history_add: Writer side. Folds one window's channel levels, taken at
+ * t_s (non-decreasing), into every tier. O(1), wait-free, RT-safe.
+ * Must only be called from the single writer thread.
+ */
+void history_add(HistoryStore *hs, uint64_t t_s, const float level[CH_COUNT]);
+
+/**
+ * history_read: Copies the buckets of one channel and tier that start in
+ * [from_s, to_s], oldest first, skipping empty ones. Only the part of
+ * the range the tier still holds is returned.
+ * Returns the number of points written (at most max).
+ */
+int history_read(HistoryStore *hs, HistoryTier tier, SensorChannel channel,
+                 uint64_t from_s, uint64_t to_s, HistoryPoint *out, int max);
+
+/**
+ * history_image_size / history_save / history_restore: The rings as one
+ * fixed-size binary image, for checkpoints. history_save may run on any
+ * thread (it copies under the SeqLock like a reader). history_restore
+ * is for a store the writer has not started on yet; it also reopens the
+ * newest bucket of each tier, so a restart inside a minute keeps
+ * folding into the same minute. Returns 0, or -1 if len is not
+ * history_image_size() (the store is left empty).
+ */
+size_t history_image_size(void);
+void history_save(HistoryStore *hs, void *image);
+int history_restore(HistoryStore *hs, const void *image, size_t len);
+
+#endif // HISTORY_H
@@ -0,0 +1,442 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include "rules.h"
+
+#define RULE_MAX_DEBOUNCE 1000
+
+// Built-in limits, used when no rules.conf exists
+#define VIB_WARNING_THRESHOLD  100.0f
+#define VIB_CRITICAL_THRESHOLD 200.0f
+#define TMP_CRITICAL_THRESHOLD 80.0f
+#define CUR_CRITICAL_THRESHOLD 15.0f
+
+typedef struct {
+    char unit[MAX_ID_LENGTH];   // "*" = every unit
+    int channel;
+    int metric;
+    float warn;
+    float crit;
+    float hyst;
+    int debounce;
+} ParsedRule;
+
+/**
+ * RuleSet: Struct-of-arrays rule table. Row k watches value keys[k];
+ * entry k * stride + u belongs to unit u. Limits are read-only after
+ * compilation; level/pending/count are written by polling_thread only.
+ */
+struct RuleSet {
+    int unit_count;
+    int stride;                // RULES_STRIDE(unit_count)
+    int row_count;             // values watched by at least one unit
+    int rule_count;            // (unit, value) pairs with a rule
+    int32_t keys[RULE_VALUE_COUNT];
+    float *warn;
+    float *crit;
+    float *hold_warn;          // warn - hysteresis
+    float *hold_crit;          // crit - hysteresis
+    float *inv_warn;           // 1 / warn for proximity (0 = not counted)
+    int32_t *debounce;
+    int32_t *level;            // 0 = OK, 1 = WARNING, 2 = CRITICAL
+    int32_t *pending;          // level being debounced
+    int32_t *count;            // consecutive windows at 'pending'
+};
+
+static const char *const channel_names[CH_COUNT] = {
+    "vibration", "sound", "temperature", "current"
+};
+
+static const char *const metric_names[RULE_METRIC_COUNT] = {
+    "level", "mean", "rms", "min", "max", "p2p", "crest", "skew", "kurtosis"
+};
+
+// Alarm texts: index 2 * RULE_VALUE_INDEX(channel, metric) + level
+#define RULE_MSG(ch, m)  "High " ch " Warning (" m ")", "CRITICAL FAULT DETECTED: " ch " " m
+#define RULE_MSGS(ch)    RULE_MSG(ch, "level"), RULE_MSG(ch, "mean"), RULE_MSG(ch, "rms"), \
+                         RULE_MSG(ch, "min"), RULE_MSG(ch, "max"), RULE_MSG(ch, "p2p"), \
+                         RULE_MSG(ch, "crest"), RULE_MSG(ch, "skew"), RULE_MSG(ch, "kurtosis")
+
+static const char *const rule_messages[RULE_MESSAGE_COUNT] = {
+    "System Nominal",
+    RULE_MSGS("Vibration"), RULE_MSGS("Sound"), RULE_MSGS("Temperature"), RULE_MSGS("Current")
+};
+
+static const ParsedRule default_rules[] = {
+    { "*", CH_VIBRATION,   RULE_LEVEL, VIB_WARNING_THRESHOLD,  VIB_CRITICAL_THRESHOLD, 0.0f, 1 },
+    { "*", CH_CURRENT,     RULE_LEVEL, CUR_CRITICAL_THRESHOLD, CUR_CRITICAL_THRESHOLD, 0.0f, 1 },
+    { "*", CH_TEMPERATURE, RULE_LEVEL, TMP_CRITICAL_THRESHOLD, TMP_CRITICAL_THRESHOLD, 0.0f, 1 },
+};
+
+// ============================================================
+// PARSING
+// ============================================================
+
+static int lookup(const char *const *names, int count, const char *name)
+{
+    for (int i = 0; i < count; i++)
+        if (strcmp(names[i], name) == 0)
+            return i;
+    return -1;
+}
+
+static char *trim(char *p)
+{
+    while (isspace((unsigned char)*p)) p++;
+    char *end = p + strlen(p);
+    while (end > p && isspace((unsigned char)end[-1])) *--end = '\0';
+    return p;
+}
+
+// "<unit|*>:<channel>[.<metric>]=<warn>,<crit>[,<hyst>[,<debounce>]]"
+// Returns NULL on success, otherwise what is wrong with the line.
+static const char *parse_line(char *line, ParsedRule *r)
+{
+    char *eq = strchr(line, '=');
+    char *colon = strchr(line, ':');
+    if (!eq || !colon || colon > eq)
+        return "expected unit:channel[.metric]=warning,critical[,hysteresis[,debounce]]";
+    *eq = '\0';
+    *colon = '\0';
+
+    char *unit = trim(line);
+    char *target = trim(colon + 1);
+    char *dot = strchr(target, '.');
+    if (dot)
+        *dot++ = '\0';
+
+    if (*unit == '\0' || strlen(unit) >= MAX_ID_LENGTH)
+        return "bad unit id";
+    snprintf(r->unit, sizeof(r->unit), "%s", unit);
+
+    r->channel = lookup(channel_names, CH_COUNT, target);
+    if (r->channel < 0 && strcmp(target, "temp") == 0)
+        r->channel = CH_TEMPERATURE;
+    r->metric = dot ? lookup(metric_names, RULE_METRIC_COUNT, trim(dot)) : RULE_LEVEL;
+    if (r->channel < 0)
+        return "unknown channel";
+    if (r->metric < 0)
+        return "unknown metric";
+
+    r->hyst = 0.0f;
+    r->debounce = 1;
+    int n = sscanf(eq + 1, " %f , %f , %f , %d", &r->warn, &r->crit, &r->hyst, &r->debounce);
+    if (n < 2)
+        return "expected warning,critical limits";
+    if (r->warn > r->crit)
+        return "warning limit above critical";
+    if (r->hyst < 0.0f)
+        return "negative hysteresis";
+    if (r->debounce < 1 || r->debounce > RULE_MAX_DEBOUNCE)
+        return "debounce out of range";
+    return NULL;
+}
+
+static int parse_file(const char *path, ParsedRule **out, int *count, char *err, size_t err_len)
+{
+    char line[256];
+    int cap = 0, lineno = 0;
+    FILE *f = path ? fopen(path, "r") : NULL;
+
+    *out = NULL;
+    *count = 0;
+    if (!f)
+        return 1;   // no file: caller uses the defaults
+
+    while (fgets(line, sizeof(line), f)) {
+        char *p = trim(line);
+        lineno++;
+        if (*p == '#' || *p == '\0')
+            continue;
+
+        if (*count == cap) {
+            int new_cap = cap ? cap * 2 : 16;
+            ParsedRule *grown = realloc(*out, (size_t)new_cap * sizeof(ParsedRule));
+            if (!grown) {
+                snprintf(err, err_len, "out of memory");
+                goto fail;
+            }
+            *out = grown;
+            cap = new_cap;
+        }
+
+        const char *why = parse_line(p, &(*out)[*count]);
+        if (why) {
+            snprintf(err, err_len, "%s:%d: %s", path, lineno, why);
+            goto fail;
+        }
+        (*count)++;
+    }
+
+    fclose(f);
+    return 0;
+
+fail:
+    fclose(f);
+    free(*out);
+    *out = NULL;
+    *count = 0;
+    return -1;
+}
+
+// ============================================================
+// COMPILATION
+// ============================================================
+
+// Last line for (unit, value): a unit line beats a '*' line
+static const ParsedRule *rule_for(const ParsedRule *all, int count, const char *unit, int value)
+{
+    const ParsedRule *wild = NULL, *own = NULL;
+
+    for (int i = 0; i < count; i++) {
+        if (RULE_VALUE_INDEX(all[i].channel, all[i].metric) != value)
+            continue;
+        if (strcmp(all[i].unit, unit) == 0)
+            own = &all[i];
+        else if (strcmp(all[i].unit, "*") == 0)
+            wild = &all[i];
+    }
+    return own ? own : wild;
+}
+
+static void *alloc_row(int rows, int stride)
+{
+    void *mem = NULL;
+    size_t len = (size_t)(rows ? rows : 1) * (size_t)stride * sizeof(float);
+
+    if (posix_memalign(&mem, 64, len) != 0)
+        return NULL;
+    memset(mem, 0, len);
+    return mem;
+}
+
+static RuleSet *compile(const ParsedRule *parsed, int count,
+                        const char (*unit_ids)[MAX_ID_LENGTH], int unit_count)
+{
+    RuleSet *rs = calloc(1, sizeof(RuleSet));
+    if (!rs)
+        return NULL;
+
+    rs->unit_count = unit_count;
+    rs->stride = RULES_STRIDE(unit_count > 0 ? unit_count : 1);
+
+    // Only values some unit watches get a row
+    for (int v = 0; v < RULE_VALUE_COUNT; v++) {
+        for (int i = 0; i < count; i++) {
+            if (RULE_VALUE_INDEX(parsed[i].channel, parsed[i].metric) == v) {
+                rs->keys[rs->row_count++] = v;
+                break;
+            }
+        }
+    }
+
+    int rows = rs->row_count, stride = rs->stride;
+    rs->warn = alloc_row(rows, stride);
+    rs->crit = alloc_row(rows, stride);
+    rs->hold_warn = alloc_row(rows, stride);
+    rs->hold_crit = alloc_row(rows, stride);
+    rs->inv_warn = alloc_row(rows, stride);
+    rs->debounce = alloc_row(rows, stride);
+    rs->level = alloc_row(rows, stride);
+    rs->pending = alloc_row(rows, stride);
+    rs->count = alloc_row(rows, stride);
+    if (!rs->warn || !rs->crit || !rs->hold_warn || !rs->hold_crit || !rs->inv_warn ||
+        !rs->debounce || !rs->level || !rs->pending || !rs->count) {
+        rules_free(rs);
+        return NULL;
+    }
+
+    for (int k = 0; k < rows; k++) {
+        for (int u = 0; u < stride; u++) {
+            size_t at = (size_t)k * (size_t)stride + (size_t)u;
+            const ParsedRule *r = u < unit_count ? rule_for(parsed, count, unit_ids[u], rs->keys[k]) : NULL;
+
+            if (!r) {
+                rs->warn[at] = rs->crit[at] = INFINITY;
+                rs->hold_warn[at] = rs->hold_crit[at] = INFINITY;
+                rs->debounce[at] = 1;
+                continue;
+            }
+            rs->warn[at] = r->warn;
+            rs->crit[at] = r->crit;
+            rs->hold_warn[at] = r->warn - r->hyst;
+            rs->hold_crit[at] = r->crit - r->hyst;
+            rs->inv_warn[at] = r->warn > 0.0f ? 1.0f / r->warn : 0.0f;
+            rs->debounce[at] = r->debounce;
+            rs->rule_count++;
+        }
+    }
+    return rs;
+}
+
+RuleSet* rules_load(const char *path, const char (*unit_ids)[MAX_ID_LENGTH], int unit_count,
+                    char *err, size_t err_len)
+{
+    ParsedRule *parsed = NULL;
+    int count = 0;
+    int rc = parse_file(path, &parsed, &count, err, err_len);
+    RuleSet *rs;
+
+    if (rc < 0)
+        return NULL;
+
+    if (rc > 0)
+        rs = compile(default_rules, (int)(sizeof(default_rules) / sizeof(default_rules[0])),
+                     unit_ids, unit_count);
+    else
+        rs = compile(parsed, count, unit_ids, unit_count);
+
+    free(parsed);
+    if (!rs)
+        snprintf(err, err_len, "out of memory compiling rules");
+    return rs;
+}
+
+void rules_free(RuleSet *rs)
+{
+    if (!rs)
+        return;
+    free(rs->warn);
+    free(rs->crit);
+    free(rs->hold_warn);
+    free(rs->hold_crit);
+    free(rs->inv_warn);
+    free(rs->debounce);
+    free(rs->level);
+    free(rs->pending);
+    free(rs->count);
+    free(rs);
+}
+
+int rules_count(const RuleSet *rs)
+{
+    return rs ? rs->rule_count : 0;
+}
+
+const char* rules_message(uint32_t message_id)
+{
+    return message_id < RULE_MESSAGE_COUNT ? rule_messages[message_id] : rule_messages[0];
+}
+
+void rules_get_state(const RuleSet *rs, int unit, RuleUnitState *out)
+{
+    memset(out, 0, sizeof(*out));
+    for (int k = 0; k < rs->row_count; k++) {
+        size_t at = (size_t)k * (size_t)rs->stride + (size_t)unit;
+        int v = rs->keys[k];
+        out->level[v] = (uint8_t)rs->level[at];
+        out->pending[v] = (uint8_t)rs->pending[at];
+        out->count[v] = (uint16_t)rs->count[at];
+    }
+}
+
+void rules_set_state(RuleSet *rs, int unit, const RuleUnitState *in)
+{
+    for (int k = 0; k < rs->row_count; k++) {
+        size_t at = (size_t)k * (size_t)rs->stride + (size_t)unit;
+        int v = rs->keys[k];
+        rs->level[at] = in->level[v] <= 2 ? in->level[v] : 0;
+        rs->pending[at] = in->pending[v] <= 2 ? in->pending[v] : 0;
+        rs->count[at] = in->count[v];
+    }
+}
+
+// ============================================================
+// EVALUATION (polling_thread)
+// ============================================================
+
+void rules_fill_values(const RuleSet *rs, const EquipmentHealth *h, float *values, int unit)
+{
+    const float levels[CH_COUNT] = {
+        h->snapshot.vibration_level, h->snapshot.sound_level,
+        h->snapshot.temperature_c, h->snapshot.current_a
+    };
+    float v[RULE_VALUE_COUNT];
+
+    for (int c = 0; c < CH_COUNT; c++) {
+        const ChannelFeatures *f = &h->features[c];
+        float *o = &v[RULE_VALUE_INDEX(c, 0)];
+        o[RULE_LEVEL] = levels[c];
+        o[RULE_MEAN] = f->mean;
+        o[RULE_RMS] = f->rms;
+        o[RULE_MIN] = f->min;
+        o[RULE_MAX] = f->max;
+        o[RULE_P2P] = f->peak_to_peak;
+        o[RULE_CREST] = f->crest_factor;
+        o[RULE_SKEW] = f->skewness;
+        o[RULE_KURTOSIS] = f->kurtosis;
+    }
+
+    // Scatter only the watched values: one store per row
+    for (int k = 0; k < rs->row_count; k++)
+        values[(size_t)k * (size_t)rs->stride + (size_t)unit] = v[rs->keys[k]];
+}
+
+_Static_assert(HEALTH_HEALTHY == 0 && HEALTH_WARNING == 1 && HEALTH_CRITICAL == 2,
+               "rule levels double as HealthStatus");
+
+// Unaligned loads/stores and lane-wise mask ? a : b (mask lanes are 0 or
+// -1) on the kernel's own vf/vi. Macros, not functions: an 8-lane vector
+// passed by value would change the ABI of the SSE build
+#define vload(p)       ({ vf v_; memcpy(&v_, (p), sizeof(v_)); v_; })
+#define vload_i(p)     ({ vi v_; memcpy(&v_, (p), sizeof(v_)); v_; })
+#define vstore_i(p, v) do { vi v_ = (v); memcpy((p), &v_, sizeof(v_)); } while (0)
+#define vsel(mask, a, b) (((a) & (mask)) | ((b) & ~(mask)))
+
+// x86 builds target baseline SSE2: the 4-lane kernel is built for it and
+// an 8-lane one for AVX2, picked per call from the CPU's feature bits.
+// Without AVX the compiler splits 8-lane vectors lane by lane, so each
+// width needs its own build. NEON and generic builds have 4 lanes only.
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(__AVX2__)
+#define RULES_DISPATCH_AVX2 1
+#endif
+
+#if RULES_VEC == 8
+#define RULES_KERNEL_LANES 8
+#define RULES_KERNEL_NAME  evaluate_x8
+#ifdef RULES_DISPATCH_AVX2
+#define RULES_KERNEL_ATTR  __attribute__((target("avx2")))
+#else
+#define RULES_KERNEL_ATTR
+#endif
+#include "rules_kernel.h"
+#undef RULES_KERNEL_LANES
+#undef RULES_KERNEL_NAME
+#undef RULES_KERNEL_ATTR
+#endif
+
+#if RULES_VEC == 4 || defined(RULES_DISPATCH_AVX2)
+#define RULES_KERNEL_LANES 4
+#define RULES_KERNEL_NAME  evaluate_x4
+#define RULES_KERNEL_ATTR
+#include "rules_kernel.h"
+#undef RULES_KERNEL_LANES
+#undef RULES_KERNEL_NAME
+#undef RULES_KERNEL_ATTR
+#endif
+
+int rules_simd_width(void)
+{
+#ifdef RULES_DISPATCH_AVX2
+    return __builtin_cpu_supports("avx2") ? 8 : 4;
+#else
+    return RULES_VEC;
+#endif
+}
+
+void rules_evaluate(RuleSet *rs, const float *values, const int32_t *due,
+                    int32_t *status, int32_t *message_id, float *proximity)
+{
+#ifdef RULES_DISPATCH_AVX2
+    if (__builtin_cpu_supports("avx2"))
+        evaluate_x8(rs, values, due, status, message_id, proximity);
+    else
+        evaluate_x4(rs, values, due, status, message_id, proximity);
+#elif RULES_VEC == 8
+    evaluate_x8(rs, values, due, status, message_id, proximity);
+#else
+    evaluate_x4(rs, values, due, status, message_id, proximity);
+#endif
+}
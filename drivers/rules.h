@@ -0,0 +1,141 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sensors.h"
+
+// ============================================================
+// THRESHOLD RULE ENGINE
+// ============================================================
+//
+// config/rules.conf lines have the form
+//
+//     <unit|*>:<channel>[.<metric>]=<warning>,<critical>[,<hysteresis>[,<debounce>]]
+//
+// e.g. "*:vibration=100,200,5,1" or "Press-Line-A:vibration.kurtosis=4,6,0.5,3".
+// A limit is crossed when the value is strictly above it. Once raised,
+// a level holds until the value falls below (limit - hysteresis). A level
+// change must be seen on <debounce> consecutive windows before it
+// takes effect. Unit-specific lines replace the '*' line of the same
+// channel and metric.
+//
+// rules_load compiles the file into one RuleSet laid out struct-of-arrays:
+// for every watched value, one row of limits and one row of runtime
+// state, each holding all units side by side. A window close is then
+// evaluated RULES_VEC units at a time with branch-free SIMD compares and
+// selects (GCC vector extensions: SSE/AVX on x86, NEON on aarch64,
+// scalar elsewhere). Units without a rule for a row get +inf limits.
+// Only the polling thread writes the state; sets are swapped whole
+// (see sensor_manager.c).
+
+#define RULES_CONFIG "config/rules.conf"
+
+/**
+ * RuleMetric: Which per-window value a rule watches. RULE_LEVEL is the
+ * SensorSnapshot value (events/s, %, C, A); the rest are ChannelFeatures.
+ */
+typedef enum {
+    RULE_LEVEL = 0,
+    RULE_MEAN,
+    RULE_RMS,
+    RULE_MIN,
+    RULE_MAX,
+    RULE_P2P,
+    RULE_CREST,
+    RULE_SKEW,
+    RULE_KURTOSIS,
+    RULE_METRIC_COUNT
+} RuleMetric;
+
+// Index of a per-window value (the rows rules_fill_values() picks from)
+#define RULE_VALUE_INDEX(channel, metric) ((channel) * RULE_METRIC_COUNT + (metric))
+#define RULE_VALUE_COUNT (CH_COUNT * RULE_METRIC_COUNT)
+
+// Widest SIMD step rules_evaluate is built with; the one in use is
+// rules_simd_width() (x86 picks AVX2 or SSE2 at run time)
+#if defined(__x86_64__) || defined(__i386__)
+#define RULES_VEC 8      // AVX2, with a 4-lane SSE2 fallback
+#else
+#define RULES_VEC 4      // NEON / generic
+#endif
+
+// Units per matrix row: whole 64-byte lines plus one spare line, so rows
+// are never a power-of-two apart and do not evict each other from the
+// same cache sets when a window close scatters one unit down a column
+#define RULES_LINE_FLOATS 16
+#define RULES_STRIDE(units) \
+    (((units) + RULES_LINE_FLOATS - 1) / RULES_LINE_FLOATS * RULES_LINE_FLOATS + RULES_LINE_FLOATS)
+
+// Message ids: 0 = nominal, otherwise 2 * value index + level (1 or 2)
+#define RULE_MESSAGE_NOMINAL 0
+#define RULE_MESSAGE_COUNT   (1 + 2 * RULE_VALUE_COUNT)
+
+typedef struct RuleSet RuleSet;
+
+/**
+ * RuleUnitState: Hysteresis/debounce state of one unit, by value index
+ * (RULE_VALUE_INDEX). Values no rule watches stay zero.
+ */
+typedef struct {
+    uint8_t level[RULE_VALUE_COUNT];     // 0 = OK, 1 = WARNING, 2 = CRITICAL
+    uint8_t pending[RULE_VALUE_COUNT];   // level being debounced
+    uint16_t count[RULE_VALUE_COUNT];    // consecutive windows at 'pending'
+} RuleUnitState;
+
+/**
+ * rules_load: Parses and compiles a rule file for the given units. If
+ * several lines name the same unit and value the last one wins.
+ * A NULL path or a missing file yields the built-in defaults (the former
+ * hard-coded vibration/current/temperature limits). On a syntax error returns NULL
+ * and describes the first bad line in err.
+ */
+RuleSet* rules_load(const char *path, const char (*unit_ids)[MAX_ID_LENGTH], int unit_count,
+                    char *err, size_t err_len);
+void rules_free(RuleSet *rs);
+
+/**
+ * rules_count: Number of (unit, value) pairs that have a rule.
+ */
+int rules_count(const RuleSet *rs);
+
+/**
+ * rules_fill_values: Writes the values rs watches for one closed window
+ * into column 'unit' of the evaluation matrix (row k holds the k-th
+ * watched value of every unit; at most RULE_VALUE_COUNT rows of
+ * RULES_STRIDE(unit_count) floats). Fill and evaluate with the same set.
+ */
+void rules_fill_values(const RuleSet *rs, const EquipmentHealth *h, float *values, int unit);
+
+/**
+ * rules_evaluate: Advances the hysteresis/debounce state of every unit
+ * whose due[] lane is -1 (others: 0, state untouched) and writes, per
+ * unit, the worst level as a HealthStatus, its message id and the
+ * largest value/warning-limit ratio (1.0 = at the first limit). values
+ * and every array are RULES_STRIDE(unit_count) wide. RT-safe: no
+ * allocation, no formatting, no locks.
+ */
+void rules_evaluate(RuleSet *rs, const float *values, const int32_t *due,
+                    int32_t *status, int32_t *message_id, float *proximity);
+
+/**
+ * rules_simd_width: Units rules_evaluate judges per SIMD step on this
+ * CPU (8 with AVX2, else 4).
+ */
+int rules_simd_width(void);
+
+/**
+ * rules_get_state / rules_set_state: Copy the runtime state of one unit
+ * out of, or into, a set (e.g. to carry raised alarms across a restart).
+ * Only the polling thread may call them on the active set; set_state
+ * ignores values the set does not watch.
+ */
+void rules_get_state(const RuleSet *rs, int unit, RuleUnitState *out);
+void rules_set_state(RuleSet *rs, int unit, const RuleUnitState *in);
+
+/**
+ * rules_message: Static text of a message id; never NULL.
+ */
+const char* rules_message(uint32_t message_id);
+
+#endif // RULES_H
@@ -0,0 +1,69 @@
+// ============================================================
+// RULE EVALUATION KERNEL (one vector width)
+// ============================================================
+//
+// Body of rules_evaluate over RULES_KERNEL_LANES-wide vectors, included
+// by rules.c once per width it builds (no include guard). Before each
+// include rules.c defines RULES_KERNEL_LANES, RULES_KERNEL_NAME and
+// RULES_KERNEL_ATTR (target ISA); the vload/vsel helpers come from
+// rules.c.
+
+RULES_KERNEL_ATTR
+static void RULES_KERNEL_NAME(RuleSet *rs, const float *values, const int32_t *due,
+                              int32_t *status, int32_t *message_id, float *proximity)
+{
+    typedef float vf __attribute__((vector_size(RULES_KERNEL_LANES * sizeof(float))));
+    typedef int32_t vi __attribute__((vector_size(RULES_KERNEL_LANES * sizeof(int32_t))));
+    const int stride = rs->stride;
+
+    for (int base = 0; base < stride; base += RULES_KERNEL_LANES) {
+        vi live = vload_i(due + base);
+        vi worst = { 0 };
+        vi worst_id = { 0 };
+        vf prox = { 0 };
+        int any = 0;
+
+        for (int l = 0; l < RULES_KERNEL_LANES; l++)
+            any |= live[l];
+        if (!any)
+            continue;
+
+        for (int k = 0; k < rs->row_count; k++) {
+            size_t at = (size_t)k * (size_t)stride + (size_t)base;
+            vf x = vload(values + at);
+            vi level = vload_i(rs->level + at);
+            vi pending = vload_i(rs->pending + at);
+            vi count = vload_i(rs->count + at);
+
+            // Level the value asks for; a raised level is kept inside the band
+            // (compares yield 0 / -1 per lane)
+            vi up = -((x > vload(rs->warn + at)) + (x > vload(rs->crit + at)));
+            vi hold = -((x > vload(rs->hold_warn + at)) + (x > vload(rs->hold_crit + at)));
+            vi kept = vsel(level < hold, level, hold);
+            vi target = vsel(up > kept, up, kept);
+
+            // Debounce: a change must persist for 'debounce' windows
+            vi changed = target != level;
+            vi fresh = target != pending;
+            vi next_count = changed & vsel(fresh, (vi){ 0 } + 1, count + 1);
+            vi commit = changed & (next_count >= vload_i(rs->debounce + at));
+            vi next_level = vsel(commit, target, level);
+
+            vstore_i(rs->level + at, vsel(live, next_level, level));
+            vstore_i(rs->pending + at, vsel(live & changed, target, pending));
+            vstore_i(rs->count + at, vsel(live, next_count & ~commit, count));
+
+            // Worst level wins; the first value at that level names it
+            vi higher = next_level > worst;
+            worst = vsel(higher, next_level, worst);
+            worst_id = vsel(higher, next_level + 2 * rs->keys[k], worst_id);
+
+            vf p = x * vload(rs->inv_warn + at);
+            prox = (vf)vsel(p > prox, (vi)p, (vi)prox);
+        }
+
+        vstore_i(status + base, worst);     // 0/1/2 == HEALTH_HEALTHY/WARNING/CRITICAL
+        vstore_i(message_id + base, worst_id);
+        memcpy(proximity + base, &prox, sizeof(prox));
+    }
+}
@@ -0,0 +1,102 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sample_ring.h"
+
+// ============================================================
+// ALLOCATION
+// ============================================================
+
+SampleRing* sample_ring_create(void)
+{
+    void *mem = NULL;
+
+    if (posix_memalign(&mem, 64, sizeof(SampleRing)) != 0)
+        return NULL;
+
+    // Zeroing also pre-faults the pages before the RT loop touches them
+    memset(mem, 0, sizeof(SampleRing));
+    return (SampleRing *)mem;
+}
+
+void sample_ring_destroy(SampleRing *ring)
+{
+    free(ring);
+}
+
+// ============================================================
+// CONSUMER SIDE
+// ============================================================
+
+void sample_ring_cursor_init(SampleRing *ring, SampleCursor *cur)
+{
+    cur->next_seq = atomic_load_explicit(&ring->head, memory_order_acquire);
+    cur->overruns = 0;
+}
+
+void sample_ring_cursor_init_oldest(SampleRing *ring, SampleCursor *cur)
+{
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    // Leave one slot of margin: the producer may be rewriting the oldest one
+    cur->next_seq = head >= SAMPLE_RING_CAPACITY ? head - SAMPLE_RING_CAPACITY + 1 : 0;
+    cur->overruns = 0;
+}
+
+void sample_ring_cursor_init_latest(SampleRing *ring, SampleCursor *cur, uint32_t n)
+{
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (n > SAMPLE_RING_CAPACITY - 1)
+        n = SAMPLE_RING_CAPACITY - 1;
+    cur->next_seq = head >= n ? head - n : 0;
+    cur->overruns = 0;
+}
+
+static void skip_to(SampleRing *ring, SampleCursor *cur, uint64_t target)
+{
+    uint64_t lost = target - cur->next_seq;
+
+    cur->overruns += lost;
+    cur->next_seq = target;
+    atomic_fetch_add_explicit(&ring->overruns, lost, memory_order_relaxed);
+}
+
+int sample_ring_read(SampleRing *ring, SampleCursor *cur, RawSample *out, int max)
+{
+    int n = 0;
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    while (n < max && cur->next_seq < head) {
+        // Lapped before we even started: jump to the oldest retained sample
+        if (head - cur->next_seq > SAMPLE_RING_CAPACITY)
+            skip_to(ring, cur, head - SAMPLE_RING_CAPACITY);
+
+        uint64_t seq = cur->next_seq;
+        SampleSlot *slot = &ring->slots[seq & SAMPLE_RING_MASK];
+        uint64_t expect = 2 * seq + 2;
+
+        uint64_t s1 = atomic_load_explicit(&slot->stamp, memory_order_acquire);
+        if (s1 == expect) {
+            out[n].seq = seq;
+            out[n].t_ns = slot->t_ns;
+            out[n].vibration = slot->vibration;
+            out[n].sound = slot->sound;
+
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&slot->stamp, memory_order_relaxed) == s1) {
+                n++;
+                cur->next_seq++;
+                continue;
+            }
+        }
+
+        // Slot was (or is being) overwritten under us: resynchronise
+        head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint64_t target = head + 1 > SAMPLE_RING_CAPACITY ? head + 1 - SAMPLE_RING_CAPACITY : 0;
+        if (target <= cur->next_seq)
+            target = cur->next_seq + 1;
+        skip_to(ring, cur, target);
+    }
+
+    return n;
+}
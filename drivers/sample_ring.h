@@ -0,0 +1,106 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+// ============================================================
+// RAW SAMPLE RING (single producer, any number of readers)
+// ============================================================
+//
+// polling_thread pushes every acquired sample; it never waits and simply
+// overwrites the oldest slot. Each reader owns a SampleCursor and detects
+// that it was lapped from the per-slot stamp, counting the lost samples
+// as overruns instead of stalling the producer.
+
+#define SAMPLE_RING_ORDER    15
+#define SAMPLE_RING_CAPACITY (1u << SAMPLE_RING_ORDER)   // 32768 samples (~1.6 s at 20 kHz)
+#define SAMPLE_RING_MASK     (SAMPLE_RING_CAPACITY - 1u)
+
+/**
+ * RawSample: One sample of the fast channels (vibration, sound).
+ */
+typedef struct {
+    uint64_t seq;        // Per-unit sample number, gap-free at the producer
+    uint64_t t_ns;       // CLOCK_MONOTONIC acquisition time
+    float vibration;     // vibration reading
+    uint8_t sound;       // sound pin level (0/1)
+} RawSample;
+
+/**
+ * SampleSlot: Ring storage. stamp = 2*seq+1 while being written and
+ * 2*seq+2 once the sample is complete (0 = never written).
+ */
+typedef struct {
+    atomic_uint_least64_t stamp;
+    uint64_t t_ns;
+    float vibration;
+    uint8_t sound;
+} SampleSlot;
+
+typedef struct {
+    _Alignas(64) atomic_uint_least64_t head;      // next seq to be written
+    _Alignas(64) atomic_uint_least64_t overruns;  // samples lost by all readers
+    _Alignas(64) SampleSlot slots[SAMPLE_RING_CAPACITY];
+} SampleRing;
+
+/**
+ * SampleCursor: Private read position of one consumer.
+ */
+typedef struct {
+    uint64_t next_seq;
+    uint64_t overruns;   // samples this consumer missed because it was lapped
+} SampleCursor;
+
+/**
+ * sample_ring_create: Allocates a zeroed, cache-aligned ring.
+ * Returns NULL on allocation failure.
+ */
+SampleRing* sample_ring_create(void);
+void sample_ring_destroy(SampleRing *ring);
+
+/**
+ * sample_ring_push: Producer side. O(1), wait-free, RT-safe.
+ * Must only be called from the single producer thread.
+ */
+static inline void sample_ring_push(SampleRing *ring, uint64_t t_ns, float vibration, uint8_t sound)
+{
+    uint64_t seq = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    SampleSlot *slot = &ring->slots[seq & SAMPLE_RING_MASK];
+
+    atomic_store_explicit(&slot->stamp, 2 * seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->t_ns = t_ns;
+    slot->vibration = vibration;
+    slot->sound = sound;
+    atomic_store_explicit(&slot->stamp, 2 * seq + 2, memory_order_release);
+    atomic_store_explicit(&ring->head, seq + 1, memory_order_release);
+}
+
+/**
+ * sample_ring_cursor_init: Positions a cursor at the live edge, so the
+ * first read returns only samples produced after this call.
+ */
+void sample_ring_cursor_init(SampleRing *ring, SampleCursor *cur);
+
+/**
+ * sample_ring_cursor_init_oldest: Positions a cursor at the oldest sample
+ * still retained, for consumers that want the recent backlog.
+ */
+void sample_ring_cursor_init_oldest(SampleRing *ring, SampleCursor *cur);
+
+/**
+ * sample_ring_cursor_init_latest: Positions a cursor so the next read
+ * returns the most recent n samples (fewer if not yet produced).
+ */
+void sample_ring_cursor_init_latest(SampleRing *ring, SampleCursor *cur, uint32_t n);
+
+/**
+ * sample_ring_read: Copies up to max samples in order, advancing cur.
+ * Never blocks; samples overwritten before they could be read are
+ * skipped and added to cur->overruns.
+ * Returns the number of samples copied (0 if nothing new).
+ */
+int sample_ring_read(SampleRing *ring, SampleCursor *cur, RawSample *out, int max);
+
+#endif // SAMPLE_RING_H
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <pthread.h>
 #include <unistd.h>
 #include <time.h>
@@ -8,21 +9,185 @@
 #include <sched.h>
 #include "sensor_manager.h"
 #include "sensors.h"
+#include "seqlock.h"
+#include "sample_ring.h"
+#include "window_stats.h"
+#include "spectrum.h"
+#include "latency_hist.h"
+#include "rt_log.h"
+#include "rules.h"
+#include "rt_profile.h"
+#include "history.h"
+#include "segment_store.h"
+#include "checkpoint.h"
+#include "alerts.h"
 
 // ============================================================
 // INTERNAL STATE & THREADING
 // ============================================================
-static pthread_mutex_t data_mutex = PTHREAD_MUTEX_INITIALIZER;
-static EquipmentHealth current_health;
+#define CACHE_LINE 64
+
+/**
+ * SlowChannelSpec: A channel too slow for the RT tick. It is read by
+ * slow_thread as a periodic split-phase task (see hw_slow_start).
+ */
+typedef struct {
+    SensorChannel ch;
+    uint32_t period_ms;
+    const char *name;
+} SlowChannelSpec;
+
+static const SlowChannelSpec slow_channels[] = {
+    { CH_TEMPERATURE, 1000, "temperature" },   // DS18B20: up to 750 ms per conversion
+    { CH_CURRENT,      100, "current" },       // ADS1115 single shot
+};
+#define SLOW_CHANNEL_COUNT ((int)(sizeof(slow_channels) / sizeof(slow_channels[0])))
+
+/**
+ * UnitState: Per-machine state, cache-line aligned so units never share
+ * a line. The published half (seq + health) is read by session threads;
+ * the private half is touched only by polling_thread.
+ */
+typedef struct {
+    // --- Published: written only by polling_thread through seq ---
+    SeqLock seq;
+    EquipmentHealth health;
+
+    // --- Published: rule state after the last window, for checkpoints ---
+    _Alignas(CACHE_LINE) SeqLock rule_seq;
+    RuleUnitState rule_state;
+
+    // --- Published: written only by spectrum_thread through spec_seq ---
+    _Alignas(CACHE_LINE) SeqLock spec_seq;
+    SpectrumResult spectrum;
+
+    // --- Published: written only by store_thread through the hub ---
+    _Alignas(CACHE_LINE) TelemetrySlot telemetry;
+
+    // --- Acquisition control: sessions request, polling_thread applies ---
+    _Alignas(CACHE_LINE) atomic_uint_least64_t rate_request;  // see pack_request()
+    atomic_uint_least64_t rate_epoch;    // (first seq << 20) | rate_hz of the current rate
+
+    // --- Slow channels: slow_thread publishes, polling_thread merges ---
+    // (reading count << 32) | float bits of the latest reading
+    _Alignas(CACHE_LINE) atomic_uint_least64_t slow_latest[SLOW_CHANNEL_COUNT];
+
+    // --- Immutable after init ---
+    _Alignas(CACHE_LINE) uint32_t id_hash;
+    int board;
+    float running_hz;       // shaft speed from units.conf (0 = unknown)
+    SampleRing *ring;       // raw per-tick samples for downstream consumers
+    HistoryStore *history;  // tiered level history, written at each window close
+
+    // --- Private to polling_thread ---
+    WindowStats stats[CH_COUNT];   // running moments of the open window
+    uint32_t rate_hz;              // current fast-channel rate
+    uint32_t fixed_rate_hz;        // 0 = adaptive
+    uint32_t window_blocks;        // window length in loop periods
+    uint32_t blocks_done;          // periods elapsed in the open window
+    uint32_t calm_windows;         // consecutive windows below the drop level
+    float proximity;               // value/limit ratio of the last window
+    uint64_t sample_credit;        // rate * elapsed ns not yet acquired (1e-9 samples)
+    uint64_t applied_request;
+    uint32_t slow_seen[SLOW_CHANNEL_COUNT];   // reading count already merged
+    float slow_last[SLOW_CHANNEL_COUNT];      // held when a window gets no reading
+    EquipmentHealth next;
+} __attribute__((aligned(CACHE_LINE))) UnitState;
+
+// The registry is built once in manager_init and is read-only afterwards,
+// so lookups need no lock. Only health payloads change at runtime.
+static UnitState *units = NULL;
+static int unit_count = 0;
+static int *unit_index = NULL;      // open-addressed hash: slot -> unit + 1
+static uint32_t unit_index_mask = 0;
 static int running = 0;
 
-// Thresholds
-#define VIB_WARNING_THRESHOLD  100.0
-#define VIB_CRITICAL_THRESHOLD 200.0
-#define TMP_CRITICAL_THRESHOLD 80.0
-#define CUR_CRITICAL_THRESHOLD 15.0
+// Window-close evaluation batch, private to polling_thread: one column
+// per unit (see rules.h), so every unit closing on the same tick is
+// judged in one SIMD pass
+static int eval_stride = 0;
+static float *eval_values = NULL;      // up to RULE_VALUE_COUNT rows x eval_stride
+static int32_t *eval_due = NULL;       // -1 = window closed this tick
+static int32_t *eval_status = NULL;
+static int32_t *eval_message = NULL;
+static float *eval_proximity = NULL;
+
+// Spectrum worker: ordinary priority, consumes the sample rings
+static pthread_t spectrum_tid;
+static int spectrum_started = 0;
+static FftPlan *spectrum_plans[32];  // by log2(size), created on first use
+
+// Slow-channel scheduler: ordinary priority, never touches polling_thread state
+static pthread_t slow_tid;
+static int slow_started = 0;
+static pthread_t store_tid;
+static int store_started = 0;
+static pthread_t checkpoint_tid;
+static int checkpoint_started = 0;
+static Checkpoint *checkpoint_buf = NULL;   // reused by every checkpoint
+#define STORE_POLL_NS 50000000L   // below MANAGER_MIN_WINDOW_MS: no window is missed
+#define SLOW_MAX_SLEEP_NS 100000000L   // re-check 'running' at least every 100 ms
+
+// RT loop observability: recorded by polling_thread only, read lock-free
+static LatencyHist wakeup_hist;     // deadline -> actual wakeup
+static LatencyHist exec_hist;       // wakeup -> block work done
+static atomic_uint_least64_t rt_loops;
+static atomic_uint_least64_t rt_missed_deadlines;
+static atomic_uint_least64_t rt_skipped_ticks;
+static atomic_uint_least64_t rt_major_faults;   // page faults inside the loop
+static atomic_uint_least64_t rt_minor_faults;
+static uint64_t rt_start_ns;
 
-#define POLL_INTERVAL_NS 1000000L
+// Window time base: CLOCK_MONOTONIC ms + this = wall-clock ms at
+// manager_init, so window times, history buckets and stored records line
+// up with the clock but never jump when it is stepped
+static int64_t wall_epoch_ms;
+
+// Scheduling/memory profile of polling_thread (config/rt.conf)
+static RtProfile rt_profile;
+
+// Fastest rate the HAL's hw_read_block honours (hw_block_max_rate,
+// clamped to the manager limits); every rate set_rate applies is capped
+static uint32_t block_max_rate_hz = MANAGER_MAX_RATE_HZ;
+
+// Threshold rules (rules.h). The set is replaced whole by
+// manager_reload_rules: polling_thread loads the pointer once per loop
+// iteration and advances rules_qs when the iteration ends, so once the
+// counter has moved after a swap no one can still hold the old set.
+// The replaced set is retired rather than waited for, and freed by the
+// next reload (or cleanup) once rules_qs has passed retired_qs.
+static _Atomic(RuleSet *) active_rules;
+static atomic_uint_least64_t rules_qs;
+static pthread_mutex_t rules_reload_lock = PTHREAD_MUTEX_INITIALIZER;
+static RuleSet *retired_rules;
+static uint64_t retired_qs;
+
+// Block-mode acquisition: every BLOCK_PERIOD_NS each unit's FIFO is
+// drained once. The loop period is fixed (absolute deadlines); a unit's
+// rate only changes how many samples each drain returns.
+#define BLOCK_PERIOD_NS   5000000L
+#define DEFAULT_WINDOW_MS 1000u
+
+// Adaptive policy: low rate while comfortably healthy, full rate as soon
+// as a window reaches APPROACH of the warning/critical limits. Dropping
+// back needs CALM_WINDOWS consecutive windows below CALM.
+#define ADAPT_LOW_RATE_HZ   2000u
+#define ADAPT_HIGH_RATE_HZ  MANAGER_MAX_RATE_HZ
+#define ADAPT_APPROACH      0.8f
+#define ADAPT_CALM          0.6f
+#define ADAPT_CALM_WINDOWS  10
+
+// Levels are normalised to the original 1 kHz tick so thresholds keep meaning
+#define REFERENCE_RATE_HZ 1000.0f
+
+#define RATE_EPOCH_BITS   20
+
+_Static_assert((uint64_t)MANAGER_MAX_RATE_HZ * BLOCK_PERIOD_NS / 1000000000ULL < HW_BLOCK_MAX_SAMPLES,
+               "block exceeds HAL FIFO capacity");
+_Static_assert(MANAGER_MAX_RATE_HZ < (1u << RATE_EPOCH_BITS), "rate does not fit the epoch word");
+
+#define UNITS_CONFIG "config/units.conf"
+#define SPECTRUM_PERIOD_S 1
 
 static void add_ns(struct timespec *ts, long ns)
 {
@@ -33,168 +198,1467 @@ static void add_ns(struct timespec *ts, long ns)
     }
 }
 
+// Background workers (spectrum, store, checkpoint, slow channels) run on
+// small stacks: memory is locked, so a default stack would be pinned whole
+static int start_worker(pthread_t *tid, void *(*fn)(void *), void *arg)
+{
+    pthread_attr_t attr;
+    int rc;
+
+    if (pthread_attr_init(&attr) != 0)
+        return -1;
+    rt_profile_worker_attr(&attr);
+    rc = pthread_create(tid, &attr, fn, arg);
+    pthread_attr_destroy(&attr);
+    return rc;
+}
+
+// ============================================================
+// UNIT REGISTRY
+// ============================================================
+
+// FNV-1a: cheap, good spread for short ASCII identifiers
+static uint32_t hash_unit_id(const char *id)
+{
+    uint32_t h = 2166136261u;
+    while (*id) {
+        h ^= (unsigned char)*id++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static UnitState *find_unit(const char *unit_id)
+{
+    if (!unit_id || !unit_index)
+        return NULL;
+
+    uint32_t h = hash_unit_id(unit_id);
+    for (uint32_t slot = h & unit_index_mask; unit_index[slot]; slot = (slot + 1) & unit_index_mask) {
+        UnitState *u = &units[unit_index[slot] - 1];
+        if (u->id_hash == h && strcmp(u->health.unit_id, unit_id) == 0)
+            return u;
+    }
+    return NULL;
+}
+
+typedef struct {
+    char unit_id[MAX_ID_LENGTH];
+    int board;
+    float rpm;
+} UnitEntry;
+
+static int append_entry(UnitEntry **list, int *count, int *cap, const char *id, int board, float rpm)
+{
+    for (int i = 0; i < *count; i++) {
+        if (strcmp((*list)[i].unit_id, id) == 0) {
+            log_error("[SENSORS] Duplicate unit '%s' in %s ignored\n", id, UNITS_CONFIG);
+            return 0;
+        }
+    }
+
+    if (*count == *cap) {
+        int new_cap = *cap ? *cap * 2 : 8;
+        UnitEntry *grown = realloc(*list, (size_t)new_cap * sizeof(UnitEntry));
+        if (!grown)
+            return -1;
+        *list = grown;
+        *cap = new_cap;
+    }
+
+    snprintf((*list)[*count].unit_id, MAX_ID_LENGTH, "%s", id);
+    (*list)[*count].board = board;
+    (*list)[*count].rpm = rpm;
+    (*count)++;
+    return 0;
+}
+
+/**
+ * load_unit_config: Parses "unit_id=board[,rpm]" lines. Missing file is not an
+ * error; the caller falls back to the single default unit.
+ */
+static int load_unit_config(const char *path, UnitEntry **list, int *count)
+{
+    int cap = 0;
+    char line[256];
+    FILE *f = fopen(path, "r");
+
+    *list = NULL;
+    *count = 0;
+    if (!f)
+        return 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        char *p = line;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '#' || *p == '\0')
+            continue;
+
+        char *eq = strchr(p, '=');
+        int board = 0;
+        float rpm = 0.0f;
+        if (eq) {
+            char *comma = strchr(eq + 1, ',');
+            *eq = '\0';
+            board = atoi(eq + 1);
+            if (comma)
+                rpm = (float)atof(comma + 1);
+        }
+
+        char *end = p + strlen(p);
+        while (end > p && isspace((unsigned char)end[-1])) *--end = '\0';
+
+        if (*p == '\0' || strlen(p) >= MAX_ID_LENGTH) {
+            log_error("[SENSORS] Invalid unit id '%s' in %s ignored\n", p, path);
+            continue;
+        }
+
+        if (append_entry(list, count, &cap, p, board, rpm) != 0) {
+            fclose(f);
+            return -1;
+        }
+    }
+
+    fclose(f);
+    return 0;
+}
+
+static void free_registry(void)
+{
+    for (int i = 0; i < unit_count; i++) {
+        sample_ring_destroy(units[i].ring);
+        history_destroy(units[i].history);
+        telemetry_clear(&units[i].telemetry);
+    }
+    free(units);
+    free(unit_index);
+    free(eval_values);
+    free(eval_due);
+    free(eval_status);
+    free(eval_message);
+    free(eval_proximity);
+    units = NULL;
+    unit_index = NULL;
+    eval_values = NULL;
+    eval_due = eval_status = eval_message = NULL;
+    eval_proximity = NULL;
+    unit_count = 0;
+}
+
+static int build_registry(const UnitEntry *list, int count)
+{
+    void *mem = NULL;
+    uint32_t slots = 1;
+
+    if (posix_memalign(&mem, CACHE_LINE, (size_t)count * sizeof(UnitState)) != 0)
+        return -1;
+    units = mem;
+    memset(units, 0, (size_t)count * sizeof(UnitState));
+
+    // Keep the index at most half full so probes stay short
+    while (slots < (uint32_t)count * 2) slots <<= 1;
+    unit_index = calloc(slots, sizeof(int));
+    if (!unit_index) {
+        free(units);
+        units = NULL;
+        return -1;
+    }
+    unit_index_mask = slots - 1;
+
+    eval_stride = RULES_STRIDE(count);
+    eval_values = calloc((size_t)RULE_VALUE_COUNT * (size_t)eval_stride, sizeof(float));
+    eval_due = calloc((size_t)eval_stride, sizeof(int32_t));
+    eval_status = calloc((size_t)eval_stride, sizeof(int32_t));
+    eval_message = calloc((size_t)eval_stride, sizeof(int32_t));
+    eval_proximity = calloc((size_t)eval_stride, sizeof(float));
+    if (!eval_values || !eval_due || !eval_status || !eval_message || !eval_proximity) {
+        unit_count = 0;
+        free_registry();
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        UnitState *u = &units[i];
+        u->ring = sample_ring_create();
+        u->history = history_create();
+        if (!u->ring || !u->history) {
+            unit_count = i + 1;
+            free_registry();
+            return -1;
+        }
+        seqlock_init(&u->seq);
+        seqlock_init(&u->rule_seq);
+        seqlock_init(&u->spec_seq);
+        snprintf(u->health.unit_id, MAX_ID_LENGTH, "%s", list[i].unit_id);
+        u->id_hash = hash_unit_id(u->health.unit_id);
+        u->board = list[i].board;
+        u->running_hz = list[i].rpm > 0.0f ? list[i].rpm / 60.0f : 0.0f;
+
+        uint32_t slot = u->id_hash & unit_index_mask;
+        while (unit_index[slot])
+            slot = (slot + 1) & unit_index_mask;
+        unit_index[slot] = i + 1;
+    }
+
+    unit_count = count;
+    return 0;
+}
+
+// ============================================================
+// ACQUISITION CONTROL
+// ============================================================
+
+// rate_request word: bits 0-31 fixed rate in Hz (0 = adaptive),
+// bits 32-63 window length in ms
+static inline uint64_t pack_request(uint32_t fixed_rate_hz, uint32_t window_ms)
+{
+    return (uint64_t)fixed_rate_hz | ((uint64_t)window_ms << 32);
+}
+
+static inline uint32_t window_ms_to_blocks(uint32_t window_ms)
+{
+    uint64_t blocks = ((uint64_t)window_ms * 1000000ULL + BLOCK_PERIOD_NS / 2) / BLOCK_PERIOD_NS;
+    return blocks ? (uint32_t)blocks : 1;
+}
+
+static void set_rate(UnitState *u, uint32_t rate_hz)
+{
+    if (rate_hz > block_max_rate_hz)
+        rate_hz = block_max_rate_hz;
+    if (rate_hz == u->rate_hz)
+        return;
+
+    // Spectra must not mix rates: consumers only use samples from here on
+    uint64_t first = atomic_load_explicit(&u->ring->head, memory_order_relaxed);
+    u->rate_hz = rate_hz;
+    u->sample_credit = 0;
+    atomic_store_explicit(&u->rate_epoch, (first << RATE_EPOCH_BITS) | rate_hz,
+                          memory_order_release);
+}
+
+/**
+ * update_acquisition: Runs at each window boundary. Applies a pending
+ * session request, then lets the adaptive policy pick the next rate.
+ */
+static void update_acquisition(UnitState *u)
+{
+    uint64_t req = atomic_load_explicit(&u->rate_request, memory_order_acquire);
+
+    if (req != u->applied_request) {
+        u->applied_request = req;
+        u->fixed_rate_hz = (uint32_t)req;
+        u->window_blocks = window_ms_to_blocks((uint32_t)(req >> 32));
+        u->calm_windows = 0;
+    }
+
+    if (u->fixed_rate_hz) {
+        set_rate(u, u->fixed_rate_hz);
+        return;
+    }
+
+    float proximity = u->proximity;
+    if (u->next.status != HEALTH_HEALTHY || proximity >= ADAPT_APPROACH) {
+        u->calm_windows = 0;
+        set_rate(u, ADAPT_HIGH_RATE_HZ);
+    } else if (proximity < ADAPT_CALM) {
+        if (u->calm_windows < ADAPT_CALM_WINDOWS)
+            u->calm_windows++;
+        if (u->calm_windows >= ADAPT_CALM_WINDOWS || u->rate_hz == ADAPT_LOW_RATE_HZ)
+            set_rate(u, ADAPT_LOW_RATE_HZ);
+    } else {
+        u->calm_windows = 0;   // between CALM and APPROACH: hold the current rate
+    }
+}
+
 // ============================================================
-// BACKGROUND POLLING THREAD (1kHz)
+// BACKGROUND POLLING THREAD (block mode)
 // ============================================================
+static void acquire_block(UnitState *u, HwBlock *blk)
+{
+    // Samples owed for one period at the unit's rate; the remainder carries
+    // over so rates that are not a multiple of 200 Hz stay exact on average
+    u->sample_credit += (uint64_t)u->rate_hz * (uint64_t)BLOCK_PERIOD_NS;
+    int want = (int)(u->sample_credit / 1000000000ULL);
+    if (want == 0)
+        return;
+    u->sample_credit -= (uint64_t)want * 1000000000ULL;
+
+    int n = hw_read_block(blk, want, u->rate_hz);
+    if (n <= 0)
+        return;
+
+    for (int i = 0; i < n; i++) {
+        window_stats_add(&u->stats[CH_VIBRATION], blk->vibration[i]);
+        window_stats_add(&u->stats[CH_SOUND], (float)blk->sound[i]);
+        sample_ring_push(u->ring, blk->t0_ns + (uint64_t)i * blk->period_ns,
+                         blk->vibration[i], blk->sound[i]);
+    }
+}
+
+// Folds slow-channel readings published since the last tick into the
+// open window: one relaxed load per channel, no bus access
+static inline void merge_slow_channels(UnitState *u)
+{
+    for (int k = 0; k < SLOW_CHANNEL_COUNT; k++) {
+        uint64_t w = atomic_load_explicit(&u->slow_latest[k], memory_order_relaxed);
+        uint32_t count = (uint32_t)(w >> 32);
+        uint32_t bits = (uint32_t)w;
+
+        if (count == u->slow_seen[k])
+            continue;
+        u->slow_seen[k] = count;
+        memcpy(&u->slow_last[k], &bits, sizeof(float));
+        window_stats_add(&u->stats[slow_channels[k].ch], u->slow_last[k]);
+    }
+}
+
+/**
+ * close_window: Turns the open window of unit i into features and levels
+ * and queues its values for the tick's batch rule evaluation.
+ */
+static void close_window(UnitState *u, int i, const RuleSet *rules)
+{
+    EquipmentHealth *next = &u->next;
+
+    // A window shorter than a slow period holds the last reading
+    for (int k = 0; k < SLOW_CHANNEL_COUNT; k++) {
+        WindowStats *w = &u->stats[slow_channels[k].ch];
+        if (w->n == 0 && u->slow_seen[k] != 0)
+            window_stats_add(w, u->slow_last[k]);
+    }
+
+    for (int c = 0; c < CH_COUNT; c++)
+        window_stats_finish(&u->stats[c], &next->features[c]);
+
+    // Populate Snapshot. Levels come from per-sample means, so they are
+    // independent of the rate and window length: vibration is events/s
+    // at the 1 kHz reference, sound is duty cycle %.
+    next->snapshot.vibration_level = next->features[CH_VIBRATION].mean * REFERENCE_RATE_HZ;
+    next->snapshot.sound_level = 100.0f * next->features[CH_SOUND].mean;
+    next->snapshot.temperature_c = next->features[CH_TEMPERATURE].mean;
+    next->snapshot.current_a = next->features[CH_CURRENT].mean;
+    next->sample_rate_hz = u->rate_hz;
+    next->window_ms = (uint32_t)((uint64_t)u->window_blocks * BLOCK_PERIOD_NS / 1000000ULL);
+    next->adaptive = u->fixed_rate_hz == 0;
+
+    rules_fill_values(rules, next, eval_values, i);
+    eval_due[i] = -1;
+
+    for (int c = 0; c < CH_COUNT; c++)
+        window_stats_reset(&u->stats[c]);
+    u->blocks_done = 0;
+}
+
+/**
+ * publish_unit: Takes unit i's verdict from the batch, publishes it with
+ * its close time t_ms and the rule state behind it, and folds the
+ * window's levels into the unit's history. The message is an id into
+ * the static rules_message() table; readers resolve it, so nothing is
+ * copied here.
+ */
+static void publish_unit(UnitState *u, int i, uint64_t t_ms, const RuleSet *rules)
+{
+    EquipmentHealth *next = &u->next;
+    RuleUnitState rs;
+
+    next->window_end_ms = t_ms;
+    next->status = (HealthStatus)eval_status[i];
+    next->message_id = (uint32_t)eval_message[i];
+    u->proximity = eval_proximity[i];
+    eval_due[i] = 0;
+
+    // Publish: bounded memcpy, never waits on a reader
+    seqlock_publish(&u->seq, &u->health, next, sizeof(EquipmentHealth));
+    rules_get_state(rules, i, &rs);
+    seqlock_publish(&u->rule_seq, &u->rule_state, &rs, sizeof(RuleUnitState));
+
+    const float level[CH_COUNT] = {
+        next->snapshot.vibration_level, next->snapshot.sound_level,
+        next->snapshot.temperature_c, next->snapshot.current_a
+    };
+    history_add(u->history, t_ms / 1000u, level);
+}
+
+static inline uint64_t timespec_ns(const struct timespec *ts)
+{
+    return (uint64_t)ts->tv_sec * 1000000000ULL + (uint64_t)ts->tv_nsec;
+}
+
+static inline uint64_t monotonic_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timespec_ns(&now);
+}
+
+// Single writer (polling_thread): relaxed load/store instead of an RMW
+static inline void counter_add(atomic_uint_least64_t *c, uint64_t v)
+{
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + v,
+                          memory_order_relaxed);
+}
+
 void* polling_thread(void* arg) {
     (void)arg; // Silence the unused variable warning
-    float vib_accum = 0.0f;
-    uint32_t snd_counts = 0;
-    int seconds_counter = 0;
+    int report_counter = 0;
+    int selected_board = -1;
     struct timespec next_tick;
     uint64_t jitter_sum_ns = 0;
     uint64_t jitter_max_ns = 0;
+    uint64_t jitter_samples = 0;
+    uint64_t wake_ns;
+    static float blk_vibration[HW_BLOCK_MAX_SAMPLES];
+    static uint8_t blk_sound[HW_BLOCK_MAX_SAMPLES];
+    HwBlock blk = { 0, 0, blk_vibration, blk_sound };
+    const int report_blocks = (int)(1000000000L / BLOCK_PERIOD_NS);   // jitter line every 1 s
+    RtFaults faults_base, faults_seen;
+    int fault_reports = 0;
+
+    rt_profile_enter_thread(&rt_profile);
 
-    printf("[SENSORS] Background polling thread started.\n");
+    log_info("[SENSORS] Background polling thread started (%d unit%s, %ld us blocks, %u-%u Hz).\n",
+             unit_count, unit_count == 1 ? "" : "s", BLOCK_PERIOD_NS / 1000L,
+             ADAPT_LOW_RATE_HZ < block_max_rate_hz ? ADAPT_LOW_RATE_HZ : block_max_rate_hz,
+             block_max_rate_hz);
+
+    // Work on private copies; only the final publish touches shared state.
+    for (int i = 0; i < unit_count; i++) {
+        UnitState *u = &units[i];
+        memcpy(&u->next, &u->health, sizeof(EquipmentHealth));
+        for (int c = 0; c < CH_COUNT; c++)
+            window_stats_reset(&u->stats[c]);
+
+        // Until the first window closes, sample at full rate
+        u->applied_request = atomic_load_explicit(&u->rate_request, memory_order_acquire);
+        u->fixed_rate_hz = (uint32_t)u->applied_request;
+        u->window_blocks = window_ms_to_blocks((uint32_t)(u->applied_request >> 32));
+        set_rate(u, u->fixed_rate_hz ? u->fixed_rate_hz : ADAPT_HIGH_RATE_HZ);
+    }
 
     if (clock_gettime(CLOCK_MONOTONIC, &next_tick) != 0) {
-        perror("clock_gettime failed");
+        log_error("[SENSORS] clock_gettime failed: %s\n", strerror(errno));
         return NULL;
     }
+    wake_ns = timespec_ns(&next_tick);
+    rt_profile_faults(&faults_base);
+    faults_seen = faults_base;
+    const RuleSet *seen_rules = atomic_load_explicit(&active_rules, memory_order_acquire);
 
     while (running) {
-        // 1. High-Frequency Digital Polling (GPIO)
-        vib_accum += hw_read_vibration_i2c();
-        if (hw_read_pin(PIN_SOUND)) snd_counts++;
+        RuleSet *rules = atomic_load_explicit(&active_rules, memory_order_acquire);
+        int closed = 0;
+
+        // A reloaded set starts blank: carry over each unit's alarm levels
+        // and debounce counts as of its last judged window, so a reload
+        // neither clears a raised alarm nor re-raises it
+        if (rules != seen_rules) {
+            for (int i = 0; i < unit_count; i++)
+                rules_set_state(rules, i, &units[i].rule_state);
+            seen_rules = rules;
+        }
+
+        // 1. Drain one FIFO block per unit, one board at a time, and close
+        //    the unit's window when it has run for its configured length
+        for (int i = 0; i < unit_count; i++) {
+            UnitState *u = &units[i];
+            if (u->board != selected_board) {
+                hw_select_unit(u->board);
+                selected_board = u->board;
+            }
+            acquire_block(u, &blk);
+            merge_slow_channels(u);
 
-        // 2. Accumulation & Evaluation (Every 1 second / 1000 ticks)
-        add_ns(&next_tick, POLL_INTERVAL_NS);
+            if (++u->blocks_done >= u->window_blocks) {
+                close_window(u, i, rules);
+                closed++;
+            }
+        }
+
+        // Judge every window closed this tick in one pass, then publish
+        if (closed) {
+            uint64_t t_ms = (uint64_t)((int64_t)(wake_ns / 1000000ULL) + wall_epoch_ms);
+
+            rules_evaluate(rules, eval_values, eval_due, eval_status, eval_message, eval_proximity);
+            for (int i = 0; i < unit_count; i++) {
+                if (eval_due[i]) {
+                    publish_unit(&units[i], i, t_ms, rules);
+                    update_acquisition(&units[i]);
+                }
+            }
+        }
+
+        // 2. Loop diagnostics (every 1 second)
+        if (++report_counter >= report_blocks) {
+            // Deferred formatting: the writer thread does the printf work
+            rt_log_u64(RT_LOG_STDOUT, "[RT] Poll loop jitter: avg=%llu us max=%llu us\n",
+                       (jitter_samples ? jitter_sum_ns / jitter_samples : 0) / 1000ULL,
+                       jitter_max_ns / 1000ULL, 0, 0);
+
+            // Page faults: any fault here is a latency spike worth naming.
+            // The first second is always reported as a startup check.
+            RtFaults f;
+            rt_profile_faults(&f);
+            if (f.major != faults_seen.major || f.minor != faults_seen.minor || fault_reports == 0) {
+                rt_log_u64(fault_reports == 0 ? RT_LOG_STDOUT : RT_LOG_STDERR,
+                           "[RT] Poll loop page faults: major=%llu minor=%llu (+%llu/+%llu in the last second)\n",
+                           f.major - faults_base.major, f.minor - faults_base.minor,
+                           f.major - faults_seen.major, f.minor - faults_seen.minor);
+                fault_reports++;
+                faults_seen = f;
+                atomic_store_explicit(&rt_major_faults, f.major - faults_base.major, memory_order_relaxed);
+                atomic_store_explicit(&rt_minor_faults, f.minor - faults_base.minor, memory_order_relaxed);
+            }
+
+            // Reset local counters for the next second
+            report_counter = 0;
+            jitter_sum_ns = 0;
+            jitter_max_ns = 0;
+            jitter_samples = 0;
+        }
+
+        // 3. Execution time and deadline accounting
+        uint64_t done_ns = monotonic_ns();
+        lat_hist_record(&exec_hist, done_ns - wake_ns);
+        counter_add(&rt_loops, 1);
+
+        // Quiescent state: 'rules' is not used past this point
+        atomic_store_explicit(&rules_qs, atomic_load_explicit(&rules_qs, memory_order_relaxed) + 1,
+                              memory_order_release);
+
+        add_ns(&next_tick, BLOCK_PERIOD_NS);
+        uint64_t tgt_ns = timespec_ns(&next_tick);
+        if (done_ns > tgt_ns) {
+            counter_add(&rt_missed_deadlines, 1);
+
+            // Overran by whole periods: resynchronise instead of bursting
+            uint64_t skip = (done_ns - tgt_ns) / (uint64_t)BLOCK_PERIOD_NS;
+            if (skip > 0) {
+                add_ns(&next_tick, (long)(skip * (uint64_t)BLOCK_PERIOD_NS));
+                tgt_ns = timespec_ns(&next_tick);
+                counter_add(&rt_skipped_ticks, skip);
+
+                // Keep windows aligned to wall time
+                report_counter += (int)skip;
+                for (int i = 0; i < unit_count; i++) {
+                    uint32_t done = units[i].blocks_done + (uint32_t)skip;
+                    units[i].blocks_done = done < units[i].window_blocks ? done
+                                                                         : units[i].window_blocks - 1;
+                }
+            }
+        }
+
+        // 4. Sleep until the next block deadline (absolute, drift-free)
 #ifdef __QNX__
         while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_tick, NULL) == EINTR) {
         }
 #else
         if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_tick, NULL) != 0)
-            usleep(1000);
+            usleep(BLOCK_PERIOD_NS / 1000);
 #endif
 
+        wake_ns = monotonic_ns();
         {
-            struct timespec now;
-            if (clock_gettime(CLOCK_MONOTONIC, &now) == 0) {
-                uint64_t now_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
-                uint64_t tgt_ns = (uint64_t)next_tick.tv_sec * 1000000000ULL + (uint64_t)next_tick.tv_nsec;
-                uint64_t jitter_ns = now_ns > tgt_ns ? now_ns - tgt_ns : tgt_ns - now_ns;
-                jitter_sum_ns += jitter_ns;
-                if (jitter_ns > jitter_max_ns)
-                    jitter_max_ns = jitter_ns;
-            }
+            uint64_t jitter_ns = wake_ns > tgt_ns ? wake_ns - tgt_ns : tgt_ns - wake_ns;
+            lat_hist_record(&wakeup_hist, wake_ns > tgt_ns ? wake_ns - tgt_ns : 0);
+            jitter_sum_ns += jitter_ns;
+            jitter_samples++;
+            if (jitter_ns > jitter_max_ns)
+                jitter_max_ns = jitter_ns;
         }
+    }
+    return NULL;
+}
 
-        seconds_counter++;
-
-        if (seconds_counter >= 1000) {
-            pthread_mutex_lock(&data_mutex);
-            
-            // Populate Snapshot
-            current_health.snapshot.vibration_level = vib_accum;
-            current_health.snapshot.sound_level = (float)(snd_counts / 10.0); // Simple duty cycle %
-            current_health.snapshot.temperature_c = hw_read_temp_i2c();
-            current_health.snapshot.current_a = hw_read_current_i2c();
-
-            // Evaluate Health Status
-            if (current_health.snapshot.vibration_level > VIB_CRITICAL_THRESHOLD || 
-                current_health.snapshot.current_a > CUR_CRITICAL_THRESHOLD) {
-                current_health.status = HEALTH_CRITICAL;
-                strcpy(current_health.message, "CRITICAL FAULT DETECTED");
-            } 
-            else if (current_health.snapshot.vibration_level > VIB_WARNING_THRESHOLD) {
-                current_health.status = HEALTH_WARNING;
-                strcpy(current_health.message, "High Vibration Warning");
-            } 
-            else {
-                current_health.status = HEALTH_HEALTHY;
-                strcpy(current_health.message, "System Nominal");
-            }
+// ============================================================
+// SPECTRUM WORKER (non-RT)
+// ============================================================
 
-            pthread_mutex_unlock(&data_mutex);
+// Frame of about one second at the unit's current rate, as a power of two
+static uint32_t spectrum_frame_size(uint32_t rate_hz)
+{
+    uint32_t n = FFT_MIN_SIZE;
+    while (n * 2 <= rate_hz && n * 2 <= SPECTRUM_FFT_SIZE)
+        n *= 2;
+    return n;
+}
 
-            printf("[RT] Poll loop jitter: avg=%llu us max=%llu us\n",
-                   (unsigned long long)((jitter_sum_ns / 1000ULL) / 1000ULL),
-                   (unsigned long long)(jitter_max_ns / 1000ULL));
+static FftPlan *spectrum_plan_for(uint32_t n)
+{
+    unsigned log2n = 0;
+    while ((1u << log2n) < n) log2n++;
 
-            // Reset local counters for the next second
-            vib_accum = 0.0f;
-            snd_counts = 0;
-            seconds_counter = 0;
-            jitter_sum_ns = 0;
-            jitter_max_ns = 0;
+    if (!spectrum_plans[log2n])
+        spectrum_plans[log2n] = fft_plan_create(n);
+    return spectrum_plans[log2n];
+}
+
+/**
+ * spectrum_thread: Once per SPECTRUM_PERIOD_S, takes about one second of
+ * the latest vibration samples of every unit from its ring (at most
+ * SPECTRUM_FFT_SIZE) and publishes the analysis. Frames that would
+ * straddle a rate change are skipped. Runs at ordinary priority; the RT
+ * loop never waits on it, and a slow pass only means a stale spectrum.
+ */
+static void* spectrum_thread(void* arg) {
+    (void)arg;
+    RawSample *raw = malloc(SPECTRUM_FFT_SIZE * sizeof(RawSample));
+    float *frame = malloc(SPECTRUM_FFT_SIZE * sizeof(float));
+    SpectrumResult *res = malloc(sizeof(SpectrumResult));
+    struct timespec next;
+
+    if (!raw || !frame || !res) {
+        log_error("[SPECTRUM] Out of memory, spectrum worker disabled\n");
+        free(raw);
+        free(frame);
+        free(res);
+        return NULL;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (running) {
+        next.tv_sec += SPECTRUM_PERIOD_S;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {
+        }
+        if (!running)
+            break;
+
+        for (int i = 0; i < unit_count; i++) {
+            UnitState *u = &units[i];
+            SampleCursor cur;
+            uint64_t epoch = atomic_load_explicit(&u->rate_epoch, memory_order_acquire);
+            uint32_t rate = (uint32_t)(epoch & ((1u << RATE_EPOCH_BITS) - 1));
+            uint64_t first_seq = epoch >> RATE_EPOCH_BITS;
+            uint32_t n = spectrum_frame_size(rate);
+            FftPlan *plan = spectrum_plan_for(n);
+
+            if (!rate || !plan)
+                continue;
+
+            sample_ring_cursor_init_latest(u->ring, &cur, n);
+            if (sample_ring_read(u->ring, &cur, raw, (int)n) != (int)n)
+                continue;   // not enough history yet, or lapped mid-read
+            if (raw[0].seq < first_seq ||
+                atomic_load_explicit(&u->rate_epoch, memory_order_acquire) != epoch)
+                continue;   // frame mixes two rates
+
+            for (uint32_t k = 0; k < n; k++)
+                frame[k] = raw[k].vibration;
+
+            spectrum_analyze(plan, frame, rate, u->running_hz, res);
+            res->t_end_ns = raw[n - 1].t_ns;
+            seqlock_publish(&u->spec_seq, &u->spectrum, res, sizeof(SpectrumResult));
+        }
+    }
+
+    free(raw);
+    free(frame);
+    free(res);
+    return NULL;
+}
+
+static void start_spectrum_worker(SensorManager* mgr) {
+    // Create the full-rate plan up front so a broken setup is reported now
+    if (!spectrum_plan_for(SPECTRUM_FFT_SIZE)) {
+        log_error("[SPECTRUM] Failed to create %d-point FFT plan\n", SPECTRUM_FFT_SIZE);
+        return;
+    }
+
+    if (start_worker(&spectrum_tid, spectrum_thread, mgr) != 0) {
+        log_error("[SPECTRUM] Failed to start spectrum worker\n");
+        return;
+    }
+    spectrum_started = 1;
+    log_info("[SPECTRUM] Worker started (up to %d-point FFT every %d s)\n",
+             SPECTRUM_FFT_SIZE, SPECTRUM_PERIOD_S);
+}
+
+// ============================================================
+// WINDOW STORE
+// ============================================================
+
+_Static_assert(sizeof(ChannelFeatures) == MANAGER_STORE_FEATURES * sizeof(float),
+               "store_values writes every ChannelFeatures field");
+
+// One record per window: the four levels, then ChannelFeatures by channel
+static void store_values(const EquipmentHealth *h, float values[MANAGER_STORE_COLUMNS])
+{
+    values[CH_VIBRATION] = h->snapshot.vibration_level;
+    values[CH_SOUND] = h->snapshot.sound_level;
+    values[CH_TEMPERATURE] = h->snapshot.temperature_c;
+    values[CH_CURRENT] = h->snapshot.current_a;
+    for (int c = 0; c < CH_COUNT; c++) {
+        const ChannelFeatures *f = &h->features[c];
+        float *v = &values[CH_COUNT + c * MANAGER_STORE_FEATURES];
+        v[0] = f->mean;
+        v[1] = f->rms;
+        v[2] = f->min;
+        v[3] = f->max;
+        v[4] = f->peak_to_peak;
+        v[5] = f->crest_factor;
+        v[6] = f->skewness;
+        v[7] = f->kurtosis;
+    }
+}
+
+static void publish_telemetry(int i, const EquipmentHealth *h) {
+    telemetry_publish(&units[i].telemetry, (unsigned)i < WIRE_NO_UNIT ? (uint16_t)i : WIRE_NO_UNIT, h);
+}
+
+/**
+ * store_thread: Appends every window published by polling_thread to the
+ * unit's segment store, runs it through the alert engine (alerts.h),
+ * which logs and pushes level changes, and encodes it once for monitor
+ * sessions (telemetry.h). It polls the published health
+ * more often than the shortest window closes, so the RT loop neither
+ * queues records nor touches a file. Stores are sealed when the manager
+ * stops.
+ */
+static void* store_thread(void* arg) {
+    SegStore **stores = arg;
+    uint64_t *last = calloc((size_t)unit_count, sizeof(uint64_t));
+    uint8_t *failing = calloc((size_t)unit_count, 1);
+    AlertUnitState *alert = calloc((size_t)unit_count, sizeof(AlertUnitState));
+    AlertEvent ev;
+    float values[MANAGER_STORE_COLUMNS];
+    EquipmentHealth h;
+    struct timespec next;
+
+    // A window restored from the checkpoint is already stored and
+    // alerted; only its level carries over (so a clear still fires)
+    for (int i = 0; last && alert && i < unit_count; i++) {
+        seqlock_snapshot(&units[i].seq, &h, &units[i].health, sizeof(EquipmentHealth));
+        last[i] = h.window_end_ms;
+        alert_unit_init(&alert[i], h.window_end_ms ? h.status : HEALTH_HEALTHY);
+        if (h.window_end_ms)
+            publish_telemetry(i, &h);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (running && last && failing && alert) {
+        next.tv_nsec += STORE_POLL_NS;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {
+        }
+
+        for (int i = 0; i < unit_count; i++) {
+            seqlock_snapshot(&units[i].seq, &h, &units[i].health, sizeof(EquipmentHealth));
+            if (h.window_end_ms == 0 || h.window_end_ms == last[i])
+                continue;
+            last[i] = h.window_end_ms;
+
+            publish_telemetry(i, &h);
+            if (alert_evaluate(&alert[i], &h, &ev))
+                alerts_publish(&ev);
+            if (!stores[i])
+                continue;
+
+            store_values(&h, values);
+            int rc = segstore_append(stores[i], (int64_t)h.window_end_ms, values);
+            if (rc != 0 && !failing[i])
+                log_error("[STORE] %s: write failed, windows are being dropped\n", h.unit_id);
+            else if (rc == 0 && failing[i])
+                log_info("[STORE] %s: writing again\n", h.unit_id);
+            failing[i] = rc != 0;
+        }
+    }
+
+    for (int i = 0; i < unit_count; i++)
+        segstore_close(stores[i]);
+    free(stores);
+    free(last);
+    free(failing);
+    free(alert);
+    return NULL;
+}
+
+static void start_store_worker(void) {
+    SegStore **stores = calloc((size_t)unit_count, sizeof(SegStore *));
+    int opened = 0;
+
+    if (!stores) {
+        log_error("[STORE] Out of memory, window store disabled\n");
+        return;
+    }
+
+    for (int i = 0; i < unit_count; i++) {
+        char dir[MAX_ID_LENGTH + 16];
+        char err[160];
+
+        snprintf(dir, sizeof(dir), "%s/%s", MANAGER_STORE_DIR, units[i].health.unit_id);
+        for (char *p = dir + strlen(MANAGER_STORE_DIR) + 1; *p; p++)
+            if (*p == '/' || *p == '.')
+                *p = '_';
+
+        stores[i] = segstore_open(dir, MANAGER_STORE_COLUMNS,
+                                  MANAGER_STORE_RETENTION_DAYS * 86400000LL, err, sizeof(err));
+        if (stores[i])
+            opened++;
+        else
+            log_error("[STORE] %s: %s (not persisted)\n", units[i].health.unit_id, err);
+    }
+
+    // Started even without a store: it also runs the alert engine
+    if (start_worker(&store_tid, store_thread, stores) != 0) {
+        log_error("[STORE] Failed to start window store\n");
+        for (int i = 0; i < unit_count; i++)
+            segstore_close(stores[i]);
+        free(stores);
+        return;
+    }
+    store_started = 1;
+    if (opened)
+        log_info("[STORE] Persisting windows of %d unit%s to %s/ (%d-day retention)\n",
+                 opened, opened == 1 ? "" : "s", MANAGER_STORE_DIR, MANAGER_STORE_RETENTION_DAYS);
+}
+
+// ============================================================
+// CHECKPOINTS (warm restart)
+// ============================================================
+
+// Sections of MANAGER_CHECKPOINT_PATH, each keyed by unit id
+enum {
+    CKPT_HEALTH = 1,      // EquipmentHealth of the last window
+    CKPT_RULES,           // RuleUnitState after that window
+    CKPT_ACQUISITION,     // rate_request word (set_rate)
+    CKPT_HISTORY          // history_save image
+};
+
+#define CHECKPOINT_INTERVAL_NS ((uint64_t)MANAGER_CHECKPOINT_INTERVAL_S * 1000000000ULL)
+
+static int checkpoint_failing = 0;
+
+/**
+ * write_checkpoint: Copies every unit through the same lock-free paths
+ * the sessions read and commits them as one file. The RT loop is never
+ * touched or waited for. About 250 KB per unit, mostly history.
+ */
+static int write_checkpoint(void)
+{
+    Checkpoint *cp = checkpoint_buf;
+    EquipmentHealth h;
+    RuleUnitState rs;
+    char err[160];
+    long rc = 0;
+
+    checkpoint_reset(cp);
+    for (int i = 0; i < unit_count && rc == 0; i++) {
+        UnitState *u = &units[i];
+        const char *id = u->health.unit_id;   // never changes after init
+        uint64_t req = atomic_load_explicit(&u->rate_request, memory_order_relaxed);
+        void *image;
+
+        seqlock_snapshot(&u->seq, &h, &u->health, sizeof(EquipmentHealth));
+        seqlock_snapshot(&u->rule_seq, &rs, &u->rule_state, sizeof(RuleUnitState));
+        if (h.window_end_ms != 0 &&
+            (checkpoint_add(cp, CKPT_HEALTH, id, &h, sizeof(h)) != 0 ||
+             checkpoint_add(cp, CKPT_RULES, id, &rs, sizeof(rs)) != 0))
+            rc = -1;
+        else if (checkpoint_add(cp, CKPT_ACQUISITION, id, &req, sizeof(req)) != 0)
+            rc = -1;
+        else if ((image = checkpoint_reserve(cp, CKPT_HISTORY, id, history_image_size())) == NULL)
+            rc = -1;
+        else
+            history_save(u->history, image);
+    }
+
+    if (rc != 0)
+        snprintf(err, sizeof(err), "out of memory");
+    else
+        rc = checkpoint_commit(cp, MANAGER_CHECKPOINT_PATH, err, sizeof(err));
+
+    if (rc < 0 && !checkpoint_failing)
+        log_error("[CHECKPOINT] %s; restart state is getting old\n", err);
+    else if (rc >= 0 && checkpoint_failing)
+        log_info("[CHECKPOINT] Writing again\n");
+    checkpoint_failing = rc < 0;
+    return rc < 0 ? -1 : 0;
+}
+
+/**
+ * checkpoint_thread: Writes a checkpoint every MANAGER_CHECKPOINT_INTERVAL_S
+ * at ordinary priority. The final one is written by manager_cleanup once
+ * every other thread has stopped.
+ */
+static void* checkpoint_thread(void* arg) {
+    (void)arg;
+    uint64_t due = monotonic_ns() + CHECKPOINT_INTERVAL_NS;
+
+    while (running) {
+        uint64_t now = monotonic_ns();
+
+        if (now >= due) {
+            write_checkpoint();
+            due += CHECKPOINT_INTERVAL_NS;
+            if (due <= now)
+                due = now + CHECKPOINT_INTERVAL_NS;
+        }
+
+        uint64_t wake = due < now + SLOW_MAX_SLEEP_NS ? due : now + SLOW_MAX_SLEEP_NS;
+        struct timespec ts = { (time_t)(wake / 1000000000ULL), (long)(wake % 1000000000ULL) };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
         }
     }
     return NULL;
 }
 
+static void start_checkpoint_worker(void) {
+    checkpoint_buf = checkpoint_create();
+    if (!checkpoint_buf) {
+        log_error("[CHECKPOINT] Out of memory, checkpoints disabled\n");
+        return;
+    }
+    if (start_worker(&checkpoint_tid, checkpoint_thread, NULL) != 0) {
+        log_error("[CHECKPOINT] Failed to start checkpoint worker\n");
+        checkpoint_destroy(checkpoint_buf);
+        checkpoint_buf = NULL;
+        return;
+    }
+    checkpoint_started = 1;
+    log_info("[CHECKPOINT] Saving state to %s every %d s\n",
+             MANAGER_CHECKPOINT_PATH, MANAGER_CHECKPOINT_INTERVAL_S);
+}
+
+typedef struct {
+    RuleSet *rules;
+    int64_t created_ms;   // set by checkpoint_load before the first section
+    int64_t now_ms;
+    uint8_t *restored;    // per unit
+} RestoreCtx;
+
+static int valid_request(uint64_t req)
+{
+    uint32_t rate = (uint32_t)req;
+    uint32_t window = (uint32_t)(req >> 32);
+
+    return (rate == 0 || (rate >= MANAGER_MIN_RATE_HZ && rate <= MANAGER_MAX_RATE_HZ)) &&
+           window >= MANAGER_MIN_WINDOW_MS && window <= MANAGER_MAX_WINDOW_MS;
+}
+
+static int restore_section(void *arg, uint32_t tag, const char *key, const void *data, size_t len)
+{
+    RestoreCtx *rc = arg;
+    UnitState *u = find_unit(key);
+    int live = rc->now_ms - rc->created_ms <= MANAGER_CHECKPOINT_MAX_AGE_S * 1000LL;
+
+    if (!u)
+        return 0;   // unit no longer in units.conf
+    int i = (int)(u - units);
+
+    if (tag == CKPT_HEALTH && live && len == sizeof(EquipmentHealth)) {
+        EquipmentHealth h;
+        memcpy(&h, data, len);
+        if ((unsigned)h.status > HEALTH_CRITICAL)
+            return 0;
+        memcpy(h.unit_id, u->health.unit_id, MAX_ID_LENGTH);
+        h.message[0] = '\0';
+        seqlock_publish(&u->seq, &u->health, &h, sizeof(EquipmentHealth));
+        rc->restored[i] = 1;
+    } else if (tag == CKPT_RULES && live && len == sizeof(RuleUnitState)) {
+        RuleUnitState rs;
+        memcpy(&rs, data, len);
+        rules_set_state(rc->rules, i, &rs);
+        seqlock_publish(&u->rule_seq, &u->rule_state, &rs, sizeof(RuleUnitState));
+    } else if (tag == CKPT_ACQUISITION && len == sizeof(uint64_t)) {
+        uint64_t req;
+        memcpy(&req, data, len);
+        if (valid_request(req))
+            atomic_store_explicit(&u->rate_request, req, memory_order_relaxed);
+    } else if (tag == CKPT_HISTORY) {
+        if (history_restore(u->history, data, len) == 0)
+            rc->restored[i] = 1;
+    }
+    return 0;
+}
+
+/**
+ * restore_checkpoint: Loads MANAGER_CHECKPOINT_PATH into the registry
+ * and rules before any thread starts. A missing, torn or corrupt file
+ * only means a cold start.
+ */
+static void restore_checkpoint(RuleSet *rules)
+{
+    RestoreCtx rc = { rules, 0, 0, calloc((size_t)unit_count, 1) };
+    struct timespec wall;
+    char err[160];
+    uint64_t t0 = monotonic_ns();
+
+    if (!rc.restored)
+        return;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    rc.now_ms = (int64_t)(timespec_ns(&wall) / 1000000ULL);
+
+    int sections = checkpoint_load(MANAGER_CHECKPOINT_PATH, restore_section, &rc,
+                                   &rc.created_ms, err, sizeof(err));
+    if (sections < 0) {
+        log_error("[CHECKPOINT] %s; cold start\n", err);
+    } else if (sections > 0) {
+        int n = 0;
+        long long age_s = (long long)((rc.now_ms - rc.created_ms) / 1000);
+        for (int i = 0; i < unit_count; i++)
+            n += rc.restored[i];
+        log_info("[CHECKPOINT] Restored %d of %d unit%s from %s (saved %lld s ago%s) in %.1f ms\n",
+                 n, unit_count, unit_count == 1 ? "" : "s", MANAGER_CHECKPOINT_PATH, age_s,
+                 age_s > MANAGER_CHECKPOINT_MAX_AGE_S ? ", history only" : "",
+                 (double)(monotonic_ns() - t0) / 1e6);
+    }
+    free(rc.restored);
+}
+
+// ============================================================
+// SLOW-CHANNEL SCHEDULER
+// ============================================================
+
+/**
+ * SlowTask: One slow channel of one unit. Each task alternates between
+ * starting a conversion and collecting it, so conversions on different
+ * boards and channels overlap instead of queueing behind each other.
+ */
+typedef struct {
+    UnitState *u;
+    int slot;                 // index into slow_channels
+    int converting;
+    uint64_t period_start_ns;
+    uint64_t due_ns;          // next start or collect
+    uint64_t errors;
+} SlowTask;
+
+static void slow_publish(UnitState *u, int slot, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    // Only slow_thread writes the word: no RMW needed
+    uint64_t prev = atomic_load_explicit(&u->slow_latest[slot], memory_order_relaxed);
+    uint64_t count = (prev >> 32) + 1;
+    atomic_store_explicit(&u->slow_latest[slot], (count << 32) | bits, memory_order_relaxed);
+}
+
+static void slow_failed(SlowTask *t, const char *what)
+{
+    // First failure and every 100th after that, so a dead sensor stays visible
+    if (t->errors++ % 100 == 0)
+        log_error("[SLOW] %s: %s %s failed (%llu errors)\n",
+                  t->u->health.unit_id, slow_channels[t->slot].name, what,
+                  (unsigned long long)t->errors);
+}
+
+static void run_slow_task(SlowTask *t, uint64_t now_ns)
+{
+    const SlowChannelSpec *spec = &slow_channels[t->slot];
+    uint64_t period_ns = (uint64_t)spec->period_ms * 1000000ULL;
+
+    if (!t->converting) {
+        int wait_us = hw_slow_start(t->u->board, spec->ch);
+        t->period_start_ns = t->due_ns;
+        if (wait_us >= 0) {
+            t->converting = 1;
+            t->due_ns = now_ns + (uint64_t)wait_us * 1000ULL;
+            return;
+        }
+        slow_failed(t, "start");
+    } else {
+        float value;
+        t->converting = 0;
+        if (hw_slow_read(t->u->board, spec->ch, &value) == 0)
+            slow_publish(t->u, t->slot, value);
+        else
+            slow_failed(t, "read");
+    }
+
+    // Next conversion on the period grid; a late sensor skips, never bursts
+    t->due_ns = t->period_start_ns + period_ns;
+    if (t->due_ns <= now_ns)
+        t->due_ns += ((now_ns - t->due_ns) / period_ns + 1) * period_ns;
+}
+
+static void* slow_thread(void* arg) {
+    SlowTask *tasks = arg;
+    int count = unit_count * SLOW_CHANNEL_COUNT;
+
+    while (running) {
+        uint64_t now = monotonic_ns();
+        uint64_t wake = now + SLOW_MAX_SLEEP_NS;
+
+        for (int i = 0; i < count; i++) {
+            if (tasks[i].due_ns <= now)
+                run_slow_task(&tasks[i], now);
+            if (tasks[i].due_ns < wake)
+                wake = tasks[i].due_ns;
+        }
+
+        struct timespec ts = { (time_t)(wake / 1000000000ULL), (long)(wake % 1000000000ULL) };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        }
+    }
+
+    free(tasks);
+    return NULL;
+}
+
+static int start_slow_scheduler(void) {
+    int count = unit_count * SLOW_CHANNEL_COUNT;
+    SlowTask *tasks = calloc((size_t)count, sizeof(SlowTask));
+    uint64_t now = monotonic_ns();
+
+    if (!tasks)
+        return -1;
+
+    // Stagger units by 1 ms so their bus transactions do not coincide
+    for (int i = 0; i < unit_count; i++) {
+        for (int k = 0; k < SLOW_CHANNEL_COUNT; k++) {
+            SlowTask *t = &tasks[i * SLOW_CHANNEL_COUNT + k];
+            t->u = &units[i];
+            t->slot = k;
+            t->due_ns = now + (uint64_t)i * 1000000ULL;
+        }
+    }
+
+    if (start_worker(&slow_tid, slow_thread, tasks) != 0) {
+        free(tasks);
+        return -1;
+    }
+    slow_started = 1;
+    log_info("[SLOW] Slow-channel scheduler started (%d task%s)\n", count, count == 1 ? "" : "s");
+    return 0;
+}
+
+// ============================================================
+// THRESHOLD RULES
+// ============================================================
+
+// Compiles path for the registered units; NULL on error (see rules_load)
+static RuleSet *compile_rules(const char *path, char *err, size_t err_len)
+{
+    char (*ids)[MAX_ID_LENGTH] = calloc((size_t)unit_count, MAX_ID_LENGTH);
+    RuleSet *rs;
+
+    if (!ids) {
+        snprintf(err, err_len, "out of memory");
+        return NULL;
+    }
+    for (int i = 0; i < unit_count; i++)
+        memcpy(ids[i], units[i].health.unit_id, MAX_ID_LENGTH);
+
+    rs = rules_load(path, (const char (*)[MAX_ID_LENGTH])ids, unit_count, err, err_len);
+    free(ids);
+    return rs;
+}
+
 // ============================================================
 // PUBLIC API
 // ============================================================
 
 int manager_init(SensorManager* mgr) {
     pthread_attr_t attr;
+    UnitEntry *list = NULL;
+    int count = 0;
 
     if (hw_init() != 0) return -1;
 
-    // Initialize state
-    memset(&current_health, 0, sizeof(EquipmentHealth));
-    strcpy(current_health.unit_id, "Sentinel-RT");
-    
-    running = 1;
-    mgr->is_running = 1;
+    block_max_rate_hz = hw_block_max_rate();
+    if (block_max_rate_hz > MANAGER_MAX_RATE_HZ)
+        block_max_rate_hz = MANAGER_MAX_RATE_HZ;
+    else if (block_max_rate_hz < MANAGER_MIN_RATE_HZ)
+        block_max_rate_hz = MANAGER_MIN_RATE_HZ;
+    if (block_max_rate_hz < MANAGER_MAX_RATE_HZ)
+        log_info("[SENSORS] HAL has no sample FIFO: fast channels capped at %u Hz\n",
+                 block_max_rate_hz);
 
-    // Start background thread with explicit RT scheduling on QNX.
-    if (pthread_attr_init(&attr) != 0) {
-        perror("pthread_attr_init failed");
+    // Lock and prefault memory before the registry and rings are allocated
+    rt_profile_load(RT_PROFILE_CONFIG, &rt_profile);
+    rt_profile_apply_process(&rt_profile);
+
+    // Initialize unit registry
+    if (load_unit_config(UNITS_CONFIG, &list, &count) != 0) {
+        log_error("[SENSORS] Out of memory reading %s\n", UNITS_CONFIG);
+        free(list);
+        return -1;
+    }
+    if (count == 0) {
+        int cap = 0;
+        if (append_entry(&list, &count, &cap, DEFAULT_UNIT_ID, 0, 0.0f) != 0) {
+            free(list);
+            return -1;
+        }
+    }
+    if (build_registry(list, count) != 0) {
+        log_error("[SENSORS] Failed to allocate registry for %d units\n", count);
+        free(list);
         return -1;
     }
+    free(list);
 
-#ifdef __QNX__
+    for (int i = 0; i < unit_count; i++) {
+        atomic_init(&units[i].rate_request, pack_request(0, DEFAULT_WINDOW_MS));
+        atomic_init(&units[i].rate_epoch, 0);
+        for (int k = 0; k < SLOW_CHANNEL_COUNT; k++)
+            atomic_init(&units[i].slow_latest[k], 0);
+        log_info("[SENSORS] Registered unit '%s' on board %d\n", units[i].health.unit_id, units[i].board);
+    }
+
+    // A broken rule file must not keep the line unmonitored: fall back
+    // to the built-in limits and let the operator fix and reload
     {
-        struct sched_param sp;
-        memset(&sp, 0, sizeof(sp));
-        sp.sched_priority = 60;
+        char err[160];
+        RuleSet *rs = compile_rules(RULES_CONFIG, err, sizeof(err));
+        if (!rs) {
+            log_error("[SENSORS] %s; using built-in limits\n", err);
+            rs = compile_rules(NULL, err, sizeof(err));
+        }
+        if (!rs) {
+            log_error("[SENSORS] %s\n", err);
+            free_registry();
+            return -1;
+        }
+        atomic_init(&active_rules, rs);
+        atomic_init(&rules_qs, 0);
+        log_info("[SENSORS] Loaded %d threshold rule%s\n", rules_count(rs), rules_count(rs) == 1 ? "" : "s");
 
-        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
-        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
-        pthread_attr_setschedparam(&attr, &sp);
+        // Last windows, alarms and history from before the restart
+        restore_checkpoint(rs);
     }
-#endif
 
-    if (pthread_create(&mgr->thread_id, &attr, polling_thread, mgr) != 0) {
-        perror("pthread_create failed");
+    lat_hist_init(&wakeup_hist);
+    lat_hist_init(&exec_hist);
+    atomic_init(&rt_loops, 0);
+    atomic_init(&rt_missed_deadlines, 0);
+    atomic_init(&rt_skipped_ticks, 0);
+    atomic_init(&rt_major_faults, 0);
+    atomic_init(&rt_minor_faults, 0);
+    rt_start_ns = monotonic_ns();
+    {
+        struct timespec wall;
+        clock_gettime(CLOCK_REALTIME, &wall);
+        wall_epoch_ms = (int64_t)(timespec_ns(&wall) / 1000000ULL) - (int64_t)(rt_start_ns / 1000000ULL);
+    }
+
+    running = 1;
+    mgr->is_running = 1;
+
+    // Start background thread with the RT profile (SCHED_FIFO, affinity, stack)
+    if (pthread_attr_init(&attr) != 0) {
+        log_error("[SENSORS] pthread_attr_init failed\n");
+        rules_free(atomic_exchange(&active_rules, NULL));
+        free_registry();
+        return -1;
+    }
+    rt_profile_thread_attr(&rt_profile, &attr);
+
+    int rc = pthread_create(&mgr->thread_id, &attr, polling_thread, mgr);
+    if (rc == EPERM && rt_profile.priority > 0) {
+        // Unprivileged (no CAP_SYS_NICE / rtprio limit): run, but say so
+        log_error("[SENSORS] SCHED_FIFO %d not permitted; poll loop runs without RT priority\n",
+                  rt_profile.priority);
+        pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+        rc = pthread_create(&mgr->thread_id, &attr, polling_thread, mgr);
+    }
+    if (rc != 0) {
+        log_error("[SENSORS] pthread_create failed: %s\n", strerror(rc));
         pthread_attr_destroy(&attr);
         running = 0;
         mgr->is_running = 0;
+        rules_free(atomic_exchange(&active_rules, NULL));
+        free_registry();
         return -1;
     }
 
     pthread_attr_destroy(&attr);
 
+    // Temperature/current readings come only from here; without it they stay at 0
+    if (start_slow_scheduler() != 0)
+        log_error("[SLOW] Failed to start slow-channel scheduler\n");
+
+    // Spectral analysis is optional: the server runs without it
+    start_spectrum_worker(mgr);
+
+    // So is persistence: without it only the in-memory history remains.
+    // The same thread raises alerts.
+    start_store_worker();
+    start_checkpoint_worker();
+
     return 0; // Success
 }
 
 int manager_get_health(SensorManager* mgr, const char* unit_id, EquipmentHealth* out_health) {
     (void)mgr;
-    pthread_mutex_lock(&data_mutex);
-    
-    // Only return data if IDs match
-    if (strcmp(current_health.unit_id, unit_id) == 0) {
-        memcpy(out_health, &current_health, sizeof(EquipmentHealth));
-        pthread_mutex_unlock(&data_mutex);
-        return 1;
-    }
-    
-    pthread_mutex_unlock(&data_mutex);
-    return 0;
+
+    // The registry is immutable after init, so lookup needs no lock
+    UnitState *u = find_unit(unit_id);
+    if (!u)
+        return 0;
+
+    seqlock_snapshot(&u->seq, out_health, &u->health, sizeof(EquipmentHealth));
+    snprintf(out_health->message, sizeof(out_health->message), "%s",
+             rules_message(out_health->message_id));
+    return 1;
+}
+
+SampleRing* manager_sample_ring(SensorManager* mgr, const char* unit_id) {
+    (void)mgr;
+    UnitState *u = find_unit(unit_id);
+    return u ? u->ring : NULL;
 }
 
-int manager_list_units(SensorManager* mgr, char list[MAX_UNITS][MAX_ID_LENGTH], int max_units) {
-    (void)mgr; (void)max_units;
-    strcpy(list[0], current_health.unit_id);
+uint32_t manager_max_rate(SensorManager* mgr) {
+    (void)mgr;
+    return block_max_rate_hz;
+}
+
+int manager_set_acquisition(SensorManager* mgr, const char* unit_id,
+                            uint32_t rate_hz, uint32_t window_ms) {
+    (void)mgr;
+    UnitState *u = find_unit(unit_id);
+    if (!u)
+        return 0;
+
+    if ((rate_hz && (rate_hz < MANAGER_MIN_RATE_HZ || rate_hz > MANAGER_MAX_RATE_HZ)) ||
+        (window_ms && (window_ms < MANAGER_MIN_WINDOW_MS || window_ms > MANAGER_MAX_WINDOW_MS)))
+        return -1;
+
+    // Sessions may race here; the last request wins, the loop sees one word
+    uint64_t cur = atomic_load_explicit(&u->rate_request, memory_order_relaxed);
+    if (window_ms == 0)
+        window_ms = (uint32_t)(cur >> 32);
+    atomic_store_explicit(&u->rate_request, pack_request(rate_hz, window_ms), memory_order_release);
     return 1;
 }
 
+int manager_reload_rules(SensorManager* mgr, char* err, size_t err_len) {
+    (void)mgr;
+    RuleSet *fresh = compile_rules(RULES_CONFIG, err, err_len);
+    if (!fresh)
+        return -1;
+
+    int count = rules_count(fresh);
+
+    // One reload at a time, so one retired set at a time. Nobody waits
+    // here: the set before the last one is freed now if the polling
+    // thread has finished the iteration that could still hold it (it
+    // runs every few ms), else this reload is refused.
+    pthread_mutex_lock(&rules_reload_lock);
+    if (retired_rules && atomic_load_explicit(&rules_qs, memory_order_acquire) == retired_qs) {
+        pthread_mutex_unlock(&rules_reload_lock);
+        rules_free(fresh);
+        snprintf(err, err_len, "polling thread still using the previous rules, try again");
+        return -1;
+    }
+    rules_free(retired_rules);
+    retired_rules = atomic_exchange_explicit(&active_rules, fresh, memory_order_acq_rel);
+    retired_qs = atomic_load_explicit(&rules_qs, memory_order_acquire);
+    pthread_mutex_unlock(&rules_reload_lock);
+
+    log_info("[SENSORS] Reloaded %d threshold rule%s from %s\n", count, count == 1 ? "" : "s", RULES_CONFIG);
+    return count;
+}
+
+TelemetryFrame* manager_get_telemetry(SensorManager* mgr, const char* unit_id) {
+    (void)mgr;
+    UnitState *u = find_unit(unit_id);
+    return u ? telemetry_acquire(&u->telemetry) : NULL;
+}
+
+int manager_get_spectrum(SensorManager* mgr, const char* unit_id, SpectrumResult* out) {
+    (void)mgr;
+    UnitState *u = find_unit(unit_id);
+    if (!u)
+        return 0;
+
+    seqlock_snapshot(&u->spec_seq, out, &u->spectrum, sizeof(SpectrumResult));
+    return 1;
+}
+
+int manager_get_history(SensorManager* mgr, const char* unit_id, HistoryTier tier,
+                        SensorChannel channel, uint32_t range_s, HistoryPoint* out, int max) {
+    (void)mgr;
+    UnitState *u = find_unit(unit_id);
+    if (!u)
+        return -1;
+
+    uint64_t now_s = (uint64_t)((int64_t)(monotonic_ns() / 1000000ULL) + wall_epoch_ms) / 1000u;
+    uint64_t from_s = range_s < now_s ? now_s - range_s + 1 : 0;
+    return history_read(u->history, tier, channel, from_s, now_s, out, max);
+}
+
+void manager_get_rt_stats(SensorManager* mgr, RtStatsSnapshot* out) {
+    (void)mgr;
+    out->loops = atomic_load_explicit(&rt_loops, memory_order_relaxed);
+    out->missed_deadlines = atomic_load_explicit(&rt_missed_deadlines, memory_order_relaxed);
+    out->skipped_ticks = atomic_load_explicit(&rt_skipped_ticks, memory_order_relaxed);
+    out->major_faults = atomic_load_explicit(&rt_major_faults, memory_order_relaxed);
+    out->minor_faults = atomic_load_explicit(&rt_minor_faults, memory_order_relaxed);
+    out->period_ns = BLOCK_PERIOD_NS;
+    out->uptime_ns = monotonic_ns() - rt_start_ns;
+    lat_hist_snapshot(&wakeup_hist, &out->wakeup);
+    lat_hist_snapshot(&exec_hist, &out->exec);
+}
+
+int manager_has_unit(SensorManager* mgr, const char* unit_id) {
+    (void)mgr;
+    return find_unit(unit_id) != NULL;
+}
+
+int manager_unit_index(SensorManager* mgr, const char* unit_id) {
+    (void)mgr;
+    UnitState *u = find_unit(unit_id);
+    return u ? (int)(u - units) : -1;
+}
+
+int manager_unit_count(SensorManager* mgr) {
+    (void)mgr;
+    return unit_count;
+}
+
+const char* manager_default_unit(SensorManager* mgr) {
+    (void)mgr;
+    return unit_count > 0 ? units[0].health.unit_id : DEFAULT_UNIT_ID;
+}
+
+int manager_list_units(SensorManager* mgr, char (*list)[MAX_ID_LENGTH], int max_units) {
+    (void)mgr;
+    int n = unit_count < max_units ? unit_count : max_units;
+
+    for (int i = 0; i < n; i++)
+        memcpy(list[i], units[i].health.unit_id, MAX_ID_LENGTH);
+    return n;
+}
+
 void manager_cleanup(SensorManager* mgr) {
     if (running) {
         running = 0;
         mgr->is_running = 0;
         pthread_join(mgr->thread_id, NULL);
-        printf("[SENSORS] Background thread joined and cleaned up successfully.\n");
+        if (slow_started) {
+            pthread_join(slow_tid, NULL);
+            slow_started = 0;
+        }
+        if (spectrum_started) {
+            pthread_join(spectrum_tid, NULL);
+            spectrum_started = 0;
+        }
+        if (store_started) {
+            pthread_join(store_tid, NULL);
+            store_started = 0;
+        }
+        if (checkpoint_started) {
+            pthread_join(checkpoint_tid, NULL);
+            checkpoint_started = 0;
+        }
+        if (checkpoint_buf) {
+            write_checkpoint();
+            checkpoint_destroy(checkpoint_buf);
+            checkpoint_buf = NULL;
+        }
+        for (unsigned i = 0; i < sizeof(spectrum_plans) / sizeof(spectrum_plans[0]); i++) {
+            fft_plan_destroy(spectrum_plans[i]);
+            spectrum_plans[i] = NULL;
+        }
+        rules_free(atomic_exchange(&active_rules, NULL));
+        rules_free(retired_rules);
+        retired_rules = NULL;
+        free_registry();
+        log_info("[SENSORS] Background thread joined and cleaned up successfully.\n");
     }
 }
@@ -2,7 +2,13 @@
 #define SENSOR_MANAGER_H
 
 #include <pthread.h>
+#include <stddef.h>
 #include "sensors.h"
+#include "sample_ring.h"
+#include "latency_hist.h"
+#include "spectrum.h"
+#include "history.h"
+#include "telemetry.h"
 
 // ============================================================
 // DATA STRUCTURES
@@ -16,30 +22,172 @@ typedef struct {
     int is_running;
 } SensorManager;
 
+/**
+ * RtStatsSnapshot: Point-in-time copy of the polling loop's latency
+ * histograms and deadline counters. Counters are cumulative since
+ * manager_init; diff two snapshots to get any period in between.
+ */
+typedef struct {
+    LatencySnapshot wakeup;      // ns from deadline to actual wakeup
+    LatencySnapshot exec;        // ns from wakeup to block work done
+    uint64_t loops;              // completed loop iterations
+    uint64_t missed_deadlines;   // iterations that finished after the next deadline
+    uint64_t skipped_ticks;      // whole periods dropped to resynchronise
+    uint64_t major_faults;       // page faults taken inside the loop (Linux;
+    uint64_t minor_faults;       //   sampled once per second)
+    uint64_t period_ns;          // loop period
+    uint64_t uptime_ns;          // time since manager_init
+} RtStatsSnapshot;
+
+// Runtime acquisition limits (manager_set_acquisition)
+#define MANAGER_MIN_RATE_HZ    200u
+#define MANAGER_MAX_RATE_HZ    20000u
+#define MANAGER_MIN_WINDOW_MS  100u
+#define MANAGER_MAX_WINDOW_MS  60000u
+
+// Window store (storage/segment_store.h): every published window of a
+// unit is appended to MANAGER_STORE_DIR/<unit id>/ as one record of the
+// four channel levels followed by mean, rms, min, max, p2p, crest, skew
+// and kurtosis of each channel (in SensorChannel order)
+#define MANAGER_STORE_DIR            "data"
+#define MANAGER_STORE_FEATURES       8
+#define MANAGER_STORE_COLUMNS        (CH_COUNT + CH_COUNT * MANAGER_STORE_FEATURES)
+#define MANAGER_STORE_RETENTION_DAYS 28
+
+// Warm restart (storage/checkpoint.h): every MANAGER_CHECKPOINT_INTERVAL_S
+// and in manager_cleanup each unit's last window, rule state, acquisition
+// request and level history are saved to MANAGER_CHECKPOINT_PATH, and
+// manager_init restores them. The last window and the rule state are
+// only restored from a checkpoint younger than MANAGER_CHECKPOINT_MAX_AGE_S;
+// the history always is (its buckets carry their own times).
+#define MANAGER_CHECKPOINT_PATH       "data/checkpoint.bin"
+#define MANAGER_CHECKPOINT_INTERVAL_S 60
+#define MANAGER_CHECKPOINT_MAX_AGE_S  600
+
 // ============================================================
 // PUBLIC API PROTOTYPES
 // ============================================================
 
 /**
- * manager_init: Starts the 1kHz background polling thread.
+ * manager_init: Loads the unit registry (config/units.conf), threshold
+ * rules (config/rules.conf) and RT profile (config/rt.conf), restores
+ * the last checkpoint, then starts the block-mode background polling
+ * thread (5 ms blocks, adaptive 2-20 kHz per channel, 1 s windows).
  * Returns 0 on success, -1 on hardware/thread failure.
  */
 int manager_init(SensorManager* mgr);
 
 /**
- * manager_get_health: Thread-safe retrieval of the latest sensor snapshot.
+ * manager_get_health: Lock-free retrieval of the latest sensor snapshot.
+ * Readers retry on a concurrent publish; the polling thread never waits.
  * Returns 1 if data retrieved, 0 if unit_id not found.
  */
 int manager_get_health(SensorManager* mgr, const char* unit_id, EquipmentHealth* out_health);
 
 /**
- * manager_list_units: populates the list with registered equipment IDs.
- * Returns the number of units found.
+ * manager_sample_ring: Raw per-tick sample ring of a unit. Consumers read
+ * it with their own SampleCursor (see sample_ring.h) without ever
+ * stalling the polling thread.
+ * Returns NULL if unit_id is not registered.
+ */
+SampleRing* manager_sample_ring(SensorManager* mgr, const char* unit_id);
+
+/**
+ * manager_set_acquisition: Requests a fast-channel rate and window length
+ * for one unit. rate_hz = 0 selects the adaptive policy (low rate while
+ * healthy, full rate near a limit); window_ms = 0 keeps the current
+ * window. Applied by the polling thread at the unit's next window
+ * boundary; the loop period and its deadlines are unaffected.
+ * Rates above manager_max_rate are applied at that rate.
+ * Returns 1 on success, 0 if unit_id is unknown, -1 if out of range.
+ */
+int manager_set_acquisition(SensorManager* mgr, const char* unit_id,
+                            uint32_t rate_hz, uint32_t window_ms);
+
+/**
+ * manager_max_rate: Highest fast-channel rate the HAL can deliver
+ * (MANAGER_MAX_RATE_HZ with a FIFO-backed HAL, 1 kHz without one).
+ */
+uint32_t manager_max_rate(SensorManager* mgr);
+
+/**
+ * manager_reload_rules: Recompiles config/rules.conf and swaps it in
+ * without stopping the polling thread, and never waits for it: the old
+ * set is freed by a later reload once the loop has passed a quiescent
+ * point (a reload before then is refused). Rule state (hysteresis/
+ * debounce) carries over to the rules the new set still has.
+ * Returns the number of compiled rules, or -1 with the reason in err
+ * (the current rules stay active).
+ */
+int manager_reload_rules(SensorManager* mgr, char* err, size_t err_len);
+
+/**
+ * manager_get_telemetry: A reference to the latest window of a unit as
+ * encoded once for every viewer (telemetry.h). Windows appear here when
+ * the store thread picks them up, within 50 ms of closing.
+ * Returns NULL if unit_id is not registered or no window has closed;
+ * release the frame with telemetry_release.
+ */
+TelemetryFrame* manager_get_telemetry(SensorManager* mgr, const char* unit_id);
+
+/**
+ * manager_get_spectrum: Lock-free copy of the latest vibration spectrum
+ * of a unit (fft_size == 0 until the first analysis has run).
+ * Returns 1 if data retrieved, 0 if unit_id not found.
+ */
+int manager_get_spectrum(SensorManager* mgr, const char* unit_id, SpectrumResult* out);
+
+/**
+ * manager_get_history: Lock-free copy of the last range_s seconds of one
+ * channel's history of a unit, from the given tier, oldest first. Point
+ * times are Unix seconds.
+ * Returns the number of points written (at most max), or -1 if unit_id
+ * is not registered.
+ */
+int manager_get_history(SensorManager* mgr, const char* unit_id, HistoryTier tier,
+                        SensorChannel channel, uint32_t range_s, HistoryPoint* out, int max);
+
+/**
+ * manager_get_rt_stats: Lock-free snapshot of the polling loop's latency
+ * histograms and deadline counters (RtStatsSnapshot is ~19 KB; avoid
+ * placing it on small thread stacks).
+ */
+void manager_get_rt_stats(SensorManager* mgr, RtStatsSnapshot* out);
+
+/**
+ * manager_has_unit: O(1) hash lookup of a registered unit.
+ * Returns 1 if registered, 0 otherwise.
+ */
+int manager_has_unit(SensorManager* mgr, const char* unit_id);
+
+/**
+ * manager_unit_index: Position of a unit in registration (list_units)
+ * order, the unit number of the binary wire format.
+ * Returns -1 if unit_id is not registered.
+ */
+int manager_unit_index(SensorManager* mgr, const char* unit_id);
+
+/**
+ * manager_unit_count: Number of registered units.
+ */
+int manager_unit_count(SensorManager* mgr);
+
+/**
+ * manager_default_unit: ID used when a command names no unit
+ * (the first entry of units.conf).
+ */
+const char* manager_default_unit(SensorManager* mgr);
+
+/**
+ * manager_list_units: populates up to max_units entries of list with
+ * registered equipment IDs, in registration order.
+ * Returns the number of entries written.
  */
-int manager_list_units(SensorManager* mgr, char list[MAX_UNITS][MAX_ID_LENGTH], int max_units);
+int manager_list_units(SensorManager* mgr, char (*list)[MAX_ID_LENGTH], int max_units);
 
 /**
- * manager_cleanup: Signals thread to stop and joins it safely.
+ * manager_cleanup: Signals thread to stop and joins it safely, then
+ * writes a final checkpoint.
  */
 void manager_cleanup(SensorManager* mgr);
 
@@ -11,7 +11,7 @@
 #define PIN_TEMP_1W   4   // Physical Pin 7 (DS18B20)
 
 #define MAX_ID_LENGTH 32
-#define MAX_UNITS     5
+#define DEFAULT_UNIT_ID "Sentinel-RT"  // Registered when no units.conf exists
 
 // ============================================================
 // DATA STRUCTURES
@@ -37,6 +37,33 @@ typedef struct {
     float current_a;       // Amperes
 } SensorSnapshot;
 
+/**
+ * SensorChannel: Index of a physical measurement channel.
+ */
+typedef enum {
+    CH_VIBRATION = 0,
+    CH_SOUND,
+    CH_TEMPERATURE,
+    CH_CURRENT,
+    CH_COUNT
+} SensorChannel;
+
+/**
+ * ChannelFeatures: Condition-monitoring indicators of one channel over
+ * one evaluation window, in the channel's raw sample units (vibration
+ * intensity per sample, sound pin level 0/1, degrees C, amperes).
+ */
+typedef struct {
+    float mean;
+    float rms;
+    float min;
+    float max;
+    float peak_to_peak;
+    float crest_factor;    // max |x| / rms
+    float skewness;
+    float kurtosis;        // Pearson (3.0 = Gaussian)
+} ChannelFeatures;
+
 /**
  * EquipmentHealth: The unified packet sent over the protocol.
  */
@@ -44,9 +71,29 @@ typedef struct {
     char unit_id[MAX_ID_LENGTH];
     HealthStatus status;
     SensorSnapshot snapshot;
-    char message[128];     // Descriptive fault message
+    ChannelFeatures features[CH_COUNT];  // indexed by SensorChannel
+    uint32_t sample_rate_hz;  // fast-channel rate during this window
+    uint32_t window_ms;       // window length
+    uint32_t adaptive;        // 1 = rate chosen by the adaptive policy
+    uint32_t message_id;      // index into the static message table (rules.h)
+    uint64_t window_end_ms;   // Unix time the window closed (0 = no window yet)
+    char message[128];     // Descriptive fault message (filled on read)
 } EquipmentHealth;
 
+/**
+ * HwBlock: One FIFO drain of the fast channels of the selected board,
+ * in caller-provided struct-of-arrays buffers. Sample i was taken at
+ * t0_ns + i * period_ns (CLOCK_MONOTONIC).
+ */
+typedef struct {
+    uint64_t t0_ns;
+    uint32_t period_ns;
+    float *vibration;      // capacity >= requested samples
+    uint8_t *sound;        // capacity >= requested samples (0/1 levels)
+} HwBlock;
+
+#define HW_BLOCK_MAX_SAMPLES 1024
+
 // ============================================================
 // HARDWARE ABSTRACTION LAYER (HAL)
 // ============================================================
@@ -59,6 +106,42 @@ float hw_read_vibration_i2c();
 float hw_read_current_i2c();
 float hw_read_temp_i2c();
 float hw_read_temp_1wire(int pin);
+
+/**
+ * hw_select_unit: Routes subsequent reads to the sensor board of one
+ * monitored machine (I2C mux channel / GPIO bank). Single-board HALs
+ * may leave this to the no-op default in sensors_generic.c.
+ */
+void hw_select_unit(int board);
+
+/**
+ * hw_read_block: Batched acquisition. Fills blk with n samples per fast
+ * channel (vibration, sound) taken at rate_hz on the selected board and
+ * timestamps the block. Backends with an ADC/accelerometer FIFO drain it
+ * in one bus transaction; the generic fallback paces single reads at
+ * rate_hz, so it returns only after (n - 1) sample periods.
+ * Returns the number of samples written (<= n) or -1 on bus error.
+ */
+int hw_read_block(HwBlock *blk, int n, uint32_t rate_hz);
+
+/**
+ * hw_block_max_rate: Highest rate_hz hw_read_block can honour. Without a
+ * FIFO every sample is its own bus transaction, so the generic fallback
+ * reports 1 kHz; high rates need a FIFO-backed HAL.
+ */
+uint32_t hw_block_max_rate(void);
+
+/**
+ * hw_slow_start / hw_slow_read: Split-phase read of a slow channel
+ * (CH_TEMPERATURE: DS18B20 "Convert T" ... "Read Scratchpad";
+ * CH_CURRENT: ADS1115 single-shot). hw_slow_start begins a conversion on
+ * a board and returns the microseconds to wait before hw_slow_read may
+ * collect it, or -1 on bus error; hw_slow_read returns 0 or -1.
+ * Neither call blocks on the conversion, and both address the board
+ * directly, so they run on their own thread alongside hw_read_block.
+ */
+int hw_slow_start(int board, SensorChannel ch);
+int hw_slow_read(int board, SensorChannel ch, float *value);
 const char* health_to_string(HealthStatus status);
 
 #endif // SENSORS_H
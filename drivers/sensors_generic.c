@@ -0,0 +1,84 @@
+#include <time.h>
+#include <errno.h>
+#include "sensors.h"
+
+// ============================================================
+// GENERIC HAL DEFAULTS
+// ============================================================
+// Weak fallbacks for optional HAL entry points. A backend that has the
+// hardware for a feature overrides the symbol with a strong definition;
+// single-board builds link these and behave as before.
+
+// One I2C read per sample (~100 us at 400 kHz) plus the sound pin
+#define HW_UNBUFFERED_MAX_RATE_HZ 1000u
+
+__attribute__((weak)) void hw_select_unit(int board)
+{
+    (void)board; // Only one sensor board wired: nothing to route
+}
+
+__attribute__((weak)) const char* health_to_string(HealthStatus status)
+{
+    switch (status) {
+        case HEALTH_HEALTHY:  return "OK";
+        case HEALTH_WARNING:  return "WARNING";
+        case HEALTH_CRITICAL: return "CRITICAL";
+        case HEALTH_FAULT:    return "FAULT";
+        default:              return "UNKNOWN";
+    }
+}
+
+__attribute__((weak)) uint32_t hw_block_max_rate(void)
+{
+    return HW_UNBUFFERED_MAX_RATE_HZ;
+}
+
+__attribute__((weak)) int hw_read_block(HwBlock *blk, int n, uint32_t rate_hz)
+{
+    struct timespec t;
+
+    if (!blk || n <= 0 || rate_hz == 0)
+        return -1;
+    if (n > HW_BLOCK_MAX_SAMPLES)
+        n = HW_BLOCK_MAX_SAMPLES;
+    if (rate_hz > HW_UNBUFFERED_MAX_RATE_HZ)
+        rate_hz = HW_UNBUFFERED_MAX_RATE_HZ;
+
+    // No FIFO: one transaction per sample, each on its own absolute
+    // deadline so sample i really is taken at t0 + i * period
+    blk->period_ns = 1000000000u / rate_hz;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    blk->t0_ns = (uint64_t)t.tv_sec * 1000000000ULL + (uint64_t)t.tv_nsec;
+    for (int i = 0; i < n; i++) {
+        if (i > 0) {
+            uint64_t due = blk->t0_ns + (uint64_t)i * blk->period_ns;
+            t.tv_sec = (time_t)(due / 1000000000ULL);
+            t.tv_nsec = (long)(due % 1000000000ULL);
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR)
+                ;
+        }
+        blk->vibration[i] = hw_read_vibration_i2c();
+        blk->sound[i] = hw_read_pin(PIN_SOUND) ? 1 : 0;
+    }
+    return n;
+}
+
+// Blocking backends: convert on the read. Only correct for single-board
+// HALs, since the board stays whatever hw_select_unit last routed to.
+__attribute__((weak)) int hw_slow_start(int board, SensorChannel ch)
+{
+    (void)board;
+    return ch == CH_TEMPERATURE || ch == CH_CURRENT ? 0 : -1;
+}
+
+__attribute__((weak)) int hw_slow_read(int board, SensorChannel ch, float *value)
+{
+    (void)board;
+    if (ch == CH_TEMPERATURE)
+        *value = hw_read_temp_i2c();
+    else if (ch == CH_CURRENT)
+        *value = hw_read_current_i2c();
+    else
+        return -1;
+    return 0;
+}
@@ -0,0 +1,418 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "sensors.h"
+#include "rt_log.h"
+
+// ============================================================
+// SIMULATED / REPLAY HAL BACKEND
+// ============================================================
+//
+// Drop-in replacement for drivers/sensors.c on machines without the Pi's
+// GPIO/I2C (build with HAL=sim). Every value is a pure function of the
+// per-board sample clock and seed, so two runs with the same settings
+// produce identical streams regardless of scheduling.
+//
+// Environment:
+//   IMS_SIM_PROFILE   sine | noise | bearing | step, or a comma list
+//                     indexed by board (default "sine")
+//   IMS_SIM_RATE_HZ   sample rate assumed by single-sample reads (1000);
+//                     hw_read_block always uses the requested rate
+//   IMS_SIM_SEED      PRNG seed (1)
+//   IMS_SIM_FAULT_S   seconds before the step/bearing fault develops (30)
+//   IMS_SIM_REPLAY    capture file to replay instead of synthesising:
+//                     one "vibration sound temp current" row per sample
+
+#define SIM_MAX_BOARDS    64
+#define SIM_RUN_HZ        29.5f   // shaft speed (~1770 rpm)
+#define SIM_BPFO_HZ       87.3f   // outer-race defect frequency
+#define SIM_BASE_LEVEL    0.05f   // ~50 events/s when healthy at 1 kHz
+#define TWO_PI            6.28318530718f
+#define SIM_TEMP_CONV_US  750000  // DS18B20 12-bit conversion
+#define SIM_CURR_CONV_US  8000    // ADS1115 single shot at 128 SPS
+
+typedef enum {
+    SIM_SINE = 0,
+    SIM_NOISE,
+    SIM_BEARING,
+    SIM_STEP
+} SimProfile;
+
+typedef struct {
+    SimProfile profile;
+    uint64_t n;           // samples produced on this board
+    double t_s;           // waveform time of the next sample
+    uint64_t rng;         // xorshift64* state
+    float last_vib;       // value of the current sample (shared by pin reads)
+    float phase;          // per-board phase offset so units differ
+    uint64_t slow_rng;    // noise of split-phase slow reads (their own thread)
+    float slow_value[CH_COUNT];  // latched at hw_slow_start
+} SimBoard;
+
+typedef struct {
+    float vibration;
+    float sound;
+    float temperature;
+    float current;
+} ReplayRow;
+
+static SimBoard boards[SIM_MAX_BOARDS];
+static SimBoard *cur = &boards[0];
+static float sample_rate_hz = 1000.0f;
+static float fault_after_s = 30.0f;
+static ReplayRow *replay = NULL;
+static size_t replay_len = 0;
+
+// ============================================================
+// DETERMINISTIC HELPERS
+// ============================================================
+static inline uint64_t xorshift64s(uint64_t *s)
+{
+    uint64_t x = *s;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *s = x;
+    return x * 2685821657736338717ULL;
+}
+
+static inline float uniform01(uint64_t *s)
+{
+    return (float)(xorshift64s(s) >> 40) * (1.0f / 16777216.0f);
+}
+
+// Irwin-Hall approximation of N(0,1): four uniforms, no transcendental calls
+static inline float gauss(uint64_t *s)
+{
+    return (uniform01(s) + uniform01(s) + uniform01(s) + uniform01(s) - 2.0f) * 1.7320508f;
+}
+
+// The sample clock is advanced by the fast-channel reader and read by the
+// slow-channel thread too (hw_slow_*), hence the relaxed atomics.
+static inline double board_clock_s(const SimBoard *b)
+{
+    double t;
+    __atomic_load(&b->t_s, &t, __ATOMIC_RELAXED);
+    return t;
+}
+
+static inline float board_time_s(const SimBoard *b)
+{
+    return (float)board_clock_s(b);
+}
+
+// sin(2*pi*f*t) with the phase reduced in double, so hours-long runs stay exact
+static inline float tone(double f_hz, double t_s, float phase)
+{
+    return sinf(TWO_PI * (float)fmod(f_hz * t_s, 1.0) + phase);
+}
+
+// 0 while healthy, ramps to 1 over the minute after the fault onset
+static inline float fault_severity(const SimBoard *b)
+{
+    float t = board_time_s(b) - fault_after_s;
+    if (t <= 0.0f) return 0.0f;
+    return t >= 60.0f ? 1.0f : t / 60.0f;
+}
+
+static SimProfile parse_profile(const char *name, size_t len)
+{
+    if (len == 5 && !strncmp(name, "noise", 5)) return SIM_NOISE;
+    if (len == 7 && !strncmp(name, "bearing", 7)) return SIM_BEARING;
+    if (len == 4 && !strncmp(name, "step", 4)) return SIM_STEP;
+    return SIM_SINE;
+}
+
+static int load_replay(const char *path)
+{
+    char line[256];
+    size_t cap = 0;
+    FILE *f = fopen(path, "r");
+
+    if (!f) {
+        perror("[SIM] Cannot open replay capture");
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        ReplayRow row;
+        for (char *p = line; *p; p++)
+            if (*p == ',') *p = ' ';
+        if (line[0] == '#' ||
+            sscanf(line, "%f %f %f %f", &row.vibration, &row.sound,
+                   &row.temperature, &row.current) != 4)
+            continue;
+
+        if (replay_len == cap) {
+            size_t new_cap = cap ? cap * 2 : 4096;
+            ReplayRow *grown = realloc(replay, new_cap * sizeof(ReplayRow));
+            if (!grown) {
+                fclose(f);
+                return -1;
+            }
+            replay = grown;
+            cap = new_cap;
+        }
+        replay[replay_len++] = row;
+    }
+    fclose(f);
+
+    if (replay_len == 0) {
+        log_error("[SIM] Replay capture %s has no samples\n", path);
+        return -1;
+    }
+    log_info("[SIM] Replaying %zu samples from %s\n", replay_len, path);
+    return 0;
+}
+
+static inline const ReplayRow *replay_row(const SimBoard *b)
+{
+    // Boards start at different offsets so units are not in lockstep
+    uint64_t n = __atomic_load_n(&b->n, __ATOMIC_RELAXED);
+    size_t idx = (size_t)((n + (uint64_t)(b - boards) * 997u) % replay_len);
+    return &replay[idx];
+}
+
+// ============================================================
+// HAL API
+// ============================================================
+
+int hw_init()
+{
+    const char *profiles = getenv("IMS_SIM_PROFILE");
+    const char *rate = getenv("IMS_SIM_RATE_HZ");
+    const char *seed = getenv("IMS_SIM_SEED");
+    const char *fault = getenv("IMS_SIM_FAULT_S");
+    const char *path = getenv("IMS_SIM_REPLAY");
+    uint64_t base_seed = seed ? strtoull(seed, NULL, 10) : 1;
+
+    if (rate && atof(rate) > 0.0) sample_rate_hz = (float)atof(rate);
+    if (fault) fault_after_s = (float)atof(fault);
+
+    for (int i = 0; i < SIM_MAX_BOARDS; i++) {
+        boards[i].profile = SIM_SINE;
+        boards[i].n = 0;
+        boards[i].t_s = 0.0;
+        boards[i].rng = (base_seed + 1) * 0x9E3779B97F4A7C15ULL + (uint64_t)i * 0xBF58476D1CE4E5B9ULL;
+        boards[i].phase = (float)i * 0.7f;
+        boards[i].slow_rng = boards[i].rng ^ 0xD1B54A32D192ED03ULL;
+    }
+
+    // Comma list: board i gets entry i, the last entry repeats
+    if (profiles && *profiles) {
+        const char *p = profiles;
+        SimProfile last = SIM_SINE;
+        for (int i = 0; i < SIM_MAX_BOARDS; i++) {
+            if (p) {
+                const char *comma = strchr(p, ',');
+                size_t len = comma ? (size_t)(comma - p) : strlen(p);
+                last = parse_profile(p, len);
+                p = comma ? comma + 1 : NULL;
+            }
+            boards[i].profile = last;
+        }
+    }
+
+    if (path && load_replay(path) != 0)
+        return -1;
+
+    cur = &boards[0];
+    log_info("[SIM] Simulated HAL ready (profile=%s, rate=%.0f Hz, seed=%llu)\n",
+             profiles ? profiles : "sine", sample_rate_hz, (unsigned long long)base_seed);
+    return 0;
+}
+
+void hw_select_unit(int board)
+{
+    if (board < 0 || board >= SIM_MAX_BOARDS)
+        board = 0;
+    cur = &boards[board];
+}
+
+void hw_configure_pin(int pin, int direction)
+{
+    (void)pin; (void)direction;
+}
+
+void hw_write_pin(int pin, int val)
+{
+    (void)pin; (void)val;
+}
+
+/**
+ * sim_vibration: Produces the next vibration sample of a board and
+ * advances its clock by dt_s. The value is a non-negative vibration
+ * intensity whose 1 kHz per-second sum matches the SW-420
+ * "events per second" scale.
+ */
+static inline float sim_vibration(SimBoard *b, double dt_s)
+{
+    double t = b->t_s;
+    float v;
+
+    if (replay) {
+        v = replay_row(b)->vibration;
+    } else {
+        float run = tone(SIM_RUN_HZ, t, b->phase);
+        float sev = fault_severity(b);
+
+        switch (b->profile) {
+        case SIM_NOISE:
+            v = SIM_BASE_LEVEL * (1.0f + 0.8f * gauss(&b->rng));
+            break;
+        case SIM_BEARING: {
+            // Decaying impulse train at BPFO, growing with fault severity
+            float since = (float)fmod(t, 1.0 / SIM_BPFO_HZ);
+            float ring = expf(-since * 400.0f) * sinf(TWO_PI * 480.0f * since);
+            v = SIM_BASE_LEVEL * (1.0f + 0.6f * run + 0.1f * gauss(&b->rng))
+              + sev * 0.4f * fabsf(ring);
+            break;
+        }
+        case SIM_STEP:
+            v = SIM_BASE_LEVEL * (1.0f + 0.6f * run) * (t >= fault_after_s ? 5.0f : 1.0f);
+            break;
+        case SIM_SINE:
+        default:
+            v = SIM_BASE_LEVEL * (1.0f + 0.6f * run + 0.2f * tone(2.0 * SIM_RUN_HZ, t, 0.0f));
+            break;
+        }
+    }
+
+    if (v < 0.0f) v = 0.0f;
+    b->last_vib = v;
+    double next = t + dt_s;
+    __atomic_store_n(&b->n, b->n + 1, __ATOMIC_RELAXED);
+    __atomic_store(&b->t_s, &next, __ATOMIC_RELAXED);
+    return v;
+}
+
+static inline uint8_t sim_sound(SimBoard *b)
+{
+    float duty;
+    if (replay)
+        duty = replay_row(b)->sound / 100.0f;
+    else
+        duty = 0.15f + 0.5f * fault_severity(b) + (b->profile == SIM_STEP &&
+               board_time_s(b) >= fault_after_s ? 0.3f : 0.0f);
+    return uniform01(&b->rng) < duty;
+}
+
+float hw_read_vibration_i2c()
+{
+    return sim_vibration(cur, 1.0 / sample_rate_hz);
+}
+
+/**
+ * hw_read_block: Emulates an accelerometer FIFO drain. The block is
+ * generated for the requested rate and stamped as ending now.
+ */
+int hw_read_block(HwBlock *blk, int n, uint32_t rate_hz)
+{
+    SimBoard *b = cur;
+    struct timespec now;
+
+    if (!blk || n <= 0 || rate_hz == 0)
+        return -1;
+    if (n > HW_BLOCK_MAX_SAMPLES)
+        n = HW_BLOCK_MAX_SAMPLES;
+
+    double dt = 1.0 / (double)rate_hz;
+    for (int i = 0; i < n; i++) {
+        // Sound is sampled on the previous position, as a single-tick read would
+        blk->sound[i] = sim_sound(b);
+        blk->vibration[i] = sim_vibration(b, dt);
+    }
+
+    blk->period_ns = 1000000000u / rate_hz;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    blk->t0_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec
+               - (uint64_t)(n - 1) * blk->period_ns;
+    return n;
+}
+
+// The emulated FIFO keeps up with any rate the manager asks for
+uint32_t hw_block_max_rate(void)
+{
+    return UINT32_MAX;
+}
+
+int hw_read_pin(int pin)
+{
+    SimBoard *b = cur;
+
+    if (pin == PIN_VIBRATION)
+        return b->last_vib > SIM_BASE_LEVEL * 1.5f;
+
+    if (pin == PIN_SOUND)
+        return sim_sound(b);
+
+    return 0;
+}
+
+static float sim_temperature(const SimBoard *b)
+{
+    if (replay)
+        return replay_row(b)->temperature;
+
+    // Slow thermal drift plus heating from the developing fault
+    return 42.0f + 2.0f * tone(1.0 / 600.0, board_clock_s(b), b->phase) + 30.0f * fault_severity(b);
+}
+
+static float sim_current(const SimBoard *b, uint64_t *rng)
+{
+    if (replay)
+        return replay_row(b)->current;
+
+    float base = 8.0f + 0.3f * gauss(rng);
+    if (b->profile == SIM_STEP && board_time_s(b) >= fault_after_s)
+        base += 9.0f;   // locked-rotor style overcurrent
+    return base + 4.0f * fault_severity(b);
+}
+
+float hw_read_temp_i2c()
+{
+    return sim_temperature(cur);
+}
+
+float hw_read_temp_1wire(int pin)
+{
+    (void)pin;
+    return hw_read_temp_i2c();
+}
+
+float hw_read_current_i2c()
+{
+    return sim_current(cur, &cur->rng);
+}
+
+/**
+ * hw_slow_start: Latches the value at conversion start, like the real
+ * parts, and reports the datasheet conversion time.
+ */
+int hw_slow_start(int board, SensorChannel ch)
+{
+    if (board < 0 || board >= SIM_MAX_BOARDS)
+        return -1;
+
+    SimBoard *b = &boards[board];
+    switch (ch) {
+    case CH_TEMPERATURE:
+        b->slow_value[ch] = sim_temperature(b);
+        return SIM_TEMP_CONV_US;
+    case CH_CURRENT:
+        b->slow_value[ch] = sim_current(b, &b->slow_rng);
+        return SIM_CURR_CONV_US;
+    default:
+        return -1;
+    }
+}
+
+int hw_slow_read(int board, SensorChannel ch, float *value)
+{
+    if (board < 0 || board >= SIM_MAX_BOARDS || (ch != CH_TEMPERATURE && ch != CH_CURRENT))
+        return -1;
+    *value = boards[board].slow_value[ch];
+    return 0;
+}
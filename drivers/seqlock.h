@@ -0,0 +1,91 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdatomic.h>
+#include <string.h>
+
+// ============================================================
+// SEQUENCE LOCK (single writer, lock-free readers)
+// ============================================================
+//
+// The writer bumps the sequence to an odd value, updates the payload and
+// bumps it back to even. Readers copy the payload and retry if the sequence
+// was odd or changed underneath them. The writer never waits on a reader,
+// so a preempted session thread can no longer delay the RT polling loop.
+
+/**
+ * SeqLock: Generation counter guarding one published payload.
+ * Even = stable, odd = write in progress.
+ */
+typedef struct {
+    atomic_uint seq;
+} SeqLock;
+
+static inline void seqlock_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+static inline void seqlock_init(SeqLock *sl)
+{
+    atomic_init(&sl->seq, 0u);
+}
+
+static inline void seqlock_write_begin(SeqLock *sl)
+{
+    unsigned s = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+    atomic_store_explicit(&sl->seq, s + 1u, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void seqlock_write_end(SeqLock *sl)
+{
+    unsigned s = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+    atomic_store_explicit(&sl->seq, s + 1u, memory_order_release);
+}
+
+static inline unsigned seqlock_read_begin(SeqLock *sl)
+{
+    unsigned s;
+    while ((s = atomic_load_explicit(&sl->seq, memory_order_acquire)) & 1u)
+        seqlock_cpu_relax();
+    return s;
+}
+
+/**
+ * seqlock_read_retry: Returns non-zero if the copy taken since
+ * seqlock_read_begin() may be torn and must be repeated.
+ */
+static inline int seqlock_read_retry(SeqLock *sl, unsigned start)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&sl->seq, memory_order_relaxed) != start;
+}
+
+/**
+ * seqlock_publish: Writer-side copy of a whole payload. Never blocks.
+ */
+static inline void seqlock_publish(SeqLock *sl, void *dst, const void *src, size_t len)
+{
+    seqlock_write_begin(sl);
+    memcpy(dst, src, len);
+    seqlock_write_end(sl);
+}
+
+/**
+ * seqlock_snapshot: Reader-side consistent copy of a whole payload.
+ */
+static inline void seqlock_snapshot(SeqLock *sl, void *dst, const void *src, size_t len)
+{
+    unsigned s;
+    do {
+        s = seqlock_read_begin(sl);
+        memcpy(dst, src, len);
+    } while (seqlock_read_retry(sl, s));
+}
+
+#endif // SEQLOCK_H
@@ -0,0 +1,356 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "spectrum.h"
+
+// ============================================================
+// SIMD PRIMITIVES (GCC vector extensions)
+// ============================================================
+#if defined(__AVX__)
+#define FFT_VEC 8
+#else
+#define FFT_VEC 4      // SSE / NEON / generic
+#endif
+
+typedef float vf __attribute__((vector_size(FFT_VEC * sizeof(float))));
+
+static inline vf vload(const float *p)
+{
+    vf v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void vstore(float *p, vf v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+#define TWO_PI_D 6.283185307179586
+
+struct FftPlan {
+    uint32_t n;            // real transform size
+    uint32_t m;            // complex size n/2
+    uint32_t *bitrev;      // m entries
+    float *tw_re;          // stage twiddles: stage with half-span h at [h - 1, 2h - 1)
+    float *tw_im;
+    float *rt_re;          // split step: exp(-2*pi*i*k/n), k < m
+    float *rt_im;
+    float *window;         // Hann, n entries
+    double window_sum;
+    double enbw_bins;      // equivalent noise bandwidth of the window, in bins
+    float *zr;             // complex work buffers, m entries
+    float *zi;
+    float *frame;          // windowed frame, n entries
+    float *xr;             // spectrum, m + 1 entries
+    float *xi;
+};
+
+static const float band_edges[SPECTRUM_BANDS] = {
+    0.0f, 10.0f, 100.0f, 500.0f, 1000.0f, 2000.0f, 5000.0f
+};
+
+static float *alloc_floats(size_t n)
+{
+    void *mem = NULL;
+    if (posix_memalign(&mem, 64, n * sizeof(float)) != 0)
+        return NULL;
+    memset(mem, 0, n * sizeof(float));
+    return mem;
+}
+
+// ============================================================
+// PLAN
+// ============================================================
+
+FftPlan* fft_plan_create(uint32_t n)
+{
+    if (n < FFT_MIN_SIZE || n > FFT_MAX_SIZE || (n & (n - 1)) != 0)
+        return NULL;
+
+    FftPlan *p = calloc(1, sizeof(FftPlan));
+    if (!p)
+        return NULL;
+
+    uint32_t m = n / 2;
+    unsigned bits = 0;
+    while ((1u << bits) < m) bits++;
+
+    p->n = n;
+    p->m = m;
+    p->bitrev = malloc(m * sizeof(uint32_t));
+    p->tw_re = alloc_floats(m);
+    p->tw_im = alloc_floats(m);
+    p->rt_re = alloc_floats(m);
+    p->rt_im = alloc_floats(m);
+    p->window = alloc_floats(n);
+    p->zr = alloc_floats(m);
+    p->zi = alloc_floats(m);
+    p->frame = alloc_floats(n);
+    p->xr = alloc_floats(m + 1);
+    p->xi = alloc_floats(m + 1);
+
+    if (!p->bitrev || !p->tw_re || !p->tw_im || !p->rt_re || !p->rt_im || !p->window ||
+        !p->zr || !p->zi || !p->frame || !p->xr || !p->xi) {
+        fft_plan_destroy(p);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < m; i++) {
+        uint32_t r = 0;
+        for (unsigned b = 0; b < bits; b++)
+            r |= ((i >> b) & 1u) << (bits - 1 - b);
+        p->bitrev[i] = r;
+    }
+
+    // Twiddles in double, then rounded once: no accumulated drift
+    for (uint32_t h = 1; h < m; h <<= 1) {
+        for (uint32_t j = 0; j < h; j++) {
+            double a = -TWO_PI_D * (double)j / (double)(2 * h);
+            p->tw_re[h - 1 + j] = (float)cos(a);
+            p->tw_im[h - 1 + j] = (float)sin(a);
+        }
+    }
+
+    for (uint32_t k = 0; k < m; k++) {
+        double a = -TWO_PI_D * (double)k / (double)n;
+        p->rt_re[k] = (float)cos(a);
+        p->rt_im[k] = (float)sin(a);
+    }
+
+    double sum = 0.0, sum_sq = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        double w = 0.5 - 0.5 * cos(TWO_PI_D * (double)i / (double)n);
+        p->window[i] = (float)w;
+        sum += w;
+        sum_sq += w * w;
+    }
+    p->window_sum = sum;
+    p->enbw_bins = (double)n * sum_sq / (sum * sum);   // 1.5 for Hann
+
+    return p;
+}
+
+void fft_plan_destroy(FftPlan *p)
+{
+    if (!p)
+        return;
+    free(p->bitrev);
+    free(p->tw_re);
+    free(p->tw_im);
+    free(p->rt_re);
+    free(p->rt_im);
+    free(p->window);
+    free(p->zr);
+    free(p->zi);
+    free(p->frame);
+    free(p->xr);
+    free(p->xi);
+    free(p);
+}
+
+uint32_t fft_plan_size(const FftPlan *p)
+{
+    return p ? p->n : 0;
+}
+
+// ============================================================
+// TRANSFORM
+// ============================================================
+
+// In-place radix-2 DIT over split re/im arrays already in bit-reversed order
+static void fft_complex(const FftPlan *p, float *re, float *im)
+{
+    const uint32_t m = p->m;
+    uint32_t h = 1;
+
+    // Short spans: scalar butterflies
+    for (; h < m && h < FFT_VEC; h <<= 1) {
+        const float *wr = p->tw_re + h - 1;
+        const float *wi = p->tw_im + h - 1;
+        for (uint32_t k = 0; k < m; k += 2 * h) {
+            for (uint32_t j = 0; j < h; j++) {
+                uint32_t a = k + j, b = a + h;
+                float tr = re[b] * wr[j] - im[b] * wi[j];
+                float ti = re[b] * wi[j] + im[b] * wr[j];
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+
+    // Long spans: FFT_VEC butterflies per step, twiddles contiguous per stage
+    for (; h < m; h <<= 1) {
+        const float *wr = p->tw_re + h - 1;
+        const float *wi = p->tw_im + h - 1;
+        for (uint32_t k = 0; k < m; k += 2 * h) {
+            float *ar = re + k, *ai = im + k;
+            float *br = ar + h, *bi = ai + h;
+            for (uint32_t j = 0; j < h; j += FFT_VEC) {
+                vf xr = vload(br + j), xi = vload(bi + j);
+                vf cr = vload(wr + j), ci = vload(wi + j);
+                vf tr = xr * cr - xi * ci;
+                vf ti = xr * ci + xi * cr;
+                vf yr = vload(ar + j), yi = vload(ai + j);
+                vstore(br + j, yr - tr);
+                vstore(bi + j, yi - ti);
+                vstore(ar + j, yr + tr);
+                vstore(ai + j, yi + ti);
+            }
+        }
+    }
+}
+
+void fft_real_forward(FftPlan *p, const float *in, float *re, float *im)
+{
+    const uint32_t m = p->m;
+    float *zr = p->zr, *zi = p->zi;
+
+    // Pack even/odd samples as one complex sequence, in bit-reversed order
+    for (uint32_t i = 0; i < m; i++) {
+        uint32_t r = p->bitrev[i];
+        zr[i] = in[2 * r];
+        zi[i] = in[2 * r + 1];
+    }
+
+    fft_complex(p, zr, zi);
+
+    // Split step: X[k] = E[k] + W^k O[k]
+    re[0] = zr[0] + zi[0];
+    im[0] = 0.0f;
+    re[m] = zr[0] - zi[0];
+    im[m] = 0.0f;
+    for (uint32_t k = 1; k < m; k++) {
+        uint32_t c = m - k;
+        float er = 0.5f * (zr[k] + zr[c]);
+        float ei = 0.5f * (zi[k] - zi[c]);
+        float orr = 0.5f * (zi[k] + zi[c]);
+        float oi = -0.5f * (zr[k] - zr[c]);
+        re[k] = er + p->rt_re[k] * orr - p->rt_im[k] * oi;
+        im[k] = ei + p->rt_re[k] * oi + p->rt_im[k] * orr;
+    }
+}
+
+// ============================================================
+// ANALYSIS
+// ============================================================
+
+float spectrum_band_edge(int band)
+{
+    if (band < 0 || band >= SPECTRUM_BANDS)
+        return 0.0f;
+    return band_edges[band];
+}
+
+static void insert_peak(SpectrumPeak *peaks, float freq, float amp)
+{
+    int i = SPECTRUM_PEAKS - 1;
+    if (amp <= peaks[i].amplitude)
+        return;
+    while (i > 0 && peaks[i - 1].amplitude < amp) {
+        peaks[i] = peaks[i - 1];
+        i--;
+    }
+    peaks[i].freq_hz = freq;
+    peaks[i].amplitude = amp;
+}
+
+// Sub-bin frequency of a peak at bin k from its neighbours (parabolic fit)
+static float refine_bin(const float *amp, uint32_t k, uint32_t m)
+{
+    if (k == 0 || k >= m)
+        return (float)k;
+    float a = amp[k - 1], b = amp[k], c = amp[k + 1];
+    float den = a - 2.0f * b + c;
+    return den < 0.0f ? (float)k + 0.5f * (a - c) / den : (float)k;
+}
+
+void spectrum_analyze(FftPlan *p, const float *samples, uint32_t rate_hz,
+                      float running_hz, SpectrumResult *res)
+{
+    const uint32_t n = p->n, m = p->m;
+    float *amp = p->xr;     // magnitudes replace re[] in place
+    double mean = 0.0;
+
+    memset(res, 0, sizeof(*res));
+    res->version = SPECTRUM_VERSION;
+    res->fft_size = n;
+    res->sample_rate_hz = rate_hz;
+    res->bin_hz = (float)rate_hz / (float)n;
+    res->running_hz = running_hz;
+
+    // 1. Remove DC, apply window
+    for (uint32_t i = 0; i < n; i++)
+        mean += samples[i];
+    mean /= (double)n;
+
+    {
+        vf vm = (vf){ 0 } + (float)mean;
+        uint32_t i = 0;
+        for (; i + FFT_VEC <= n; i += FFT_VEC)
+            vstore(p->frame + i, (vload(samples + i) - vm) * vload(p->window + i));
+        for (; i < n; i++)
+            p->frame[i] = (samples[i] - (float)mean) * p->window[i];
+    }
+
+    // 2. Transform, then single-sided peak amplitudes (window-corrected)
+    fft_real_forward(p, p->frame, p->xr, p->xi);
+
+    const float scale = (float)(2.0 / p->window_sum);
+    for (uint32_t k = 0; k <= m; k++)
+        amp[k] = scale * sqrtf(p->xr[k] * p->xr[k] + p->xi[k] * p->xi[k]);
+    amp[0] *= 0.5f;
+    amp[m] *= 0.5f;
+
+    // 3. Band and total RMS: sum of bin powers over the window's ENBW
+    double band_pow[SPECTRUM_BANDS] = { 0 };
+    double total_pow = 0.0;
+    int band = 0;
+    for (uint32_t k = 1; k <= m; k++) {
+        float f = (float)k * res->bin_hz;
+        double pw = 0.5 * (double)amp[k] * (double)amp[k];
+        while (band + 1 < SPECTRUM_BANDS && f >= band_edges[band + 1])
+            band++;
+        band_pow[band] += pw;
+        total_pow += pw;
+    }
+    for (int b = 0; b < SPECTRUM_BANDS; b++)
+        res->band_rms[b] = (float)sqrt(band_pow[b] / p->enbw_bins);
+    res->total_rms = (float)sqrt(total_pow / p->enbw_bins);
+
+    // 4. Peaks and dominant line (bins 0-1 carry window leakage of the DC)
+    for (uint32_t k = 2; k < m; k++) {
+        if (amp[k] > amp[k - 1] && amp[k] >= amp[k + 1])
+            insert_peak(res->peaks, refine_bin(amp, k, m) * res->bin_hz, amp[k]);
+    }
+    res->dominant_hz = res->peaks[0].freq_hz;
+    res->dominant_amp = res->peaks[0].amplitude;
+
+    // 5. Running-speed harmonics: strongest bin within +/-2 bins of h * f0
+    if (running_hz > 0.0f) {
+        for (int h = 0; h < SPECTRUM_HARMONICS; h++) {
+            float target = (float)(h + 1) * running_hz / res->bin_hz;
+            int lo = (int)target - 2, hi = (int)target + 2;
+            if (lo < 1) lo = 1;
+            if (hi > (int)m) hi = (int)m;
+            for (int k = lo; k <= hi; k++) {
+                if (amp[k] > res->harmonic_amp[h])
+                    res->harmonic_amp[h] = amp[k];
+            }
+        }
+    }
+
+    // 6. Max-hold decimation for display/transport
+    uint32_t out = m < SPECTRUM_OUT_BINS ? m : SPECTRUM_OUT_BINS;
+    uint32_t group = m / out;
+    res->out_bins = out;
+    res->out_bin_hz = res->bin_hz * (float)group;
+    for (uint32_t o = 0; o < out; o++) {
+        float mx = 0.0f;
+        for (uint32_t k = o * group; k < (o + 1) * group; k++)
+            if (amp[k] > mx) mx = amp[k];
+        res->bins[o] = mx;
+    }
+}
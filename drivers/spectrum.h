@@ -0,0 +1,95 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <stdint.h>
+
+// ============================================================
+// VIBRATION SPECTRUM ENGINE
+// ============================================================
+//
+// Real FFT of power-of-two size N, computed as an N/2-point complex FFT
+// plus a split step. Twiddles, bit-reversal order and the Hann window are
+// precomputed in an FftPlan; butterflies use GCC vector extensions, which
+// lower to SSE/AVX on x86, NEON on the Pi and plain scalar code elsewhere.
+//
+// Plans and work buffers are allocated up front. Nothing here is meant to
+// run on the RT polling thread: spectra are computed by a worker that
+// reads the raw sample ring.
+
+#define FFT_MIN_SIZE        64
+#define FFT_MAX_SIZE        65536
+
+#define SPECTRUM_FFT_SIZE   16384      // 1.22 Hz resolution at 20 kHz
+#define SPECTRUM_OUT_BINS   256        // max-hold decimated magnitude bins
+#define SPECTRUM_BANDS      7
+#define SPECTRUM_HARMONICS  4          // 1x..4x running speed
+#define SPECTRUM_PEAKS      5
+#define SPECTRUM_VERSION    1
+
+typedef struct FftPlan FftPlan;
+
+/**
+ * SpectrumPeak: One local maximum of the amplitude spectrum.
+ */
+typedef struct {
+    float freq_hz;
+    float amplitude;
+} SpectrumPeak;
+
+/**
+ * SpectrumResult: Analysis of one vibration frame. Fixed size, fixed-width
+ * fields and no pointers, so it can be copied through a seqlock and sent
+ * as-is (little-endian) by binary clients.
+ * Amplitudes are single-sided peak amplitudes in raw vibration units,
+ * window-corrected; band values are RMS over the band.
+ */
+typedef struct {
+    uint32_t version;                      // SPECTRUM_VERSION
+    uint32_t fft_size;                     // 0 = no spectrum computed yet
+    uint32_t sample_rate_hz;
+    uint32_t out_bins;                     // SPECTRUM_OUT_BINS
+    uint64_t t_end_ns;                     // CLOCK_MONOTONIC of the last sample
+    float bin_hz;                          // FFT resolution
+    float out_bin_hz;                      // width of one bins[] entry
+    float running_hz;                      // shaft speed used for harmonics (0 = unknown)
+    float dominant_hz;
+    float dominant_amp;
+    float total_rms;                       // AC RMS over the whole spectrum
+    float band_rms[SPECTRUM_BANDS];        // see spectrum_band_edge()
+    float harmonic_amp[SPECTRUM_HARMONICS];
+    SpectrumPeak peaks[SPECTRUM_PEAKS];    // strongest first
+    float bins[SPECTRUM_OUT_BINS];         // max-hold decimated amplitudes
+} SpectrumResult;
+
+_Static_assert(sizeof(SpectrumResult) % 8 == 0, "SpectrumResult must stay padding-free");
+
+/**
+ * fft_plan_create: Precomputes twiddles, bit reversal and window for a
+ * real FFT of n samples (power of two, FFT_MIN_SIZE..FFT_MAX_SIZE).
+ * Returns NULL on a bad size or allocation failure.
+ */
+FftPlan* fft_plan_create(uint32_t n);
+void fft_plan_destroy(FftPlan *plan);
+uint32_t fft_plan_size(const FftPlan *plan);
+
+/**
+ * fft_real_forward: Unwindowed real FFT of n samples. Writes bins
+ * 0..n/2 inclusive (n/2 + 1 values each) to re/im.
+ */
+void fft_real_forward(FftPlan *plan, const float *in, float *re, float *im);
+
+/**
+ * spectrum_analyze: Removes the mean, applies the Hann window, transforms
+ * and reduces the frame into res. samples holds fft_plan_size(plan)
+ * values taken at rate_hz.
+ */
+void spectrum_analyze(FftPlan *plan, const float *samples, uint32_t rate_hz,
+                      float running_hz, SpectrumResult *res);
+
+/**
+ * spectrum_band_edge: Lower edge of band b in Hz; band b ends where
+ * band b + 1 starts (the last band ends at Nyquist).
+ */
+float spectrum_band_edge(int band);
+
+#endif // SPECTRUM_H
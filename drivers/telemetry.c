@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "telemetry.h"
+
+// Guards every slot's frame pointer. Held only to swap a pointer or take
+// a reference: a publish per window per unit and one acquire per monitor
+// line, all from ordinary threads.
+static pthread_mutex_t slot_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int telemetry_publish(TelemetrySlot *slot, uint16_t unit, const EquipmentHealth *h)
+{
+    TelemetryFrame *f = malloc(sizeof(TelemetryFrame));
+    TelemetryFrame *prev = slot->frame;   // only this thread replaces it
+    const ChannelFeatures *v = &h->features[CH_VIBRATION];
+    float peak = fmaxf(fabsf(v->min), fabsf(v->max));   // the peak crest_factor uses
+
+    if (!f)
+        return -1;
+    atomic_init(&f->refs, 1);
+    f->seq = slot->seq + 1;
+    f->t_ms = h->window_end_ms;
+    memcpy(f->unit_id, h->unit_id, MAX_ID_LENGTH);
+    f->unit = unit;
+
+    int n = snprintf(f->text, sizeof(f->text),
+                     "[%s] Vib: %.0f | Snd: %.0f%% | Temp: %.1fC | Cur: %.2fA\n"
+                     "    Vib RMS: %.3f | Peak: %.3f | Crest: %.2f | Kurt: %.2f | Skew: %.2f\n",
+                     health_to_string(h->status),
+                     h->snapshot.vibration_level,
+                     h->snapshot.sound_level,
+                     h->snapshot.temperature_c,
+                     h->snapshot.current_a,
+                     v->rms, peak, v->crest_factor, v->kurtosis, v->skewness);
+    f->text_len = n < 0 ? 0 : n >= (int)sizeof(f->text) ? sizeof(f->text) - 1 : (uint32_t)n;
+
+    // Value order is the SNAPSHOT layout of wire.h
+    WireSnapshot *w = &f->values;
+    w->status = (uint8_t)h->status;
+    w->values[0] = h->snapshot.vibration_level;
+    w->values[1] = h->snapshot.sound_level;
+    w->values[2] = h->snapshot.temperature_c;
+    w->values[3] = h->snapshot.current_a;
+    w->values[4] = v->rms;
+    w->values[5] = peak;
+    w->values[6] = v->crest_factor;
+    w->values[7] = v->kurtosis;
+    w->values[8] = v->skewness;
+
+    wire_header(f->snapshot, WIRE_SNAPSHOT, unit, f->seq, f->t_ms, WIRE_SNAPSHOT_SIZE);
+    wire_snapshot(f->snapshot + WIRE_HEADER_SIZE, w);
+
+    pthread_mutex_lock(&slot_lock);
+    slot->seq = f->seq;
+    slot->frame = f;
+    pthread_mutex_unlock(&slot_lock);
+
+    if (prev)
+        telemetry_release(prev);
+    return 0;
+}
+
+TelemetryFrame *telemetry_acquire(TelemetrySlot *slot)
+{
+    TelemetryFrame *f;
+
+    pthread_mutex_lock(&slot_lock);
+    f = slot->frame;
+    if (f)
+        atomic_fetch_add_explicit(&f->refs, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&slot_lock);
+    return f;
+}
+
+void telemetry_release(TelemetryFrame *f)
+{
+    if (f && atomic_fetch_sub_explicit(&f->refs, 1, memory_order_acq_rel) == 1)
+        free(f);
+}
+
+void telemetry_clear(TelemetrySlot *slot)
+{
+    TelemetryFrame *old;
+
+    pthread_mutex_lock(&slot_lock);
+    old = slot->frame;
+    slot->frame = NULL;
+    pthread_mutex_unlock(&slot_lock);
+
+    telemetry_release(old);
+}
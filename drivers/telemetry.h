@@ -0,0 +1,75 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "sensors.h"
+#include "wire.h"
+
+// ============================================================
+// TELEMETRY HUB (encode once, fan out)
+// ============================================================
+//
+// Every monitor session used to read the unit's health and format the
+// same numbers itself, so a window cost as many snprintf calls as there
+// were viewers. Now the manager's store thread encodes each published
+// window once into an immutable reference-counted TelemetryFrame: the
+// monitor text and the SNAPSHOT frame of the wire format (wire.h), plus
+// the decoded values a session diffs against for its DELTA frames. The
+// frame replaces the one in the unit's TelemetrySlot. A session takes a
+// reference to the current frame, queues the bytes its mode needs and
+// drops the reference; a replaced frame is freed by whoever releases it
+// last, so a reader never sees one change or disappear under it.
+
+#define TELEMETRY_TEXT_MAX 256
+
+/**
+ * TelemetryFrame: One window of one unit, encoded. Never modified after
+ * it is published.
+ */
+typedef struct {
+    atomic_int refs;
+    uint64_t seq;                       // 1, 2, ... per unit since start
+    uint64_t t_ms;                      // window close, Unix ms
+    char unit_id[MAX_ID_LENGTH];
+    uint16_t unit;                      // wire unit number (list_units index)
+    uint32_t text_len;
+    char text[TELEMETRY_TEXT_MAX];      // monitor lines, NUL-terminated
+    unsigned char snapshot[WIRE_HEADER_SIZE + WIRE_SNAPSHOT_SIZE];   // SNAPSHOT frame
+    WireSnapshot values;                // what snapshot carries
+} TelemetryFrame;
+
+/**
+ * TelemetrySlot: A unit's current frame. Zero-initialised = empty.
+ */
+typedef struct {
+    TelemetryFrame *frame;
+    uint64_t seq;                       // seq of the last frame published
+} TelemetrySlot;
+
+/**
+ * telemetry_publish: Encodes one window of unit (its list_units index)
+ * and makes it the slot's current frame. One publisher per slot; not
+ * for the RT loop (allocates and takes a lock).
+ * Returns 0, or -1 if out of memory (the slot keeps its frame).
+ */
+int telemetry_publish(TelemetrySlot *slot, uint16_t unit, const EquipmentHealth *h);
+
+/**
+ * telemetry_acquire: A new reference to the slot's current frame, or
+ * NULL if nothing has been published. Release it when done.
+ */
+TelemetryFrame *telemetry_acquire(TelemetrySlot *slot);
+
+/**
+ * telemetry_release: Drops a reference; the last one frees the frame.
+ */
+void telemetry_release(TelemetryFrame *f);
+
+/**
+ * telemetry_clear: Empties the slot, dropping its reference.
+ */
+void telemetry_clear(TelemetrySlot *slot);
+
+#endif // TELEMETRY_H
@@ -0,0 +1,97 @@
+#ifndef WINDOW_STATS_H
+#define WINDOW_STATS_H
+
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+#include "sensors.h"
+
+// ============================================================
+// STREAMING WINDOW STATISTICS
+// ============================================================
+//
+// Welford's running mean extended to the 3rd and 4th central moments
+// (Terriberry's update), so skewness and kurtosis come out of a single
+// pass in O(1) per sample without the cancellation of raw power sums.
+// Accumulators are double; a 1 s window at 20 kHz is 20000 updates.
+
+typedef struct {
+    uint32_t n;
+    double mean;
+    double m2;             // sum of squared deviations from the mean
+    double m3;
+    double m4;
+    float min;
+    float max;
+} WindowStats;
+
+static inline void window_stats_reset(WindowStats *w)
+{
+    w->n = 0;
+    w->mean = 0.0;
+    w->m2 = 0.0;
+    w->m3 = 0.0;
+    w->m4 = 0.0;
+    w->min = FLT_MAX;
+    w->max = -FLT_MAX;
+}
+
+/**
+ * window_stats_add: Folds one sample into the window. Hot path.
+ */
+static inline void window_stats_add(WindowStats *w, float x)
+{
+    double n1 = (double)w->n;
+    double n = n1 + 1.0;
+    double delta = (double)x - w->mean;
+    double delta_n = delta / n;
+    double delta_n2 = delta_n * delta_n;
+    double term1 = delta * delta_n * n1;
+
+    w->n++;
+    w->mean += delta_n;
+    w->m4 += term1 * delta_n2 * (n * n - 3.0 * n + 3.0)
+           + 6.0 * delta_n2 * w->m2 - 4.0 * delta_n * w->m3;
+    w->m3 += term1 * delta_n * (n - 2.0) - 3.0 * delta_n * w->m2;
+    w->m2 += term1;
+
+    if (x < w->min) w->min = x;
+    if (x > w->max) w->max = x;
+}
+
+/**
+ * window_stats_finish: Derives the published indicators. Shape metrics
+ * of a constant (or empty) window are reported as 0. Kurtosis is
+ * Pearson's (3.0 for Gaussian noise), the usual bearing-fault scale.
+ */
+static inline void window_stats_finish(const WindowStats *w, ChannelFeatures *f)
+{
+    if (w->n == 0) {
+        f->mean = f->rms = f->min = f->max = 0.0f;
+        f->peak_to_peak = f->crest_factor = f->skewness = f->kurtosis = 0.0f;
+        return;
+    }
+
+    double n = (double)w->n;
+    double var = w->m2 / n;
+    double rms = sqrt(w->mean * w->mean + var);
+    double peak = fabs((double)w->max) > fabs((double)w->min) ? fabs((double)w->max)
+                                                              : fabs((double)w->min);
+
+    f->mean = (float)w->mean;
+    f->rms = (float)rms;
+    f->min = w->min;
+    f->max = w->max;
+    f->peak_to_peak = w->max - w->min;
+    f->crest_factor = rms > 0.0 ? (float)(peak / rms) : 0.0f;
+
+    if (w->m2 > 0.0 && w->n > 1) {
+        f->skewness = (float)(sqrt(n) * w->m3 / pow(w->m2, 1.5));
+        f->kurtosis = (float)(n * w->m4 / (w->m2 * w->m2));
+    } else {
+        f->skewness = 0.0f;
+        f->kurtosis = 0.0f;
+    }
+}
+
+#endif // WINDOW_STATS_H
@@ -5,16 +5,108 @@
 #include <sys/select.h>
 #include <sys/time.h>
 #include <openssl/ssl.h>
+#include <openssl/err.h>
 #include <time.h>
-#include <pthread.h>
+#include <ctype.h>
+#include <strings.h>
+#include <limits.h>
 
 #include "protocol.h"
 #include "authorization.h"
 #include "sensor_manager.h"
+#include "rt_log.h"
+#include "blackbox.h"
+#include "alerts.h"
+#include "rules.h"
+#include "wire.h"
 
 #define EOM_MARKER '\x03'
+#define OUT_CHUNK  4096              // first allocation of a session's output buffer
+#define MONITOR_PERIOD_MS 1000
+#define HISTORY_FRAME_POINTS 1024    // binary get_history: points per HISTORY frame
 
-static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
+typedef enum {
+    STREAM_MONITOR,
+    STREAM_LOG,          // get_log, paged out as the client reads
+    STREAM_FOLLOW,       // follow_log
+    STREAM_ALERTS,       // subscribe_alerts
+    STREAM_CLEAR         // clear_log, until the committer has done it
+} StreamKind;
+
+typedef struct {
+    ProtocolContext *ctx;
+    long limit;          // 0 = no limit
+    long offset;         // matches still to skip
+    long shown;
+    uint64_t last_seq;   // last record shown: the resume cursor
+    uint64_t consumed;   // last record shown or skipped
+    int more;            // stopped at limit
+    int paused;          // stopped because the client is behind
+} LogRender;
+
+/*
+ * ProtocolStream: A streaming command between protocol_poll calls.
+ * Times are CLOCK_MONOTONIC ms.
+ */
+struct ProtocolStream {
+    StreamKind kind;
+    int64_t stop_ms;            // time limit, 0 = none
+    int64_t next_ms;            // monitor: next line due
+    long ticks;                 // monitor: lines so far
+    long max_ticks;             // monitor: -1 = infinite
+    uint64_t sent_seq;          // monitor (binary): window last sent, 0 = none
+    int since_key;              // monitor (binary): deltas since the last SNAPSHOT
+    WireSnapshot sent;          // monitor (binary): its values, the next DELTA's base
+    char unit[MAX_ID_LENGTH];   // monitor unit / subscribe_alerts filter
+    int critical_only;          // subscribe_alerts severity=critical
+    uint64_t cursor;            // last record/alert consumed; clear_log ticket
+    uint64_t sync_seq;          // get_log: record that must be committed first, 0 = none
+    int64_t wait_until;         // get_log/clear_log: longest wait for the committer
+    uint64_t missed;            // alerts lost to the ring
+    BlackboxQuery q;            // get_log / follow_log filters
+    char log_unit[BLACKBOX_UNIT_MAX + 1];
+    int filtered;               // get_log: unit/kind/time filter given
+    int paged;                  // get_log: limit/offset/after given
+    long blocks_read;           // get_log: index blocks read over all pages
+    long blocks;
+    LogRender r;
+};
+
+static int64_t mono_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static size_t output_backlog(const ProtocolContext *ctx)
+{
+    return ctx->out_len - ctx->out_off;
+}
+
+static ProtocolStream *stream_begin(ProtocolContext *ctx, StreamKind kind)
+{
+    ProtocolStream *s = calloc(1, sizeof(ProtocolStream));
+
+    if (!s) {
+        send_response(ctx, "[ERROR] Out of memory.\n");
+        send_eom(ctx);
+        return NULL;
+    }
+    s->kind = kind;
+    s->r.ctx = ctx;
+    return s;
+}
+
+/* Ends the running stream with an optional closing line and the EOM. */
+static void stream_end(ProtocolContext *ctx, const char *msg)
+{
+    if (msg)
+        send_response(ctx, msg);
+    send_eom(ctx);
+    free(ctx->stream);
+    ctx->stream = NULL;
+}
 
 static int role_can_execute(UserRole role, const char *command)
 {
@@ -26,7 +118,13 @@ static int role_can_execute(UserRole role, const char *command)
         !strcmp(command, "list_units") ||
         !strcmp(command, "get_sensors") ||
         !strcmp(command, "get_health") ||
+        !strcmp(command, "get_spectrum") ||
+        !strcmp(command, "get_history") ||
         !strcmp(command, "get_log") ||
+        !strcmp(command, "follow_log") ||
+        !strcmp(command, "subscribe_alerts") ||
+        !strcmp(command, "get_latency") ||
+        !strcmp(command, "protocol") ||
         !strcmp(command, "quit") ||
         !strcmp(command, "exit")) {
         return 1;
@@ -35,6 +133,9 @@ static int role_can_execute(UserRole role, const char *command)
     if (!strcmp(command, "monitor"))
         return role == ROLE_OPERATOR || role == ROLE_MAINTENANCE || role == ROLE_ADMIN;
 
+    if (!strcmp(command, "set_rate") || !strcmp(command, "reload_rules"))
+        return role == ROLE_MAINTENANCE || role == ROLE_ADMIN;
+
     if (!strcmp(command, "clear_log"))
         return role == ROLE_ADMIN;
 
@@ -55,36 +156,194 @@ static void send_permission_denied(ProtocolContext *ctx, const char *command)
 /* ============================================================ */
 /* Helper Functions                                             */
 /* ============================================================ */
+
+/* A number token is digits only ("500"). */
+static int is_number_token(const char *tok)
+{
+    if (!isdigit((unsigned char)*tok))
+        return 0;
+    while (isdigit((unsigned char)*tok))
+        tok++;
+    return *tok == '\0';
+}
+
+/* A duration token is digits with an optional s/m/h/d suffix ("20s", "5m"). */
+static int is_duration_token(const char *tok)
+{
+    if (!isdigit((unsigned char)*tok))
+        return 0;
+    while (isdigit((unsigned char)*tok))
+        tok++;
+    if (*tok == 's' || *tok == 'm' || *tok == 'h' || *tok == 'd')
+        tok++;
+    return *tok == '\0';
+}
+
+/* Seconds in a duration token (see is_duration_token). */
+static long duration_seconds(const char *tok)
+{
+    char *end;
+    long val = strtol(tok, &end, 10);
+
+    if (*end == 'm')
+        return val * 60;
+    if (*end == 'h')
+        return val * 3600;
+    if (*end == 'd')
+        return val * 86400;
+    return val;
+}
+
+/*
+ * resolve_unit: Picks the unit named by the client, or the default unit
+ * when none was given. Sends the error and EOM itself on an unknown unit.
+ * Returns 1 with out_id filled, 0 if the command must stop.
+ */
+static int resolve_unit(ProtocolContext *ctx, const char *name, char out_id[MAX_ID_LENGTH])
+{
+    if (!name || !*name)
+        name = manager_default_unit(ctx->sensor_mgr);
+
+    if (!manager_has_unit(ctx->sensor_mgr, name)) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "Unknown unit '%.*s'. Type 'list_units'.\n",
+                 MAX_ID_LENGTH, name);
+        send_response(ctx, msg);
+        send_eom(ctx);
+        return 0;
+    }
+
+    snprintf(out_id, MAX_ID_LENGTH, "%s", name);
+    return 1;
+}
+
+/* Appends len bytes to the output and returns where they go, or NULL. */
+static char *reserve_output(ProtocolContext *ctx, size_t len)
+{
+    if (ctx->out_off > 0 && ctx->out_len + len > ctx->out_cap) {
+        // Reclaim what is written before growing (the reactor lets a
+        // pending SSL_write retry from the moved buffer)
+        memmove(ctx->out, ctx->out + ctx->out_off, ctx->out_len - ctx->out_off);
+        ctx->out_len -= ctx->out_off;
+        ctx->out_off = 0;
+    }
+    if (ctx->out_len + len > ctx->out_cap) {
+        size_t cap = ctx->out_cap ? ctx->out_cap : OUT_CHUNK;
+        while (cap < ctx->out_len + len)
+            cap *= 2;
+        char *grown = realloc(ctx->out, cap);
+        if (!grown)
+            return NULL;
+        ctx->out = grown;
+        ctx->out_cap = cap;
+    }
+    char *at = ctx->out + ctx->out_len;
+    ctx->out_len += len;
+    return at;
+}
+
+static int queue_output(ProtocolContext *ctx, const char *data, size_t len)
+{
+    char *at = reserve_output(ctx, len);
+    if (!at)
+        return -1;
+    memcpy(at, data, len);
+    return 0;
+}
+
+static void output_dropped(ProtocolContext *ctx)
+{
+    log_error("[PROTOCOL] Output of %s dropped (client not reading)\n",
+              ctx->identity.common_name);
+}
+
+static void send_data(ProtocolContext *ctx, const void *data, size_t len)
+{
+    if (output_backlog(ctx) + len > PROTOCOL_OUT_MAX || queue_output(ctx, data, len) != 0)
+        output_dropped(ctx);
+}
+
+/*
+ * Reserves a binary frame (wire.h) with its header written and returns
+ * where its payload_len bytes of payload go, or NULL if it was dropped.
+ * Only END frames are never capped.
+ */
+static unsigned char *begin_frame(ProtocolContext *ctx, WireType type, uint16_t unit,
+                                  uint64_t seq, uint64_t t_ms, size_t payload_len)
+{
+    size_t len = WIRE_HEADER_SIZE + payload_len;
+    unsigned char *p = NULL;
+
+    if (type == WIRE_END || output_backlog(ctx) + len <= PROTOCOL_OUT_MAX)
+        p = (unsigned char *)reserve_output(ctx, len);
+    if (!p) {
+        output_dropped(ctx);
+        return NULL;
+    }
+    wire_header(p, type, unit, seq, t_ms, payload_len);
+    return p + WIRE_HEADER_SIZE;
+}
+
+static void send_frame(ProtocolContext *ctx, WireType type, uint16_t unit, uint64_t seq,
+                       uint64_t t_ms, const void *payload, size_t payload_len)
+{
+    unsigned char *p = begin_frame(ctx, type, unit, seq, t_ms, payload_len);
+    if (p && payload_len)
+        memcpy(p, payload, payload_len);
+}
+
+/* Wire unit number of a registered unit */
+static uint16_t wire_unit(ProtocolContext *ctx, const char *unit_id)
+{
+    int i = manager_unit_index(ctx->sensor_mgr, unit_id);
+    return i >= 0 && (unsigned)i < WIRE_NO_UNIT ? (uint16_t)i : WIRE_NO_UNIT;
+}
+
 void send_response(ProtocolContext *ctx, const char *msg)
 {
-    if (ctx && ctx->ssl && msg)
-        SSL_write(ctx->ssl, msg, (int)strlen(msg));
+    if (!ctx || !msg)
+        return;
+    if (ctx->wire_version)
+        send_frame(ctx, WIRE_TEXT, WIRE_NO_UNIT, 0, 0, msg, strlen(msg));
+    else
+        send_data(ctx, msg, strlen(msg));
 }
 
 void send_eom(ProtocolContext *ctx)
 {
     char marker = EOM_MARKER;
-    if (ctx && ctx->ssl)
-        SSL_write(ctx->ssl, &marker, 1);
+
+    // Never capped: a lost marker would leave the client waiting
+    if (!ctx)
+        return;
+    if (ctx->wire_version)
+        begin_frame(ctx, WIRE_END, WIRE_NO_UNIT, 0, 0, 0);
+    else
+        queue_output(ctx, &marker, 1);
 }
 
-void log_alert(const char *unit, const char *message)
+int protocol_flush(ProtocolContext *ctx)
 {
-    pthread_mutex_lock(&log_mutex);
+    ERR_clear_error();
+    while (ctx->out_off < ctx->out_len) {
+        size_t left = ctx->out_len - ctx->out_off;
+        int n = SSL_write(ctx->ssl, ctx->out + ctx->out_off, left > INT_MAX ? INT_MAX : (int)left);
 
-    FILE *f = fopen("blackbox.log", "a");
-    if (!f) {
-        pthread_mutex_unlock(&log_mutex);
-        return;
+        if (n <= 0) {
+            int err = SSL_get_error(ctx->ssl, n);
+            return err == SSL_ERROR_WANT_WRITE || err == SSL_ERROR_WANT_READ ? 0 : -1;
+        }
+        ctx->out_off += (size_t)n;
     }
 
-    time_t now = time(NULL);
-    char *ts = ctime(&now);
-    ts[strlen(ts) - 1] = 0;
-
-    fprintf(f, "[%s] CRITICAL ALERT | Unit: %s | %s\n", ts, unit, message);
-    fclose(f);
-    pthread_mutex_unlock(&log_mutex);
+    // Idle sessions keep at most a small buffer
+    ctx->out_len = ctx->out_off = 0;
+    if (ctx->out_cap > OUT_CHUNK) {
+        free(ctx->out);
+        ctx->out = NULL;
+        ctx->out_cap = 0;
+    }
+    return 1;
 }
 
 /* ============================================================ */
@@ -95,17 +354,28 @@ void cmd_help(ProtocolContext *ctx)
 {
     send_response(ctx, "Available commands:\n");
     send_response(ctx, "  list_units     - List equipment\n");
-    send_response(ctx, "  get_sensors    - Raw sensors\n");
-    send_response(ctx, "  get_health     - Health report\n");
-    send_response(ctx, "  get_log        - Show blackbox.log\n");
+    send_response(ctx, "  get_sensors [unit] - Raw sensors\n");
+    send_response(ctx, "  get_health [unit]  - Health report\n");
+    send_response(ctx, "  get_spectrum [unit] - Vibration FFT summary\n");
+    send_response(ctx, "  get_history [unit] <channel> [range] - Level history (e.g. 10m, 6h, 7d)\n");
+    send_response(ctx, "  get_log [unit] [range] [filters] - Blackbox (limit=, offset=, after=, severity=)\n");
+    send_response(ctx, "  follow_log [unit] [time] [severity=] - Stream new blackbox records\n");
+    send_response(ctx, "  subscribe_alerts [unit] [time] [severity=] - Push alerts as they fire\n");
+    send_response(ctx, "  get_latency    - RT loop latency percentiles\n");
     if (ctx->identity.role == ROLE_OPERATOR ||
         ctx->identity.role == ROLE_MAINTENANCE ||
         ctx->identity.role == ROLE_ADMIN) {
-        send_response(ctx, "  monitor [time] - Live stream\n");
+        send_response(ctx, "  monitor [unit] [time] - Live stream\n");
+    }
+    if (ctx->identity.role == ROLE_MAINTENANCE ||
+        ctx->identity.role == ROLE_ADMIN) {
+        send_response(ctx, "  set_rate [unit] <hz|auto> [window_ms] - Acquisition rate\n");
+        send_response(ctx, "  reload_rules   - Re-read config/rules.conf\n");
     }
     if (ctx->identity.role == ROLE_ADMIN)
-        send_response(ctx, "  clear_log      - Wipe blackbox.log\n");
+        send_response(ctx, "  clear_log      - Wipe the blackbox\n");
     send_response(ctx, "  whoami         - Identity info\n");
+    send_response(ctx, "  protocol <text|binary [version] [delta]> - Reply format\n");
     send_response(ctx, "  quit           - Disconnect session\n");
     send_eom(ctx);
 }
@@ -122,8 +392,40 @@ void cmd_whoami(ProtocolContext *ctx)
 
 void cmd_list_units(ProtocolContext *ctx)
 {
-    char list[MAX_UNITS][MAX_ID_LENGTH];
-    int count = manager_list_units(ctx->sensor_mgr, list, MAX_UNITS);
+    int total = manager_unit_count(ctx->sensor_mgr);
+    char (*list)[MAX_ID_LENGTH] = malloc((size_t)(total > 0 ? total : 1) * MAX_ID_LENGTH);
+
+    if (!list) {
+        send_response(ctx, "[ERROR] Out of memory.\n");
+        send_eom(ctx);
+        return;
+    }
+
+    int count = manager_list_units(ctx->sensor_mgr, list, total);
+
+    if (ctx->wire_version) {
+        // UNITS frames: index, then length-prefixed ids
+        int first = 0;
+        do {
+            int n = count - first < WIRE_UNITS_PER_FRAME ? count - first : WIRE_UNITS_PER_FRAME;
+            unsigned char payload[4 + WIRE_UNITS_PER_FRAME * (1 + MAX_ID_LENGTH)];
+            size_t len = 4;
+
+            wire_put_u16(payload, (uint16_t)first);
+            wire_put_u16(payload + 2, (uint16_t)n);
+            for (int i = first; i < first + n; i++) {
+                size_t id_len = strnlen(list[i], MAX_ID_LENGTH);
+                payload[len++] = (unsigned char)id_len;
+                memcpy(payload + len, list[i], id_len);
+                len += id_len;
+            }
+            send_frame(ctx, WIRE_UNITS, WIRE_NO_UNIT, 0, 0, payload, len);
+            first += WIRE_UNITS_PER_FRAME;
+        } while (first < count);
+        free(list);
+        send_eom(ctx);
+        return;
+    }
 
     send_response(ctx, "=== Registered Units ===\n");
 
@@ -132,13 +434,23 @@ void cmd_list_units(ProtocolContext *ctx)
         snprintf(buf, sizeof(buf), " - %s\n", list[i]);
         send_response(ctx, buf);
     }
+    free(list);
     send_eom(ctx);
 }
 
-void cmd_get_sensors(ProtocolContext *ctx)
+static const char *const channel_names[CH_COUNT] = {
+    "Vibration", "Sound", "Temp", "Current"
+};
+
+void cmd_get_sensors(ProtocolContext *ctx, const char *args)
 {
+    char unit[MAX_ID_LENGTH];
     EquipmentHealth h;
-    if (manager_get_health(ctx->sensor_mgr, "Sentinel-RT", &h)) {
+
+    if (!resolve_unit(ctx, args, unit))
+        return;
+
+    if (manager_get_health(ctx->sensor_mgr, unit, &h)) {
         char buf[256];
         snprintf(buf, sizeof(buf),
                  "Vib: %.0f | Snd: %.1f%% | Temp: %.1fC | Cur: %.2fA\n",
@@ -146,16 +458,281 @@ void cmd_get_sensors(ProtocolContext *ctx)
                  h.snapshot.sound_level,
                  h.snapshot.temperature_c,
                  h.snapshot.current_a);
+        send_response(ctx, buf);
+
+        snprintf(buf, sizeof(buf), "Acquisition: %u Hz (%s) | Window: %u ms\n",
+                 h.sample_rate_hz, h.adaptive ? "adaptive" : "fixed", h.window_ms);
+        send_response(ctx, buf);
+
+        send_response(ctx, "Channel   |     Mean |      RMS |      Min |      Max |      P2P | Crest |  Skew |  Kurt\n");
+        for (int c = 0; c < CH_COUNT; c++) {
+            const ChannelFeatures *f = &h.features[c];
+            snprintf(buf, sizeof(buf),
+                     "%-9s | %8.3f | %8.3f | %8.3f | %8.3f | %8.3f | %5.2f | %5.2f | %5.2f\n",
+                     channel_names[c], f->mean, f->rms, f->min, f->max,
+                     f->peak_to_peak, f->crest_factor, f->skewness, f->kurtosis);
+            send_response(ctx, buf);
+        }
+    }
+    send_eom(ctx);
+}
+
+void cmd_get_spectrum(ProtocolContext *ctx, const char *args)
+{
+    char unit[MAX_ID_LENGTH];
+    char buf[256];
+    int len;
+
+    if (!resolve_unit(ctx, args, unit))
+        return;
+
+    // ~1.2 KB: fine on the session stack, unlike RtStatsSnapshot
+    SpectrumResult s;
+    if (!manager_get_spectrum(ctx->sensor_mgr, unit, &s) || s.fft_size == 0) {
+        send_response(ctx, "[INFO] Spectrum not available yet (needs one full FFT frame).\n");
+        send_eom(ctx);
+        return;
+    }
+
+    snprintf(buf, sizeof(buf), "=== Vibration Spectrum %s (%u-pt, %.2f Hz/bin, %u Hz) ===\n",
+             unit, s.fft_size, s.bin_hz, s.sample_rate_hz);
+    send_response(ctx, buf);
+    snprintf(buf, sizeof(buf), "Dominant : %.2f Hz (amp %.4f) | Total RMS: %.4f\n",
+             s.dominant_hz, s.dominant_amp, s.total_rms);
+    send_response(ctx, buf);
+
+    len = snprintf(buf, sizeof(buf), "Band RMS :");
+    for (int b = 0; b < SPECTRUM_BANDS && len < (int)sizeof(buf); b++) {
+        float lo = spectrum_band_edge(b);
+        float hi = b + 1 < SPECTRUM_BANDS ? spectrum_band_edge(b + 1) : 0.5f * (float)s.sample_rate_hz;
+        len += snprintf(buf + len, sizeof(buf) - (size_t)len, " %.0f-%.0f:%.4f", lo, hi, s.band_rms[b]);
+    }
+    send_response(ctx, buf);
+    send_response(ctx, "\n");
 
+    if (s.running_hz > 0.0f) {
+        len = snprintf(buf, sizeof(buf), "Harmonics of %.2f Hz (%.0f rpm):",
+                       s.running_hz, s.running_hz * 60.0f);
+        for (int h = 0; h < SPECTRUM_HARMONICS && len < (int)sizeof(buf); h++)
+            len += snprintf(buf + len, sizeof(buf) - (size_t)len, " %dx %.4f", h + 1, s.harmonic_amp[h]);
         send_response(ctx, buf);
+        send_response(ctx, "\n");
     }
+
+    len = snprintf(buf, sizeof(buf), "Peaks    :");
+    for (int k = 0; k < SPECTRUM_PEAKS && s.peaks[k].amplitude > 0.0f && len < (int)sizeof(buf); k++)
+        len += snprintf(buf + len, sizeof(buf) - (size_t)len, " %.2fHz/%.4f",
+                        s.peaks[k].freq_hz, s.peaks[k].amplitude);
+    send_response(ctx, buf);
+    send_response(ctx, "\n");
     send_eom(ctx);
 }
 
-void cmd_get_health(ProtocolContext *ctx)
+#define HISTORY_DEFAULT_RANGE_S 600
+
+/* Channel named by the client ("vibration", "temp", "Current", ...), or -1. */
+static int parse_channel(const char *tok)
+{
+    static const char *const long_names[CH_COUNT] = {
+        "vibration", "sound", "temperature", "current"
+    };
+
+    for (int c = 0; c < CH_COUNT; c++)
+        if (!strcasecmp(tok, long_names[c]) || !strcasecmp(tok, channel_names[c]))
+            return c;
+    return -1;
+}
+
+void cmd_get_history(ProtocolContext *ctx, const char *args)
 {
+    char tok[3][64] = {{0}};
+    char unit_arg[64] = {0};
+    char range_arg[64] = "10m";
+    char unit[MAX_ID_LENGTH];
+    char buf[4096];
+    int channel = -1, len = 0;
+    long range_s = HISTORY_DEFAULT_RANGE_S;
+    int n = args ? sscanf(args, "%63s %63s %63s", tok[0], tok[1], tok[2]) : 0;
+
+    // "get_history [unit] <channel> [range]", in any order
+    for (int i = 0; i < n; i++) {
+        int c = parse_channel(tok[i]);
+        if (c >= 0 && channel < 0)
+            channel = c;
+        else if (is_duration_token(tok[i]))
+            memcpy(range_arg, tok[i], sizeof(range_arg));
+        else
+            memcpy(unit_arg, tok[i], sizeof(unit_arg));
+    }
+    range_s = duration_seconds(range_arg);
+
+    if (channel < 0 || range_s <= 0 || range_s > (long)history_tier_span(HISTORY_TIER_HOUR)) {
+        send_response(ctx, "Usage: get_history [unit] <vibration|sound|temperature|current> [range]\n"
+                           "       range up to 30d, default 10m (<=1h: 1 s points, <=1d: 1 min, else 1 h)\n");
+        send_eom(ctx);
+        return;
+    }
+
+    if (!resolve_unit(ctx, unit_arg, unit))
+        return;
+
+    // The shortest tier that covers the whole range
+    HistoryTier tier = HISTORY_TIER_SECOND;
+    while (tier < HISTORY_TIER_HOUR && range_s > (long)history_tier_span(tier))
+        tier++;
+
+    // Up to 3600 points (~86 KB): keep them off the session thread's stack
+    int max = HISTORY_SECONDS;
+    HistoryPoint *pts = malloc((size_t)max * sizeof(HistoryPoint));
+    if (!pts) {
+        send_response(ctx, "[ERROR] Out of memory.\n");
+        send_eom(ctx);
+        return;
+    }
+
+    int count = manager_get_history(ctx->sensor_mgr, unit, tier, (SensorChannel)channel,
+                                    (uint32_t)range_s, pts, max);
+    uint32_t width = history_tier_seconds(tier);
+
+    if (ctx->wire_version) {
+        // HISTORY frames, written straight into the output buffer
+        uint16_t u = wire_unit(ctx, unit);
+        int first = 0;
+        do {
+            int n = count - first < HISTORY_FRAME_POINTS ? count - first : HISTORY_FRAME_POINTS;
+            if (n < 0)
+                n = 0;
+            unsigned char *p = begin_frame(ctx, WIRE_HISTORY, u, 0,
+                                           n ? pts[first].t_s * 1000u : 0,
+                                           WIRE_HISTORY_HEAD + (size_t)n * WIRE_HISTORY_POINT);
+            if (!p)
+                break;
+            p[0] = (unsigned char)channel;
+            p[1] = (unsigned char)tier;
+            wire_put_u16(p + 2, 0);
+            wire_put_u32(p + 4, width);
+            wire_put_u32(p + 8, (uint32_t)n);
+            p += WIRE_HISTORY_HEAD;
+            for (int i = first; i < first + n; i++, p += WIRE_HISTORY_POINT) {
+                wire_put_u32(p, (uint32_t)pts[i].t_s);
+                wire_put_u32(p + 4, pts[i].windows);
+                wire_put_f32(p + 8, pts[i].min);
+                wire_put_f32(p + 12, pts[i].max);
+                wire_put_f32(p + 16, pts[i].avg);
+            }
+            first += HISTORY_FRAME_POINTS;
+        } while (first < count);
+        free(pts);
+        send_eom(ctx);
+        return;
+    }
+
+    snprintf(buf, sizeof(buf), "=== History %s %s, last %s (%d x %u %s points) ===\n",
+             unit, channel_names[channel], range_arg, count > 0 ? count : 0,
+             width >= 3600 ? width / 3600 : width >= 60 ? width / 60 : width,
+             width >= 3600 ? "h" : width >= 60 ? "min" : "s");
+    send_response(ctx, buf);
+    if (count <= 0)
+        send_response(ctx, "[INFO] No history for that range yet.\n");
+
+    // Batch lines into large writes: one TLS record per ~4 KB, not per point
+    for (int i = 0; i < count; i++) {
+        char stamp[32];
+        time_t t = (time_t)pts[i].t_s;
+        struct tm tm;
+
+        localtime_r(&t, &tm);
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+        if (tier == HISTORY_TIER_SECOND)
+            len += snprintf(buf + len, sizeof(buf) - (size_t)len, "%s  %.3f\n", stamp, pts[i].avg);
+        else
+            len += snprintf(buf + len, sizeof(buf) - (size_t)len,
+                            "%s  min %.3f  max %.3f  avg %.3f  (%u windows)\n",
+                            stamp, pts[i].min, pts[i].max, pts[i].avg, pts[i].windows);
+        if (len > (int)sizeof(buf) - 128 || i == count - 1) {
+            send_response(ctx, buf);
+            len = 0;
+        }
+    }
+
+    free(pts);
+    send_eom(ctx);
+}
+
+void cmd_set_rate(ProtocolContext *ctx, const char *args)
+{
+    char tok[3][64] = {{0}};
+    char unit[MAX_ID_LENGTH];
+    char msg[192];
+    int n = args ? sscanf(args, "%63s %63s %63s", tok[0], tok[1], tok[2]) : 0;
+    int first = 0;
+
+    // "set_rate <unit> <hz|auto> [ms]" or "set_rate <hz|auto> [ms]" for the default unit
+    if (n > 0 && strcmp(tok[0], "auto") != 0 && !is_number_token(tok[0]))
+        first = 1;
+
+    if (n <= first || (strcmp(tok[first], "auto") != 0 && !is_number_token(tok[first])) ||
+        (n > first + 1 && !is_number_token(tok[first + 1]))) {
+        send_response(ctx, "Usage: set_rate [unit] <hz|auto> [window_ms]\n");
+        send_eom(ctx);
+        return;
+    }
+
+    if (!resolve_unit(ctx, first ? tok[0] : NULL, unit))
+        return;
+
+    uint32_t rate = strcmp(tok[first], "auto") == 0 ? 0 : (uint32_t)strtoul(tok[first], NULL, 10);
+    uint32_t window_ms = n > first + 1 ? (uint32_t)strtoul(tok[first + 1], NULL, 10) : 0;
+
+    if (!strcmp(tok[first], "0") ||
+        manager_set_acquisition(ctx->sensor_mgr, unit, rate, window_ms) != 1) {
+        snprintf(msg, sizeof(msg), "[ERROR] Rate must be %u-%u Hz or 'auto'; window %u-%u ms.\n",
+                 MANAGER_MIN_RATE_HZ, MANAGER_MAX_RATE_HZ,
+                 MANAGER_MIN_WINDOW_MS, MANAGER_MAX_WINDOW_MS);
+        send_response(ctx, msg);
+        send_eom(ctx);
+        return;
+    }
+
+    if (rate > manager_max_rate(ctx->sensor_mgr))
+        snprintf(msg, sizeof(msg), "[SUCCESS] %s: fixed %u Hz (HAL limit)", unit,
+                 manager_max_rate(ctx->sensor_mgr));
+    else if (rate)
+        snprintf(msg, sizeof(msg), "[SUCCESS] %s: fixed %u Hz", unit, rate);
+    else
+        snprintf(msg, sizeof(msg), "[SUCCESS] %s: adaptive rate", unit);
+    send_response(ctx, msg);
+    if (window_ms) {
+        snprintf(msg, sizeof(msg), ", %u ms window", window_ms);
+        send_response(ctx, msg);
+    }
+    send_response(ctx, " (applies at the next window boundary).\n");
+    send_eom(ctx);
+}
+
+void cmd_reload_rules(ProtocolContext *ctx)
+{
+    char err[160];
+    char msg[256];
+    int n = manager_reload_rules(ctx->sensor_mgr, err, sizeof(err));
+
+    if (n < 0)
+        snprintf(msg, sizeof(msg), "[ERROR] %s (previous rules kept).\n", err);
+    else
+        snprintf(msg, sizeof(msg), "[SUCCESS] %d threshold rule%s active.\n", n, n == 1 ? "" : "s");
+    send_response(ctx, msg);
+    send_eom(ctx);
+}
+
+void cmd_get_health(ProtocolContext *ctx, const char *args)
+{
+    char unit[MAX_ID_LENGTH];
     EquipmentHealth h;
-    if (manager_get_health(ctx->sensor_mgr, "Sentinel-RT", &h)) {
+
+    if (!resolve_unit(ctx, args, unit))
+        return;
+
+    if (manager_get_health(ctx->sensor_mgr, unit, &h)) {
         char buf[256];
         snprintf(buf, sizeof(buf),
                  "Status: %s | Message: %s\n",
@@ -167,103 +744,690 @@ void cmd_get_health(ProtocolContext *ctx)
     send_eom(ctx);
 }
 
-void cmd_get_log(ProtocolContext *ctx)
+#define LOG_PAGE_MAX 100000
+
+// Longest get_log/clear_log wait on the blackbox committer before going
+// ahead (get_log) or replying that it is still pending (clear_log)
+#define COMMIT_WAIT_MS 2000
+
+/*
+ * Renders one blackbox record as a text line. Stops the query at the
+ * page limit, or once the client is PROTOCOL_OUT_LOW behind (the stream
+ * resumes after 'consumed' when it has caught up).
+ */
+static int render_log_entry(void *arg, const BlackboxEntry *e)
+{
+    LogRender *r = arg;
+    char stamp[32];
+    char line[512];
+    time_t t = (time_t)(e->t_ms / 1000);
+    struct tm tm;
+    int n;
+
+    if (r->offset > 0) {
+        r->offset--;
+        r->consumed = e->seq;
+        return 0;
+    }
+    if (r->limit && r->shown == r->limit) {
+        r->more = 1;
+        return 1;
+    }
+    if (output_backlog(r->ctx) >= PROTOCOL_OUT_LOW) {
+        r->paused = 1;
+        return 1;
+    }
+
+    localtime_r(&t, &tm);
+    strftime(stamp, sizeof(stamp), "%a %b %e %H:%M:%S %Y", &tm);
+    n = snprintf(line, sizeof(line), "#%llu [%s] ", (unsigned long long)e->seq, stamp);
+    if (e->kind == BLACKBOX_ALERT)
+        snprintf(line + n, sizeof(line) - (size_t)n, "CRITICAL ALERT | Unit: %.*s | %.*s\n",
+                 e->unit_len, e->unit, e->text_len, e->text);
+    else if (e->unit_len > 0)
+        snprintf(line + n, sizeof(line) - (size_t)n, "EVENT | Unit: %.*s | %.*s\n",
+                 e->unit_len, e->unit, e->text_len, e->text);
+    else
+        snprintf(line + n, sizeof(line) - (size_t)n, "EVENT | %.*s\n", e->text_len, e->text);
+    send_response(r->ctx, line);
+
+    r->shown++;
+    r->last_seq = e->seq;
+    r->consumed = e->seq;
+    return 0;
+}
+
+/*
+ * Time argument of get_log: a duration back from now ("15m"), or local
+ * time as YYYY-MM-DD, YYYY-MM-DDTHH:MM or YYYY-MM-DDTHH:MM:SS.
+ */
+static int parse_log_time(const char *tok, int64_t now_ms, int64_t *out_ms)
+{
+    struct tm tm;
+    time_t t;
+    int n;
+
+    if (is_duration_token(tok)) {
+        *out_ms = now_ms - (int64_t)duration_seconds(tok) * 1000;
+        return 0;
+    }
+
+    memset(&tm, 0, sizeof(tm));
+    n = sscanf(tok, "%d-%d-%dT%d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+               &tm.tm_hour, &tm.tm_min, &tm.tm_sec);
+    if (n != 3 && n != 5 && n != 6)
+        return -1;
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    if ((t = mktime(&tm)) == (time_t)-1)
+        return -1;
+    *out_ms = (int64_t)t * 1000;
+    return 0;
+}
+
+static int parse_log_count(const char *tok, long max, long *out)
+{
+    if (!is_number_token(tok))
+        return -1;
+    *out = strtol(tok, NULL, 10);
+    return *out <= max ? 0 : -1;
+}
+
+/* severity= of get_log/follow_log as a BlackboxQuery kinds mask. */
+static int parse_log_severity(const char *v, uint32_t *kinds)
+{
+    if (!strcasecmp(v, "critical") || !strcasecmp(v, "alert"))
+        *kinds = 1u << BLACKBOX_ALERT;
+    else if (!strcasecmp(v, "event") || !strcasecmp(v, "info"))
+        *kinds = 1u << BLACKBOX_EVENT;
+    else
+        return -1;
+    return 0;
+}
+
+void cmd_get_log(ProtocolContext *ctx, const char *args)
+{
+    char copy[256];
+    char *save = NULL;
+    long after = 0;
+    int bad = 0;
+    int64_t now_ms = (int64_t)time(NULL) * 1000;
+    ProtocolStream *s = stream_begin(ctx, STREAM_LOG);
+
+    if (!s)
+        return;
+
+    // "get_log [unit] [range] [from=T] [to=T] [severity=S] [limit=N] [offset=N] [after=SEQ]"
+    snprintf(copy, sizeof(copy), "%s", args ? args : "");
+    for (char *tok = strtok_r(copy, " \t", &save); tok && !bad; tok = strtok_r(NULL, " \t", &save)) {
+        if (!strncmp(tok, "from=", 5))
+            bad = parse_log_time(tok + 5, now_ms, &s->q.from_ms);
+        else if (!strncmp(tok, "to=", 3))
+            bad = parse_log_time(tok + 3, now_ms, &s->q.to_ms);
+        else if (!strncmp(tok, "severity=", 9))
+            bad = parse_log_severity(tok + 9, &s->q.kinds);
+        else if (!strncmp(tok, "limit=", 6)) {
+            bad = parse_log_count(tok + 6, LOG_PAGE_MAX, &s->r.limit) || s->r.limit == 0;
+            s->paged = 1;
+        } else if (!strncmp(tok, "offset=", 7)) {
+            bad = parse_log_count(tok + 7, LONG_MAX, &s->r.offset);
+            s->paged = 1;
+        } else if (!strncmp(tok, "after=", 6)) {
+            bad = parse_log_count(tok + 6, LONG_MAX, &after);
+            s->cursor = (uint64_t)after;
+            s->paged = 1;
+        } else if (strchr(tok, '=')) {
+            bad = 1;
+        } else if (is_duration_token(tok)) {
+            bad = parse_log_time(tok, now_ms, &s->q.from_ms);
+        } else {
+            snprintf(s->log_unit, sizeof(s->log_unit), "%s", tok);
+            s->q.unit = s->log_unit;
+        }
+    }
+
+    if (bad) {
+        free(s);
+        send_response(ctx, "Usage: get_log [unit] [range] [from=T] [to=T] [severity=critical|event]\n"
+                           "               [limit=N] [offset=N] [after=SEQ]\n"
+                           "       T is a range back from now (15m, 2h, 7d) or YYYY-MM-DD[THH:MM[:SS]]\n");
+        send_eom(ctx);
+        return;
+    }
+    s->filtered = s->q.unit || s->q.kinds || s->q.from_ms || s->q.to_ms;
+
+    // Records still staged for the next group commit are written first;
+    // paging starts when the commit is announced (see poll_log)
+    s->sync_seq = blackbox_request_sync();
+    s->wait_until = mono_ms() + COMMIT_WAIT_MS;
+
+    // The records go out from protocol_poll, a page at a time
+    ctx->stream = s;
+}
+
+/* Renders the next page of a get_log result. */
+static int poll_log(ProtocolContext *ctx, ProtocolStream *s)
 {
-    FILE *f = fopen("blackbox.log", "r");
-    if (!f) {
-        send_response(ctx, "[INFO] Log is empty.\n");
+    BlackboxQueryStats st;
+    LogRender *r = &s->r;
+    long matched;
+
+    if (output_backlog(ctx) >= PROTOCOL_OUT_LOW)
+        return 0;
+
+    // Waiting for the commit asked for by cmd_get_log; the commit
+    // notification brings us back, the deadline covers a stuck committer
+    if (s->sync_seq) {
+        int64_t now = mono_ms();
+        if (blackbox_wait(s->sync_seq - 1, 0, NULL) == 0 && now < s->wait_until)
+            return (int)(s->wait_until - now);
+        s->sync_seq = 0;
+    }
+
+    s->q.after_seq = s->cursor;
+    r->paused = 0;
+    matched = blackbox_query(&s->q, render_log_entry, r, &st);
+    s->blocks_read += st.blocks_read;
+    s->blocks = st.blocks;
+    if (r->paused) {
+        s->cursor = r->consumed;
+        return 0;
+    }
+
+    // A page only pauses after showing a record, so with nothing shown
+    // this was the one and only page
+    if (r->shown == 0)
+        send_response(ctx, matched == 0 && !s->filtered && !s->paged ? "[INFO] Log is empty.\n"
+                                                                      : "[INFO] No matching log records.\n");
+
+    char msg[160];
+    if (r->more) {
+        snprintf(msg, sizeof(msg), "[MORE] Next page: same filters with after=%llu\n",
+                 (unsigned long long)r->last_seq);
+        send_response(ctx, msg);
+    }
+    if (s->filtered || s->paged) {
+        snprintf(msg, sizeof(msg), "--- %ld records shown (read %ld of %ld index blocks) ---\n",
+                 r->shown, s->blocks_read, s->blocks);
+        send_response(ctx, msg);
+    }
+
+    stream_end(ctx, NULL);
+    return -1;
+}
+
+// Longest a blocking session sleeps on a commit or an alert before
+// checking for ENTER
+#define FOLLOW_WAIT_MS 250
+
+void cmd_follow_log(ProtocolContext *ctx, const char *args)
+{
+    char copy[256];
+    char limit_arg[64] = {0};
+    char *save = NULL;
+    long after = 0;
+    int bad = 0;
+    uint64_t committed = 0;
+    ProtocolStream *s = stream_begin(ctx, STREAM_FOLLOW);
+
+    if (!s)
+        return;
+
+    // "follow_log [unit] [time] [severity=S] [after=SEQ]"
+    snprintf(copy, sizeof(copy), "%s", args ? args : "");
+    for (char *tok = strtok_r(copy, " \t", &save); tok && !bad; tok = strtok_r(NULL, " \t", &save)) {
+        if (!strncmp(tok, "severity=", 9))
+            bad = parse_log_severity(tok + 9, &s->q.kinds);
+        else if (!strncmp(tok, "after=", 6))
+            bad = parse_log_count(tok + 6, LONG_MAX, &after);
+        else if (strchr(tok, '='))
+            bad = 1;
+        else if (is_duration_token(tok))
+            snprintf(limit_arg, sizeof(limit_arg), "%s", tok);
+        else {
+            snprintf(s->log_unit, sizeof(s->log_unit), "%s", tok);
+            s->q.unit = s->log_unit;
+        }
+    }
+
+    if (bad) {
+        free(s);
+        send_response(ctx, "Usage: follow_log [unit] [time] [severity=critical|event] [after=SEQ]\n");
         send_eom(ctx);
         return;
     }
 
-    char line[256];
-    while (fgets(line, sizeof(line), f))
-        send_response(ctx, line);
+    // Start at the current end of the log unless resuming from a cursor
+    if (blackbox_wait(0, 0, &committed) < 0) {
+        free(s);
+        send_response(ctx, "[ERROR] Blackbox unavailable.\n");
+        send_eom(ctx);
+        return;
+    }
+    s->cursor = after > 0 ? (uint64_t)after : committed;
+    if (limit_arg[0])
+        s->stop_ms = mono_ms() + (int64_t)duration_seconds(limit_arg) * 1000;
+
+    char msg[192];
+    snprintf(msg, sizeof(msg), "\n>>> FOLLOW LOG after #%llu%s%s (Limit: %s) <<<\n",
+             (unsigned long long)s->cursor, s->q.unit ? " for " : "", s->q.unit ? s->q.unit : "",
+             limit_arg[0] ? limit_arg : "Infinite");
+    send_response(ctx, msg);
+    send_response(ctx, "Press 'ENTER' to stop following.\n\n");
+    ctx->stream = s;
+}
+
+static int poll_follow(ProtocolContext *ctx, ProtocolStream *s)
+{
+    uint64_t committed;
+    int64_t now;
+    int rc;
+
+    if (output_backlog(ctx) >= PROTOCOL_OUT_LOW)
+        return 0;
+
+    rc = blackbox_wait(s->cursor, 0, &committed);
+    if (rc < 0) {
+        stream_end(ctx, "\n>>> FOLLOW LOG STOPPED (blackbox shut down) <<<\n");
+        return -1;
+    }
+    if (rc > 0) {
+        // Only the index blocks past the cursor are read; a resume cursor
+        // replays what is already there
+        s->q.after_seq = s->cursor;
+        s->r.paused = 0;
+        blackbox_query(&s->q, render_log_entry, &s->r, NULL);
+        if (s->r.paused) {
+            s->cursor = s->r.consumed;
+            return 0;
+        }
+        // Committed records that did not match are not read again
+        s->cursor = committed > s->r.consumed ? committed : s->r.consumed;
+    }
+
+    now = mono_ms();
+    if (s->stop_ms && now >= s->stop_ms) {
+        stream_end(ctx, "\n>>> FOLLOW LOG TIME LIMIT REACHED <<<\n");
+        return -1;
+    }
+    // Otherwise only a commit brings more
+    return s->stop_ms ? (int)(s->stop_ms - now) : -1;
+}
+
+// Alerts copied per alerts_read call
+#define SUBSCRIBE_BATCH 16
+
+static void send_alert(ProtocolContext *ctx, const AlertEvent *e)
+{
+    char stamp[32];
+    char held[48] = "";
+    char msg[384];
+    time_t t = (time_t)(e->t_ms / 1000);
+    struct tm tm;
+
+    if (ctx->wire_version) {
+        const char *text = e->to == HEALTH_HEALTHY ? "Condition cleared" : rules_message(e->message_id);
+        size_t text_len = strlen(text);
+        unsigned char *p = begin_frame(ctx, WIRE_ALERT, wire_unit(ctx, e->unit_id), e->seq,
+                                       e->t_ms, 14 + text_len);
+        if (p) {
+            p[0] = (unsigned char)e->from;
+            p[1] = (unsigned char)e->to;
+            wire_put_u16(p + 2, 0);
+            wire_put_u32(p + 4, e->suppressed);
+            wire_put_u32(p + 8, e->message_id);
+            wire_put_u16(p + 12, (uint16_t)text_len);
+            memcpy(p + 14, text, text_len);
+        }
+        return;
+    }
+
+    localtime_r(&t, &tm);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+    if (e->suppressed)
+        snprintf(held, sizeof(held), " (%u change%s held back)", e->suppressed,
+                 e->suppressed == 1 ? "" : "s");
+    snprintf(msg, sizeof(msg), "[ALERT #%llu] %s | %s | %s -> %s | %s%s\n",
+             (unsigned long long)e->seq, stamp, e->unit_id, health_to_string(e->from),
+             health_to_string(e->to),
+             e->to == HEALTH_HEALTHY ? "Condition cleared" : rules_message(e->message_id), held);
+    send_response(ctx, msg);
+}
+
+void cmd_subscribe_alerts(ProtocolContext *ctx, const char *args)
+{
+    char copy[256];
+    char unit[MAX_ID_LENGTH] = {0};
+    char limit_arg[64] = {0};
+    char *save = NULL;
+    int bad = 0, critical_only = 0;
+
+    // "subscribe_alerts [unit] [time] [severity=critical|warning]"
+    snprintf(copy, sizeof(copy), "%s", args ? args : "");
+    for (char *tok = strtok_r(copy, " \t", &save); tok && !bad; tok = strtok_r(NULL, " \t", &save)) {
+        if (!strncmp(tok, "severity=", 9)) {
+            if (!strcasecmp(tok + 9, "critical"))
+                critical_only = 1;
+            else if (strcasecmp(tok + 9, "warning"))
+                bad = 1;
+        } else if (strchr(tok, '=')) {
+            bad = 1;
+        } else if (is_duration_token(tok)) {
+            snprintf(limit_arg, sizeof(limit_arg), "%s", tok);
+        } else if (!resolve_unit(ctx, tok, unit)) {
+            return;
+        }
+    }
+
+    if (bad) {
+        send_response(ctx, "Usage: subscribe_alerts [unit] [time] [severity=critical|warning]\n");
+        send_eom(ctx);
+        return;
+    }
+
+    ProtocolStream *s = stream_begin(ctx, STREAM_ALERTS);
+    if (!s)
+        return;
+    memcpy(s->unit, unit, sizeof(s->unit));
+    s->critical_only = critical_only;
+    if (limit_arg[0])
+        s->stop_ms = mono_ms() + (int64_t)duration_seconds(limit_arg) * 1000;
+
+    // Only alerts raised from now on
+    alerts_wait(0, 0, &s->cursor);
+
+    char msg[192];
+    snprintf(msg, sizeof(msg), "\n>>> ALERT SUBSCRIPTION %s%s(Limit: %s) <<<\n",
+             unit[0] ? unit : "all units", critical_only ? ", critical only " : " ",
+             limit_arg[0] ? limit_arg : "Infinite");
+    send_response(ctx, msg);
+    send_response(ctx, "Alerts are pushed as they fire. Press 'ENTER' to stop.\n\n");
+    ctx->stream = s;
+}
+
+static int poll_alerts(ProtocolContext *ctx, ProtocolStream *s)
+{
+    AlertEvent ev[SUBSCRIBE_BATCH];
+    int64_t now;
+    int n;
+
+    // Left in the ring while the client is behind; what the ring
+    // overwrites meanwhile is reported as dropped
+    while (output_backlog(ctx) < PROTOCOL_OUT_LOW &&
+           (n = alerts_read(&s->cursor, ev, SUBSCRIBE_BATCH, &s->missed)) > 0) {
+        for (int i = 0; i < n; i++) {
+            if (s->unit[0] && strcmp(ev[i].unit_id, s->unit) != 0)
+                continue;
+            if (s->critical_only && ev[i].from != HEALTH_CRITICAL && ev[i].to != HEALTH_CRITICAL)
+                continue;
+            send_alert(ctx, &ev[i]);
+        }
+    }
+    if (s->missed) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "[WARN] %llu alert%s dropped (session too slow)\n",
+                 (unsigned long long)s->missed, s->missed == 1 ? "" : "s");
+        send_response(ctx, msg);
+        s->missed = 0;
+    }
+    if (output_backlog(ctx) >= PROTOCOL_OUT_LOW)
+        return 0;
+
+    now = mono_ms();
+    if (s->stop_ms && now >= s->stop_ms) {
+        stream_end(ctx, "\n>>> ALERT SUBSCRIPTION TIME LIMIT REACHED <<<\n");
+        return -1;
+    }
+    // Otherwise only a publish brings more
+    return s->stop_ms ? (int)(s->stop_ms - now) : -1;
+}
+
+static void send_latency_line(ProtocolContext *ctx, const char *label, const LatencySnapshot *s)
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "  %-7s p50=%.1f p99=%.1f p99.9=%.1f p99.99=%.1f max=%.1f us (n=%llu)\n",
+             label,
+             lat_snapshot_percentile(s, 50.0) / 1000.0,
+             lat_snapshot_percentile(s, 99.0) / 1000.0,
+             lat_snapshot_percentile(s, 99.9) / 1000.0,
+             lat_snapshot_percentile(s, 99.99) / 1000.0,
+             lat_snapshot_max(s) / 1000.0,
+             (unsigned long long)s->total);
+    send_response(ctx, buf);
+}
+
+static void send_rt_stats(ProtocolContext *ctx, const char *title, const RtStatsSnapshot *s)
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "%s (%.1f s) | loops: %llu | missed deadlines: %llu | skipped ticks: %llu"
+             " | page faults: %llu major, %llu minor\n",
+             title,
+             s->uptime_ns / 1e9,
+             (unsigned long long)s->loops,
+             (unsigned long long)s->missed_deadlines,
+             (unsigned long long)s->skipped_ticks,
+             (unsigned long long)s->major_faults,
+             (unsigned long long)s->minor_faults);
+    send_response(ctx, buf);
+    send_latency_line(ctx, "Wakeup", &s->wakeup);
+    send_latency_line(ctx, "Exec", &s->exec);
+}
+
+void cmd_get_latency(ProtocolContext *ctx)
+{
+    // ~19 KB each: keep them off the session thread's stack
+    RtStatsSnapshot *now = malloc(sizeof(RtStatsSnapshot));
+    RtStatsSnapshot *delta = malloc(sizeof(RtStatsSnapshot));
+
+    if (!now || !delta) {
+        free(now);
+        free(delta);
+        send_response(ctx, "[ERROR] Out of memory.\n");
+        send_eom(ctx);
+        return;
+    }
+
+    manager_get_rt_stats(ctx->sensor_mgr, now);
+
+    char buf[128];
+    snprintf(buf, sizeof(buf), "=== RT Poll Loop (period %.1f ms) ===\n", now->period_ns / 1e6);
+    send_response(ctx, buf);
+    send_rt_stats(ctx, "Since start", now);
+    snprintf(buf, sizeof(buf), "Log records dropped: %llu | Blackbox records dropped: %llu\n",
+             (unsigned long long)rt_log_dropped(), (unsigned long long)blackbox_dropped());
+    send_response(ctx, buf);
+
+    if (ctx->rt_mark) {
+        const RtStatsSnapshot *m = ctx->rt_mark;
+        lat_snapshot_diff(&now->wakeup, &m->wakeup, &delta->wakeup);
+        lat_snapshot_diff(&now->exec, &m->exec, &delta->exec);
+        delta->loops = now->loops - m->loops;
+        delta->missed_deadlines = now->missed_deadlines - m->missed_deadlines;
+        delta->skipped_ticks = now->skipped_ticks - m->skipped_ticks;
+        delta->major_faults = now->major_faults - m->major_faults;
+        delta->minor_faults = now->minor_faults - m->minor_faults;
+        delta->period_ns = now->period_ns;
+        delta->uptime_ns = now->uptime_ns - m->uptime_ns;
+        send_rt_stats(ctx, "Since last get_latency", delta);
+        free(delta);
+    } else {
+        ctx->rt_mark = delta;
+    }
 
-    fclose(f);
+    // The current snapshot becomes the baseline for the next call
+    memcpy(ctx->rt_mark, now, sizeof(RtStatsSnapshot));
+    free(now);
     send_eom(ctx);
 }
 
 void cmd_clear_log(ProtocolContext *ctx)
 {
-    FILE *f = fopen("blackbox.log", "w");
-    if (f)
-        fclose(f);
+    uint64_t ticket = blackbox_request_clear();
+    ProtocolStream *s;
+
+    if (ticket == 0) {
+        send_response(ctx, "[ERROR] Blackbox unavailable.\n");
+        send_eom(ctx);
+        return;
+    }
+
+    // The committer does the file work; poll_clear replies once it is done
+    if (!(s = stream_begin(ctx, STREAM_CLEAR)))
+        return;
+    s->cursor = ticket;
+    s->wait_until = mono_ms() + COMMIT_WAIT_MS;
+    ctx->stream = s;
+}
+
+static int poll_clear(ProtocolContext *ctx, ProtocolStream *s)
+{
+    int64_t now = mono_ms();
+    int rc = blackbox_clear_wait(s->cursor, 0);
+
+    if (rc == 0 && now < s->wait_until)
+        return (int)(s->wait_until - now);
+    if (rc <= 0) {
+        stream_end(ctx, rc == 0 ? "[ERROR] Log clear still pending, check get_log later.\n"
+                                : "[ERROR] Blackbox unavailable.\n");
+        return -1;
+    }
+
+    // The wipe itself stays on record
+    blackbox_log(BLACKBOX_EVENT, NULL, 0, "Log cleared by %s", ctx->identity.common_name);
+    stream_end(ctx, "[SUCCESS] Log cleared.\n");
+    return -1;
+}
+
+void cmd_protocol(ProtocolContext *ctx, const char *args)
+{
+    char tok[3][16] = {{0}};
+    int n = args ? sscanf(args, "%15s %15s %15s", tok[0], tok[1], tok[2]) : 0;
+    long version = WIRE_VERSION;
+    int flags = 0, bad = n < 1;
+
+    if (n == 1 && !strcasecmp(tok[0], "text")) {
+        ctx->wire_version = 0;
+        ctx->wire_flags = 0;
+        send_response(ctx, "[SUCCESS] Text replies.\n");
+        send_eom(ctx);
+        return;
+    }
+
+    // "protocol binary [version] [delta]": the reply is already binary
+    if (!bad && strcasecmp(tok[0], "binary"))
+        bad = 1;
+    for (int i = 1; i < n && !bad; i++) {
+        if (!strcasecmp(tok[i], "delta"))
+            flags |= WIRE_FLAG_DELTA;
+        else if (is_number_token(tok[i]) && (version = atol(tok[i])) >= 1)
+            ;
+        else
+            bad = 1;
+    }
+    if (bad) {
+        send_response(ctx, "Usage: protocol text | protocol binary [version] [delta]\n");
+        send_eom(ctx);
+        return;
+    }
 
-    send_response(ctx, "[SUCCESS] Log cleared.\n");
+    // Negotiated down to what this server speaks; the client checks HELLO
+    unsigned char hello[4];
+    ctx->wire_version = (uint8_t)(version < WIRE_VERSION ? version : WIRE_VERSION);
+    ctx->wire_flags = (uint8_t)flags;
+    hello[0] = ctx->wire_version;
+    hello[1] = ctx->wire_flags;
+    wire_put_u16(hello + 2, (uint16_t)manager_unit_count(ctx->sensor_mgr));
+    send_frame(ctx, WIRE_HELLO, WIRE_NO_UNIT, 0, 0, hello, sizeof(hello));
     send_eom(ctx);
 }
 
 void cmd_monitor(ProtocolContext *ctx, const char *args)
 {
-    int max_ticks = -1;
+    char unit_arg[64] = {0};
+    char limit_arg[64] = {0};
+    char unit[MAX_ID_LENGTH];
 
+    // Accepts "monitor", "monitor 20s", "monitor <unit>" and "monitor <unit> 5m"
     if (args && strlen(args) > 0) {
-        int val;
-        char unit = 's';
-        int items = sscanf(args, "%d%c", &val, &unit);
-
-        if (items >= 1) {
-            if (unit == 'm')
-                max_ticks = val * 60;
-            else if (unit == 'h')
-                max_ticks = val * 3600;
+        char tok[2][64] = {{0}};
+        int n = sscanf(args, "%63s %63s", tok[0], tok[1]);
+
+        for (int i = 0; i < n; i++) {
+            if (is_duration_token(tok[i]))
+                memcpy(limit_arg, tok[i], sizeof(limit_arg));
             else
-                max_ticks = val;
+                memcpy(unit_arg, tok[i], sizeof(unit_arg));
         }
     }
 
-    char msg[128];
-    if (max_ticks > 0)
-        snprintf(msg, sizeof(msg), "\n>>> MONITOR START (Limit: %s) <<<\n", args);
+    if (!resolve_unit(ctx, unit_arg, unit))
+        return;
+
+    ProtocolStream *s = stream_begin(ctx, STREAM_MONITOR);
+    if (!s)
+        return;
+    memcpy(s->unit, unit, sizeof(s->unit));
+    s->max_ticks = limit_arg[0] ? duration_seconds(limit_arg) : -1;
+    s->next_ms = mono_ms();
+
+    char msg[192];
+    if (s->max_ticks > 0)
+        snprintf(msg, sizeof(msg), "\n>>> MONITOR START %s (Limit: %s) <<<\n", unit, limit_arg);
     else
-        snprintf(msg, sizeof(msg), "\n>>> MONITOR START (Infinite) <<<\n");
+        snprintf(msg, sizeof(msg), "\n>>> MONITOR START %s (Infinite) <<<\n", unit);
 
     send_response(ctx, msg);
     send_response(ctx, "Press 'ENTER' to stop monitoring.\n\n");
+    ctx->stream = s;
+}
 
-    EquipmentHealth h;
-    int fd = SSL_get_fd(ctx->ssl);
-    int ticks = 0;
-
-    while (ctx->running) {
-        if (manager_get_health(ctx->sensor_mgr, "Sentinel-RT", &h)) {
-            char buf[256];
-            snprintf(buf, sizeof(buf),
-                     "[%s] Vib: %.0f | Snd: %.0f%% | Temp: %.1fC | Cur: %.2fA\n",
-                     health_to_string(h.status),
-                     h.snapshot.vibration_level,
-                     h.snapshot.sound_level,
-                     h.snapshot.temperature_c,
-                     h.snapshot.current_a);
-
-            send_response(ctx, buf);
-
-            if (h.status == HEALTH_CRITICAL)
-                log_alert(h.unit_id, h.message);
-        }
-
-        fd_set fds;
-        FD_ZERO(&fds);
-        FD_SET(fd, &fds);
+static int poll_monitor(ProtocolContext *ctx, ProtocolStream *s)
+{
+    int64_t now = mono_ms();
 
-        struct timeval tv = {1, 0};
+    if (now < s->next_ms)
+        return (int)(s->next_ms - now);
 
-        if (SSL_pending(ctx->ssl) > 0 ||
-            select(fd + 1, &fds, NULL, NULL, &tv) > 0) {
-            char dummy;
-            SSL_read(ctx->ssl, &dummy, 1);
-            send_response(ctx, "\n>>> MONITOR STOPPED <<<\n");
-            break;
-        }
+    if (s->max_ticks > 0 && s->ticks >= s->max_ticks) {
+        stream_end(ctx, "\n>>> MONITOR TIME LIMIT REACHED <<<\n");
+        return -1;
+    }
 
-        if (max_ticks > 0 && ++ticks >= max_ticks) {
-            send_response(ctx, "\n>>> MONITOR TIME LIMIT REACHED <<<\n");
-            break;
+    // A client that is behind misses lines rather than queueing stale ones.
+    // The lines were encoded once for every viewer when the window closed.
+    if (output_backlog(ctx) < PROTOCOL_OUT_LOW) {
+        TelemetryFrame *f = manager_get_telemetry(ctx->sensor_mgr, s->unit);
+        if (f && !ctx->wire_version) {
+            send_data(ctx, f->text, f->text_len);
+        } else if (f && f->seq != s->sent_seq) {
+            // Binary: each window once, as a DELTA from the one this stream
+            // sent last when negotiated, with a full SNAPSHOT every so often.
+            // The base is per stream: windows closed between ticks are skipped
+            if ((ctx->wire_flags & WIRE_FLAG_DELTA) && s->sent_seq &&
+                s->since_key < WIRE_DELTA_KEYFRAME - 1) {
+                unsigned char delta[WIRE_HEADER_SIZE + WIRE_DELTA_MAX];
+                size_t len = wire_delta(delta + WIRE_HEADER_SIZE, &s->sent, &f->values);
+                wire_header(delta, WIRE_DELTA, f->unit, f->seq, f->t_ms, len);
+                send_data(ctx, delta, WIRE_HEADER_SIZE + len);
+                s->since_key++;
+            } else {
+                send_data(ctx, f->snapshot, sizeof(f->snapshot));
+                s->since_key = 0;
+            }
+            s->sent_seq = f->seq;
+            s->sent = f->values;
         }
+        telemetry_release(f);
     }
 
-    send_eom(ctx);
+    s->ticks++;
+    s->next_ms += MONITOR_PERIOD_MS;
+    if (s->next_ms <= now)
+        s->next_ms = now + MONITOR_PERIOD_MS;   // stalled: no catch-up burst
+    return (int)(s->next_ms - now);
 }
 
 /* ============================================================ */
@@ -272,57 +1436,191 @@ void cmd_monitor(ProtocolContext *ctx, const char *args)
 
 void protocol_init(ProtocolContext *ctx, SSL *ssl, ClientIdentity id, SensorManager *mgr)
 {
+    memset(ctx, 0, sizeof(*ctx));
     ctx->ssl = ssl;
     ctx->identity = id;
     ctx->sensor_mgr = mgr;
     ctx->running = 1;
 }
 
-void protocol_run(ProtocolContext *ctx)
+void protocol_cleanup(ProtocolContext *ctx)
 {
-    char buf[1024];
+    free(ctx->rt_mark);
+    ctx->rt_mark = NULL;
+    free(ctx->stream);
+    ctx->stream = NULL;
+    free(ctx->out);
+    ctx->out = NULL;
+    ctx->out_len = ctx->out_off = ctx->out_cap = 0;
+}
 
+void protocol_start(ProtocolContext *ctx)
+{
     send_response(ctx, "--- Connected to Sentinel-RT Secure Server ---\n");
     send_eom(ctx);
+}
 
-    while (ctx->running) {
-        int n = SSL_read(ctx->ssl, buf, sizeof(buf) - 1);
-        if (n <= 0)
-            break;
+static void dispatch(ProtocolContext *ctx, char *buf)
+{
+    char command[64] = {0};
+    if (sscanf(buf, "%63s", command) != 1)
+        return;
 
-        buf[n] = 0;
+    if (!role_can_execute(ctx->identity.role, command)) {
+        send_permission_denied(ctx, command);
+        return;
+    }
 
-        char command[64] = {0};
-        if (sscanf(buf, "%63s", command) != 1)
-            continue;
+    // Arguments follow the command word; strip the line terminator
+    char *args = buf + strspn(buf, " \t");
+    args += strlen(command);
+    while (*args == ' ' || *args == '\t')
+        args++;
+    args[strcspn(args, "\r\n")] = '\0';
 
-        if (!role_can_execute(ctx->identity.role, command)) {
-            send_permission_denied(ctx, command);
-            continue;
-        }
+    if (!strcmp(command, "help")) cmd_help(ctx);
+    else if (!strcmp(command, "monitor")) cmd_monitor(ctx, args);
+    else if (!strcmp(command, "list_units")) cmd_list_units(ctx);
+    else if (!strcmp(command, "get_sensors")) cmd_get_sensors(ctx, args);
+    else if (!strcmp(command, "get_health")) cmd_get_health(ctx, args);
+    else if (!strcmp(command, "get_spectrum")) cmd_get_spectrum(ctx, args);
+    else if (!strcmp(command, "get_history")) cmd_get_history(ctx, args);
+    else if (!strcmp(command, "set_rate")) cmd_set_rate(ctx, args);
+    else if (!strcmp(command, "reload_rules")) cmd_reload_rules(ctx);
+    else if (!strcmp(command, "get_log")) cmd_get_log(ctx, args);
+    else if (!strcmp(command, "follow_log")) cmd_follow_log(ctx, args);
+    else if (!strcmp(command, "subscribe_alerts")) cmd_subscribe_alerts(ctx, args);
+    else if (!strcmp(command, "get_latency")) cmd_get_latency(ctx);
+    else if (!strcmp(command, "clear_log")) cmd_clear_log(ctx);
+    else if (!strcmp(command, "whoami")) cmd_whoami(ctx);
+    else if (!strcmp(command, "protocol")) cmd_protocol(ctx, args);
+    else if (!strcmp(command, "quit") || !strcmp(command, "exit")) {
+        send_response(ctx, "\n>>> DISCONNECTING <<<\n");
+        send_eom(ctx);
+        ctx->running = 0; /* The server closes the socket once this is written */
+    }
+    else {
+        send_response(ctx, "Unknown command. Type 'help'.\n");
+        send_eom(ctx);
+    }
+}
 
-        if (!strcmp(command, "help")) cmd_help(ctx);
-        else if (!strcmp(command, "monitor")) {
-            char *args = buf + strlen("monitor");
-            while (*args == ' ' || *args == '\t')
-                args++;
-            cmd_monitor(ctx, args);
-        }
-        else if (!strcmp(command, "list_units")) cmd_list_units(ctx);
-        else if (!strcmp(command, "get_sensors")) cmd_get_sensors(ctx);
-        else if (!strcmp(command, "get_health")) cmd_get_health(ctx);
-        else if (!strcmp(command, "get_log")) cmd_get_log(ctx);
-        else if (!strcmp(command, "clear_log")) cmd_clear_log(ctx);
-        else if (!strcmp(command, "whoami")) cmd_whoami(ctx);
-        else if (!strcmp(command, "quit") || !strcmp(command, "exit")) {
-            send_response(ctx, "\n>>> DISCONNECTING <<<\n");
-            send_eom(ctx);
-            ctx->running = 0; 
-            break; /* Let the server.c gracefully close the socket */
+void protocol_input(ProtocolContext *ctx, const char *data, int len)
+{
+    char buf[1024];
+
+    if (!ctx->running || len <= 0)
+        return;
+
+    if (ctx->stream) {
+        // The client sends ENTER; whatever came is the stop key
+        switch (ctx->stream->kind) {
+        case STREAM_MONITOR: stream_end(ctx, "\n>>> MONITOR STOPPED <<<\n"); break;
+        case STREAM_FOLLOW:  stream_end(ctx, "\n>>> FOLLOW LOG STOPPED <<<\n"); break;
+        case STREAM_ALERTS:  stream_end(ctx, "\n>>> ALERT SUBSCRIPTION STOPPED <<<\n"); break;
+        case STREAM_LOG:
+        case STREAM_CLEAR:   break;   // not read meanwhile (protocol_reading)
         }
-        else {
-            send_response(ctx, "Unknown command. Type 'help'.\n");
-            send_eom(ctx);
+        return;
+    }
+
+    if (len > (int)sizeof(buf) - 1)
+        len = (int)sizeof(buf) - 1;
+    memcpy(buf, data, (size_t)len);
+    buf[len] = '\0';
+    dispatch(ctx, buf);
+}
+
+int protocol_poll(ProtocolContext *ctx)
+{
+    ProtocolStream *s = ctx->stream;
+
+    if (!s || !ctx->running)
+        return -1;
+
+    switch (s->kind) {
+    case STREAM_MONITOR: return poll_monitor(ctx, s);
+    case STREAM_LOG:     return poll_log(ctx, s);
+    case STREAM_FOLLOW:  return poll_follow(ctx, s);
+    case STREAM_ALERTS:  return poll_alerts(ctx, s);
+    case STREAM_CLEAR:   return poll_clear(ctx, s);
+    }
+    return -1;
+}
+
+int protocol_reading(const ProtocolContext *ctx)
+{
+    return ctx->running && !(ctx->stream && (ctx->stream->kind == STREAM_LOG ||
+                                             ctx->stream->kind == STREAM_CLEAR));
+}
+
+/* Input waiting on a blocking session, within wait_ms (-1 = forever). */
+static int input_ready(ProtocolContext *ctx, int fd, int wait_ms)
+{
+    fd_set fds;
+    struct timeval tv = {wait_ms / 1000, (wait_ms % 1000) * 1000};
+
+    if (SSL_pending(ctx->ssl) > 0)
+        return 1;
+    FD_ZERO(&fds);
+    FD_SET(fd, &fds);
+    return select(fd + 1, &fds, NULL, NULL, wait_ms < 0 ? NULL : &tv) > 0;
+}
+
+/*
+ * Sleeps a blocking session until its stream may have more: on the
+ * blackbox/alert condition variables (a push goes out at once), or until
+ * the next monitor line or a key.
+ */
+static void stream_wait(ProtocolContext *ctx, int fd, int wait_ms)
+{
+    ProtocolStream *s = ctx->stream;
+    int ms = wait_ms < 0 || wait_ms > FOLLOW_WAIT_MS ? FOLLOW_WAIT_MS : wait_ms;
+
+    if (s->kind == STREAM_FOLLOW)
+        blackbox_wait(s->cursor, ms, NULL);
+    else if (s->kind == STREAM_LOG)
+        blackbox_wait(s->sync_seq - 1, ms, NULL);
+    else if (s->kind == STREAM_CLEAR)
+        blackbox_clear_wait(s->cursor, ms);
+    else if (s->kind == STREAM_ALERTS)
+        alerts_wait(s->cursor, ms, NULL);
+    else
+        input_ready(ctx, fd, wait_ms);
+}
+
+void protocol_run(ProtocolContext *ctx)
+{
+    char buf[1024];
+    int fd = SSL_get_fd(ctx->ssl);
+
+    protocol_start(ctx);
+
+    while (ctx->running) {
+        int wait_ms = protocol_poll(ctx);
+
+        // Blocking socket: returns once everything is written
+        if (protocol_flush(ctx) < 0)
+            return;
+
+        if (ctx->stream) {
+            if (!protocol_reading(ctx)) {
+                if (wait_ms != 0)
+                    stream_wait(ctx, fd, wait_ms);   // get_log/clear_log on the committer
+                continue;   // else the next get_log page
+            }
+            if (!input_ready(ctx, fd, 0)) {
+                stream_wait(ctx, fd, wait_ms);
+                continue;
+            }
         }
+
+        int n = SSL_read(ctx->ssl, buf, sizeof(buf));
+        if (n <= 0)
+            break;
+        protocol_input(ctx, buf, n);
     }
+
+    // The goodbye after quit
+    protocol_flush(ctx);
 }
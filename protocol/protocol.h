@@ -8,6 +8,25 @@
 // ============================================================
 // DATA STRUCTURES
 // ============================================================
+//
+// A session is a state machine that never blocks: commands append their
+// replies to the session's output buffer, and streaming commands
+// (monitor, follow_log, subscribe_alerts, long get_log results) leave a
+// ProtocolStream behind that protocol_poll advances. Whoever owns the
+// socket feeds reads to protocol_input and writes the buffer out with
+// protocol_flush: protocol_run does it with blocking I/O on a thread of
+// its own, the Linux reactor (reactor.h) with non-blocking sockets for
+// many sessions per thread.
+//
+// Streams stop producing while more than PROTOCOL_OUT_LOW bytes are
+// unsent (monitor skips lines, the others resume where they were once the
+// client catches up), so a slow client costs memory up to about that,
+// never more than PROTOCOL_OUT_MAX.
+
+#define PROTOCOL_OUT_LOW  (16 * 1024)
+#define PROTOCOL_OUT_MAX  (256 * 1024)
+
+typedef struct ProtocolStream ProtocolStream;
 
 /**
  * ProtocolContext: Maintains the state for a single client connection.
@@ -17,6 +36,14 @@ typedef struct {
     ClientIdentity identity; // Authenticated user info (Name/Role)
     SensorManager *sensor_mgr; // Pointer to the shared hardware manager
     int running;            // Loop control flag
+    RtStatsSnapshot *rt_mark; // get_latency baseline of this session (lazy)
+    ProtocolStream *stream; // streaming command in progress, NULL if none
+    char *out;              // replies not written yet (lazy, see protocol_flush)
+    size_t out_len;
+    size_t out_off;         // bytes of out already written
+    size_t out_cap;
+    uint8_t wire_version;   // 0 = text replies, else binary frames (wire.h)
+    uint8_t wire_flags;     // WIRE_FLAG_* negotiated with wire_version
 } ProtocolContext;
 
 // ============================================================
@@ -29,11 +56,49 @@ typedef struct {
 void protocol_init(ProtocolContext *ctx, SSL *ssl, ClientIdentity id, SensorManager *mgr);
 
 /**
- * protocol_run: The main command-processing loop. 
- * Listens for encrypted commands and routes them to implementations.
+ * protocol_start: Queues the connect banner.
+ */
+void protocol_start(ProtocolContext *ctx);
+
+/**
+ * protocol_input: Handles one read from the client. A read carries one
+ * command line (clients write each command in one go); while a stream
+ * runs, any input stops it.
+ */
+void protocol_input(ProtocolContext *ctx, const char *data, int len);
+
+/**
+ * protocol_poll: Advances the running stream, if any.
+ * Returns the ms until it must be called again, 0 to call it again as
+ * soon as the output has drained, or -1 if only input or a blackbox /
+ * alert notification can give it more to do.
+ */
+int protocol_poll(ProtocolContext *ctx);
+
+/**
+ * protocol_reading: 0 while input must be left unread (a get_log result
+ * is still being paged out), else 1 until the session quits.
+ */
+int protocol_reading(const ProtocolContext *ctx);
+
+/**
+ * protocol_flush: Writes the queued output with SSL_write.
+ * Returns 1 when all of it is written, 0 if a non-blocking socket would
+ * block (call again when it is writable), -1 if the connection failed.
+ */
+int protocol_flush(ProtocolContext *ctx);
+
+/**
+ * protocol_run: The blocking command loop for a thread-per-session
+ * server: drives the calls above until the client quits or disconnects.
  */
 void protocol_run(ProtocolContext *ctx);
 
+/**
+ * protocol_cleanup: Releases per-session state once the session ends.
+ */
+void protocol_cleanup(ProtocolContext *ctx);
+
 // ============================================================
 // COMMAND IMPLEMENTATIONS
 // ============================================================
@@ -41,28 +106,99 @@ void protocol_run(ProtocolContext *ctx);
 void cmd_help(ProtocolContext *ctx);
 void cmd_whoami(ProtocolContext *ctx);
 void cmd_list_units(ProtocolContext *ctx);
-void cmd_get_sensors(ProtocolContext *ctx);
-void cmd_get_health(ProtocolContext *ctx);
-void cmd_get_log(ProtocolContext *ctx);
+
+/**
+ * cmd_get_sensors / cmd_get_health: Report one unit.
+ * args may name a unit; empty args select the default unit.
+ */
+void cmd_get_sensors(ProtocolContext *ctx, const char *args);
+void cmd_get_health(ProtocolContext *ctx, const char *args);
+
+/**
+ * cmd_get_spectrum: Dominant line, band RMS, running-speed harmonics and
+ * strongest peaks of the latest vibration FFT of one unit.
+ */
+void cmd_get_spectrum(ProtocolContext *ctx, const char *args);
+
+/**
+ * cmd_get_history: Level history of one channel of one unit over a
+ * range (default 10m, up to 30d) from the tier that covers it: 1 s
+ * points up to 1h, 1 min min/max/avg up to 1d, 1 h rollups beyond.
+ */
+void cmd_get_history(ProtocolContext *ctx, const char *args);
+
+/**
+ * cmd_set_rate: Fixed acquisition rate or the adaptive policy for one
+ * unit, optionally with a new window length (MAINTENANCE/ADMIN).
+ */
+void cmd_set_rate(ProtocolContext *ctx, const char *args);
+
+/**
+ * cmd_reload_rules: Recompiles config/rules.conf and swaps it into the
+ * running poll loop (MAINTENANCE/ADMIN). A bad file is rejected with its
+ * line number and the current rules stay in force.
+ */
+void cmd_reload_rules(ProtocolContext *ctx);
+
+/**
+ * cmd_get_log: Blackbox records, oldest first, filtered by unit, time
+ * range (from=/to= or a range back from now) and severity. Pages with
+ * limit=/offset=; after=<seq> resumes after the last record shown. Only
+ * index blocks that can match are read. A long result is rendered as the
+ * client takes it (a get_log stream), not all at once.
+ */
+void cmd_get_log(ProtocolContext *ctx, const char *args);
+
+/**
+ * cmd_follow_log: Streams blackbox records as they are committed, like
+ * tail -f, until ENTER or the optional time limit. Filters by unit and
+ * severity=; after=<seq> first replays everything past that record.
+ */
+void cmd_follow_log(ProtocolContext *ctx, const char *args);
+
+/**
+ * cmd_subscribe_alerts: Pushes alerts (health level changes, see
+ * alerts.h) the moment the manager raises them, until ENTER or the
+ * optional time limit. Filters by unit and severity=critical.
+ */
+void cmd_subscribe_alerts(ProtocolContext *ctx, const char *args);
+
+/**
+ * cmd_get_latency: Poll-loop wakeup/exec percentiles and deadline
+ * counters, since server start and since this session's previous call.
+ */
+void cmd_get_latency(ProtocolContext *ctx);
 void cmd_clear_log(ProtocolContext *ctx);
 
 /**
- * cmd_monitor: Handles real-time telemetry streaming.
- * Supports args like "20s", "5m", "1h".
+ * cmd_monitor: Starts real-time telemetry streaming, one line pair per
+ * second from protocol_poll (in binary mode, one SNAPSHOT or DELTA frame
+ * per new window).
+ * Supports args "[unit] [time]", e.g. "20s", "Press-Line-A 5m", "1h".
  */
 void cmd_monitor(ProtocolContext *ctx, const char *args);
 
+/**
+ * cmd_protocol: "protocol binary [version] [delta]" switches replies to
+ * the framed binary format of wire.h (answered with a HELLO frame naming
+ * the version the server chose); "protocol text" switches back.
+ */
+void cmd_protocol(ProtocolContext *ctx, const char *args);
+
 // ============================================================
 // PROTOCOL HELPERS
 // ============================================================
 
 /**
- * send_response: Sends an encrypted string to the client.
+ * send_response: Queues a string for the client (see protocol_flush),
+ * as a TEXT frame in binary mode.
+ * Dropped if the session already has PROTOCOL_OUT_MAX bytes unsent.
  */
 void send_response(ProtocolContext *ctx, const char *msg);
 
 /**
- * send_eom: Sends the End-of-Message marker (0x03) to reset client prompt.
+ * send_eom: Queues the End-of-Message marker (0x03) to reset client
+ * prompt, or an END frame in binary mode.
  */
 void send_eom(ProtocolContext *ctx);
 
@@ -0,0 +1,474 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#include "reactor.h"
+#include "protocol.h"
+#include "authorization.h"
+#include "rt_log.h"
+#include "rt_profile.h"
+#include "blackbox.h"
+#include "alerts.h"
+
+#define REACTOR_EVENTS   64
+#define READ_CHUNK       1024    // one client command per read (see protocol_input)
+#define SERVICE_ROUNDS   8       // back-to-back get_log pages before others get a turn
+#define ACCEPT_RETRY_MS  1000    // pause after accept fails (e.g. out of fds)
+
+typedef enum {
+    CONN_HANDSHAKE,
+    CONN_OPEN
+} ConnState;
+
+typedef struct Conn {
+    int fd;
+    SSL *ssl;
+    ConnState state;
+    int closed;                 // waiting for the end of the event batch to be freed
+    uint32_t events;            // epoll interest as registered
+    int64_t due_ms;             // next protocol_poll (or handshake deadline), -1 = none
+    char ip[INET_ADDRSTRLEN];
+    ProtocolContext proto;      // valid once CONN_OPEN
+    struct Conn *prev, *next;
+} Conn;
+
+typedef struct {
+    int index;
+    int epfd;
+    int listen_fd;
+    int wake_fd;                // eventfd written on blackbox commits and alerts
+    int64_t accept_resume_ms;   // 0 = accepting
+    int64_t earliest;           // lowest due_ms of any session, INT64_MAX = none
+    const ReactorConfig *cfg;
+    Conn *conns;
+    Conn *closed;               // closed this batch; events may still name them
+} Reactor;
+
+static Reactor reactors[REACTOR_MAX_THREADS];
+
+static int64_t mono_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void set_interest(Reactor *r, Conn *c, uint32_t events)
+{
+    struct epoll_event ev;
+
+    if (events == c->events)
+        return;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = c;
+    if (epoll_ctl(r->epfd, EPOLL_CTL_MOD, c->fd, &ev) == 0)
+        c->events = events;
+}
+
+static void note_due(Reactor *r, const Conn *c)
+{
+    if (c->due_ms >= 0 && c->due_ms < r->earliest)
+        r->earliest = c->due_ms;
+}
+
+// ============================================================
+// SESSIONS
+// ============================================================
+
+static void conn_close(Reactor *r, Conn *c)
+{
+    if (c->state == CONN_OPEN) {
+        protocol_cleanup(&c->proto);
+        log_info("[CONN] Session ended for %s\n", c->proto.identity.common_name);
+    }
+
+    // Best effort close_notify; the socket is non-blocking
+    ERR_clear_error();
+    SSL_shutdown(c->ssl);
+    SSL_free(c->ssl);
+    close(c->fd);   // also leaves the epoll set
+
+    if (c->prev)
+        c->prev->next = c->next;
+    else
+        r->conns = c->next;
+    if (c->next)
+        c->next->prev = c->prev;
+
+    log_info("[CONN] Session fully closed for %s.\n", c->ip);
+    c->closed = 1;
+    c->next = r->closed;
+    r->closed = c;
+    r->cfg->release_slot();
+}
+
+/*
+ * Reads, polls and writes until the session has nothing left to do now.
+ * Returns 0, or -1 if it was closed.
+ */
+static int conn_service(Reactor *r, Conn *c, int readable)
+{
+    ProtocolContext *p = &c->proto;
+    char buf[READ_CHUNK];
+    int wait_ms = -1, flushed = 1;
+
+    for (int round = 0; round < SERVICE_ROUNDS; round++) {
+        // Input waits while a get_log result is going out or the client
+        // is not reading its replies
+        while (readable && protocol_reading(p) && p->out_len - p->out_off < PROTOCOL_OUT_LOW) {
+            ERR_clear_error();
+            int n = SSL_read(c->ssl, buf, sizeof(buf));
+            if (n > 0) {
+                protocol_input(p, buf, n);
+                continue;
+            }
+            int err = SSL_get_error(c->ssl, n);
+            if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
+                conn_close(r, c);   // disconnect or TLS error
+                return -1;
+            }
+            break;
+        }
+
+        wait_ms = protocol_poll(p);
+        flushed = protocol_flush(p);
+        if (flushed < 0 || (!p->running && flushed > 0)) {
+            conn_close(r, c);       // failed, or the goodbye after quit is out
+            return -1;
+        }
+
+        // Records OpenSSL already decrypted raise no EPOLLIN
+        readable = protocol_reading(p) && SSL_has_pending(c->ssl);
+        if (!readable && (!flushed || wait_ms != 0))
+            break;
+    }
+
+    if (wait_ms == 0)
+        c->due_ms = flushed ? mono_ms() : -1;   // more is ready / EPOLLOUT resumes it
+    else
+        c->due_ms = wait_ms > 0 ? mono_ms() + wait_ms : -1;
+    note_due(r, c);
+
+    uint32_t events = 0;
+    if (protocol_reading(p) && p->out_len - p->out_off < PROTOCOL_OUT_LOW)
+        events |= EPOLLIN;
+    if (!flushed)
+        events |= EPOLLOUT;
+    set_interest(r, c, events);
+    return 0;
+}
+
+/*
+ * Advances the TLS handshake; on completion authorizes the client and
+ * starts its session. Returns 0, or -1 if it was closed.
+ */
+static int conn_handshake(Reactor *r, Conn *c)
+{
+    ClientIdentity id;
+    int rc;
+
+    ERR_clear_error();
+    rc = SSL_accept(c->ssl);
+    if (rc <= 0) {
+        int err = SSL_get_error(c->ssl, rc);
+        if (err == SSL_ERROR_WANT_READ) {
+            set_interest(r, c, EPOLLIN);
+            return 0;
+        }
+        if (err == SSL_ERROR_WANT_WRITE) {
+            set_interest(r, c, EPOLLOUT);
+            return 0;
+        }
+        log_info("[AUTH] TLS Handshake failed. Rejecting connection from %s.\n", c->ip);
+        ERR_print_errors_cb(rt_log_ssl_error, NULL);
+        conn_close(r, c);
+        return -1;
+    }
+
+    if (authorize_client(c->ssl, &id) != 0) {
+        log_info("[AUTH] Access DENIED: Missing or invalid client certificate from %s.\n", c->ip);
+        conn_close(r, c);
+        return -1;
+    }
+    if (id.role == ROLE_UNAUTHORIZED) {
+        log_info("[AUTH] Access DENIED: Client '%s' has an unauthorized role.\n", id.common_name);
+        conn_close(r, c);
+        return -1;
+    }
+    log_info("[AUTH] Access GRANTED to User: '%s' | Assigned Role: '%s'%s\n",
+             id.common_name, role_to_string(id.role), SSL_session_reused(c->ssl) ? " (resumed)" : "");
+
+    protocol_init(&c->proto, c->ssl, id, r->cfg->sensor_mgr);
+    protocol_start(&c->proto);
+    c->state = CONN_OPEN;
+    c->due_ms = -1;
+
+    // A first command may have come with the handshake's last flight
+    return conn_service(r, c, 1);
+}
+
+static void accept_clients(Reactor *r)
+{
+    for (;;) {
+        struct sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        int fd = accept4(r->listen_fd, (struct sockaddr *)&addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+
+            // Out of fds or memory: stop listening for a while instead of
+            // spinning on a listen socket that stays readable
+            log_error("[ERROR] Accept failed: %s\n", strerror(errno));
+            epoll_ctl(r->epfd, EPOLL_CTL_DEL, r->listen_fd, NULL);
+            r->accept_resume_ms = mono_ms() + ACCEPT_RETRY_MS;
+            return;
+        }
+
+        char ip_buf[INET_ADDRSTRLEN] = {0};
+        inet_ntop(AF_INET, &addr.sin_addr, ip_buf, sizeof(ip_buf));
+        log_info("[CONN] TCP Connection established from IP: %s (reactor %d)\n", ip_buf, r->index);
+
+        if (!r->cfg->reserve_slot()) {
+            log_info("[SESSIONS] Connection rejected for %s: session limit reached.\n", ip_buf);
+            close(fd);
+            continue;
+        }
+
+        Conn *c = calloc(1, sizeof(Conn));
+        SSL *ssl = c ? SSL_new(r->cfg->ssl_ctx) : NULL;
+        if (!ssl) {
+            log_error("[ERROR] Failed to allocate session state for %s\n", ip_buf);
+            free(c);
+            close(fd);
+            r->cfg->release_slot();
+            continue;
+        }
+
+        SSL_set_fd(ssl, fd);
+        SSL_set_accept_state(ssl);
+        // Partial writes from a buffer that may move between retries (the
+        // session output grows while a write is pending), no TLS buffers
+        // held by idle sessions, and no mid-session handshakes
+        SSL_set_mode(ssl, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER |
+                          SSL_MODE_RELEASE_BUFFERS);
+        SSL_set_options(ssl, SSL_OP_NO_RENEGOTIATION);
+
+        c->fd = fd;
+        c->ssl = ssl;
+        c->state = CONN_HANDSHAKE;
+        c->events = EPOLLIN;
+        c->due_ms = mono_ms() + REACTOR_HANDSHAKE_MS;
+        snprintf(c->ip, sizeof(c->ip), "%s", ip_buf);
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            log_error("[ERROR] Cannot watch connection from %s: %s\n", ip_buf, strerror(errno));
+            SSL_free(ssl);
+            free(c);
+            close(fd);
+            r->cfg->release_slot();
+            continue;
+        }
+
+        c->next = r->conns;
+        if (r->conns)
+            r->conns->prev = c;
+        r->conns = c;
+        note_due(r, c);
+    }
+}
+
+// ============================================================
+// EVENT LOOP
+// ============================================================
+
+/*
+ * Runs what is due: stream ticks, streams woken by a commit or an alert,
+ * handshake deadlines. Recomputes the earliest deadline on the way.
+ */
+static void run_timers(Reactor *r, int64_t now, int notified)
+{
+    int64_t earliest = INT64_MAX;
+    Conn *next;
+
+    for (Conn *c = r->conns; c; c = next) {
+        next = c->next;
+
+        if (c->state == CONN_HANDSHAKE) {
+            if (now >= c->due_ms) {
+                log_info("[AUTH] Handshake timed out. Rejecting connection from %s.\n", c->ip);
+                conn_close(r, c);
+                continue;
+            }
+        } else if ((notified && c->proto.stream) || (c->due_ms >= 0 && now >= c->due_ms)) {
+            if (conn_service(r, c, 0) != 0)
+                continue;
+        }
+
+        if (c->due_ms >= 0 && c->due_ms < earliest)
+            earliest = c->due_ms;
+    }
+    r->earliest = earliest;
+}
+
+static void *reactor_loop(void *arg)
+{
+    Reactor *r = arg;
+    struct epoll_event events[REACTOR_EVENTS];
+
+    for (;;) {
+        int64_t now = mono_ms();
+        int64_t until = r->earliest;
+        int timeout = -1, notified = 0;
+
+        if (r->accept_resume_ms && r->accept_resume_ms < until)
+            until = r->accept_resume_ms;
+        if (until != INT64_MAX)
+            timeout = until <= now ? 0 : (until - now > INT32_MAX ? INT32_MAX : (int)(until - now));
+
+        int n = epoll_wait(r->epfd, events, REACTOR_EVENTS, timeout);
+        if (n < 0 && errno != EINTR) {
+            log_error("[ERROR] Reactor %d: epoll_wait failed: %s\n", r->index, strerror(errno));
+            return NULL;
+        }
+
+        for (int i = 0; i < n; i++) {
+            void *ptr = events[i].data.ptr;
+
+            if (ptr == &r->listen_fd) {
+                accept_clients(r);
+            } else if (ptr == &r->wake_fd) {
+                uint64_t count;
+                ssize_t got = read(r->wake_fd, &count, sizeof(count));
+                (void)got;
+                notified = 1;
+            } else {
+                Conn *c = ptr;
+
+                if (c->closed)
+                    continue;
+                if (c->state == CONN_HANDSHAKE)
+                    conn_handshake(r, c);
+                else if (events[i].events & (EPOLLERR | EPOLLHUP) && !(events[i].events & EPOLLIN))
+                    conn_close(r, c);
+                else
+                    conn_service(r, c, (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0);
+            }
+        }
+
+        now = mono_ms();
+        if (r->accept_resume_ms && now >= r->accept_resume_ms) {
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN;
+            ev.data.ptr = &r->listen_fd;
+            epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->listen_fd, &ev);
+            r->accept_resume_ms = 0;
+        }
+        if (notified || now >= r->earliest)
+            run_timers(r, now, notified);
+
+        while (r->closed) {
+            Conn *c = r->closed;
+            r->closed = c->next;
+            free(c);
+        }
+    }
+    return NULL;
+}
+
+static int reactor_init(Reactor *r, int index, const ReactorConfig *cfg)
+{
+    struct epoll_event ev;
+
+    memset(r, 0, sizeof(*r));
+    r->index = index;
+    r->cfg = cfg;
+    r->listen_fd = cfg->listen_fd[index];
+    r->earliest = INT64_MAX;
+    r->epfd = epoll_create1(EPOLL_CLOEXEC);
+    r->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (r->epfd < 0 || r->wake_fd < 0) {
+        log_error("[ERROR] Reactor %d: %s\n", index, strerror(errno));
+        return -1;
+    }
+
+    fcntl(r->listen_fd, F_SETFL, fcntl(r->listen_fd, F_GETFL) | O_NONBLOCK);
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = &r->listen_fd;
+    if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->listen_fd, &ev) != 0)
+        return -1;
+    ev.data.ptr = &r->wake_fd;
+    if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->wake_fd, &ev) != 0)
+        return -1;
+
+    if (blackbox_watch(r->wake_fd) != 0 || alerts_watch(r->wake_fd) != 0)
+        log_error("[WARN] Reactor %d: no commit/alert wakeups, follow_log and "
+                  "subscribe_alerts wait for other activity\n", index);
+    return 0;
+}
+
+// ============================================================
+// PUBLIC API
+// ============================================================
+
+int reactor_default_threads(void)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (cpus < 1)
+        return 1;
+    return cpus > REACTOR_MAX_THREADS ? REACTOR_MAX_THREADS : (int)cpus;
+}
+
+int reactor_run(const ReactorConfig *cfg)
+{
+    int threads = cfg->threads < 1 ? 1 : cfg->threads > REACTOR_MAX_THREADS ? REACTOR_MAX_THREADS
+                                                                              : cfg->threads;
+
+    for (int i = 0; i < threads; i++) {
+        if (reactor_init(&reactors[i], i, cfg) != 0)
+            return -1;
+    }
+
+    for (int i = 1; i < threads; i++) {
+        pthread_t tid;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        rt_profile_worker_attr(&attr);
+        int rc = pthread_create(&tid, &attr, reactor_loop, &reactors[i]);
+        pthread_attr_destroy(&attr);
+        if (rc != 0) {
+            log_error("[ERROR] Reactor %d: cannot start: %s\n", i, strerror(rc));
+            return -1;
+        }
+        pthread_detach(tid);
+    }
+
+    log_info("[NETWORK] %d reactor thread%s serving sessions (epoll%s)\n",
+             threads, threads == 1 ? "" : "s", threads > 1 ? ", SO_REUSEPORT" : "");
+    reactor_loop(&reactors[0]);
+    return -1;
+}
@@ -0,0 +1,56 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <openssl/ssl.h>
+#include "sensor_manager.h"
+
+// ============================================================
+// EPOLL SESSION REACTOR (Linux)
+// ============================================================
+//
+// A few event-loop threads serve every client instead of one thread per
+// connection. Each reactor owns a listening socket bound with
+// SO_REUSEPORT (the kernel spreads new connections across them), an
+// epoll set and the sessions it accepted, and drives each one as a
+// non-blocking state machine: SSL_accept until the handshake completes,
+// then SSL_read into protocol_input, protocol_poll for streams and
+// protocol_flush for output, waiting for EPOLLIN/EPOLLOUT wherever
+// OpenSSL reports WANT_READ/WANT_WRITE. Nothing in it sleeps except
+// epoll_wait, whose timeout is the nearest stream deadline; an eventfd
+// registered with blackbox_watch/alerts_watch wakes it for follow_log
+// and subscribe_alerts.
+//
+// A session costs its SSL object (buffers released while idle), a
+// ProtocolContext and output up to PROTOCOL_OUT_LOW behind, so memory
+// grows with clients but not with threads. A client that has not
+// completed its handshake within REACTOR_HANDSHAKE_MS is dropped.
+
+#define REACTOR_MAX_THREADS  4
+#define REACTOR_HANDSHAKE_MS 10000
+
+/**
+ * ReactorConfig: What the server hands to reactor_run.
+ * listen_fd[i] is reactor i's bound, listening socket.
+ */
+typedef struct {
+    SSL_CTX *ssl_ctx;
+    SensorManager *sensor_mgr;
+    int listen_fd[REACTOR_MAX_THREADS];
+    int threads;
+    int (*reserve_slot)(void);   // 0 = refuse the connection
+    void (*release_slot)(void);
+} ReactorConfig;
+
+/**
+ * reactor_default_threads: One reactor per online CPU, up to
+ * REACTOR_MAX_THREADS.
+ */
+int reactor_default_threads(void);
+
+/**
+ * reactor_run: Starts cfg->threads reactors, running the first on the
+ * calling thread. Only returns if it cannot start (-1).
+ */
+int reactor_run(const ReactorConfig *cfg);
+
+#endif // REACTOR_H
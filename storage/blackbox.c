@@ -0,0 +1,831 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "blackbox.h"
+#include "file_util.h"
+#include "config_file.h"
+#include "rt_log.h"
+#include "rt_profile.h"
+
+#define BB_MAGIC        "BBOX"
+#define BB_VERSION      1
+#define BB_ALIGN        8
+#define BB_STAGE_BYTES  (64 * 1024)   // per staging buffer; two alternate
+#define BB_PATH_MAX     64
+#define BB_CRC_SKIP     offsetof(BlackboxRecord, seq)
+
+#define DEFAULT_COMMIT_MS 1000
+#define DEFAULT_FILE_KB   1024
+#define DEFAULT_FILES     3
+
+// Staging: producers append under stage_lock, the committer swaps buffers
+static pthread_mutex_t stage_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stage_cond;     // wakes the committer early
+static pthread_cond_t commit_cond;    // wakes blackbox_wait/clear_wait callers
+static uint8_t *stage[2];
+static size_t stage_len;
+static int stage_idx;
+static int running = 0;
+static int sync_requested = 0;
+static uint64_t clear_requested = 0;  // last blackbox_request_clear ticket
+static uint64_t clear_done = 0;       // last ticket the committer carried out
+static int clear_failed = 0;          // ... and whether it failed
+static uint64_t next_seq = 1;
+static uint64_t committed_seq = 0;    // every record up to this one is done
+static uint64_t dropped = 0;
+static int watch_fd[BLACKBOX_WATCH_MAX];   // written after every commit
+static int watch_count = 0;
+
+// The files and their index: the committer (writes and clears) and the
+// first step of blackbox_query
+static pthread_mutex_t io_lock = PTHREAD_MUTEX_INITIALIZER;
+static BlackboxConfig config;
+static int fd = -1;
+static uint64_t file_size;
+static uint64_t write_off;
+static int write_failing = 0;
+
+static pthread_t committer;
+static int started = 0;
+
+// ============================================================
+// TIME
+// ============================================================
+
+static int64_t wall_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void deadline_in(struct timespec *ts, long ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_nsec -= 1000000000L;
+        ts->tv_sec++;
+    }
+}
+
+// ============================================================
+// CONFIGURATION
+// ============================================================
+
+int blackbox_load_config(const char *path, BlackboxConfig *cfg)
+{
+    const ConfigKey keys[] = {
+        { "commit_ms", 10, 60000,              NULL, &cfg->commit_ms },
+        { "file_kb",   16, 1024 * 1024,        NULL, &cfg->file_kb },
+        { "files",     0,  BLACKBOX_MAX_FILES, NULL, &cfg->files },
+    };
+
+    cfg->commit_ms = DEFAULT_COMMIT_MS;
+    cfg->file_kb = DEFAULT_FILE_KB;
+    cfg->files = DEFAULT_FILES;
+
+    return config_file_load(path, "BLACKBOX", keys, sizeof(keys) / sizeof(keys[0]));
+}
+
+// ============================================================
+// FILE FORMAT
+// ============================================================
+
+static void rotated_path(char *path, unsigned i)
+{
+    snprintf(path, BB_PATH_MAX, BLACKBOX_ROTATED, i);
+}
+
+// Copies the record header at off if a whole, intact record starts there
+static int record_at(const uint8_t *base, size_t size, size_t off, BlackboxRecord *r)
+{
+    if (off + sizeof(*r) > size)
+        return 0;
+    memcpy(r, base + off, sizeof(*r));
+    if (r->length < sizeof(*r) || r->length % BB_ALIGN || r->length > size - off ||
+        sizeof(*r) + r->unit_len + r->text_len > r->length)
+        return 0;
+    return file_crc32(base + off + BB_CRC_SKIP, r->length - BB_CRC_SKIP) == r->crc;
+}
+
+static const uint8_t *map_file(int f, size_t *size)
+{
+    struct stat st;
+    const BlackboxFileHeader *h;
+
+    if (fstat(f, &st) != 0 || (size_t)st.st_size < sizeof(BlackboxFileHeader))
+        return NULL;
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, f, 0);
+    if (base == MAP_FAILED)
+        return NULL;
+
+    h = base;
+    if (memcmp(h->magic, BB_MAGIC, 4) != 0 || h->version != BB_VERSION) {
+        munmap(base, (size_t)st.st_size);
+        return NULL;
+    }
+    *size = (size_t)st.st_size;
+    return base;
+}
+
+static int pwrite_all(int f, const void *buf, size_t len, uint64_t off)
+{
+    const uint8_t *p = buf;
+
+    while (len > 0) {
+        ssize_t n = pwrite(f, p, len, (off_t)off);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        p += n;
+        off += (uint64_t)n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Fresh, preallocated (zeroed) file: later batches never grow it. A new
+// inode, so a reader still mapping the old file never sees it shrink.
+static int create_file(const char *path, uint64_t size)
+{
+    BlackboxFileHeader h;
+    int f;
+
+    unlink(path);
+    f = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+
+    if (f < 0)
+        return -1;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, BB_MAGIC, 4);
+    h.version = BB_VERSION;
+    h.created_ms = (uint64_t)wall_ms();
+
+    if (ftruncate(f, (off_t)size) != 0 || pwrite_all(f, &h, sizeof(h), 0) != 0) {
+        close(f);
+        return -1;
+    }
+    posix_fallocate(f, 0, (off_t)size);   // best effort: sparse works too
+    fdatasync(f);
+    return f;
+}
+
+// ============================================================
+// SPARSE INDEX
+// ============================================================
+
+/**
+ * IndexBlock: Summary of up to BLACKBOX_INDEX_RECORDS consecutive records.
+ */
+typedef struct {
+    uint64_t off;          // first record
+    uint64_t end;          // just past the last record
+    uint64_t first_seq;
+    uint64_t last_seq;
+    int64_t min_ms;
+    int64_t max_ms;
+    uint64_t units;        // unit_bit() of every record
+    uint32_t kinds;        // 1u << kind of every record
+    uint32_t records;
+} IndexBlock;
+
+typedef struct {
+    IndexBlock *blocks;
+    int count;
+    int cap;
+} FileIndex;
+
+// [0] = active file, [i] = blackbox.i.bin; guarded by io_lock
+static FileIndex file_index[BLACKBOX_MAX_FILES + 1];
+
+// One of 64 signature bits per unit id (FNV-1a)
+static uint64_t unit_bit(const char *unit, size_t len)
+{
+    uint32_t h = 2166136261u;
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)unit[i];
+        h *= 16777619u;
+    }
+    return 1ULL << (h & 63u);
+}
+
+static void index_add(FileIndex *fi, uint64_t off, const BlackboxRecord *r, const char *unit)
+{
+    IndexBlock *b = fi->count ? &fi->blocks[fi->count - 1] : NULL;
+
+    if (!b || b->records >= BLACKBOX_INDEX_RECORDS) {
+        if (fi->count == fi->cap) {
+            int cap = fi->cap ? fi->cap * 2 : 64;
+            IndexBlock *grown = realloc(fi->blocks, (size_t)cap * sizeof(IndexBlock));
+            if (grown) {
+                fi->blocks = grown;
+                fi->cap = cap;
+            }
+        }
+        // Out of memory: the last block keeps growing (coarser, still exact)
+        if (fi->count < fi->cap) {
+            b = &fi->blocks[fi->count++];
+            memset(b, 0, sizeof(*b));
+            b->off = off;
+            b->first_seq = r->seq;
+            b->min_ms = b->max_ms = r->t_ms;
+        }
+        if (!b)
+            return;
+    }
+
+    b->end = off + r->length;
+    b->last_seq = r->seq;
+    if (r->t_ms < b->min_ms) b->min_ms = r->t_ms;
+    if (r->t_ms > b->max_ms) b->max_ms = r->t_ms;
+    b->units |= unit_bit(unit, r->unit_len);
+    b->kinds |= 1u << (r->kind & 31u);
+    b->records++;
+}
+
+static void index_reset(FileIndex *fi)
+{
+    free(fi->blocks);
+    memset(fi, 0, sizeof(*fi));
+}
+
+// Indexes the intact records of one mapped file; returns where they end
+static size_t index_records(const uint8_t *base, size_t size, FileIndex *fi, uint64_t *last_seq)
+{
+    size_t off = sizeof(BlackboxFileHeader);
+    BlackboxRecord r;
+
+    while (record_at(base, size, off, &r)) {
+        index_add(fi, off, &r, (const char *)base + off + sizeof(r));
+        *last_seq = r.seq;
+        off += r.length;
+    }
+    return off;
+}
+
+// Points fd/write_off at the end of the intact records of the active file
+static int open_active(uint64_t *last_seq)
+{
+    static const uint8_t zeros[4096];
+    size_t size, end;
+    const uint8_t *base;
+    int f = open(BLACKBOX_PATH, O_RDWR);
+
+    if (f >= 0 && (base = map_file(f, &size)) != NULL) {
+        end = index_records(base, size, &file_index[0], last_seq);
+        int dirty = 0;
+        for (size_t i = end; i < size && !dirty; i++)
+            dirty = base[i] != 0;
+        munmap((void *)base, size);
+
+        // A torn batch: wipe it, so a later shorter record cannot make an
+        // old one behind it look like its successor
+        if (dirty) {
+            for (size_t off = end; off < size; off += sizeof(zeros))
+                pwrite_all(f, zeros, size - off < sizeof(zeros) ? size - off : sizeof(zeros), off);
+            fdatasync(f);
+            log_info("[BLACKBOX] Torn tail after record #%llu discarded\n",
+                     (unsigned long long)*last_seq);
+        }
+    } else {
+        if (f >= 0)
+            close(f);
+        size = (size_t)config.file_kb * 1024;
+        end = sizeof(BlackboxFileHeader);
+        f = create_file(BLACKBOX_PATH, size);
+        if (f < 0)
+            return -1;
+    }
+
+    fd = f;
+    file_size = size;
+    write_off = end;
+    return 0;
+}
+
+// ============================================================
+// COMMITTER
+// ============================================================
+
+static int rotate(void)
+{
+    char from[BB_PATH_MAX], to[BB_PATH_MAX];
+
+    fdatasync(fd);
+    close(fd);
+    fd = -1;
+
+    // The indexes move with their files
+    for (unsigned i = BLACKBOX_MAX_FILES; i >= 1 && i >= config.files; i--) {
+        rotated_path(to, i);
+        unlink(to);
+        index_reset(&file_index[i]);
+    }
+    for (unsigned i = config.files; i > 1; i--) {
+        rotated_path(from, i - 1);
+        rotated_path(to, i);
+        rename(from, to);
+        file_index[i] = file_index[i - 1];
+    }
+    if (config.files > 0) {
+        rotated_path(to, 1);
+        rename(BLACKBOX_PATH, to);
+        file_index[1] = file_index[0];
+    } else {
+        index_reset(&file_index[0]);
+    }
+    memset(&file_index[0], 0, sizeof(file_index[0]));
+
+    fd = create_file(BLACKBOX_PATH, (uint64_t)config.file_kb * 1024);
+    if (fd < 0)
+        return -1;
+    file_size = (uint64_t)config.file_kb * 1024;
+    write_off = sizeof(BlackboxFileHeader);
+    return 0;
+}
+
+// Writes whole records in one pwrite per file, rotating between records
+static int write_batch(const uint8_t *buf, size_t len)
+{
+    size_t done = 0;
+
+    while (done < len) {
+        uint64_t room = file_size - write_off;
+        size_t n = 0;
+        uint32_t rl;
+
+        while (done + n < len) {
+            memcpy(&rl, buf + done + n, sizeof(rl));
+            if (n + rl > room)
+                break;
+            n += rl;
+        }
+
+        if (n == 0) {
+            if (write_off == sizeof(BlackboxFileHeader) || rotate() != 0)
+                return -1;
+            continue;
+        }
+        if (pwrite_all(fd, buf + done, n, write_off) != 0)
+            return -1;
+        for (size_t k = 0; k < n; ) {
+            BlackboxRecord r;
+            memcpy(&r, buf + done + k, sizeof(r));
+            index_add(&file_index[0], write_off + k, &r, (const char *)buf + done + k + sizeof(r));
+            k += r.length;
+        }
+        write_off += n;
+        done += n;
+    }
+    return fdatasync(fd);
+}
+
+// Deletes the rotated files and starts an empty active one. io_lock held.
+static int clear_files(void)
+{
+    char path[BB_PATH_MAX];
+
+    for (unsigned i = 1; i <= BLACKBOX_MAX_FILES; i++) {
+        rotated_path(path, i);
+        unlink(path);
+    }
+    for (unsigned i = 0; i <= BLACKBOX_MAX_FILES; i++)
+        index_reset(&file_index[i]);
+    if (fd >= 0)
+        close(fd);
+    fd = create_file(BLACKBOX_PATH, (uint64_t)config.file_kb * 1024);
+    file_size = (uint64_t)config.file_kb * 1024;
+    write_off = sizeof(BlackboxFileHeader);
+    return fd < 0 ? -1 : 0;
+}
+
+static void *committer_main(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&stage_lock);
+    for (;;) {
+        struct timespec deadline;
+
+        deadline_in(&deadline, (long)config.commit_ms);
+        while (running && !sync_requested && clear_requested == clear_done &&
+               stage_len < BB_STAGE_BYTES / 2) {
+            if (pthread_cond_timedwait(&stage_cond, &stage_lock, &deadline) == ETIMEDOUT)
+                break;
+        }
+
+        int stop = !running;
+        const uint8_t *buf = stage[stage_idx];
+        size_t len = stage_len;
+        uint64_t last = next_seq - 1;
+        uint64_t clear = clear_requested;
+        int clear_rc = 0;
+
+        stage_idx ^= 1;
+        stage_len = 0;
+        sync_requested = 0;
+        pthread_mutex_unlock(&stage_lock);
+
+        // A clear drops what was staged before it and starts a new file
+        if (clear != clear_done) {
+            len = 0;
+            pthread_mutex_lock(&io_lock);
+            clear_rc = clear_files();
+            pthread_mutex_unlock(&io_lock);
+        }
+
+        if (len) {
+            pthread_mutex_lock(&io_lock);
+            int rc = fd >= 0 ? write_batch(buf, len) : -1;
+            pthread_mutex_unlock(&io_lock);
+
+            if (rc != 0 && !write_failing)
+                log_error("[BLACKBOX] Write failed (%s), records are being lost\n", strerror(errno));
+            else if (rc == 0 && write_failing)
+                log_info("[BLACKBOX] Writing again\n");
+            write_failing = rc != 0;
+        }
+
+        pthread_mutex_lock(&stage_lock);
+        committed_seq = last;
+        if (clear != clear_done) {
+            clear_done = clear;
+            clear_failed = clear_rc != 0;
+        }
+        pthread_cond_broadcast(&commit_cond);
+        for (int i = 0; i < watch_count; i++) {
+            uint64_t one = 1;
+            ssize_t n = write(watch_fd[i], &one, sizeof(one));
+            (void)n;   // a full pipe already has a wakeup pending
+        }
+        if (stop)
+            break;
+    }
+    pthread_mutex_unlock(&stage_lock);
+    return NULL;
+}
+
+// ============================================================
+// PUBLIC API
+// ============================================================
+
+int blackbox_start(const BlackboxConfig *cfg)
+{
+    pthread_condattr_t ca;
+    pthread_attr_t attr;
+    uint64_t last = 0;
+
+    if (started)
+        return 0;
+
+    config = *cfg;
+
+    stage[0] = malloc(BB_STAGE_BYTES);
+    stage[1] = malloc(BB_STAGE_BYTES);
+    if (!stage[0] || !stage[1] || open_active(&last) != 0) {
+        free(stage[0]);
+        free(stage[1]);
+        stage[0] = stage[1] = NULL;
+        return -1;
+    }
+
+    // Index the rotated files too; sequence numbers continue from the
+    // newest file that has records
+    for (unsigned i = 1; i <= BLACKBOX_MAX_FILES; i++) {
+        char path[BB_PATH_MAX];
+        const uint8_t *base;
+        uint64_t file_last = 0;
+        size_t size;
+
+        rotated_path(path, i);
+        int f = open(path, O_RDONLY);
+        if (f < 0)
+            continue;
+        if ((base = map_file(f, &size)) != NULL) {
+            index_records(base, size, &file_index[i], &file_last);
+            munmap((void *)base, size);
+            if (last == 0)
+                last = file_last;
+        }
+        close(f);
+    }
+
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&stage_cond, &ca);
+    pthread_cond_init(&commit_cond, &ca);
+    pthread_condattr_destroy(&ca);
+
+    pthread_mutex_lock(&stage_lock);
+    next_seq = last + 1;
+    committed_seq = last;
+    stage_len = 0;
+    running = 1;
+    pthread_mutex_unlock(&stage_lock);
+
+    pthread_attr_init(&attr);
+    rt_profile_worker_attr(&attr);
+#ifdef __QNX__
+    {
+        // Below every RT thread, like the log writer
+        struct sched_param sp;
+        memset(&sp, 0, sizeof(sp));
+        sp.sched_priority = 5;
+
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+        pthread_attr_setschedparam(&attr, &sp);
+    }
+#endif
+
+    if (pthread_create(&committer, &attr, committer_main, NULL) != 0) {
+        pthread_attr_destroy(&attr);
+        pthread_mutex_lock(&stage_lock);
+        running = 0;
+        pthread_mutex_unlock(&stage_lock);
+        close(fd);
+        fd = -1;
+        return -1;
+    }
+    pthread_attr_destroy(&attr);
+    started = 1;
+
+    log_info("[BLACKBOX] %s: next record #%llu, %u ms group commit, up to %u files of %u KB\n",
+             BLACKBOX_PATH, (unsigned long long)next_seq, config.commit_ms,
+             config.files + 1, config.file_kb);
+    return 0;
+}
+
+void blackbox_stop(void)
+{
+    if (!started)
+        return;
+
+    pthread_mutex_lock(&stage_lock);
+    running = 0;
+    pthread_cond_signal(&stage_cond);
+    pthread_mutex_unlock(&stage_lock);
+    pthread_join(committer, NULL);
+    started = 0;
+
+    pthread_mutex_lock(&io_lock);
+    close(fd);
+    fd = -1;
+    for (unsigned i = 0; i <= BLACKBOX_MAX_FILES; i++)
+        index_reset(&file_index[i]);
+    pthread_mutex_unlock(&io_lock);
+    free(stage[0]);
+    free(stage[1]);
+    stage[0] = stage[1] = NULL;
+}
+
+void blackbox_log(BlackboxKind kind, const char *unit, int64_t t_ms, const char *fmt, ...)
+{
+    char text[BLACKBOX_TEXT_MAX + 1];
+    BlackboxRecord r;
+    va_list ap;
+    size_t unit_len = unit ? strnlen(unit, BLACKBOX_UNIT_MAX) : 0;
+
+    va_start(ap, fmt);
+    int n = vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+
+    // Stored without the line break; the reader renders lines
+    size_t text_len = n < 0 ? 0 : (size_t)n > BLACKBOX_TEXT_MAX ? BLACKBOX_TEXT_MAX : (size_t)n;
+    while (text_len > 0 && text[text_len - 1] == '\n')
+        text_len--;
+
+    memset(&r, 0, sizeof(r));
+    r.length = (uint32_t)((sizeof(r) + unit_len + text_len + BB_ALIGN - 1) & ~(size_t)(BB_ALIGN - 1));
+    r.t_ms = t_ms ? t_ms : wall_ms();
+    r.text_len = (uint16_t)text_len;
+    r.unit_len = (uint8_t)unit_len;
+    r.kind = (uint8_t)kind;
+
+    pthread_mutex_lock(&stage_lock);
+    if (!running || stage_len + r.length > BB_STAGE_BYTES) {
+        dropped++;
+        pthread_mutex_unlock(&stage_lock);
+        return;
+    }
+
+    uint8_t *p = stage[stage_idx] + stage_len;
+    r.seq = next_seq++;
+    memcpy(p, &r, sizeof(r));
+    if (unit_len)
+        memcpy(p + sizeof(r), unit, unit_len);
+    memcpy(p + sizeof(r) + unit_len, text, text_len);
+    memset(p + sizeof(r) + unit_len + text_len, 0, r.length - sizeof(r) - unit_len - text_len);
+    r.crc = file_crc32(p + BB_CRC_SKIP, r.length - BB_CRC_SKIP);
+    memcpy(p + offsetof(BlackboxRecord, crc), &r.crc, sizeof(r.crc));
+
+    stage_len += r.length;
+    if (stage_len >= BB_STAGE_BYTES / 2)
+        pthread_cond_signal(&stage_cond);
+    pthread_mutex_unlock(&stage_lock);
+}
+
+uint64_t blackbox_request_sync(void)
+{
+    pthread_mutex_lock(&stage_lock);
+    uint64_t target = next_seq - 1;
+    if (running && committed_seq < target) {
+        sync_requested = 1;
+        pthread_cond_signal(&stage_cond);
+    }
+    pthread_mutex_unlock(&stage_lock);
+    return target;
+}
+
+int blackbox_wait(uint64_t after_seq, int timeout_ms, uint64_t *committed)
+{
+    struct timespec deadline;
+    int rc;
+
+    deadline_in(&deadline, timeout_ms);
+    pthread_mutex_lock(&stage_lock);
+    while (running && committed_seq <= after_seq) {
+        if (pthread_cond_timedwait(&commit_cond, &stage_lock, &deadline) == ETIMEDOUT)
+            break;
+    }
+    rc = !running ? -1 : committed_seq > after_seq;
+    if (committed)
+        *committed = committed_seq;
+    pthread_mutex_unlock(&stage_lock);
+    return rc;
+}
+
+int blackbox_watch(int fd)
+{
+    int rc = -1;
+
+    pthread_mutex_lock(&stage_lock);
+    if (watch_count < BLACKBOX_WATCH_MAX) {
+        watch_fd[watch_count++] = fd;
+        rc = 0;
+    }
+    pthread_mutex_unlock(&stage_lock);
+    return rc;
+}
+
+static int block_may_match(const IndexBlock *b, const BlackboxQuery *q, int64_t to_ms,
+                           uint64_t unit_sig)
+{
+    return b->last_seq > q->after_seq &&
+           b->max_ms >= q->from_ms && b->min_ms <= to_ms &&
+           (!q->kinds || (b->kinds & q->kinds)) &&
+           (!unit_sig || (b->units & unit_sig));
+}
+
+long blackbox_query(const BlackboxQuery *q, BlackboxVisitor fn, void *arg,
+                    BlackboxQueryStats *stats)
+{
+    struct {
+        int fd;
+        IndexBlock *blocks;
+        int count;
+    } files[BLACKBOX_MAX_FILES + 1];
+    int nfiles = 0, stop = 0;
+    long matched = 0, blocks = 0, blocks_read = 0, records_read = 0;
+    int64_t to_ms = q->to_ms ? q->to_ms : INT64_MAX;
+    size_t unit_len = q->unit ? strlen(q->unit) : 0;
+    uint64_t unit_sig = q->unit ? unit_bit(q->unit, unit_len) : 0;
+
+
+    // Open the files and copy the candidate blocks, oldest file first. A
+    // later rotation or clear renames or replaces paths; the open files
+    // and the bytes their blocks describe stay as they are.
+    pthread_mutex_lock(&io_lock);
+    for (int i = BLACKBOX_MAX_FILES; i >= 0; i--) {
+        const FileIndex *fi = &file_index[i];
+        char path[BB_PATH_MAX];
+        IndexBlock *sel;
+        int n = 0;
+
+        blocks += fi->count;
+        if (fi->count == 0 || (sel = malloc((size_t)fi->count * sizeof(IndexBlock))) == NULL)
+            continue;
+        for (int b = 0; b < fi->count; b++)
+            if (block_may_match(&fi->blocks[b], q, to_ms, unit_sig))
+                sel[n++] = fi->blocks[b];
+
+        if (i == 0)
+            snprintf(path, sizeof(path), "%s", BLACKBOX_PATH);
+        else
+            rotated_path(path, (unsigned)i);
+        int f = n > 0 ? open(path, O_RDONLY) : -1;
+        if (f < 0) {
+            free(sel);
+            continue;
+        }
+        files[nfiles].fd = f;
+        files[nfiles].blocks = sel;
+        files[nfiles].count = n;
+        nfiles++;
+    }
+    pthread_mutex_unlock(&io_lock);
+
+    for (int i = 0; i < nfiles; i++) {
+        size_t size = 0;
+        const uint8_t *base = stop ? NULL : map_file(files[i].fd, &size);
+
+        for (int b = 0; base && !stop && b < files[i].count; b++) {
+            const IndexBlock *blk = &files[i].blocks[b];
+            size_t off = blk->off;
+            BlackboxRecord r;
+
+            blocks_read++;
+            while (off < blk->end && record_at(base, size, off, &r)) {
+                const char *unit = (const char *)base + off + sizeof(r);
+
+                records_read++;
+                if (r.seq > q->after_seq && r.t_ms >= q->from_ms && r.t_ms <= to_ms &&
+                    (!q->kinds || (q->kinds & (1u << (r.kind & 31u)))) &&
+                    (!q->unit || (r.unit_len == unit_len && memcmp(unit, q->unit, unit_len) == 0))) {
+                    BlackboxEntry e = {
+                        .seq = r.seq, .t_ms = r.t_ms, .kind = (BlackboxKind)r.kind,
+                        .unit = unit, .unit_len = r.unit_len,
+                        .text = unit + r.unit_len, .text_len = r.text_len,
+                    };
+                    matched++;
+                    if (fn(arg, &e)) {
+                        stop = 1;
+                        break;
+                    }
+                }
+                off += r.length;
+            }
+        }
+
+        if (base)
+            munmap((void *)base, size);
+        close(files[i].fd);
+        free(files[i].blocks);
+    }
+
+    if (stats) {
+        stats->blocks = blocks;
+        stats->blocks_read = blocks_read;
+        stats->records_read = records_read;
+    }
+    return matched;
+}
+
+uint64_t blackbox_request_clear(void)
+{
+    uint64_t ticket = 0;
+
+    pthread_mutex_lock(&stage_lock);
+    if (running) {
+        ticket = ++clear_requested;
+        pthread_cond_signal(&stage_cond);
+    }
+    pthread_mutex_unlock(&stage_lock);
+    return ticket;
+}
+
+int blackbox_clear_wait(uint64_t ticket, int timeout_ms)
+{
+    struct timespec deadline;
+    int rc;
+
+    if (ticket == 0)
+        return -1;
+    deadline_in(&deadline, timeout_ms);
+    pthread_mutex_lock(&stage_lock);
+    while (running && clear_done < ticket) {
+        if (pthread_cond_timedwait(&commit_cond, &stage_lock, &deadline) == ETIMEDOUT)
+            break;
+    }
+    // A later clear done in the same pass also empties the log
+    if (clear_done >= ticket)
+        rc = clear_failed ? -1 : 1;
+    else
+        rc = running ? 0 : -1;
+    pthread_mutex_unlock(&stage_lock);
+    return rc;
+}
+
+uint64_t blackbox_dropped(void)
+{
+    pthread_mutex_lock(&stage_lock);
+    uint64_t n = dropped;
+    pthread_mutex_unlock(&stage_lock);
+    return n;
+}
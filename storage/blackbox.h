@@ -0,0 +1,215 @@
+#ifndef BLACKBOX_H
+#define BLACKBOX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================
+// BINARY BLACKBOX (group-committed, size-capped)
+// ============================================================
+//
+// The event audit trail: critical alerts and operator events as binary,
+// length-prefixed records with a CRC-32 each, in a preallocated file.
+//
+//   file   = BlackboxFileHeader | record | record | ... | zeros
+//   record = BlackboxRecord | unit | text | zero padding to 8 bytes
+//
+// blackbox_log only formats and copies the record into a staging buffer
+// under a short lock; it never touches the file. A low-priority committer
+// thread writes everything staged with one pwrite and one fdatasync every
+// commit_ms (sooner when the buffer is half full), so a burst of alerts
+// costs one flash write, not one per alert. When the active file is full
+// it is renamed to blackbox.1.bin (older ones shift up, the oldest kept
+// file is dropped) and a fresh preallocated file takes its place: disk
+// use is bounded by (files + 1) * file_kb.
+//
+// A record torn by a power cut fails its CRC; readers and the next start
+// stop at it, so only the last batch can be lost. Sequence numbers keep
+// counting across rotations and restarts. Text is rendered on demand by
+// the reader (get_log); live readers (follow_log) sleep in blackbox_wait
+// until the committer announces a write, or have it written to a watch
+// fd (blackbox_watch) from an event loop, then query past their cursor.
+//
+// Alongside the files the committer keeps a sparse in-memory index: one
+// entry per BLACKBOX_INDEX_RECORDS records with their offset, sequence
+// and time range, a 64-bit unit signature and the kinds present. It is
+// rebuilt from the files at start. Queries use it to visit only blocks
+// that can hold a match, so a filtered page of a full log reads a few
+// pages of the mapping instead of every record.
+
+#define BLACKBOX_CONFIG     "config/blackbox.conf"
+#define BLACKBOX_PATH       "blackbox.bin"      // active file
+#define BLACKBOX_ROTATED    "blackbox.%u.bin"   // 1 = newest rotated file
+#define BLACKBOX_UNIT_MAX   63
+#define BLACKBOX_TEXT_MAX   255
+#define BLACKBOX_MAX_FILES  16
+#define BLACKBOX_INDEX_RECORDS 64
+#define BLACKBOX_WATCH_MAX  8
+
+typedef enum {
+    BLACKBOX_ALERT = 1,   // a unit in CRITICAL state
+    BLACKBOX_EVENT        // everything else worth an audit line
+} BlackboxKind;
+
+/**
+ * BlackboxConfig: Parsed config/blackbox.conf.
+ */
+typedef struct {
+    uint32_t commit_ms;   // group-commit interval
+    uint32_t file_kb;     // preallocated size of each file
+    uint32_t files;       // rotated files kept besides the active one
+} BlackboxConfig;
+
+/**
+ * BlackboxFileHeader: Start of every blackbox file.
+ */
+typedef struct {
+    char magic[4];        // "BBOX"
+    uint32_t version;
+    uint64_t created_ms;
+    uint64_t reserved[2];
+} BlackboxFileHeader;
+
+/**
+ * BlackboxRecord: Precedes each record's unit and text.
+ */
+typedef struct {
+    uint32_t length;      // whole record incl. padding; 0 = free space
+    uint32_t crc;         // CRC-32 of the record after this field
+    uint64_t seq;
+    int64_t t_ms;         // Unix time
+    uint16_t text_len;
+    uint8_t unit_len;
+    uint8_t kind;         // BlackboxKind
+    uint32_t reserved;
+} BlackboxRecord;
+
+/**
+ * BlackboxEntry: One decoded record handed to a BlackboxVisitor. unit
+ * and text are not NUL-terminated and only valid during the call.
+ */
+typedef struct {
+    uint64_t seq;
+    int64_t t_ms;
+    BlackboxKind kind;
+    const char *unit;
+    int unit_len;
+    const char *text;
+    int text_len;
+} BlackboxEntry;
+
+/**
+ * BlackboxVisitor: Called by blackbox_query for each matching record,
+ * oldest first. Return non-zero to stop the query.
+ */
+typedef int (*BlackboxVisitor)(void *arg, const BlackboxEntry *e);
+
+/**
+ * BlackboxQuery: Record filter. Zero-initialise, then narrow: a zero
+ * to_ms means no upper bound, a NULL unit any unit, zero kinds any kind.
+ */
+typedef struct {
+    int64_t from_ms;      // Unix ms, inclusive
+    int64_t to_ms;        // Unix ms, inclusive (0 = no limit)
+    const char *unit;
+    uint32_t kinds;       // mask of 1u << BlackboxKind
+    uint64_t after_seq;   // resume cursor: only records with a larger seq
+} BlackboxQuery;
+
+/**
+ * BlackboxQueryStats: How much of the log a query had to read.
+ */
+typedef struct {
+    long blocks;          // index blocks in the log
+    long blocks_read;     // blocks that could match and were decoded
+    long records_read;    // records decoded (matching or not)
+} BlackboxQueryStats;
+
+/**
+ * blackbox_load_config: Fills cfg with the defaults (1000 ms commits,
+ * 1024 KB files, 3 rotated files), then applies path. A missing file
+ * keeps the defaults. Returns 0, or -1 after logging a bad line (the
+ * remaining lines are still applied).
+ */
+int blackbox_load_config(const char *path, BlackboxConfig *cfg);
+
+/**
+ * blackbox_start: Opens (creating and preallocating if needed) the
+ * active file, recovers its end after a crash and starts the committer.
+ * Returns 0, or -1 if the file cannot be used (records are then dropped).
+ */
+int blackbox_start(const BlackboxConfig *cfg);
+
+/**
+ * blackbox_stop: Commits what is staged and joins the committer.
+ * Safe to call more than once (e.g. from atexit).
+ */
+void blackbox_stop(void);
+
+/**
+ * blackbox_log: Stages one record. t_ms = 0 stamps the current time.
+ * unit may be NULL or empty. Never blocks on I/O; the record is dropped
+ * (and counted) if the blackbox is not running or the staging buffer is
+ * full. Not for the RT loop (formats with vsnprintf).
+ */
+void blackbox_log(BlackboxKind kind, const char *unit, int64_t t_ms, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+/**
+ * blackbox_request_sync: Asks the committer to write what is staged now
+ * instead of at the end of its interval, without waiting. Returns the
+ * sequence number of the last record staged: once blackbox_wait reports
+ * it committed, everything staged before the call is on disk. For
+ * readers, never the alert path.
+ */
+uint64_t blackbox_request_sync(void);
+
+/**
+ * blackbox_wait: Sleeps until records after after_seq have been committed
+ * (the committer broadcasts after every write) or timeout_ms passes.
+ * committed, if not NULL, gets the last committed sequence number.
+ * Returns 1 if there are new records, 0 on timeout, -1 if the blackbox is
+ * not running.
+ */
+int blackbox_wait(uint64_t after_seq, int timeout_ms, uint64_t *committed);
+
+/**
+ * blackbox_watch: Registers fd (a non-blocking eventfd or pipe) to be
+ * written 8 bytes after every commit, for event loops that cannot sleep
+ * in blackbox_wait. At most BLACKBOX_WATCH_MAX, kept for the life of the
+ * process. Returns 0, or -1 if the table is full.
+ */
+int blackbox_watch(int fd);
+
+/**
+ * blackbox_query: Visits the committed records matching q, oldest first.
+ * Only the index blocks that can hold a match are decoded, through mmap.
+ * Safe while the committer writes and rotates. stats may be NULL.
+ * Returns the number of records passed to fn.
+ */
+long blackbox_query(const BlackboxQuery *q, BlackboxVisitor fn, void *arg,
+                    BlackboxQueryStats *stats);
+
+/**
+ * blackbox_request_clear: Asks the committer to drop the staged records,
+ * delete the rotated files and empty the active one, without waiting for
+ * the file work. Sequence numbers keep counting. Returns a ticket for
+ * blackbox_clear_wait, or 0 if the blackbox is not running.
+ */
+uint64_t blackbox_request_clear(void);
+
+/**
+ * blackbox_clear_wait: Sleeps until the clear with that ticket is done or
+ * timeout_ms passes (0 = just check); the watch fds are written too.
+ * Returns 1 once it is done, 0 if it is still pending, -1 if it failed
+ * or the blackbox is not running.
+ */
+int blackbox_clear_wait(uint64_t ticket, int timeout_ms);
+
+/**
+ * blackbox_dropped: Records lost to a full staging buffer, or logged
+ * while the blackbox was not running, since startup.
+ */
+uint64_t blackbox_dropped(void);
+
+#endif // BLACKBOX_H
@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "checkpoint.h"
+#include "file_util.h"
+
+#define CKPT_MAGIC    "CKPT"
+#define CKPT_VERSION  1
+#define CKPT_PATH_MAX 512
+#define CKPT_LOAD_MAX (64u << 20)   // refuse anything larger than this
+
+#define CKPT_PAD(n) (((n) + 7u) & ~(size_t)7u)
+
+struct Checkpoint {
+    uint8_t *buf;         // CheckpointHeader, then the sections
+    size_t len;
+    size_t cap;
+    uint32_t sections;
+};
+
+// ============================================================
+// BUILDING
+// ============================================================
+
+Checkpoint* checkpoint_create(void)
+{
+    Checkpoint *cp = calloc(1, sizeof(Checkpoint));
+
+    if (!cp)
+        return NULL;
+    cp->cap = 64 * 1024;
+    cp->buf = malloc(cp->cap);
+    if (!cp->buf) {
+        free(cp);
+        return NULL;
+    }
+    checkpoint_reset(cp);
+    return cp;
+}
+
+void checkpoint_destroy(Checkpoint *cp)
+{
+    if (!cp)
+        return;
+    free(cp->buf);
+    free(cp);
+}
+
+void checkpoint_reset(Checkpoint *cp)
+{
+    memset(cp->buf, 0, sizeof(CheckpointHeader));
+    cp->len = sizeof(CheckpointHeader);
+    cp->sections = 0;
+}
+
+void* checkpoint_reserve(Checkpoint *cp, uint32_t tag, const char *key, size_t len)
+{
+    size_t need = sizeof(CheckpointSection) + CKPT_PAD(len);
+    CheckpointSection sec;
+
+    if (len > UINT32_MAX)
+        return NULL;
+    if (cp->len + need > cp->cap) {
+        size_t cap = cp->cap;
+        while (cp->len + need > cap)
+            cap *= 2;
+        uint8_t *grown = realloc(cp->buf, cap);
+        if (!grown)
+            return NULL;
+        cp->buf = grown;
+        cp->cap = cap;
+    }
+
+    memset(&sec, 0, sizeof(sec));
+    sec.tag = tag;
+    sec.length = (uint32_t)len;
+    snprintf(sec.key, sizeof(sec.key), "%s", key ? key : "");
+
+    uint8_t *p = cp->buf + cp->len;
+    memcpy(p, &sec, sizeof(sec));
+    memset(p + sizeof(sec), 0, CKPT_PAD(len));
+    cp->len += need;
+    cp->sections++;
+    return p + sizeof(sec);
+}
+
+int checkpoint_add(Checkpoint *cp, uint32_t tag, const char *key, const void *data, size_t len)
+{
+    void *p = checkpoint_reserve(cp, tag, key, len);
+
+    if (!p)
+        return -1;
+    if (len)
+        memcpy(p, data, len);
+    return 0;
+}
+
+// ============================================================
+// COMMIT
+// ============================================================
+
+// Directory part of path ("." if none)
+static void dir_of(const char *path, char *dir, size_t dir_len)
+{
+    const char *slash = strrchr(path, '/');
+
+    if (!slash)
+        snprintf(dir, dir_len, ".");
+    else
+        snprintf(dir, dir_len, "%.*s", (int)(slash - path), path);
+}
+
+long checkpoint_commit(Checkpoint *cp, const char *path, char *err, size_t err_len)
+{
+    char tmp[CKPT_PATH_MAX];
+    char dir[CKPT_PATH_MAX];
+    CheckpointHeader h;
+    struct timespec now;
+    int fd;
+
+    dir_of(path, dir, sizeof(dir));
+    if (file_make_dirs(dir) != 0) {
+        snprintf(err, err_len, "cannot create %s: %s", dir, strerror(errno));
+        return -1;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CKPT_MAGIC, 4);
+    h.version = CKPT_VERSION;
+    h.created_ms = (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    h.length = cp->len - sizeof(h);
+    h.sections = cp->sections;
+    h.crc = file_crc32(cp->buf + sizeof(h), cp->len - sizeof(h));
+    memcpy(cp->buf, &h, sizeof(h));
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        snprintf(err, err_len, "cannot create %s: %s", tmp, strerror(errno));
+        return -1;
+    }
+    if (file_write_all(fd, cp->buf, cp->len) != 0 || fdatasync(fd) != 0) {
+        snprintf(err, err_len, "cannot write %s: %s", tmp, strerror(errno));
+        close(fd);
+        unlink(tmp);
+        return -1;
+    }
+    close(fd);
+
+    if (rename(tmp, path) != 0) {
+        snprintf(err, err_len, "cannot rename %s: %s", tmp, strerror(errno));
+        unlink(tmp);
+        return -1;
+    }
+
+    // Make the rename itself durable
+    fd = open(dir, O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+    return (long)cp->len;
+}
+
+// ============================================================
+// LOADING
+// ============================================================
+
+int checkpoint_load(const char *path, CheckpointVisitor fn, void *arg,
+                    int64_t *created_ms, char *err, size_t err_len)
+{
+    CheckpointHeader h;
+    struct stat st;
+    uint8_t *body;
+    int fd, visited = 0;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT)
+            return 0;
+        snprintf(err, err_len, "cannot open %s: %s", path, strerror(errno));
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(h) || st.st_size > (off_t)CKPT_LOAD_MAX ||
+        read(fd, &h, sizeof(h)) != (ssize_t)sizeof(h) ||
+        memcmp(h.magic, CKPT_MAGIC, 4) != 0 || h.version != CKPT_VERSION ||
+        h.length != (uint64_t)st.st_size - sizeof(h)) {
+        snprintf(err, err_len, "%s is not a checkpoint (or a truncated one)", path);
+        close(fd);
+        return -1;
+    }
+
+    body = malloc(h.length ? h.length : 1);
+    if (!body) {
+        snprintf(err, err_len, "out of memory reading %s", path);
+        close(fd);
+        return -1;
+    }
+    size_t got = 0;
+    while (got < h.length) {
+        ssize_t n = read(fd, body + got, h.length - got);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        got += (size_t)n;
+    }
+    close(fd);
+
+    if (got != h.length || file_crc32(body, h.length) != h.crc) {
+        snprintf(err, err_len, "%s fails its checksum", path);
+        free(body);
+        return -1;
+    }
+
+    if (created_ms)
+        *created_ms = h.created_ms;
+
+    // The CRC matched, so section bounds only need checking against bugs
+    for (size_t off = 0; off + sizeof(CheckpointSection) <= h.length; ) {
+        CheckpointSection sec;
+        memcpy(&sec, body + off, sizeof(sec));
+        off += sizeof(sec);
+        if (sec.length > h.length - off)
+            break;
+        sec.key[CHECKPOINT_KEY_MAX - 1] = '\0';
+        visited++;
+        if (fn(arg, sec.tag, sec.key, body + off, sec.length))
+            break;
+        off += CKPT_PAD((size_t)sec.length);
+    }
+
+    free(body);
+    return visited;
+}
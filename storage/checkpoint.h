@@ -0,0 +1,103 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================
+// STATE CHECKPOINTS (write-temp-then-rename)
+// ============================================================
+//
+// A checkpoint is one file of tagged, keyed binary sections, built in
+// memory and replaced whole:
+//
+//   file    = CheckpointHeader | section | section | ...
+//   section = CheckpointSection | payload | zero padding to 8 bytes
+//
+// checkpoint_commit writes <path>.tmp, fdatasyncs it, renames it over
+// path and syncs the directory, so after a crash path holds either the
+// previous checkpoint or the new one, never a mix. The header carries a
+// CRC-32 of everything after it; a file that fails it is ignored as a
+// whole. Section payloads are raw structs in host byte order; readers
+// check each length and skip tags they do not know.
+//
+// Nothing here is RT-safe: build and commit on an ordinary thread.
+
+#define CHECKPOINT_KEY_MAX 32   // key incl. NUL (a unit id)
+
+/**
+ * CheckpointHeader: Start of every checkpoint file.
+ */
+typedef struct {
+    char magic[4];        // "CKPT"
+    uint32_t version;
+    int64_t created_ms;   // Unix time of the commit
+    uint64_t length;      // bytes after the header
+    uint32_t sections;
+    uint32_t crc;         // CRC-32 of the bytes after the header
+} CheckpointHeader;
+
+/**
+ * CheckpointSection: Precedes each section's payload.
+ */
+typedef struct {
+    uint32_t tag;         // what the payload is (defined by the caller)
+    uint32_t length;      // payload bytes, without padding
+    char key[CHECKPOINT_KEY_MAX];   // whose it is ("" = global)
+} CheckpointSection;
+
+typedef struct Checkpoint Checkpoint;
+
+/**
+ * CheckpointVisitor: Called by checkpoint_load for each section, in file
+ * order. data is only valid during the call. Return non-zero to stop.
+ */
+typedef int (*CheckpointVisitor)(void *arg, uint32_t tag, const char *key,
+                                 const void *data, size_t len);
+
+/**
+ * checkpoint_create: Empty in-memory checkpoint; its buffer grows as
+ * sections are added and is kept across checkpoint_reset.
+ * Returns NULL on allocation failure.
+ */
+Checkpoint* checkpoint_create(void);
+void checkpoint_destroy(Checkpoint *cp);
+
+/**
+ * checkpoint_reset: Drops every section, keeping the buffer.
+ */
+void checkpoint_reset(Checkpoint *cp);
+
+/**
+ * checkpoint_reserve: Appends a section of len bytes and returns its
+ * payload for the caller to fill (zeroed), or NULL if out of memory.
+ * The pointer is valid until the next reserve/add.
+ */
+void* checkpoint_reserve(Checkpoint *cp, uint32_t tag, const char *key, size_t len);
+
+/**
+ * checkpoint_add: Appends a copy of data as one section.
+ * Returns 0, or -1 if out of memory.
+ */
+int checkpoint_add(Checkpoint *cp, uint32_t tag, const char *key, const void *data, size_t len);
+
+/**
+ * checkpoint_commit: Atomically replaces path with the sections added so
+ * far (see above), creating its directory if needed.
+ * Returns the bytes written, or -1 with the reason in err (path is
+ * then untouched).
+ */
+long checkpoint_commit(Checkpoint *cp, const char *path, char *err, size_t err_len);
+
+/**
+ * checkpoint_load: Reads and verifies path, then visits its sections.
+ * created_ms, if not NULL, gets the commit time before the first
+ * section is visited.
+ * Returns the number of sections visited, 0 if there is no checkpoint,
+ * or -1 with the reason in err if the file is unreadable or corrupt
+ * (nothing is visited then).
+ */
+int checkpoint_load(const char *path, CheckpointVisitor fn, void *arg,
+                    int64_t *created_ms, char *err, size_t err_len);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,36 @@
+#ifndef FILE_UTIL_H
+#define FILE_UTIL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================
+// STORAGE FILE HELPERS
+// ============================================================
+//
+// The small pieces every on-disk format here needs: the CRC-32 that
+// guards blackbox records and checkpoints, a write that survives short
+// writes and EINTR, and mkdir -p for data directories.
+
+#define FILE_PATH_MAX 512
+
+/**
+ * file_crc32: CRC-32 (IEEE 802.3, as zlib and gzip) of len bytes.
+ * Thread-safe; the table is built on first use.
+ */
+uint32_t file_crc32(const void *data, size_t len);
+
+/**
+ * file_write_all: Writes all len bytes at the file position, retrying
+ * short writes and EINTR. Returns 0, or -1 with errno set.
+ */
+int file_write_all(int fd, const void *buf, size_t len);
+
+/**
+ * file_make_dirs: Creates dir and any missing parents (mode 0755), like
+ * mkdir -p. Returns 0, or -1 with errno set (ENAMETOOLONG if dir is
+ * FILE_PATH_MAX or longer).
+ */
+int file_make_dirs(const char *dir);
+
+#endif // FILE_UTIL_H
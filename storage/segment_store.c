@@ -0,0 +1,631 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "segment_store.h"
+#include "file_util.h"
+
+#define SEG_MAGIC    "GSEG"
+#define SEG_VERSION  1
+#define SEG_SUFFIX   ".seg"
+#define SEG_PATH_MAX 512
+
+// Worst-case encoded size: the first record of a block is stored raw,
+// later ones need at most 4+32 bits of timestamp and 2+5+5+32 per value
+#define SEG_TS_MAX_BITS    36
+#define SEG_VALUE_MAX_BITS 44
+#define SEG_BLOCK_CAP(columns) \
+    (sizeof(SegBlockHeader) + \
+     ((size_t)SEGSTORE_BLOCK_RECORDS * (SEG_TS_MAX_BITS + SEG_VALUE_MAX_BITS * (size_t)(columns)) + 64) / 8 + 8)
+
+// ============================================================
+// BIT STREAMS
+// ============================================================
+
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    uint64_t acc;
+    int nacc;             // bits in acc not yet written (< 8 between calls)
+} BitWriter;
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint64_t acc;
+    int nacc;
+} BitReader;
+
+// Appends the low n bits of v (n <= 32), most significant first
+static inline void bw_put(BitWriter *w, uint64_t v, int n)
+{
+    w->acc = (w->acc << n) | (v & ((1ULL << n) - 1));
+    w->nacc += n;
+    while (w->nacc >= 8) {
+        w->nacc -= 8;
+        w->buf[w->len++] = (uint8_t)(w->acc >> w->nacc);
+    }
+}
+
+static inline void bw_finish(BitWriter *w)
+{
+    if (w->nacc > 0)
+        w->buf[w->len++] = (uint8_t)(w->acc << (8 - w->nacc));
+    w->nacc = 0;
+}
+
+// Reads n bits (n <= 32); past the end reads zeros
+static inline uint64_t br_get(BitReader *r, int n)
+{
+    while (r->nacc < n) {
+        r->acc = (r->acc << 8) | (r->p < r->end ? *r->p++ : 0u);
+        r->nacc += 8;
+    }
+    r->nacc -= n;
+    return (r->acc >> r->nacc) & ((1ULL << n) - 1);
+}
+
+static inline int64_t sign_extend(uint64_t v, int n)
+{
+    return (int64_t)(v << (64 - n)) >> (64 - n);
+}
+
+static uint32_t fnv1a(const uint8_t *p, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+// ============================================================
+// GORILLA CODEC
+// ============================================================
+
+/**
+ * CoderState: Per-block state shared by the encoder and the decoder.
+ * lead/trail describe the bit window of the last explicit XOR of each
+ * column (lead 0xff = none yet).
+ */
+typedef struct {
+    uint32_t records;
+    int64_t prev_t;
+    int64_t prev_delta;
+    uint32_t prev[SEGSTORE_MAX_COLUMNS];
+    uint8_t lead[SEGSTORE_MAX_COLUMNS];
+    uint8_t trail[SEGSTORE_MAX_COLUMNS];
+} CoderState;
+
+static inline uint32_t float_bits(float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static inline float bits_float(uint32_t u)
+{
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static void encode_record(BitWriter *w, CoderState *cs, int columns,
+                          int64_t t, const float *values)
+{
+    if (cs->records == 0) {
+        bw_put(w, (uint64_t)t >> 32, 32);
+        bw_put(w, (uint64_t)t, 32);
+        cs->prev_delta = 0;
+    } else {
+        // Delta-of-delta: '0' | '10'+7 | '110'+9 | '1110'+12 | '1111'+32
+        int64_t delta = t - cs->prev_t;
+        int64_t dod = delta - cs->prev_delta;
+
+        if (dod == 0) {
+            bw_put(w, 0x0, 1);
+        } else if (dod >= -64 && dod < 64) {
+            bw_put(w, 0x2, 2);
+            bw_put(w, (uint64_t)dod, 7);
+        } else if (dod >= -256 && dod < 256) {
+            bw_put(w, 0x6, 3);
+            bw_put(w, (uint64_t)dod, 9);
+        } else if (dod >= -2048 && dod < 2048) {
+            bw_put(w, 0xe, 4);
+            bw_put(w, (uint64_t)dod, 12);
+        } else {
+            bw_put(w, 0xf, 4);
+            bw_put(w, (uint64_t)dod, 32);   // |dod| < 2 segment spans
+        }
+        cs->prev_delta = delta;
+    }
+    cs->prev_t = t;
+
+    for (int c = 0; c < columns; c++) {
+        uint32_t bits = float_bits(values[c]);
+
+        if (cs->records == 0) {
+            bw_put(w, bits, 32);
+            cs->lead[c] = 0xff;
+        } else {
+            // XOR: '0' same value | '10' inside the previous window | '11'+lead+len
+            uint32_t x = bits ^ cs->prev[c];
+            if (x == 0) {
+                bw_put(w, 0x0, 1);
+            } else {
+                int lead = __builtin_clz(x);
+                int trail = __builtin_ctz(x);
+
+                if (cs->lead[c] != 0xff && lead >= cs->lead[c] && trail >= cs->trail[c]) {
+                    bw_put(w, 0x2, 2);
+                    bw_put(w, x >> cs->trail[c], 32 - cs->lead[c] - cs->trail[c]);
+                } else {
+                    int sig = 32 - lead - trail;
+                    bw_put(w, 0x3, 2);
+                    bw_put(w, (uint64_t)lead, 5);
+                    bw_put(w, (uint64_t)(sig - 1), 5);
+                    bw_put(w, x >> trail, sig);
+                    cs->lead[c] = (uint8_t)lead;
+                    cs->trail[c] = (uint8_t)trail;
+                }
+            }
+        }
+        cs->prev[c] = bits;
+    }
+    cs->records++;
+}
+
+static void decode_record(BitReader *r, CoderState *cs, int columns, int64_t *t, float *values)
+{
+    if (cs->records == 0) {
+        uint64_t hi = br_get(r, 32);
+        cs->prev_t = (int64_t)((hi << 32) | br_get(r, 32));
+        cs->prev_delta = 0;
+    } else {
+        int64_t dod;
+        if (br_get(r, 1) == 0)
+            dod = 0;
+        else if (br_get(r, 1) == 0)
+            dod = sign_extend(br_get(r, 7), 7);
+        else if (br_get(r, 1) == 0)
+            dod = sign_extend(br_get(r, 9), 9);
+        else if (br_get(r, 1) == 0)
+            dod = sign_extend(br_get(r, 12), 12);
+        else
+            dod = sign_extend(br_get(r, 32), 32);
+        cs->prev_delta += dod;
+        cs->prev_t += cs->prev_delta;
+    }
+    *t = cs->prev_t;
+
+    for (int c = 0; c < columns; c++) {
+        if (cs->records == 0) {
+            cs->prev[c] = (uint32_t)br_get(r, 32);
+            cs->lead[c] = 0xff;
+        } else if (br_get(r, 1) != 0) {
+            uint32_t x;
+            if (br_get(r, 1) == 0) {
+                int sig = 32 - cs->lead[c] - cs->trail[c];
+                x = (uint32_t)br_get(r, sig) << cs->trail[c];
+            } else {
+                int lead = (int)br_get(r, 5);
+                int sig = (int)br_get(r, 5) + 1;
+                int trail = 32 - lead - sig;
+                x = (uint32_t)br_get(r, sig) << trail;
+                cs->lead[c] = (uint8_t)lead;
+                cs->trail[c] = (uint8_t)trail;
+            }
+            cs->prev[c] ^= x;
+        }
+        values[c] = bits_float(cs->prev[c]);
+    }
+    cs->records++;
+}
+
+/**
+ * block_at: Copies the header of the block at off of a file mapped at
+ * base (blocks are not aligned). Returns 0 if no complete, intact block
+ * starts there (end of data or a torn tail).
+ */
+static int block_at(const uint8_t *base, size_t size, size_t off, SegBlockHeader *bh)
+{
+    if (off + sizeof(SegBlockHeader) > size)
+        return 0;
+    memcpy(bh, base + off, sizeof(*bh));
+    return bh->records > 0 && bh->records <= SEGSTORE_BLOCK_RECORDS &&
+           bh->bytes <= size - off - sizeof(SegBlockHeader) &&
+           fnv1a(base + off + sizeof(SegBlockHeader), bh->bytes) == bh->checksum;
+}
+
+// ============================================================
+// SEGMENT FILES
+// ============================================================
+
+static int is_segment_name(const struct dirent *de)
+{
+    size_t len = strlen(de->d_name);
+    return len > strlen(SEG_SUFFIX) && de->d_name[0] != '.' &&
+           strcmp(de->d_name + len - strlen(SEG_SUFFIX), SEG_SUFFIX) == 0;
+}
+
+// Segment names sort by time: zero-padded first timestamp
+static int list_segments(const char *dir, struct dirent ***names)
+{
+    return scandir(dir, names, is_segment_name, alphasort);
+}
+
+static void free_list(struct dirent **names, int n)
+{
+    for (int i = 0; i < n; i++)
+        free(names[i]);
+    free(names);
+}
+
+static int header_valid(const SegHeader *h)
+{
+    return memcmp(h->magic, SEG_MAGIC, 4) == 0 && h->version == SEG_VERSION &&
+           h->columns >= 1 && h->columns <= SEGSTORE_MAX_COLUMNS;
+}
+
+static void header_add(SegHeader *h, int64_t t, const float *values)
+{
+    if (h->records == 0)
+        h->first_ms = t;
+    for (int c = 0; c < h->columns; c++) {
+        if (h->records == 0 || values[c] < h->min[c]) h->min[c] = values[c];
+        if (h->records == 0 || values[c] > h->max[c]) h->max[c] = values[c];
+    }
+    h->last_ms = t;
+    h->records++;
+}
+
+/**
+ * recover_segment: Seals a segment left open by a crash: keeps the
+ * intact blocks, truncates the torn tail and rebuilds the header.
+ * An empty segment is removed. Returns 0, or -1 if the file is unusable.
+ */
+static int recover_segment(const char *path)
+{
+    int fd = open(path, O_RDWR);
+    struct stat sb;
+    int rc = -1;
+
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(SegHeader)) {
+        close(fd);
+        return -1;
+    }
+
+    size_t size = (size_t)sb.st_size;
+    uint8_t *base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+
+    SegHeader h;
+    memcpy(&h, base, sizeof(h));
+    if (header_valid(&h)) {
+        size_t off = sizeof(SegHeader);
+        SegBlockHeader bh;
+        float values[SEGSTORE_MAX_COLUMNS];
+
+        h.records = 0;
+        while (block_at(base, size, off, &bh)) {
+            BitReader r = { base + off + sizeof(bh), base + off + sizeof(bh) + bh.bytes, 0, 0 };
+            CoderState cs;
+            int64_t t;
+
+            cs.records = 0;
+            for (uint32_t i = 0; i < bh.records; i++) {
+                decode_record(&r, &cs, h.columns, &t, values);
+                header_add(&h, t, values);
+            }
+            off += sizeof(bh) + bh.bytes;
+        }
+
+        if (h.records == 0) {
+            rc = unlink(path);
+        } else {
+            h.sealed = 1;
+            rc = (ftruncate(fd, (off_t)off) == 0 &&
+                  pwrite(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h)) ? 0 : -1;
+        }
+    }
+
+    munmap(base, size);
+    close(fd);
+    return rc;
+}
+
+// ============================================================
+// WRITER
+// ============================================================
+
+struct SegStore {
+    char dir[SEG_PATH_MAX];
+    int columns;
+    int64_t retention_ms;
+    int fd;                   // open segment, -1 = none
+    int64_t seg_end_ms;       // open segment takes records before this time
+    int64_t last_ms;          // newest record accepted
+    SegHeader hdr;            // open segment, kept current in memory
+    uint8_t *block;           // SegBlockHeader + bitstream being built
+    int64_t block_first_ms;
+    BitWriter bw;
+    CoderState cs;
+};
+
+static void block_reset(SegStore *st)
+{
+    st->bw.buf = st->block + sizeof(SegBlockHeader);
+    st->bw.len = 0;
+    st->bw.acc = 0;
+    st->bw.nacc = 0;
+    st->cs.records = 0;
+}
+
+int segstore_flush(SegStore *st)
+{
+    SegBlockHeader bh;
+    int rc;
+
+    if (st->fd < 0 || st->cs.records == 0)
+        return 0;
+
+    bw_finish(&st->bw);
+    memset(&bh, 0, sizeof(bh));
+    bh.bytes = (uint32_t)st->bw.len;
+    bh.records = st->cs.records;
+    bh.first_ms = st->block_first_ms;
+    bh.last_ms = st->cs.prev_t;
+    bh.checksum = fnv1a(st->bw.buf, st->bw.len);
+    memcpy(st->block, &bh, sizeof(bh));
+
+    // One append per block: header and payload together
+    rc = file_write_all(st->fd, st->block, sizeof(bh) + st->bw.len);
+    block_reset(st);
+    return rc;
+}
+
+// A segment whose header write fails stays unsealed and is recovered
+// by the next segstore_open
+static void seal_segment(SegStore *st)
+{
+    if (st->fd < 0)
+        return;
+    segstore_flush(st);
+    st->hdr.sealed = 1;
+    if (pwrite(st->fd, &st->hdr, sizeof(st->hdr), 0) == (ssize_t)sizeof(st->hdr))
+        fdatasync(st->fd);
+    close(st->fd);
+    st->fd = -1;
+}
+
+// Deletes sealed segments that end before the retention horizon
+static void prune_segments(SegStore *st)
+{
+    struct dirent **names;
+    int n;
+
+    if (st->retention_ms <= 0 || (n = list_segments(st->dir, &names)) < 0)
+        return;
+
+    for (int i = 0; i < n; i++) {
+        char path[SEG_PATH_MAX * 2];
+        SegHeader h;
+        int fd;
+
+        snprintf(path, sizeof(path), "%s/%s", st->dir, names[i]->d_name);
+        fd = open(path, O_RDONLY);
+        if (fd < 0)
+            continue;
+        if (pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) && header_valid(&h) &&
+            h.sealed && h.last_ms < st->last_ms - st->retention_ms)
+            unlink(path);
+        close(fd);
+    }
+    free_list(names, n);
+}
+
+static int start_segment(SegStore *st, int64_t t)
+{
+    char path[SEG_PATH_MAX * 2];
+
+    snprintf(path, sizeof(path), "%s/%013lld" SEG_SUFFIX, st->dir, (long long)t);
+    st->fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (st->fd < 0)
+        return -1;
+
+    memset(&st->hdr, 0, sizeof(st->hdr));
+    memcpy(st->hdr.magic, SEG_MAGIC, 4);
+    st->hdr.version = SEG_VERSION;
+    st->hdr.columns = (uint16_t)st->columns;
+    st->hdr.first_ms = t;
+    if (file_write_all(st->fd, &st->hdr, sizeof(st->hdr)) != 0) {
+        close(st->fd);
+        st->fd = -1;
+        unlink(path);
+        return -1;
+    }
+
+    st->seg_end_ms = (t / SEGSTORE_SEGMENT_MS + 1) * SEGSTORE_SEGMENT_MS;
+    block_reset(st);
+    return 0;
+}
+
+SegStore* segstore_open(const char *dir, int columns, int64_t retention_ms,
+                        char *err, size_t err_len)
+{
+    struct dirent **names;
+    SegStore *st;
+    int n;
+
+    if (columns < 1 || columns > SEGSTORE_MAX_COLUMNS) {
+        snprintf(err, err_len, "%d columns (1-%d supported)", columns, SEGSTORE_MAX_COLUMNS);
+        return NULL;
+    }
+    if (strlen(dir) >= SEG_PATH_MAX || file_make_dirs(dir) != 0) {
+        snprintf(err, err_len, "%s: %s", dir, strlen(dir) >= SEG_PATH_MAX ? "path too long" : strerror(errno));
+        return NULL;
+    }
+
+    // Seal whatever a crash left open
+    n = list_segments(dir, &names);
+    if (n < 0) {
+        snprintf(err, err_len, "%s: %s", dir, strerror(errno));
+        return NULL;
+    }
+    for (int i = 0; i < n; i++) {
+        char path[SEG_PATH_MAX * 2];
+        SegHeader h;
+        int fd;
+
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i]->d_name);
+        fd = open(path, O_RDONLY);
+        if (fd < 0)
+            continue;
+        int unsealed = pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) && header_valid(&h) && !h.sealed;
+        close(fd);
+        if (unsealed)
+            recover_segment(path);   // an unusable file is skipped by readers
+    }
+    free_list(names, n);
+
+    st = calloc(1, sizeof(SegStore));
+    if (st)
+        st->block = malloc(SEG_BLOCK_CAP(columns));
+    if (!st || !st->block) {
+        free(st);
+        snprintf(err, err_len, "out of memory");
+        return NULL;
+    }
+    snprintf(st->dir, sizeof(st->dir), "%s", dir);
+    st->columns = columns;
+    st->retention_ms = retention_ms;
+    st->fd = -1;
+    st->last_ms = INT64_MIN;
+    return st;
+}
+
+int segstore_append(SegStore *st, int64_t t_ms, const float *values)
+{
+    if (t_ms < st->last_ms)
+        return -1;
+
+    if (st->fd >= 0 && t_ms >= st->seg_end_ms) {
+        seal_segment(st);
+        st->last_ms = t_ms;
+        prune_segments(st);
+    }
+    if (st->fd < 0 && start_segment(st, t_ms) != 0)
+        return -1;
+
+    if (st->cs.records == 0)
+        st->block_first_ms = t_ms;
+    encode_record(&st->bw, &st->cs, st->columns, t_ms, values);
+    header_add(&st->hdr, t_ms, values);
+    st->last_ms = t_ms;
+
+    if (st->cs.records == SEGSTORE_BLOCK_RECORDS)
+        return segstore_flush(st);
+    return 0;
+}
+
+void segstore_close(SegStore *st)
+{
+    if (!st)
+        return;
+    seal_segment(st);
+    free(st->block);
+    free(st);
+}
+
+// ============================================================
+// READER
+// ============================================================
+
+long segstore_scan(const char *dir, int64_t from_ms, int64_t to_ms,
+                   SegStoreVisitor fn, void *arg)
+{
+    struct dirent **names;
+    long visited = 0;
+    int stop = 0;
+    int n = list_segments(dir, &names);
+
+    if (n < 0)
+        return -1;
+
+    for (int i = 0; i < n && !stop; i++) {
+        char path[SEG_PATH_MAX * 2];
+        struct stat sb;
+        int fd;
+
+        // Names are first timestamps: everything after this one is too new
+        if (strtoll(names[i]->d_name, NULL, 10) > to_ms)
+            break;
+
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i]->d_name);
+        fd = open(path, O_RDONLY);
+        if (fd < 0)
+            continue;
+        if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(SegHeader)) {
+            close(fd);
+            continue;
+        }
+
+        size_t size = (size_t)sb.st_size;
+        const uint8_t *base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED)
+            continue;
+
+        const SegHeader *h = (const SegHeader *)base;
+        if (header_valid(h) && !(h->sealed && h->last_ms < from_ms)) {
+            size_t off = sizeof(SegHeader);
+            SegBlockHeader bh;
+            float values[SEGSTORE_MAX_COLUMNS];
+
+            while (!stop && block_at(base, size, off, &bh)) {
+                const uint8_t *p = base + off + sizeof(bh);
+                off += sizeof(bh) + bh.bytes;
+                if (bh.last_ms < from_ms)
+                    continue;
+                if (bh.first_ms > to_ms) {
+                    stop = 1;
+                    break;
+                }
+
+                BitReader r = { p, p + bh.bytes, 0, 0 };
+                CoderState cs;
+                int64_t t;
+
+                cs.records = 0;
+                for (uint32_t k = 0; k < bh.records; k++) {
+                    decode_record(&r, &cs, h->columns, &t, values);
+                    if (t < from_ms)
+                        continue;
+                    if (t > to_ms) {
+                        stop = 1;
+                        break;
+                    }
+                    visited++;
+                    if (fn && fn(arg, t, values, h->columns)) {
+                        stop = 1;
+                        break;
+                    }
+                }
+            }
+        }
+        munmap((void *)base, size);
+    }
+
+    free_list(names, n);
+    return visited;
+}
@@ -0,0 +1,112 @@
+#ifndef SEGMENT_STORE_H
+#define SEGMENT_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================
+// COMPRESSED TIME-SERIES SEGMENTS (Gorilla-style)
+// ============================================================
+//
+// A store is one directory of append-only segment files, each covering
+// one aligned time span (an hour by default) and named after its first
+// timestamp (<ms>.seg). A record is a millisecond timestamp plus a fixed
+// number of float columns.
+//
+//   file   = SegHeader | block | block | ...
+//   block  = SegBlockHeader | bitstream of up to SEGSTORE_BLOCK_RECORDS records
+//
+// Inside a block, timestamps are delta-of-delta coded and every column
+// is XOR coded against its previous value (Gorilla, adapted to 32-bit
+// floats). Each block restarts the coders, so it decodes on its own. A
+// block is written with one append when it fills, so the card sees one
+// small sequential write per block instead of one per record. The
+// checksum lets readers and crash recovery stop at a torn tail. The
+// segment header's record count, time range and per-column min/max are
+// written when the segment is sealed (on rotation or close, or by
+// recovery on the next open), so range scans skip whole files without
+// decoding them. Readers mmap the files and never block the writer.
+//
+// The writer is single-threaded and does file I/O: never call it from
+// the RT loop. Files use host byte order.
+
+#define SEGSTORE_MAX_COLUMNS   64
+#define SEGSTORE_BLOCK_RECORDS 64
+#define SEGSTORE_SEGMENT_MS    (3600LL * 1000LL)
+
+/**
+ * SegHeader: Start of every segment file.
+ */
+typedef struct {
+    char magic[4];                    // "GSEG"
+    uint16_t version;
+    uint16_t columns;
+    uint32_t sealed;                  // 1 once the fields below are final
+    uint32_t records;
+    int64_t first_ms;
+    int64_t last_ms;
+    float min[SEGSTORE_MAX_COLUMNS];
+    float max[SEGSTORE_MAX_COLUMNS];
+} SegHeader;
+
+/**
+ * SegBlockHeader: Precedes each compressed block.
+ */
+typedef struct {
+    uint32_t bytes;                   // bitstream length
+    uint32_t records;
+    int64_t first_ms;
+    int64_t last_ms;
+    uint32_t checksum;                // FNV-1a of the bitstream
+    uint32_t reserved;
+} SegBlockHeader;
+
+typedef struct SegStore SegStore;
+
+/**
+ * SegStoreVisitor: Called by segstore_scan for each record in range, in
+ * time order. Return non-zero to stop the scan.
+ */
+typedef int (*SegStoreVisitor)(void *arg, int64_t t_ms, const float *values, int columns);
+
+/**
+ * segstore_open: Opens (creating if needed) the store in dir for records
+ * of 'columns' floats. Segments left unsealed by a crash are recovered
+ * up to their last intact block and sealed. Segments that end more than
+ * retention_ms before the newest record are deleted at each rotation
+ * (0 = keep everything).
+ * Returns NULL with the reason in err.
+ */
+SegStore* segstore_open(const char *dir, int columns, int64_t retention_ms,
+                        char *err, size_t err_len);
+
+/**
+ * segstore_append: Adds one record. t_ms must not go backwards.
+ * Returns 0, or -1 on an I/O error or an out-of-order time (the record
+ * is dropped; the store stays usable).
+ */
+int segstore_append(SegStore *st, int64_t t_ms, const float *values);
+
+/**
+ * segstore_flush: Writes the partly filled block, if any. The next
+ * record starts a new block.
+ * Returns 0, or -1 on an I/O error.
+ */
+int segstore_flush(SegStore *st);
+
+/**
+ * segstore_close: Flushes, seals the open segment and frees the store.
+ */
+void segstore_close(SegStore *st);
+
+/**
+ * segstore_scan: Visits every stored record of dir with from_ms <=
+ * t_ms <= to_ms, oldest first, reading the files through mmap. Safe
+ * to call while a writer appends to the same directory; the block
+ * being filled is not visible until it is written.
+ * Returns the number of records visited, or -1 if dir cannot be read.
+ */
+long segstore_scan(const char *dir, int64_t from_ms, int64_t to_ms,
+                   SegStoreVisitor fn, void *arg);
+
+#endif // SEGMENT_STORE_H
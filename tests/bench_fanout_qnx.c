@@ -0,0 +1,320 @@
+/*
+ * bench_fanout_qnx.c  —  Monitor Telemetry Fan-Out Benchmark  (QNX Neutrino target)
+ * ============================================================================
+ * Measures: Cost of one monitor tick (every viewer gets the unit's latest
+ *           window) for growing numbers of monitor sessions, comparing
+ *
+ *           PER-SESSION  the previous path: each session copies the
+ *                        unit's EquipmentHealth out of its seqlock and
+ *                        snprintf's the two monitor lines itself
+ *           HUB          drivers/telemetry.c: the window is encoded once
+ *                        (text and wire frames) into a reference-counted
+ *                        frame; each session takes a reference, queues
+ *                        the bytes and drops it
+ *
+ *           Each size is run twice: with the lines only queued into the
+ *           session's output buffer, and with them also sent through
+ *           SSL_write (AES-256-GCM, TLS 1.3), which is the per-session
+ *           cost that remains. All sessions write through one TLS
+ *           connection over an in-memory BIO pair; the ciphertext is
+ *           discarded.
+ *
+ * Build (on host, cross-compile for RPi 4):
+ *   qcc -V gcc_ntoaarch64le -D_QNX_SOURCE -O2 \
+ *       -o bench_fanout_qnx tests/bench_fanout_qnx.c drivers/telemetry.c \
+ *       -lm -lssl -lcrypto
+ *
+ * Deploy & Run:
+ *   scp bench_fanout_qnx qnxuser@<RPI_IP>:/tmp/
+ *   ssh qnxuser@<RPI_IP> "/tmp/bench_fanout_qnx"
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/ec.h>
+#include <openssl/x509.h>
+
+#include "../drivers/seqlock.h"
+#include "../drivers/telemetry.h"
+
+/* ------------------------------------------------------------------ */
+/*  Benchmark parameters                                               */
+/* ------------------------------------------------------------------ */
+#define MAX_SESSIONS      512
+#define LINES_PER_RUN     (1u << 18)   /* session lines per size (queue only) */
+#define TLS_LINES_PER_RUN (1u << 15)   /* session lines per size (with TLS)   */
+#define SESSION_BUF       512
+
+static const int session_counts[] = { 1, 8, 64, 512 };
+
+/* ------------------------------------------------------------------ */
+/*  Timing helper                                                      */
+/* ------------------------------------------------------------------ */
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void die(const char *what) {
+    fprintf(stderr, "%s failed\n", what);
+    ERR_print_errors_fp(stderr);
+    exit(1);
+}
+
+/* The server links this from drivers/sensors_generic.c */
+const char* health_to_string(HealthStatus status) {
+    switch (status) {
+        case HEALTH_HEALTHY:  return "OK";
+        case HEALTH_WARNING:  return "WARNING";
+        case HEALTH_CRITICAL: return "CRITICAL";
+        case HEALTH_FAULT:    return "FAULT";
+        default:              return "UNKNOWN";
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Sessions                                                           */
+/* ------------------------------------------------------------------ */
+typedef struct {
+    char out[SESSION_BUF];
+    size_t len;
+} Session;
+
+typedef struct {
+    SSL *srv;
+    BIO *drain;        /* client end of the BIO pair */
+} Wire;
+
+static void session_send(Session *s, const Wire *w, const char *data, size_t len) {
+    memcpy(s->out, data, len);
+    s->len = len;
+    if (w) {
+        unsigned char scratch[1024];
+        if (SSL_write(w->srv, s->out, (int)s->len) != (int)s->len)
+            die("SSL_write");
+        while (BIO_read(w->drain, scratch, sizeof(scratch)) > 0) {
+        }
+    }
+    s->len = 0;
+}
+
+/* Previous poll_monitor body, per session */
+static void tick_per_session(SeqLock *seq, const EquipmentHealth *shared, Session *sessions,
+                             int n, const Wire *w) {
+    EquipmentHealth h;
+    char buf[256];
+
+    for (int i = 0; i < n; i++) {
+        seqlock_snapshot(seq, &h, shared, sizeof(EquipmentHealth));
+        int len = snprintf(buf, sizeof(buf),
+                           "[%s] Vib: %.0f | Snd: %.0f%% | Temp: %.1fC | Cur: %.2fA\n",
+                           health_to_string(h.status),
+                           h.snapshot.vibration_level,
+                           h.snapshot.sound_level,
+                           h.snapshot.temperature_c,
+                           h.snapshot.current_a);
+        const ChannelFeatures *v = &h.features[CH_VIBRATION];
+        len += snprintf(buf + len, sizeof(buf) - (size_t)len,
+                        "    Vib RMS: %.3f | Peak: %.3f | Crest: %.2f | Kurt: %.2f | Skew: %.2f\n",
+                        v->rms, fmaxf(fabsf(v->min), fabsf(v->max)), v->crest_factor,
+                        v->kurtosis, v->skewness);
+        session_send(&sessions[i], w, buf, (size_t)len);
+    }
+}
+
+/* Encode once, then every session takes a reference */
+static void tick_hub(TelemetrySlot *slot, const EquipmentHealth *shared, Session *sessions,
+                     int n, const Wire *w) {
+    if (telemetry_publish(slot, 0, shared) != 0)
+        die("telemetry_publish");
+
+    for (int i = 0; i < n; i++) {
+        TelemetryFrame *cur = telemetry_acquire(slot);
+        session_send(&sessions[i], w, cur->text, cur->text_len);
+        telemetry_release(cur);
+    }
+}
+
+/* A new window: the numbers change on every tick */
+static void next_window(SeqLock *seq, EquipmentHealth *h, uint32_t tick) {
+    float r = (float)(tick % 1000u) / 1000.0f;
+    seqlock_write_begin(seq);
+    h->status = tick % 7u == 0 ? HEALTH_WARNING : HEALTH_HEALTHY;
+    h->snapshot.vibration_level = 40.0f + 60.0f * r;
+    h->snapshot.sound_level = 15.0f + r;
+    h->snapshot.temperature_c = 42.0f + 3.0f * r;
+    h->snapshot.current_a = 7.9f + r;
+    h->features[CH_VIBRATION].rms = 0.05f + 0.01f * r;
+    h->features[CH_VIBRATION].min = -0.11f + 0.04f * r;   // negative-going impulses
+    h->features[CH_VIBRATION].max = 0.08f + 0.02f * r;
+    h->features[CH_VIBRATION].crest_factor = 1.5f + r;
+    h->features[CH_VIBRATION].kurtosis = 1.8f + r;
+    h->features[CH_VIBRATION].skewness = r - 0.5f;
+    h->window_end_ms = 1700000000000ULL + (uint64_t)tick * 1000u;
+    seqlock_write_end(seq);
+}
+
+/* ------------------------------------------------------------------ */
+/*  TLS connection over a BIO pair                                     */
+/* ------------------------------------------------------------------ */
+static Wire make_wire(SSL_CTX **sctx_out, SSL_CTX **cctx_out, SSL **cli_out) {
+    EVP_PKEY *key = NULL;
+    EVP_PKEY_CTX *kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+    if (!kctx || EVP_PKEY_keygen_init(kctx) <= 0 ||
+        EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kctx, NID_X9_62_prime256v1) <= 0 ||
+        EVP_PKEY_keygen(kctx, &key) <= 0)
+        die("EC keygen");
+    EVP_PKEY_CTX_free(kctx);
+
+    X509 *cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 86400L);
+    X509_set_pubkey(cert, key);
+    X509_NAME_add_entry_by_txt(X509_get_subject_name(cert), "CN", MBSTRING_ASC,
+                               (const unsigned char *)"localhost", -1, -1, 0);
+    X509_set_issuer_name(cert, X509_get_subject_name(cert));
+    if (!X509_sign(cert, key, EVP_sha256()))
+        die("X509_sign");
+
+    SSL_CTX *sctx = SSL_CTX_new(TLS_server_method());
+    SSL_CTX *cctx = SSL_CTX_new(TLS_client_method());
+    if (!sctx || !cctx || SSL_CTX_use_certificate(sctx, cert) <= 0 ||
+        SSL_CTX_use_PrivateKey(sctx, key) <= 0)
+        die("SSL_CTX");
+    SSL_CTX_set_ciphersuites(sctx, "TLS_AES_256_GCM_SHA384");
+    X509_free(cert);
+    EVP_PKEY_free(key);
+
+    SSL *srv = SSL_new(sctx), *cli = SSL_new(cctx);
+    BIO *sbio, *cbio;
+    if (!srv || !cli || !BIO_new_bio_pair(&sbio, 0, &cbio, 0))
+        die("SSL_new/BIO_new_bio_pair");
+    SSL_set_bio(srv, sbio, sbio);
+    SSL_set_bio(cli, cbio, cbio);
+    SSL_set_accept_state(srv);
+    SSL_set_connect_state(cli);
+
+    int s_done = 0, c_done = 0;
+    for (int round = 0; !(s_done && c_done); round++) {
+        if (round > 100)
+            die("handshake (no progress)");
+        if (!c_done) {
+            int rc = SSL_do_handshake(cli);
+            if (rc == 1) c_done = 1;
+            else if (SSL_get_error(cli, rc) != SSL_ERROR_WANT_READ) die("client handshake");
+        }
+        if (!s_done) {
+            int rc = SSL_do_handshake(srv);
+            if (rc == 1) s_done = 1;
+            else if (SSL_get_error(srv, rc) != SSL_ERROR_WANT_READ) die("server handshake");
+        }
+    }
+
+    /* Discard the session tickets still in flight */
+    unsigned char scratch[1024];
+    while (BIO_read(cbio, scratch, sizeof(scratch)) > 0) {
+    }
+
+    *sctx_out = sctx;
+    *cctx_out = cctx;
+    *cli_out = cli;
+    return (Wire){ srv, cbio };
+}
+
+static void print_row(const char *name, int n, int tls, uint32_t ticks, uint64_t ns, double base) {
+    double per_tick = (double)ns / (double)ticks;
+    printf("%-12s %8d %4s %12.2f %12.1f %8.2fx\n", name, n, tls ? "yes" : "no",
+           per_tick / 1000.0, per_tick / n, base > 0.0 ? base / per_tick : 1.0);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Main                                                               */
+/* ------------------------------------------------------------------ */
+int main(void) {
+    Session *sessions = calloc(MAX_SESSIONS, sizeof(Session));
+    EquipmentHealth *shared = calloc(1, sizeof(EquipmentHealth));
+    SeqLock seq;
+    TelemetrySlot slot = {0};
+    SSL_CTX *sctx, *cctx;
+    SSL *cli;
+
+    if (!sessions || !shared) {
+        fprintf(stderr, "malloc failed\n");
+        return 1;
+    }
+    seqlock_init(&seq);
+    snprintf(shared->unit_id, MAX_ID_LENGTH, "Unit-0");
+    Wire wire = make_wire(&sctx, &cctx, &cli);
+
+    printf("=== RT-Bench: Monitor Fan-Out (drivers/telemetry.c)  [QNX] ===\n");
+    printf("Frame       : %zu bytes (text up to %d, snapshot %d)\n",
+           sizeof(TelemetryFrame), TELEMETRY_TEXT_MAX, WIRE_HEADER_SIZE + WIRE_SNAPSHOT_SIZE);
+    printf("Lines/run   : %u queued, %u through TLS, per size\n\n", LINES_PER_RUN, TLS_LINES_PER_RUN);
+    printf("%-12s %8s %4s %12s %12s %9s\n", "Benchmark", "Sessions", "TLS", "us/tick",
+           "ns/session", "Speedup");
+
+    for (int tls = 0; tls <= 1; tls++) {
+        const Wire *w = tls ? &wire : NULL;
+        for (unsigned c = 0; c < sizeof(session_counts) / sizeof(session_counts[0]); c++) {
+            int n = session_counts[c];
+            uint32_t ticks = (tls ? TLS_LINES_PER_RUN : LINES_PER_RUN) / (uint32_t)n;
+
+            uint64_t t0 = now_ns();
+            for (uint32_t t = 0; t < ticks; t++) {
+                next_window(&seq, shared, t);
+                tick_per_session(&seq, shared, sessions, n, w);
+            }
+            uint64_t old_ns = now_ns() - t0;
+            double base = (double)old_ns / (double)ticks;
+            print_row("PER-SESSION", n, tls, ticks, old_ns, 0.0);
+
+            t0 = now_ns();
+            for (uint32_t t = 0; t < ticks; t++) {
+                next_window(&seq, shared, t);
+                tick_hub(&slot, shared, sessions, n, w);
+            }
+            uint64_t hub_ns = now_ns() - t0;
+            print_row("HUB", n, tls, ticks, hub_ns, base);
+        }
+        if (!tls)
+            printf("\n");
+    }
+
+    /* Both paths must render the same lines */
+    char ref[256];
+    EquipmentHealth h;
+    seqlock_snapshot(&seq, &h, shared, sizeof(h));
+    snprintf(ref, sizeof(ref),
+             "[%s] Vib: %.0f | Snd: %.0f%% | Temp: %.1fC | Cur: %.2fA\n"
+             "    Vib RMS: %.3f | Peak: %.3f | Crest: %.2f | Kurt: %.2f | Skew: %.2f\n",
+             health_to_string(h.status), h.snapshot.vibration_level, h.snapshot.sound_level,
+             h.snapshot.temperature_c, h.snapshot.current_a, h.features[CH_VIBRATION].rms,
+             fmaxf(fabsf(h.features[CH_VIBRATION].min), fabsf(h.features[CH_VIBRATION].max)),
+             h.features[CH_VIBRATION].crest_factor,
+             h.features[CH_VIBRATION].kurtosis, h.features[CH_VIBRATION].skewness);
+    TelemetryFrame *f = telemetry_acquire(&slot);
+    if (strcmp(ref, f->text) != 0)
+        printf("  !! hub text differs:\n%s%s", ref, f->text);
+    printf("\n(last frame seq %llu)\n", (unsigned long long)f->seq);
+    telemetry_release(f);
+
+    telemetry_clear(&slot);
+    SSL_free(wire.srv);
+    SSL_free(cli);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    free(sessions);
+    free(shared);
+    return 0;
+}
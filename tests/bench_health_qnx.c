@@ -0,0 +1,253 @@
+/*
+ * bench_health_qnx.c  —  Window Health Evaluation Benchmark  (QNX Neutrino target)
+ * ============================================================================
+ * Measures: Units evaluated per second at a window close, for growing
+ *           numbers of monitored machines, comparing
+ *
+ *           PER-STRUCT  the previous path: each EquipmentHealth is
+ *                       judged on its own by a scalar loop over its rules
+ *                       and the winning message is strcpy'd into it
+ *           SOA         drivers/rules.c: the values of all units sit in a
+ *                       struct-of-arrays matrix and rules_evaluate()
+ *                       judges 4 or 8 units per SIMD step; the message
+ *                       is an id into a static table
+ *
+ *           Both paths start from the same EquipmentHealth structs and
+ *           include gathering their values. Every unit closes its window
+ *           on every iteration (worst case: all windows aligned).
+ *
+ * Build (on host, cross-compile for RPi 4):
+ *   qcc -V gcc_ntoaarch64le -D_QNX_SOURCE -O2 \
+ *       -o bench_health_qnx tests/bench_health_qnx.c drivers/rules.c -lm
+ *
+ * Deploy & Run:
+ *   scp bench_health_qnx qnxuser@<RPI_IP>:/tmp/
+ *   ssh qnxuser@<RPI_IP> "/tmp/bench_health_qnx"
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../drivers/rules.h"
+
+/* ------------------------------------------------------------------ */
+/*  Benchmark parameters                                               */
+/* ------------------------------------------------------------------ */
+#define MAX_UNITS        4096
+#define EVALS_PER_RUN    (1u << 21)   /* unit evaluations per size      */
+#define RULES_PATH       "/tmp/bench_health_rules.conf"
+
+static const int unit_counts[] = { 1, 8, 64, 512, 4096 };
+
+/* ------------------------------------------------------------------ */
+/*  Timing helper                                                      */
+/* ------------------------------------------------------------------ */
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Previous per-struct evaluator (reference)                          */
+/* ------------------------------------------------------------------ */
+typedef struct {
+    int value;
+    float warn, crit, hyst;
+    int debounce;
+    int level, pending, count;
+    char msg[2][96];
+} ScalarRule;
+
+#define SCALAR_RULES 4
+
+static void scalar_fill(const EquipmentHealth *h, float *v) {
+    const float levels[CH_COUNT] = {
+        h->snapshot.vibration_level, h->snapshot.sound_level,
+        h->snapshot.temperature_c, h->snapshot.current_a
+    };
+    for (int c = 0; c < CH_COUNT; c++) {
+        const ChannelFeatures *f = &h->features[c];
+        float *o = &v[RULE_VALUE_INDEX(c, 0)];
+        o[RULE_LEVEL] = levels[c];
+        o[RULE_MEAN] = f->mean;
+        o[RULE_RMS] = f->rms;
+        o[RULE_MIN] = f->min;
+        o[RULE_MAX] = f->max;
+        o[RULE_P2P] = f->peak_to_peak;
+        o[RULE_CREST] = f->crest_factor;
+        o[RULE_SKEW] = f->skewness;
+        o[RULE_KURTOSIS] = f->kurtosis;
+    }
+}
+
+static float scalar_evaluate(ScalarRule *rules, EquipmentHealth *h) {
+    float v[RULE_VALUE_COUNT];
+    int worst = 0;
+    const char *msg = NULL;
+    float prox = 0.0f;
+
+    scalar_fill(h, v);
+    for (int i = 0; i < SCALAR_RULES; i++) {
+        ScalarRule *r = &rules[i];
+        float x = v[r->value];
+        int up = (x > r->warn) + (x > r->crit);
+        int hold = (x > r->warn - r->hyst) + (x > r->crit - r->hyst);
+        int kept = r->level < hold ? r->level : hold;
+        int target = up > kept ? up : kept;
+
+        if (target == r->level) {
+            r->count = 0;
+        } else {
+            if (target != r->pending) { r->pending = target; r->count = 0; }
+            if (++r->count >= r->debounce) { r->level = target; r->count = 0; }
+        }
+        if (r->level > worst) { worst = r->level; msg = r->msg[worst - 1]; }
+        if (r->warn > 0.0f && x / r->warn > prox) prox = x / r->warn;
+    }
+
+    h->status = worst == 2 ? HEALTH_CRITICAL : worst == 1 ? HEALTH_WARNING : HEALTH_HEALTHY;
+    strcpy(h->message, msg ? msg : "System Nominal");
+    return prox;
+}
+
+static void scalar_init(ScalarRule *r) {
+    static const struct { int ch, m; float w, c, h; int d; } spec[SCALAR_RULES] = {
+        { CH_VIBRATION,   RULE_LEVEL,    100.0f, 200.0f, 5.0f, 1 },
+        { CH_CURRENT,     RULE_LEVEL,    15.0f,  15.0f,  0.5f, 1 },
+        { CH_TEMPERATURE, RULE_LEVEL,    80.0f,  80.0f,  2.0f, 1 },
+        { CH_VIBRATION,   RULE_KURTOSIS, 4.0f,   6.0f,   0.5f, 3 },
+    };
+    memset(r, 0, SCALAR_RULES * sizeof(ScalarRule));
+    for (int i = 0; i < SCALAR_RULES; i++) {
+        r[i].value = RULE_VALUE_INDEX(spec[i].ch, spec[i].m);
+        r[i].warn = spec[i].w;
+        r[i].crit = spec[i].c;
+        r[i].hyst = spec[i].h;
+        r[i].debounce = spec[i].d;
+        snprintf(r[i].msg[0], sizeof(r[i].msg[0]), "High Warning (> %g)", (double)spec[i].w);
+        snprintf(r[i].msg[1], sizeof(r[i].msg[1]), "CRITICAL FAULT DETECTED (> %g)", (double)spec[i].c);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Synthetic windows: mostly healthy, a few units near or over limits */
+/* ------------------------------------------------------------------ */
+static void fill_units(EquipmentHealth *h, int n) {
+    uint32_t seed = 12345u;
+    for (int u = 0; u < n; u++) {
+        seed = seed * 1664525u + 1013904223u;
+        float r = (float)(seed >> 8) / 16777216.0f;
+        memset(&h[u], 0, sizeof(h[u]));
+        h[u].snapshot.vibration_level = 40.0f + 180.0f * r * r * r;
+        h[u].snapshot.sound_level = 15.0f;
+        h[u].snapshot.temperature_c = 42.0f + 10.0f * r;
+        h[u].snapshot.current_a = 8.0f + 8.0f * r * r;
+        for (int c = 0; c < CH_COUNT; c++) {
+            h[u].features[c].mean = 1.0f;
+            h[u].features[c].rms = 1.1f;
+            h[u].features[c].kurtosis = 3.0f + 3.5f * r * r;
+        }
+    }
+}
+
+static void print_row(const char *name, int units, uint64_t evals, uint64_t ns, double base) {
+    double ups = (double)evals * 1e9 / (double)ns;
+    printf("%-12s %6d %14.0f %10.1f %8.2fx\n",
+           name, units, ups, (double)ns / (double)evals, base > 0.0 ? ups / base : 1.0);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Main                                                               */
+/* ------------------------------------------------------------------ */
+int main(void) {
+    char (*ids)[MAX_ID_LENGTH] = malloc(MAX_UNITS * MAX_ID_LENGTH);
+    EquipmentHealth *health = malloc(MAX_UNITS * sizeof(EquipmentHealth));
+    ScalarRule *scalar = malloc((size_t)MAX_UNITS * SCALAR_RULES * sizeof(ScalarRule));
+    int stride = RULES_STRIDE(MAX_UNITS);
+    float *values = calloc((size_t)RULE_VALUE_COUNT * stride, sizeof(float));
+    int32_t *due = malloc(stride * sizeof(int32_t));
+    int32_t *status = malloc(stride * sizeof(int32_t));
+    int32_t *message = malloc(stride * sizeof(int32_t));
+    float *prox = malloc(stride * sizeof(float));
+    char err[160];
+    volatile float sink = 0.0f;
+
+    if (!ids || !health || !scalar || !values || !due || !status || !message || !prox) {
+        fprintf(stderr, "malloc failed\n");
+        return 1;
+    }
+
+    FILE *f = fopen(RULES_PATH, "w");
+    if (!f) { perror("rules file"); return 1; }
+    fprintf(f, "*:vibration=100,200,5\n*:current=15,15,0.5\n*:temperature=80,80,2\n"
+               "*:vibration.kurtosis=4,6,0.5,3\n");
+    fclose(f);
+
+    for (int u = 0; u < MAX_UNITS; u++)
+        snprintf(ids[u], MAX_ID_LENGTH, "Unit-%d", u);
+    fill_units(health, MAX_UNITS);
+
+    printf("=== RT-Bench: Window Health Evaluation (drivers/rules.c)  [QNX] ===\n");
+    printf("Rules/unit  : %d | SIMD width: %d floats\n", SCALAR_RULES, rules_simd_width());
+    printf("Evals/run   : %u per size\n\n", EVALS_PER_RUN);
+    printf("%-12s %6s %14s %10s %9s\n", "Benchmark", "Units", "Units/s", "ns/unit", "Speedup");
+
+    for (unsigned s = 0; s < sizeof(unit_counts) / sizeof(unit_counts[0]); s++) {
+        int n = unit_counts[s];
+        int iters = (int)(EVALS_PER_RUN / (unsigned)n);
+        uint64_t evals = (uint64_t)iters * (uint64_t)n;
+
+        /* Per-struct path */
+        for (int u = 0; u < n; u++)
+            scalar_init(&scalar[u * SCALAR_RULES]);
+        uint64_t t0 = now_ns();
+        for (int it = 0; it < iters; it++)
+            for (int u = 0; u < n; u++)
+                sink += scalar_evaluate(&scalar[u * SCALAR_RULES], &health[u]);
+        uint64_t scalar_ns = now_ns() - t0;
+        double base = (double)evals * 1e9 / (double)scalar_ns;
+        print_row("PER-STRUCT", n, evals, scalar_ns, 0.0);
+
+        /* Struct-of-arrays path */
+        RuleSet *rs = rules_load(RULES_PATH, (const char (*)[MAX_ID_LENGTH])ids, n, err, sizeof(err));
+        if (!rs) { fprintf(stderr, "rules_load: %s\n", err); return 1; }
+        memset(due, 0, stride * sizeof(int32_t));
+        t0 = now_ns();
+        for (int it = 0; it < iters; it++) {
+            for (int u = 0; u < n; u++) {
+                rules_fill_values(rs, &health[u], values, u);
+                due[u] = -1;
+            }
+            rules_evaluate(rs, values, due, status, message, prox);
+            for (int u = 0; u < n; u++)
+                health[u].message_id = (uint32_t)message[u];
+            sink += prox[0];
+        }
+        uint64_t soa_ns = now_ns() - t0;
+        print_row("SOA", n, evals, soa_ns, base);
+
+        /* Both paths must agree on the verdicts */
+        int mismatches = 0;
+        for (int u = 0; u < n; u++)
+            mismatches += (int)health[u].status != status[u];
+        if (mismatches)
+            printf("  !! %d status mismatches\n", mismatches);
+        rules_free(rs);
+    }
+
+    printf("\n(checksum %.3f)\n", (double)sink);
+    remove(RULES_PATH);
+    free(ids);
+    free(health);
+    free(scalar);
+    free(values);
+    free(due);
+    free(status);
+    free(message);
+    free(prox);
+    return 0;
+}
@@ -0,0 +1,301 @@
+/*
+ * bench_segstore_qnx.c  —  Window Store Benchmark  (QNX Neutrino target)
+ * ============================================================================
+ * Measures: Bytes per sample, ingest rate and range-scan throughput of the
+ *           Gorilla-compressed segment store in storage/segment_store.c,
+ *           against a raw-struct baseline that appends each record as
+ *           { int64 t_ms; float v[36]; } through stdio and scans it back
+ *           through mmap.
+ *
+ *           The data is one day of synthetic 1 Hz windows laid out like the
+ *           server's records (MANAGER_STORE_COLUMNS): four channel levels at
+ *           sensor resolution, then mean/rms/min/max/p2p/crest/skew/kurtosis
+ *           per channel. Both stores write under /tmp and include the final
+ *           flush (store sealed, file closed) in the ingest time.
+ *
+ *           Scans run over the whole day and over one hour in the middle
+ *           (the segment headers let the store skip the other 23 files).
+ *           Throughput is records per second; every scan also sums one
+ *           column so both readers touch the decoded values.
+ *
+ * Build (on host, cross-compile for RPi 4):
+ *   qcc -V gcc_ntoaarch64le -D_QNX_SOURCE -O2 \
+ *       -o bench_segstore_qnx tests/bench_segstore_qnx.c storage/segment_store.c -lm
+ *
+ * Deploy & Run:
+ *   scp bench_segstore_qnx qnxuser@<RPI_IP>:/tmp/
+ *   ssh qnxuser@<RPI_IP> "/tmp/bench_segstore_qnx"
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../storage/segment_store.h"
+
+/* ------------------------------------------------------------------ */
+/*  Benchmark parameters                                               */
+/* ------------------------------------------------------------------ */
+#define CHANNELS     4
+#define FEATURES     8
+#define COLUMNS      (CHANNELS + CHANNELS * FEATURES)   /* 36, as the server */
+#define RECORDS      86400                               /* one day at 1 Hz   */
+#define START_MS     1767225600000LL                     /* hour-aligned      */
+#define STORE_DIR    "/tmp/bench_segstore"
+#define RAW_FILE     "/tmp/bench_segstore.raw"
+#define SCAN_REPEAT  5
+
+typedef struct {
+    int64_t t_ms;
+    float v[COLUMNS];
+} RawRecord;
+
+/* ------------------------------------------------------------------ */
+/*  Timing helper                                                      */
+/* ------------------------------------------------------------------ */
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Synthetic windows: slow process drift + load cycle + sensor noise  */
+/* ------------------------------------------------------------------ */
+static uint32_t seed = 12345u;
+
+static float noise(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return (float)(seed >> 8) / 16777216.0f - 0.5f;
+}
+
+static float quantize(float x, float step) {
+    return roundf(x / step) * step;
+}
+
+static void fill_record(int64_t i, float *v) {
+    static const float base[CHANNELS]  = { 50.0f, 3.2f, 42.0f, 12.5f };
+    static const float step[CHANNELS]  = { 0.1f, 0.01f, 0.01f, 0.1f };
+    static const float swing[CHANNELS] = { 5.0f, 0.4f, 3.0f, 1.5f };
+    double hour = (double)i / 3600.0;
+
+    for (int c = 0; c < CHANNELS; c++) {
+        float level = base[c] + swing[c] * (float)sin(6.283185307 * hour / 8.0 + c)
+                    + step[c] * 3.0f * noise();
+        float rms = level * (1.0f + 0.02f * noise());
+        float *f = &v[CHANNELS + c * FEATURES];
+
+        v[c] = quantize(level, step[c]);
+        f[0] = level;                                  /* mean     */
+        f[1] = rms;                                    /* rms      */
+        f[2] = level - 1.4f * rms * 0.1f;              /* min      */
+        f[3] = level + 1.4f * rms * 0.1f;              /* max      */
+        f[4] = f[3] - f[2];                            /* p2p      */
+        f[5] = 1.41f + 0.05f * noise();                /* crest    */
+        f[6] = 0.1f * noise();                         /* skewness */
+        f[7] = 3.0f + 0.2f * noise();                  /* kurtosis */
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Housekeeping                                                       */
+/* ------------------------------------------------------------------ */
+static void remove_store(void) {
+    DIR *d = opendir(STORE_DIR);
+    struct dirent *e;
+    char path[512];
+
+    if (d) {
+        while ((e = readdir(d)) != NULL) {
+            if (e->d_name[0] == '.')
+                continue;
+            snprintf(path, sizeof(path), "%s/%s", STORE_DIR, e->d_name);
+            unlink(path);
+        }
+        closedir(d);
+        rmdir(STORE_DIR);
+    }
+    unlink(RAW_FILE);
+}
+
+static long long store_bytes(int *files) {
+    DIR *d = opendir(STORE_DIR);
+    struct dirent *e;
+    struct stat st;
+    char path[512];
+    long long total = 0;
+
+    *files = 0;
+    if (!d)
+        return 0;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.')
+            continue;
+        snprintf(path, sizeof(path), "%s/%s", STORE_DIR, e->d_name);
+        if (stat(path, &st) == 0) {
+            total += st.st_size;
+            (*files)++;
+        }
+    }
+    closedir(d);
+    return total;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Scans                                                              */
+/* ------------------------------------------------------------------ */
+typedef struct {
+    long records;
+    double sum;
+} ScanTotal;
+
+static int visit(void *arg, int64_t t_ms, const float *values, int columns) {
+    ScanTotal *s = arg;
+    (void)t_ms;
+    (void)columns;
+    s->records++;
+    s->sum += values[0];
+    return 0;
+}
+
+static ScanTotal scan_raw(int64_t from_ms, int64_t to_ms) {
+    ScanTotal s = { 0, 0.0 };
+    struct stat st;
+    int fd = open(RAW_FILE, O_RDONLY);
+
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        return s;
+    }
+    const RawRecord *r = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (r == MAP_FAILED)
+        return s;
+
+    size_t n = (size_t)st.st_size / sizeof(RawRecord);
+    for (size_t i = 0; i < n; i++) {
+        if (r[i].t_ms < from_ms || r[i].t_ms > to_ms)
+            continue;
+        s.records++;
+        s.sum += r[i].v[0];
+    }
+    munmap((void *)r, (size_t)st.st_size);
+    return s;
+}
+
+static ScanTotal scan_store(int64_t from_ms, int64_t to_ms) {
+    ScanTotal s = { 0, 0.0 };
+    segstore_scan(STORE_DIR, from_ms, to_ms, visit, &s);
+    return s;
+}
+
+/* Best of SCAN_REPEAT runs; returns records/s and the last result */
+static double time_scan(ScanTotal (*scan)(int64_t, int64_t),
+                        int64_t from_ms, int64_t to_ms, ScanTotal *out) {
+    uint64_t best = UINT64_MAX;
+
+    for (int i = 0; i < SCAN_REPEAT; i++) {
+        uint64_t t0 = now_ns();
+        *out = scan(from_ms, to_ms);
+        uint64_t ns = now_ns() - t0;
+        if (ns < best) best = ns;
+    }
+    return (double)out->records * 1e9 / (double)best;
+}
+
+static void print_row(const char *name, double bytes_per_rec, double ingest,
+                      double full, double hour) {
+    printf("%-18s %10.1f %10.2f %12.0f %12.0f %12.0f\n",
+           name, bytes_per_rec, bytes_per_rec / (COLUMNS + 1),
+           ingest, full, hour);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Main                                                               */
+/* ------------------------------------------------------------------ */
+int main(void) {
+    printf("=== RT-Bench: Window Store (storage/segment_store.c)  [QNX] ===\n");
+    printf("Records     : %d at 1 Hz, %d float columns + timestamp\n", RECORDS, COLUMNS);
+    printf("Store       : %s (segments of %lld s, blocks of %d records)\n\n",
+           STORE_DIR, SEGSTORE_SEGMENT_MS / 1000, SEGSTORE_BLOCK_RECORDS);
+
+    float (*data)[COLUMNS] = malloc((size_t)RECORDS * sizeof(*data));
+    if (!data) { fprintf(stderr, "malloc failed\n"); return 1; }
+    for (int i = 0; i < RECORDS; i++)
+        fill_record(i, data[i]);
+
+    remove_store();
+
+    /* Raw-struct baseline */
+    uint64_t t0 = now_ns();
+    FILE *f = fopen(RAW_FILE, "wb");
+    if (!f) { fprintf(stderr, "cannot create %s\n", RAW_FILE); return 1; }
+    for (int i = 0; i < RECORDS; i++) {
+        RawRecord r;
+        r.t_ms = START_MS + (int64_t)i * 1000;
+        memcpy(r.v, data[i], sizeof(r.v));
+        fwrite(&r, sizeof(r), 1, f);
+    }
+    fflush(f);
+    fdatasync(fileno(f));
+    fclose(f);
+    double raw_ingest = (double)RECORDS * 1e9 / (double)(now_ns() - t0);
+
+    /* Segment store; a few ms of jitter on the window timestamps */
+    char err[128];
+    t0 = now_ns();
+    SegStore *st = segstore_open(STORE_DIR, COLUMNS, 0, err, sizeof(err));
+    if (!st) { fprintf(stderr, "segstore_open: %s\n", err); return 1; }
+    for (int i = 0; i < RECORDS; i++) {
+        int64_t t_ms = START_MS + (int64_t)i * 1000 + (i % 7 == 0 ? 1 : 0);
+        if (segstore_append(st, t_ms, data[i]) != 0) {
+            fprintf(stderr, "segstore_append failed at %d\n", i);
+            return 1;
+        }
+    }
+    segstore_close(st);
+    double seg_ingest = (double)RECORDS * 1e9 / (double)(now_ns() - t0);
+
+    /* Sizes */
+    struct stat rs;
+    int files = 0;
+    long long seg_total = store_bytes(&files);
+    double raw_per_rec = stat(RAW_FILE, &rs) == 0 ? (double)rs.st_size / RECORDS : 0.0;
+    double seg_per_rec = (double)seg_total / RECORDS;
+
+    /* Scans: the whole day, then hour 12 */
+    int64_t day_from = START_MS, day_to = START_MS + (int64_t)RECORDS * 1000;
+    int64_t hour_from = START_MS + 12 * 3600000LL, hour_to = hour_from + 3600000LL - 1;
+    ScanTotal raw_full, raw_hour, seg_full, seg_hour;
+
+    double raw_full_rate = time_scan(scan_raw, day_from, day_to, &raw_full);
+    double raw_hour_rate = time_scan(scan_raw, hour_from, hour_to, &raw_hour);
+    double seg_full_rate = time_scan(scan_store, day_from, day_to, &seg_full);
+    double seg_hour_rate = time_scan(scan_store, hour_from, hour_to, &seg_hour);
+
+    printf("%-18s %10s %10s %12s %12s %12s\n",
+           "Benchmark", "B/record", "B/sample", "Ingest(r/s)", "Scan24h(r/s)", "Scan1h(r/s)");
+    print_row("RAW STRUCT [QNX]", raw_per_rec, raw_ingest, raw_full_rate, raw_hour_rate);
+    print_row("SEGMENTS [QNX]", seg_per_rec, seg_ingest, seg_full_rate, seg_hour_rate);
+
+    printf("\nCompression : %.2fx (%lld bytes in %d segments vs %lld raw)\n",
+           seg_per_rec > 0.0 ? raw_per_rec / seg_per_rec : 0.0,
+           seg_total, files, (long long)rs.st_size);
+
+    /* Checksum: both stores must return the same records */
+    printf("Result check: 24h %ld/%ld records, 1h %ld/%ld records, col0 sum %.1f/%.1f\n",
+           seg_full.records, raw_full.records, seg_hour.records, raw_hour.records,
+           seg_full.sum, raw_full.sum);
+
+    remove_store();
+    free(data);
+    return 0;
+}
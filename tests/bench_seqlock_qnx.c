@@ -0,0 +1,238 @@
+/*
+ * bench_seqlock_qnx.c  —  Snapshot Publication Contention Benchmark  (QNX Neutrino target)
+ * =====================================================================================
+ * Measures: Jitter of a 1 kHz absolute-deadline poll loop (the same shape as
+ *           polling_thread in drivers/sensor_manager.c) while it publishes an
+ *           EquipmentHealth snapshot, with 0 and with 32 reader threads
+ *           hammering the snapshot (worst case of MAX_CONCURRENT_SESSIONS
+ *           monitor sessions).
+ *
+ *           Two publication schemes are compared:
+ *             MUTEX   — the previous data_mutex lock/copy/unlock
+ *             SEQLOCK — drivers/seqlock.h, writer never waits
+ *
+ *           The window is shortened to WINDOW_TICKS so every run contains
+ *           enough publications to expose lock hand-off delays.
+ *
+ * Build (on host, cross-compile for RPi 4):
+ *   qcc -V gcc_ntoaarch64le -D_QNX_SOURCE -O2 \
+ *       -o bench_seqlock_qnx tests/bench_seqlock_qnx.c
+ *
+ * Deploy & Run (as root so the loop gets SCHED_FIFO):
+ *   scp bench_seqlock_qnx qnxuser@<RPI_IP>:/tmp/
+ *   ssh qnxuser@<RPI_IP> "/tmp/bench_seqlock_qnx"
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "../drivers/sensors.h"
+#include "../drivers/seqlock.h"
+
+/* ------------------------------------------------------------------ */
+/*  Benchmark parameters                                               */
+/* ------------------------------------------------------------------ */
+#define TICKS          3000        /* 3 s of 1 kHz polling per run     */
+#define WINDOW_TICKS   10          /* publish every 10 ticks           */
+#define POLL_NS        1000000L
+#define MAX_READERS    32
+#define RT_PRIORITY    60
+
+typedef enum { MODE_MUTEX = 0, MODE_SEQLOCK } PublishMode;
+
+/* ------------------------------------------------------------------ */
+/*  Shared snapshot                                                    */
+/* ------------------------------------------------------------------ */
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+static SeqLock s_seq;
+static EquipmentHealth s_shared;
+
+static volatile int s_readers_run;
+static PublishMode s_mode;
+static uint64_t s_reads[MAX_READERS];
+
+static uint64_t s_tick_ns[TICKS];
+static uint64_t s_pub_ns[TICKS / WINDOW_TICKS];
+
+/* ------------------------------------------------------------------ */
+/*  Timing helpers                                                     */
+/* ------------------------------------------------------------------ */
+static inline uint64_t ts_to_ns(const struct timespec *ts) {
+    return (uint64_t)ts->tv_sec * 1000000000ULL + (uint64_t)ts->tv_nsec;
+}
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts_to_ns(&ts);
+}
+
+static void add_ns(struct timespec *ts, long ns) {
+    ts->tv_nsec += ns;
+    while (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec += 1;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Reader: emulates cmd_monitor calling manager_get_health nonstop    */
+/* ------------------------------------------------------------------ */
+static void *reader_thread(void *arg) {
+    int idx = (int)(intptr_t)arg;
+    EquipmentHealth h;
+    uint64_t n = 0;
+
+    memset(&h, 0, sizeof(h));
+    while (s_readers_run) {
+        if (s_mode == MODE_MUTEX) {
+            pthread_mutex_lock(&s_mutex);
+            memcpy(&h, &s_shared, sizeof(h));
+            pthread_mutex_unlock(&s_mutex);
+        } else {
+            seqlock_snapshot(&s_seq, &h, &s_shared, sizeof(h));
+        }
+        n++;
+    }
+    s_reads[idx] = n + (uint64_t)h.status;
+    return NULL;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Writer: 1 kHz absolute-deadline loop, publishes every window       */
+/* ------------------------------------------------------------------ */
+static void *poll_thread(void *arg) {
+    (void)arg;
+    EquipmentHealth next;
+    struct timespec next_tick;
+    int pubs = 0;
+
+    memset(&next, 0, sizeof(next));
+    strcpy(next.unit_id, "Sentinel-RT");
+    clock_gettime(CLOCK_MONOTONIC, &next_tick);
+
+    for (int i = 0; i < TICKS; i++) {
+        add_ns(&next_tick, POLL_NS);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_tick, NULL) == EINTR) {
+        }
+
+        uint64_t woke = now_ns();
+        uint64_t tgt = ts_to_ns(&next_tick);
+        s_tick_ns[i] = woke > tgt ? woke - tgt : tgt - woke;
+
+        if ((i + 1) % WINDOW_TICKS == 0) {
+            next.snapshot.vibration_level = (float)i;
+            next.status = (HealthStatus)(i & 1);
+
+            uint64_t t0 = now_ns();
+            if (s_mode == MODE_MUTEX) {
+                pthread_mutex_lock(&s_mutex);
+                memcpy(&s_shared, &next, sizeof(next));
+                pthread_mutex_unlock(&s_mutex);
+            } else {
+                seqlock_publish(&s_seq, &s_shared, &next, sizeof(next));
+            }
+            s_pub_ns[pubs++] = now_ns() - t0;
+        }
+    }
+    return NULL;
+}
+
+static void stats(const uint64_t *v, int n, uint64_t *min_ns, uint64_t *max_ns,
+                  uint64_t *avg_ns) {
+    uint64_t sum = 0;
+    *min_ns = UINT64_MAX;
+    *max_ns = 0;
+    for (int i = 0; i < n; i++) {
+        sum += v[i];
+        if (v[i] < *min_ns) *min_ns = v[i];
+        if (v[i] > *max_ns) *max_ns = v[i];
+    }
+    *avg_ns = sum / (uint64_t)n;
+}
+
+static int run_case(PublishMode mode, int readers, const char *label) {
+    pthread_t rd[MAX_READERS];
+    pthread_t wr;
+    pthread_attr_t attr;
+    struct sched_param sp;
+    int rt = 1;
+
+    s_mode = mode;
+    s_readers_run = 1;
+    memset(&s_shared, 0, sizeof(s_shared));
+    seqlock_init(&s_seq);
+
+    for (int r = 0; r < readers; r++) {
+        if (pthread_create(&rd[r], NULL, reader_thread, (void *)(intptr_t)r) != 0) {
+            fprintf(stderr, "reader pthread_create failed\n");
+            return -1;
+        }
+    }
+
+    pthread_attr_init(&attr);
+    memset(&sp, 0, sizeof(sp));
+    sp.sched_priority = RT_PRIORITY;
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+    pthread_attr_setschedparam(&attr, &sp);
+    if (pthread_create(&wr, &attr, poll_thread, NULL) != 0) {
+        /* Not privileged: fall back to default scheduling */
+        rt = 0;
+        if (pthread_create(&wr, NULL, poll_thread, NULL) != 0) {
+            fprintf(stderr, "writer pthread_create failed\n");
+            return -1;
+        }
+    }
+    pthread_attr_destroy(&attr);
+
+    pthread_join(wr, NULL);
+    s_readers_run = 0;
+    for (int r = 0; r < readers; r++)
+        pthread_join(rd[r], NULL);
+
+    uint64_t tmin, tmax, tavg, pmin, pmax, pavg;
+    stats(s_tick_ns, TICKS, &tmin, &tmax, &tavg);
+    stats(s_pub_ns, TICKS / WINDOW_TICKS, &pmin, &pmax, &pavg);
+
+    uint64_t reads = 0;
+    for (int r = 0; r < readers; r++) reads += s_reads[r];
+
+    printf("%-24s %10llu %10llu %10llu %10llu %12llu %12llu%s\n",
+           label,
+           (unsigned long long)(tmin / 1000),
+           (unsigned long long)(tmax / 1000),
+           (unsigned long long)(tavg / 1000),
+           (unsigned long long)((tmax - tmin) / 1000),
+           (unsigned long long)pmax,
+           (unsigned long long)(reads / (TICKS / 1000)),
+           rt ? "" : "  (no SCHED_FIFO)");
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Main                                                               */
+/* ------------------------------------------------------------------ */
+int main(void) {
+    printf("=== RT-Bench: SEQLOCK vs MUTEX publication  [QNX] ===\n");
+    printf("Ticks/run   : %d @ 1 kHz\n", TICKS);
+    printf("Window      : %d ticks\n", WINDOW_TICKS);
+    printf("Payload     : %zu bytes (EquipmentHealth)\n\n", sizeof(EquipmentHealth));
+
+    printf("%-24s %10s %10s %10s %10s %12s %12s\n",
+           "Benchmark", "Min(us)", "Max(us)", "Avg(us)", "Jitter(us)",
+           "PubMax(ns)", "Reads/s");
+
+    if (run_case(MODE_MUTEX, 0, "MUTEX   0 readers") != 0) return 1;
+    if (run_case(MODE_MUTEX, MAX_READERS, "MUTEX   32 readers") != 0) return 1;
+    if (run_case(MODE_SEQLOCK, 0, "SEQLOCK 0 readers") != 0) return 1;
+    if (run_case(MODE_SEQLOCK, MAX_READERS, "SEQLOCK 32 readers") != 0) return 1;
+
+    return 0;
+}
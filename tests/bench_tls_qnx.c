@@ -0,0 +1,332 @@
+/*
+ * bench_tls_qnx.c  —  mTLS Handshake & Authorization Benchmark  (QNX Neutrino target)
+ * ============================================================================
+ * Measures: Server handshakes per second for a reconnecting client, with
+ *           the same RSA-2048 CA / server / client setup quick_start.sh
+ *           generates, comparing
+ *
+ *           FULL        a new session: key exchange, server signature,
+ *                       client certificate verification
+ *           RESUMED     the client offers the session it got last time
+ *                       (TLS 1.3 ticket, TLS 1.2 ticket or session ID),
+ *                       accepted through common/tls_session.c
+ *
+ *           and authorize_client() on the resulting session:
+ *
+ *           PARSE       the previous path: CN and OU read out of the
+ *                       peer certificate on every connection
+ *           CACHED      common/authorization.c: the identity found by
+ *                       the certificate's signature
+ *
+ *           Client and server run in one thread over an in-memory BIO
+ *           pair, so no network time is included. Handshakes/s counts
+ *           only time spent in the server's SSL calls.
+ *
+ * Build (on host, cross-compile for RPi 4):
+ *   qcc -V gcc_ntoaarch64le -D_QNX_SOURCE -O2 \
+ *       -o bench_tls_qnx tests/bench_tls_qnx.c common/tls_session.c \
+ *       common/authorization.c -lm -lssl -lcrypto
+ *
+ * Deploy & Run:
+ *   scp bench_tls_qnx qnxuser@<RPI_IP>:/tmp/
+ *   ssh qnxuser@<RPI_IP> "/tmp/bench_tls_qnx"
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+#include "../common/authorization.h"
+#include "../common/tls_session.h"
+
+/* ------------------------------------------------------------------ */
+/*  Benchmark parameters                                               */
+/* ------------------------------------------------------------------ */
+#define HANDSHAKES_FULL     200
+#define HANDSHAKES_RESUMED  2000
+#define AUTH_CALLS          200000
+
+/* ------------------------------------------------------------------ */
+/*  Timing helper                                                      */
+/* ------------------------------------------------------------------ */
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void die(const char *what) {
+    fprintf(stderr, "%s failed\n", what);
+    ERR_print_errors_fp(stderr);
+    exit(1);
+}
+
+/* ------------------------------------------------------------------ */
+/*  In-memory PKI (same shape as scripts/quick_start.sh)               */
+/* ------------------------------------------------------------------ */
+static EVP_PKEY *make_key(void) {
+    EVP_PKEY *key = NULL;
+    EVP_PKEY_CTX *kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, NULL);
+    if (!kctx || EVP_PKEY_keygen_init(kctx) <= 0 ||
+        EVP_PKEY_CTX_set_rsa_keygen_bits(kctx, 2048) <= 0 ||
+        EVP_PKEY_keygen(kctx, &key) <= 0)
+        die("RSA keygen");
+    EVP_PKEY_CTX_free(kctx);
+    return key;
+}
+
+static X509 *make_cert(EVP_PKEY *key, const char *cn, const char *ou,
+                       X509 *issuer, EVP_PKEY *issuer_key, long serial) {
+    X509 *cert = X509_new();
+    X509_NAME *name = X509_NAME_new();
+
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), serial);
+    X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 86400L);
+    X509_set_pubkey(cert, key);
+    X509_NAME_add_entry_by_txt(name, "O", MBSTRING_ASC, (const unsigned char *)"IMS", -1, -1, 0);
+    if (ou)
+        X509_NAME_add_entry_by_txt(name, "OU", MBSTRING_ASC, (const unsigned char *)ou, -1, -1, 0);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)cn, -1, -1, 0);
+    X509_set_subject_name(cert, name);
+    X509_set_issuer_name(cert, issuer ? X509_get_subject_name(issuer) : name);
+    if (!issuer) {
+        X509_EXTENSION *ext = X509V3_EXT_conf_nid(NULL, NULL, NID_basic_constraints, "critical,CA:TRUE");
+        if (!ext || !X509_add_ext(cert, ext, -1))
+            die("CA extension");
+        X509_EXTENSION_free(ext);
+    }
+    if (!X509_sign(cert, issuer_key ? issuer_key : key, EVP_sha256()))
+        die("X509_sign");
+    X509_NAME_free(name);
+    return cert;
+}
+
+/* ------------------------------------------------------------------ */
+/*  One handshake over a BIO pair                                      */
+/* ------------------------------------------------------------------ */
+typedef struct {
+    SSL_CTX *server_ctx;
+    SSL_CTX *client_ctx;
+} Endpoints;
+
+/*
+ * Connects a fresh client/server pair, offering `offer` if given.
+ * Returns the server SSL (caller frees) and adds its CPU time to *server_ns.
+ * *session receives the client's session for the next reconnect.
+ */
+static SSL *handshake(const Endpoints *ep, SSL_SESSION *offer, SSL_SESSION **session,
+                      uint64_t *server_ns) {
+    SSL *srv = SSL_new(ep->server_ctx);
+    SSL *cli = SSL_new(ep->client_ctx);
+    BIO *sbio, *cbio;
+    int s_done = 0, c_done = 0;
+    unsigned char byte;
+
+    if (!srv || !cli || !BIO_new_bio_pair(&sbio, 0, &cbio, 0))
+        die("SSL_new/BIO_new_bio_pair");
+    SSL_set_bio(srv, sbio, sbio);
+    SSL_set_bio(cli, cbio, cbio);
+    SSL_set_accept_state(srv);
+    SSL_set_connect_state(cli);
+    if (offer)
+        SSL_set_session(cli, offer);
+
+    for (int round = 0; !(s_done && c_done); round++) {
+        if (round > 100)
+            die("handshake (no progress)");
+        if (!c_done) {
+            int rc = SSL_do_handshake(cli);
+            if (rc == 1) c_done = 1;
+            else if (SSL_get_error(cli, rc) != SSL_ERROR_WANT_READ) die("client handshake");
+        }
+        if (!s_done) {
+            uint64_t t0 = now_ns();
+            int rc = SSL_do_handshake(srv);
+            *server_ns += now_ns() - t0;
+            if (rc == 1) s_done = 1;
+            else if (SSL_get_error(srv, rc) != SSL_ERROR_WANT_READ) die("server handshake");
+        }
+    }
+
+    /* TLS 1.3 tickets arrive after the handshake: let the client read them */
+    if (SSL_read(cli, &byte, 1) > 0)
+        die("unexpected application data");
+    if (session) {
+        SSL_SESSION_free(*session);
+        *session = SSL_get1_session(cli);
+    }
+
+    /* Close cleanly, as client and server do: an unclean close drops the session */
+    SSL_shutdown(cli);
+    uint64_t t0 = now_ns();
+    SSL_shutdown(srv);
+    *server_ns += now_ns() - t0;
+    SSL_free(cli);
+    return srv;
+}
+
+typedef struct {
+    const char *name;
+    int version;        /* TLS1_3_VERSION / TLS1_2_VERSION */
+    int tickets;        /* 0: TLS 1.2 session-ID cache */
+} Variant;
+
+static void print_row(const char *name, const char *proto, int n, int resumed, uint64_t ns, double base) {
+    double hps = (double)n * 1e9 / (double)ns;
+    printf("%-10s %-14s %8d %12.1f %10.3f %8.2fx\n", name, proto, resumed, hps,
+           (double)ns / (double)n / 1e6, base > 0.0 ? hps / base : 1.0);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Previous authorize_client (reference)                              */
+/* ------------------------------------------------------------------ */
+static int parse_client(SSL *ssl, ClientIdentity *out_id) {
+    X509 *cert = SSL_get_peer_certificate(ssl);
+    char ou_buf[64] = {0};
+    if (!cert)
+        return -1;
+    X509_NAME_get_text_by_NID(X509_get_subject_name(cert), NID_commonName,
+                              out_id->common_name, sizeof(out_id->common_name));
+    X509_NAME_get_text_by_NID(X509_get_subject_name(cert), NID_organizationalUnitName,
+                              ou_buf, sizeof(ou_buf));
+    for (char *p = ou_buf; *p; ++p)
+        *p = (char)toupper((unsigned char)*p);
+    if (strcmp(ou_buf, "MAINTENANCE") == 0) out_id->role = ROLE_MAINTENANCE;
+    else if (strcmp(ou_buf, "OPERATOR") == 0) out_id->role = ROLE_OPERATOR;
+    else if (strcmp(ou_buf, "VIEWER") == 0) out_id->role = ROLE_VIEWER;
+    else out_id->role = ROLE_ADMIN;
+    X509_free(cert);
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Main                                                               */
+/* ------------------------------------------------------------------ */
+int main(void) {
+    static const Variant variants[] = {
+        { "TLS 1.3",        TLS1_3_VERSION, 1 },
+        { "TLS 1.2 ticket", TLS1_2_VERSION, 1 },
+        { "TLS 1.2 id",     TLS1_2_VERSION, 0 },
+    };
+    EVP_PKEY *ca_key = make_key(), *srv_key = make_key(), *cli_key = make_key();
+    X509 *ca = make_cert(ca_key, "IMS Root CA", NULL, NULL, NULL, 1);
+    X509 *srv_cert = make_cert(srv_key, "localhost", NULL, ca, ca_key, 2);
+    X509 *cli_cert = make_cert(cli_key, "operator1", "Operator", ca, ca_key, 3);
+    volatile int sink = 0;
+
+    printf("=== RT-Bench: mTLS Handshakes (common/tls_session.c)  [QNX] ===\n");
+    printf("Keys        : RSA-2048 CA, server and client | %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("Handshakes  : %d full, %d resumed per protocol\n\n", HANDSHAKES_FULL, HANDSHAKES_RESUMED);
+    printf("%-10s %-14s %8s %12s %10s %9s\n", "Benchmark", "Protocol", "Resumed", "Handshakes/s",
+           "ms/hshake", "Speedup");
+
+    SSL *last = NULL;
+    for (unsigned v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        const Variant *var = &variants[v];
+        Endpoints ep;
+        SSL_SESSION *session = NULL;
+
+        /* Server: configured like apps/server.c configure_context */
+        ep.server_ctx = SSL_CTX_new(TLS_server_method());
+        if (!ep.server_ctx ||
+            SSL_CTX_use_certificate(ep.server_ctx, srv_cert) <= 0 ||
+            SSL_CTX_use_PrivateKey(ep.server_ctx, srv_key) <= 0)
+            die("server context");
+        X509_STORE_add_cert(SSL_CTX_get_cert_store(ep.server_ctx), ca);
+        SSL_CTX_set_verify(ep.server_ctx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, NULL);
+        SSL_CTX_set_max_proto_version(ep.server_ctx, var->version);
+        if (tls_session_setup(ep.server_ctx) != 0)
+            die("tls_session_setup");
+
+        /* Client: like apps/client.c, keeping its session between runs */
+        ep.client_ctx = SSL_CTX_new(TLS_client_method());
+        if (!ep.client_ctx ||
+            SSL_CTX_use_certificate(ep.client_ctx, cli_cert) <= 0 ||
+            SSL_CTX_use_PrivateKey(ep.client_ctx, cli_key) <= 0)
+            die("client context");
+        X509_STORE_add_cert(SSL_CTX_get_cert_store(ep.client_ctx), ca);
+        SSL_CTX_set_verify(ep.client_ctx, SSL_VERIFY_PEER, NULL);
+        SSL_CTX_set_session_cache_mode(ep.client_ctx, SSL_SESS_CACHE_CLIENT);
+        if (!var->tickets)
+            SSL_CTX_set_options(ep.client_ctx, SSL_OP_NO_TICKET);
+
+        /* Full handshakes: no session offered */
+        uint64_t full_ns = 0;
+        int resumed = 0;
+        for (int i = 0; i < HANDSHAKES_FULL; i++) {
+            SSL *srv = handshake(&ep, NULL, i == HANDSHAKES_FULL - 1 ? &session : NULL, &full_ns);
+            resumed += SSL_session_reused(srv);
+            SSL_free(srv);
+        }
+        double base = (double)HANDSHAKES_FULL * 1e9 / (double)full_ns;
+        print_row("FULL", var->name, HANDSHAKES_FULL, resumed, full_ns, 0.0);
+
+        /* Resumed: every reconnect offers the session from the previous one */
+        uint64_t res_ns = 0;
+        resumed = 0;
+        for (int i = 0; i < HANDSHAKES_RESUMED; i++) {
+            SSL *srv = handshake(&ep, session, &session, &res_ns);
+            resumed += SSL_session_reused(srv);
+            if (last)
+                SSL_free(last);
+            last = srv;
+        }
+        print_row("RESUMED", var->name, HANDSHAKES_RESUMED, resumed, res_ns, base);
+        if (resumed != HANDSHAKES_RESUMED)
+            printf("  !! %d of %d reconnects fell back to a full handshake\n",
+                   HANDSHAKES_RESUMED - resumed, HANDSHAKES_RESUMED);
+
+        SSL_SESSION_free(session);
+        SSL_CTX_free(ep.client_ctx);
+        SSL_CTX_free(ep.server_ctx);
+    }
+
+    /* Authorization on the last (resumed) session */
+    ClientIdentity ref, id;
+    if (parse_client(last, &ref) != 0 || authorize_client(last, &id) != 0)
+        die("authorize_client");
+    if (strcmp(ref.common_name, id.common_name) != 0 || ref.role != id.role)
+        printf("  !! identity mismatch: %s/%s vs %s/%s\n", ref.common_name,
+               role_to_string(ref.role), id.common_name, role_to_string(id.role));
+
+    printf("\n%-10s %12s %10s %9s\n", "Benchmark", "Auths/s", "ns/auth", "Speedup");
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < AUTH_CALLS; i++) {
+        parse_client(last, &id);
+        sink += id.role;
+    }
+    uint64_t parse_ns = now_ns() - t0;
+    t0 = now_ns();
+    for (int i = 0; i < AUTH_CALLS; i++) {
+        authorize_client(last, &id);
+        sink += id.role;
+    }
+    uint64_t cached_ns = now_ns() - t0;
+    printf("%-10s %12.0f %10.1f %8.2fx\n", "PARSE", AUTH_CALLS * 1e9 / (double)parse_ns,
+           (double)parse_ns / AUTH_CALLS, 1.0);
+    printf("%-10s %12.0f %10.1f %8.2fx\n", "CACHED", AUTH_CALLS * 1e9 / (double)cached_ns,
+           (double)cached_ns / AUTH_CALLS, (double)parse_ns / (double)cached_ns);
+    printf("Identity    : %s (%s)\n", id.common_name, role_to_string(id.role));
+
+    printf("\n(checksum %d)\n", sink);
+    SSL_free(last);
+    X509_free(ca);
+    X509_free(srv_cert);
+    X509_free(cli_cert);
+    EVP_PKEY_free(ca_key);
+    EVP_PKEY_free(srv_key);
+    EVP_PKEY_free(cli_key);
+    return 0;
+}
@@ -1,8 +1,10 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include "sensor_manager.h"
 #include "sensors.h"
+#include "rt_log.h"
 
 // ANSI Color Codes
 #define ANSI_COLOR_RED     "\x1b[31m"
@@ -35,11 +37,19 @@ void print_health(const EquipmentHealth *h) {
 
     printf("------------------------------------------------\n");
     printf("Equipment : %s\n", h->unit_id);
+    printf("Rate      : %u Hz (%s), %u ms window\n",
+           h->sample_rate_hz, h->adaptive ? "adaptive" : "fixed", h->window_ms);
     printf("Status    : %s%s%s\n", color, status_str, ANSI_COLOR_RESET);
     printf("Vibration : %.0f events/s\n", h->snapshot.vibration_level);
     printf("Sound     : %.1f %%\n", h->snapshot.sound_level);
     printf("Temp      : %.1f C\n", h->snapshot.temperature_c);
     printf("Current   : %.2f A\n", h->snapshot.current_a);
+    printf("Vib stats : rms %.3f | p2p %.3f | crest %.2f | skew %.2f | kurt %.2f\n",
+           h->features[CH_VIBRATION].rms,
+           h->features[CH_VIBRATION].peak_to_peak,
+           h->features[CH_VIBRATION].crest_factor,
+           h->features[CH_VIBRATION].skewness,
+           h->features[CH_VIBRATION].kurtosis);
     
     // Print critical alert messages if they exist
     if (h->status == HEALTH_CRITICAL && strlen(h->message) > 0) {
@@ -54,6 +64,10 @@ int main() {
 
     SensorManager manager;
 
+    // Manager diagnostics are queued like in the server, not printed inline
+    if (rt_log_init() != 0)
+        fprintf(stderr, "[WARN] Log writer unavailable, logging synchronously\n");
+
     // 1. Initialize hardware and threads (manager_init now returns int and handles registration internally)
     if (manager_init(&manager) != 0) {
         fprintf(stderr, "[ERROR] Failed to initialize Sensor Manager. Check hardware mapping.\n");
@@ -61,25 +75,51 @@ int main() {
     }
 
     printf("Sensors initialized successfully.\n");
-    printf(" - Digital polling: 1kHz (Vibration/Sound)\n");
+    printf(" - Block acquisition: 2-20kHz adaptive per channel, 5ms FIFO drains (Vibration/Sound)\n");
     printf(" - Analog polling: 1Hz (Temp/Current)\n");
     printf("Starting loop. Press Ctrl+C to stop.\n\n");
 
     EquipmentHealth health;
+    int unit_count = manager_unit_count(&manager);
+    char (*units)[MAX_ID_LENGTH] = malloc((size_t)unit_count * MAX_ID_LENGTH);
+    if (!units) {
+        fprintf(stderr, "[ERROR] Out of memory.\n");
+        return 1;
+    }
+    unit_count = manager_list_units(&manager, units, unit_count);
+
+    // Raw sample consumer on the first unit: checks the ring keeps up
+    static RawSample samples[SAMPLE_RING_CAPACITY];
+    SampleRing *ring = manager_sample_ring(&manager, units[0]);
+    SampleCursor cursor;
+    sample_ring_cursor_init(ring, &cursor);
 
     while (1) {
         // 2. Wait for data to accumulate (Sample window = 1.0s)
         sleep(1); 
 
-        // 3. Get the health report
-        if (manager_get_health(&manager, "Sentinel-RT", &health)) {
-            print_health(&health);
-        } else {
-            fprintf(stderr, "Error: Could not retrieve health for Sentinel-RT\n");
+        // 3. Get the health report of every registered unit
+        for (int i = 0; i < unit_count; i++) {
+            if (manager_get_health(&manager, units[i], &health)) {
+                print_health(&health);
+            } else {
+                fprintf(stderr, "Error: Could not retrieve health for %s\n", units[i]);
+            }
+        }
+
+        int got = sample_ring_read(ring, &cursor, samples, SAMPLE_RING_CAPACITY);
+        if (got > 0) {
+            printf("Raw ring  : %d samples (seq %llu..%llu), %llu overruns\n",
+                   got,
+                   (unsigned long long)samples[0].seq,
+                   (unsigned long long)samples[got - 1].seq,
+                   (unsigned long long)cursor.overruns);
         }
     }
 
     // Cleanup (Unreachable due to while(1), but good practice)
+    free(units);
     manager_cleanup(&manager);
+    rt_log_shutdown();
     return 0;
 }